@@ -1,67 +1,192 @@
 #pragma once
+#include "sys/buffer_budget.hpp"
 #include "sys/defines.hpp"
+#include "sys/stats.hpp"
 
-#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <memory>
 #include <mutex>
-#include <queue>
-#include <thread>
 
+/// @brief Bounded single producer, single consumer ring of preallocated chunks.
+/// @note Chunks are allocated once at construction and recycled between the reader and writer. Both sides block instead of
+/// polling. The producer must always call close() when it's finished, even on failure. The chunks are drawn from the global
+/// buffer budget, so a queue created while others are running can end up with fewer chunks than asked for. Time either side
+/// spends blocked is recorded to sys::stats under the queue's pipeline.
 class BufferQueue final
 {
     public:
-        /// @brief Makes thing easier to read and type.
-        using Buffer = std::unique_ptr<sys::Byte[]>;
+        /// @brief Chunk handed to the consumer by get_front.
+        struct Chunk
+        {
+                const sys::Byte *buffer{};
+                size_t size{};
+        };
 
-        /// @brief This is a pair in the queue.
-        using QueuePair = std::pair<Buffer, size_t>;
+        /// @brief Creates a new BufferQueue.
+        /// @param pipeline Pipeline the queue's stalls are recorded under.
+        /// @param chunkCount Maximum number of chunks in the ring.
+        /// @param chunkSize Size of each chunk in bytes.
+        BufferQueue(sys::stats::Pipeline pipeline, int chunkCount, size_t chunkSize)
+            : m_pipeline(pipeline)
+            , m_chunkSize(chunkSize > 0 ? chunkSize : 1)
+            , m_chunkCount(sys::buffer_budget::reserve(chunkCount > 0 ? chunkCount : 1, m_chunkSize))
+            , m_pool(std::make_unique<sys::Byte[]>(m_chunkCount * m_chunkSize))
+            , m_sizes(std::make_unique<size_t[]>(m_chunkCount)) {};
 
-        /// @brief Less of a pain to type out.
-        using BufferGuard = std::lock_guard<std::mutex>;
+        /// @brief Records the stalls and returns the chunks to the budget.
+        ~BufferQueue()
+        {
+            sys::stats::record_pipeline(m_pipeline, m_producerStall, m_consumerStall);
+            sys::buffer_budget::release(m_chunkCount * m_chunkSize);
+        }
 
-        /// @brief Creates a new BufferQueue.
-        /// @param bufferLimit Number of buffers before the queue is considered full.
-        BufferQueue(int bufferLimit) noexcept
-            : m_bufferLimit(bufferLimit) {};
+        BufferQueue(const BufferQueue &)            = delete;
+        BufferQueue &operator=(const BufferQueue &) = delete;
 
-        /// @brief Attempts the push the buffer to the queue. Returns false if it fails.
-        inline bool try_push(Buffer &buffer, size_t bufferSize)
+        /// @brief Returns the size of each chunk.
+        inline size_t get_chunk_size() const noexcept { return m_chunkSize; }
+
+        /// @brief Producer. Blocks until a chunk is free and returns it. Returns nullptr if the queue was aborted.
+        inline sys::Byte *get_write_buffer()
         {
-            std::lock_guard queueGuard{m_queueMutex};
-            if (m_bufferLimit != NO_LIMIT && static_cast<int>(m_queue.size()) >= m_bufferLimit) { return false; }
+            std::unique_lock queueGuard{m_queueMutex};
+            auto isFree = [this]() { return m_aborted || m_count < m_chunkCount; };
+            if (!isFree())
+            {
+                const uint64_t stallBegin = sys::stats::get_time();
+                m_freeCondition.wait(queueGuard, isFree);
+                m_producerStall += sys::stats::get_time() - stallBegin;
+            }
+            if (m_aborted) { return nullptr; }
 
-            m_queue.emplace(std::move(buffer), bufferSize);
-            return true;
+            return &m_pool[m_writeIndex * m_chunkSize];
         }
 
-        /// @brief Gets and returns the pair at the front of the queue if there is one. Returns false if this fails.
-        inline bool get_front(QueuePair &pairOut)
+        /// @brief Producer. Hands the chunk returned by get_write_buffer to the consumer.
+        /// @param size Number of bytes written to the chunk.
+        inline void push(size_t size)
         {
-            std::lock_guard queueGuard{m_queueMutex};
-            if (m_queue.empty()) { return false; }
+            {
+                std::lock_guard queueGuard{m_queueMutex};
+                m_sizes[m_writeIndex] = size;
+                m_writeIndex          = (m_writeIndex + 1) % m_chunkCount;
+                ++m_count;
+            }
+            m_filledCondition.notify_one();
+        }
 
-            pairOut = std::move(m_queue.front());
-            m_queue.pop();
+        /// @brief Producer. Signals the end of the stream. Passing false marks the stream as failed.
+        inline void close(bool success = true)
+        {
+            {
+                std::lock_guard queueGuard{m_queueMutex};
+                m_closed = true;
+                if (!success) { m_aborted = true; }
+            }
+            m_filledCondition.notify_all();
+            m_freeCondition.notify_all();
+        }
+
+        /// @brief Consumer. Blocks until a chunk is available. Returns false at the end of the stream or on failure.
+        inline bool get_front(BufferQueue::Chunk &chunkOut)
+        {
+            std::unique_lock queueGuard{m_queueMutex};
+            auto isFilled = [this]() { return m_aborted || m_closed || m_count > 0; };
+            if (!isFilled())
+            {
+                const uint64_t stallBegin = sys::stats::get_time();
+                m_filledCondition.wait(queueGuard, isFilled);
+                m_consumerStall += sys::stats::get_time() - stallBegin;
+            }
+            if (m_aborted || m_count == 0) { return false; }
+
+            chunkOut.buffer = &m_pool[m_readIndex * m_chunkSize];
+            chunkOut.size   = m_sizes[m_readIndex];
             return true;
         }
 
-        /// @brief This is the default delay period to use if either of the above fail.
-        static inline void default_delay() noexcept { std::this_thread::sleep_for(std::chrono::microseconds(10)); }
+        /// @brief Consumer. Returns the chunk from get_front to the producer.
+        inline void pop()
+        {
+            {
+                std::lock_guard queueGuard{m_queueMutex};
+                m_readIndex = (m_readIndex + 1) % m_chunkCount;
+                --m_count;
+            }
+            m_freeCondition.notify_one();
+        }
 
-        /// @brief This can be passed to the constructor to make is_full() return false all of the time.
-        static inline int NO_LIMIT = -1;
+        /// @brief Consumer. Stops the producer and blocks until it has called close().
+        /// @note This must be called before anything the producer references goes out of scope.
+        inline void abort()
+        {
+            std::unique_lock queueGuard{m_queueMutex};
+            m_aborted = true;
+            m_freeCondition.notify_all();
+            m_filledCondition.wait(queueGuard, [this]() { return m_closed; });
+        }
+
+        /// @brief Consumer. Blocks until the producer has called close().
+        inline void wait_closed()
+        {
+            std::unique_lock queueGuard{m_queueMutex};
+            m_filledCondition.wait(queueGuard, [this]() { return m_closed; });
+        }
+
+        /// @brief Returns whether the stream failed or was aborted.
+        inline bool has_failed()
+        {
+            std::lock_guard queueGuard{m_queueMutex};
+            return m_aborted;
+        }
+
+        /// @brief Resets the queue so it can be reused for another stream without reallocating.
+        /// @note Only call this once the producer has closed.
+        inline void reset()
+        {
+            std::lock_guard queueGuard{m_queueMutex};
+            sys::stats::record_pipeline(m_pipeline, m_producerStall, m_consumerStall);
+            m_readIndex     = 0;
+            m_writeIndex    = 0;
+            m_count         = 0;
+            m_closed        = false;
+            m_aborted       = false;
+            m_producerStall = 0;
+            m_consumerStall = 0;
+        }
 
     private:
-        /// @brief Maximum number of buffers.
-        int m_bufferLimit{};
+        /// @brief Pipeline stalls are recorded under.
+        sys::stats::Pipeline m_pipeline{};
 
-        /// @brief Stores the size of the buffers allocated with allocate_buffer.
-        size_t m_bufferSize{};
+        /// @brief Size of each chunk.
+        size_t m_chunkSize{};
 
-        /// @brief Mutex to lock the queue with.
-        std::mutex m_queueMutex{};
+        /// @brief Number of chunks in the ring.
+        size_t m_chunkCount{};
+
+        /// @brief The chunks. One allocation.
+        std::unique_ptr<sys::Byte[]> m_pool{};
+
+        /// @brief Filled size of each chunk.
+        std::unique_ptr<size_t[]> m_sizes{};
 
-        /// @brief Queue of buffers.
-        std::queue<QueuePair> m_queue{};
+        /// @brief Ring indexes and the number of filled chunks.
+        size_t m_readIndex{};
+        size_t m_writeIndex{};
+        size_t m_count{};
+
+        /// @brief Stream state.
+        bool m_closed{};
+        bool m_aborted{};
+
+        /// @brief Microseconds each side has spent blocked during the current stream.
+        uint64_t m_producerStall{};
+        uint64_t m_consumerStall{};
+
+        /// @brief Mutex and conditions for both sides.
+        std::mutex m_queueMutex{};
+        std::condition_variable m_freeCondition{};
+        std::condition_variable m_filledCondition{};
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include "appstates/BaseState.hpp"
+#include "appstates/DebugOverlayState.hpp"
 #include "sdl.hpp"
 
 #include <atomic>
@@ -45,6 +46,9 @@ class JKSV
         /// @brief Stores the build string.
         std::string m_buildString{};
 
+        /// @brief Thread pool counters drawn over everything when enabled.
+        std::shared_ptr<DebugOverlayState> m_debugOverlay{};
+
         /// @brief Sets the system to enable boost mode.
         void set_boost_mode();
 
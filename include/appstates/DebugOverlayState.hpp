@@ -0,0 +1,39 @@
+#pragma once
+#include "appstates/BaseState.hpp"
+#include "sys/sys.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+
+/// @brief Overlay showing the thread pool and pipeline counters from sys::stats.
+/// @note This isn't pushed to the StateManager. JKSV updates and renders it on top of everything else while the debug overlay
+/// setting is enabled, so it never takes focus from the state it's drawn over.
+class DebugOverlayState final : public BaseState
+{
+    public:
+        /// @brief Constructor.
+        DebugOverlayState();
+
+        /// @brief Creates and returns a new DebugOverlayState.
+        static inline std::shared_ptr<DebugOverlayState> create() { return std::make_shared<DebugOverlayState>(); }
+
+        /// @brief Refreshes the lines from the counters every so often.
+        void update() override;
+
+        /// @brief Renders the overlay.
+        void render() override;
+
+    private:
+        /// @brief Job counts, queued and running times, then one line per pipeline.
+        static constexpr size_t COUNT_LINES = 3 + sys::stats::COUNT_PIPELINES;
+
+        /// @brief Lines displayed.
+        std::array<std::string, COUNT_LINES> m_lines{};
+
+        /// @brief Timer for refreshing the lines.
+        sys::Timer m_refreshTimer{};
+
+        /// @brief Rebuilds the lines from the counters.
+        void refresh_lines();
+};
@@ -56,4 +56,7 @@ class ExtrasMenuState final : public BaseState
 
         /// @brief Terminates a process.
         void terminate_process();
+
+        /// @brief Times the SD and system storage at different chunk sizes and saves the fastest to config.
+        void calibrate_io();
 };
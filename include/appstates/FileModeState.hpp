@@ -1,10 +1,13 @@
 #pragma once
 #include "StateManager.hpp"
 #include "appstates/BaseState.hpp"
+#include "fs/ZipIndex.hpp"
 #include "fslib.hpp"
 #include "sdl.hpp"
 #include "ui/ui.hpp"
 
+#include <memory>
+#include <string>
 #include <string_view>
 
 class FileModeState final : public BaseState
@@ -73,6 +76,14 @@ class FileModeState final : public BaseState
         std::shared_ptr<ui::Menu> m_dirMenuA{};
         std::shared_ptr<ui::Menu> m_dirMenuB{};
 
+        /// @brief ZIPs being browsed on each side. These are null while a side is browsing a regular directory.
+        std::shared_ptr<fs::ZipIndex> m_zipA{};
+        std::shared_ptr<fs::ZipIndex> m_zipB{};
+
+        /// @brief Current directory inside of each ZIP. Empty is the root of the ZIP.
+        std::string m_zipDirA{};
+        std::string m_zipDirB{};
+
         /// @brief Stores whether the instance is dealing with sensitive data.
         bool m_isSystem{};
 
@@ -112,6 +123,9 @@ class FileModeState final : public BaseState
         /// @brief Loads the current directory listings and menus.
         void initialize_directory_menu(const fslib::Path &path, fslib::Directory &directory, ui::Menu &menu);
 
+        /// @brief Loads the directory of the ZIP passed into the menu.
+        void initialize_zip_menu(const fs::ZipIndex &zip, const std::string &zipDir, ui::Menu &menu);
+
         /// @brief Updates the current Y coordinate of the dialog.
         void update_y() noexcept;
 
@@ -121,6 +135,16 @@ class FileModeState final : public BaseState
         /// @brief Handles changing the current directory or opening the options.
         void enter_selected(fslib::Path &path, fslib::Directory &directory, ui::Menu &menu);
 
+        /// @brief Handles changing the current directory inside of a ZIP.
+        void enter_selected_zip(std::shared_ptr<fs::ZipIndex> &zip, std::string &zipDir, ui::Menu &menu);
+
+        /// @brief Indexes the ZIP entry passed and starts browsing it in place of the directory.
+        void enter_zip(const fslib::Path &path,
+                       std::shared_ptr<fs::ZipIndex> &zip,
+                       std::string &zipDir,
+                       ui::Menu &menu,
+                       const fslib::DirectoryEntry &entry);
+
         /// @brief Opens the little option pop-up thingy.
         void open_option_menu(fslib::Directory &directory, ui::Menu &menu);
 
@@ -158,6 +182,15 @@ class FileModeState final : public BaseState
         /// @brief Returns a reference ot the currently "inactive" directory.
         fslib::Directory &get_destination_directory() noexcept;
 
+        /// @brief Returns a reference to the ZIP the "active" side is browsing.
+        std::shared_ptr<fs::ZipIndex> &get_source_zip() noexcept;
+
+        /// @brief Returns a reference to the ZIP the "inactive" side is browsing.
+        std::shared_ptr<fs::ZipIndex> &get_destination_zip() noexcept;
+
+        /// @brief Returns a reference to the "active" directory inside of its ZIP.
+        std::string &get_source_zip_directory() noexcept;
+
         /// @brief Returns whether or not a path is at the root.
         inline bool path_is_root(fslib::Path &path) const { return std::char_traits<char>::length(path.get_path()) <= 1; }
 
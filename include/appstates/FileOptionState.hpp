@@ -2,11 +2,14 @@
 #include "StateManager.hpp"
 #include "appstates/BaseState.hpp"
 #include "appstates/FileModeState.hpp"
+#include "fs/ZipIndex.hpp"
 #include "fslib.hpp"
 #include "sys/sys.hpp"
 #include "ui/ui.hpp"
 
 #include <atomic>
+#include <memory>
+#include <string>
 
 class FileOptionState final : public BaseState
 {
@@ -48,6 +51,8 @@ class FileOptionState final : public BaseState
             fslib::Path destPath{};
             int64_t journalSize{};
             FileOptionState *spawningState{};
+            std::shared_ptr<fs::ZipIndex> zipIndex{};
+            std::string zipEntry{};
         };
         // clang-format on
 
@@ -106,6 +111,18 @@ class FileOptionState final : public BaseState
         /// @brief Sets up and begins the copy task.
         void copy_target();
 
+        /// @brief Sets up and begins the task to copy out of the ZIP being browsed.
+        void copy_zip_target();
+
+        /// @brief Builds the destination path for copying sourceName to the destination side.
+        /// @param sourceName Name of the file or folder being copied. nullptr if the whole directory is.
+        /// @param fullDest Path to write the destination to.
+        /// @return False if the destination isn't a directory.
+        bool get_copy_destination(const char *sourceName, fslib::Path &fullDest);
+
+        /// @brief Returns the path of the ZIP entry selected or the current ZIP directory if '.' is.
+        std::string get_zip_target();
+
         /// @brief Sets up and begins the delete task.
         void delete_target();
 
@@ -128,9 +145,15 @@ class FileOptionState final : public BaseState
         /// @param path
         void get_show_file_properties(const fslib::Path &path);
 
+        /// @brief Creates a message displaying the properties of the ZIP entry selected.
+        void get_show_zip_properties();
+
         /// @brief Pops the error writing to system message.
         void pop_system_error();
 
+        /// @brief Pops the ZIPs are read-only message.
+        void pop_read_only_error();
+
         /// @brief Sets the menu index back to 0 and deactivates the state.
         void deactivate_state();
 
@@ -6,6 +6,8 @@
 #include "sys/sys.hpp"
 #include "ui/ui.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -74,6 +76,19 @@ class ProgressState final : public BaseTask
         /// @brief Percentage as a string for printing to screen.
         std::string m_percentageString{};
 
+        /// @brief Throughput, time remaining, and file count for whole operations.
+        std::string m_statsString{};
+
+        /// @brief X coordinate of the stats string.
+        int m_statsX{};
+
+        /// @brief Time and byte count the throughput was last sampled at.
+        std::chrono::steady_clock::time_point m_sampleTime{};
+        int64_t m_sampleBytes{};
+
+        /// @brief Smoothed throughput in bytes per second.
+        double m_throughput{};
+
         /// @brief Transition.
         ui::Transition m_transition{};
 
@@ -95,6 +110,9 @@ class ProgressState final : public BaseTask
         /// @brief This updates the current progress displayed.
         void update_progress() noexcept;
 
+        /// @brief Samples the throughput and updates the stats string.
+        void update_operation_stats(sys::ProgressTask *task);
+
         /// @brief Closes the dialog.
         void close_dialog();
 
@@ -27,6 +27,17 @@ namespace config::keys
     inline constexpr std::string_view SHOW_SYSTEM_USER        = "ShowSystem";
     inline constexpr std::string_view ENABLE_TRASH_BIN        = "EnableTrash";
     inline constexpr std::string_view UI_ANIMATION_SCALE      = "UIAnimationScaling";
+    inline constexpr std::string_view INCREMENTAL_BACKUPS     = "IncrementalBackups";
+    inline constexpr std::string_view DEDUPLICATE_BACKUPS     = "DeduplicateBackups";
+    inline constexpr std::string_view VERIFY_WRITES           = "VerifyWrites";
+    inline constexpr std::string_view INDEXED_ARCHIVES        = "IndexedArchives";
+    inline constexpr std::string_view TITLE_DICTIONARIES      = "TitleDictionaries";
+    inline constexpr std::string_view DEBUG_OVERLAY           = "DebugOverlay";
+    inline constexpr std::string_view REMOTE_PRECONNECT       = "RemotePreconnect";
+    inline constexpr std::string_view SD_CHUNK_SHIFT          = "SDChunkShift";
+    inline constexpr std::string_view SYSTEM_CHUNK_SHIFT      = "SystemChunkShift";
+    inline constexpr std::string_view IO_QUEUE_DEPTH          = "IOQueueDepth";
+    inline constexpr std::string_view REMOTE_TRANSFER_LIMIT   = "RemoteTransferLimit";
     inline constexpr std::string_view FAVORITES               = "Favorites";
     inline constexpr std::string_view BLACKLIST               = "BlackList";
 }
@@ -1,22 +1,26 @@
 #pragma once
 #include "BufferQueue.hpp"
+#include "fs/ZipPipe.hpp"
 #include "fslib.hpp"
 #include "sys/sys.hpp"
 
-#include <array>
-#include <mutex>
-#include <queue>
-#include <semaphore>
-
 namespace curl
 {
-    inline constexpr int DOWNLOAD_QUEUE_LIMIT = 128;
+    /// @brief Number of chunks in the download ring.
+    inline constexpr int DOWNLOAD_QUEUE_CHUNKS = 8;
+
+    /// @brief Size of each download chunk. curl's writes are gathered into these.
+    inline constexpr size_t SIZE_DOWNLOAD_CHUNK = 0x40000;
 
     // clang-format off
     struct DownloadStruct : sys::threadpool::DataStruct
     {
         /// @brief Buffer queue for downloads.
-        BufferQueue bufferQueue{BufferQueue::NO_LIMIT};
+        BufferQueue bufferQueue{sys::stats::Pipeline::Download, DOWNLOAD_QUEUE_CHUNKS, SIZE_DOWNLOAD_CHUNK};
+
+        /// @brief Chunk curl is currently writing to and how much of it is filled.
+        sys::Byte *writeBuffer{};
+        size_t writeOffset{};
 
         /// @brief Destination file to write to.
         fslib::File *dest{};
@@ -26,9 +30,15 @@ namespace curl
 
         /// @brief Size of the file being downloaded.
         int64_t fileSize{};
+    };
 
-        /// @brief Signals when the write thread is complete.
-        std::binary_semaphore writeComplete{0};
+    struct StreamDownloadStruct
+    {
+        /// @brief Pipe the download is written to.
+        fs::ZipPipe *pipe{};
+
+        /// @brief Optional. Task to update with progress.
+        sys::ProgressTask *task{};
     };
     // clang-format on
 
@@ -0,0 +1,110 @@
+#pragma once
+#include "curl/curl.hpp"
+#include "fslib.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <switch.h>
+#include <utility>
+#include <vector>
+
+namespace curl
+{
+    // clang-format off
+    struct Transfer
+    {
+        /// @brief Handle performing the transfer. Every transfer needs its own since they're all running at once.
+        curl::Handle handle{curl::new_handle()};
+
+        /// @brief Headers sent with the transfer. These need to live as long as the handle is using them.
+        curl::HeaderList headers{curl::new_header_list()};
+
+        /// @brief File being uploaded and the struct curl reads it through. The file is closed before complete is called.
+        fslib::File source{};
+        curl::UploadStruct upload{};
+
+        /// @brief Response from the server.
+        std::string response{};
+
+        /// @brief Called once the transfer is finished. performed is whether or not curl finished it without an error.
+        std::function<void(curl::Transfer &transfer, bool performed)> complete{};
+    };
+    // clang-format on
+
+    /// @brief Runs multiple transfers at the same time with curl_multi on its own thread.
+    /// @note Completions run on the thread that owns the engine from add() and wait(). They can touch anything that thread
+    /// can without locking.
+    class TransferEngine final
+    {
+        public:
+            /// @brief Starts the engine. If this fails, transfers are performed as they're added instead.
+            /// @param limit Maximum number of transfers in flight at once.
+            TransferEngine(size_t limit);
+
+            /// @brief Waits for every transfer to finish and stops the engine.
+            ~TransferEngine();
+
+            TransferEngine(const TransferEngine &)            = delete;
+            TransferEngine(TransferEngine &&)                 = delete;
+            TransferEngine &operator=(const TransferEngine &) = delete;
+            TransferEngine &operator=(TransferEngine &&)      = delete;
+
+            /// @brief Queues a transfer. This blocks while the limit is reached.
+            /// @param transfer Transfer to queue. The handle should be completely set up.
+            void add(std::unique_ptr<curl::Transfer> transfer);
+
+            /// @brief Blocks until every transfer added has finished and runs their completions.
+            void wait();
+
+        private:
+            /// @brief Definition for a finished transfer and whether curl performed it without an error.
+            using Finished = std::pair<std::unique_ptr<curl::Transfer>, bool>;
+
+            /// @brief Multi handle driving the transfers. Only the engine thread touches this after construction.
+            CURLM *m_multi{};
+
+            /// @brief Thread the multi handle is driven on.
+            Thread m_thread{};
+
+            /// @brief Whether or not the thread was started.
+            bool m_isRunning{};
+
+            /// @brief Maximum number of transfers in flight.
+            size_t m_limit{};
+
+            /// @brief Mutex and condition shared by both sides.
+            std::mutex m_engineMutex{};
+            std::condition_variable m_engineCondition{};
+
+            /// @brief Transfers added that the engine hasn't picked up yet.
+            std::vector<std::unique_ptr<curl::Transfer>> m_pending{};
+
+            /// @brief Transfers finished whose completions haven't run yet.
+            std::vector<TransferEngine::Finished> m_finished{};
+
+            /// @brief Number of transfers added that haven't finished.
+            size_t m_inFlight{};
+
+            /// @brief Signals the engine thread to exit.
+            bool m_exit{};
+
+            /// @brief Thread function. arg is the engine.
+            static void engine_thread_function(void *arg);
+
+            /// @brief Drives the multi handle until the engine is stopped.
+            void run();
+
+            /// @brief Moves finished transfers out of the multi handle.
+            /// @param running Transfers currently attached to the multi handle.
+            void collect_finished(std::vector<std::unique_ptr<curl::Transfer>> &running);
+
+            /// @brief Runs the completions of every transfer finished so far.
+            void run_completions();
+
+            /// @brief Closes the source and runs the completion of the transfer passed.
+            static void complete_transfer(curl::Transfer &transfer, bool performed);
+    };
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "fs/ZipPipe.hpp"
 #include "fslib.hpp"
 #include "sys/sys.hpp"
 
@@ -9,7 +10,13 @@ namespace curl
     {
         /// @brief Source file to upload from.
         fslib::File *source{};
-        
+
+        /// @brief Pipe to upload from instead of a file.
+        fs::ZipPipe *pipe{};
+
+        /// @brief Number of bytes read from the pipe.
+        int64_t pipeSize{};
+
         /// @brief Optional. Task to update with progress.
         sys::ProgressTask *task{};
     };
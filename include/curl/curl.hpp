@@ -23,11 +23,11 @@ namespace curl
     /// @brief Definition for a vector containing headers received from libcurl.
     using HeaderArray = std::vector<std::string>;
 
-    /// @brief Initializes lib curl.
+    /// @brief Initializes lib curl and the cache shared between handles.
     /// @return True on success. False on failure.
     bool initialize();
 
-    /// @brief Exits libcurl
+    /// @brief Frees the shared cache and exits libcurl.
     void exit();
 
     /// @brief Inline templated function to wrap curl_easy_setopt and make using curl::Handle slightly easier.
@@ -43,24 +43,24 @@ namespace curl
         return curl_easy_setopt(handle.get(), option, value);
     }
 
-    /// @brief Inline function that returns a self cleaning curl handle.
+    /// @brief Returns a self cleaning curl handle.
+    /// @note Every handle shares one DNS cache and TLS session cache. Requests to a host any handle has already talked to
+    /// skip the lookup and resume the TLS session instead of doing a full handshake. Connections stay with each handle, since
+    /// curl can't share them between handles running on different threads.
     /// @return Curl handle.
-    static inline curl::Handle new_handle() { return curl::Handle(curl_easy_init(), curl_easy_cleanup); }
+    curl::Handle new_handle();
 
     /// @brief Inline function that returns a nullptr'd self cleaning curl_list.
     /// @return Self cleaning curl_slist.
     static inline curl::HeaderList new_header_list() { return curl::HeaderList(nullptr, curl_slist_free_all); }
 
-    /// @brief Inline wrapper function for curl_easy_reset.
+    /// @brief Wrapper function for curl_easy_reset. This restores JKSV's defaults and keeps the handle on the shared cache.
     /// @param curl curl::Handle to reset.
-    static inline void reset_handle(curl::Handle &curl)
-    {
-        curl_easy_reset(curl.get());
-        curl::set_option(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl::set_option(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl::set_option(curl, CURLOPT_USERAGENT, curl::STRING_USER_AGENT);
-        curl::set_option(curl, CURLOPT_CONNECTTIMEOUT, 5L);
-    }
+    void reset_handle(curl::Handle &curl);
+
+    /// @brief Makes a HEAD request to the URL passed so the DNS lookup and TLS session are cached before they're needed.
+    /// @param url URL to connect to. The response doesn't matter.
+    void preconnect(std::string_view url);
 
     /// @brief Logged inline wrapper function for curl_easy_perform.
     /// @param handle Handle to perform.
@@ -79,6 +79,14 @@ namespace curl
     /// @return Number of bytes read so curl thinks everything went OK.
     size_t read_data_from_file(char *buffer, size_t size, size_t count, curl::UploadStruct *upload);
 
+    /// @brief Curl callback function for reading data from a ZIP pipe. This blocks until the ZIP has data to send.
+    /// @param buffer Incoming buffer from curl to read to.
+    /// @param size Element size.
+    /// @param count Element count.
+    /// @param upload Upload struct with the pipe to read from.
+    /// @return Number of bytes read. 0 at the end of the ZIP. CURL_READFUNC_ABORT if writing the ZIP failed.
+    size_t read_data_from_pipe(char *buffer, size_t size, size_t count, curl::UploadStruct *upload);
+
     /// @brief Curl callback function that writes incoming headers to a vector/array.
     /// @param buffer Incoming buffer from curl.
     /// @param size Element size.
@@ -111,10 +119,25 @@ namespace curl
     /// @return size * count
     size_t download_file_threaded(const char *buffer, size_t size, size_t count, curl::DownloadStruct *download);
 
+    /// @brief Curl callback function that writes downloaded data to a ZIP pipe. This blocks while the pipe is full.
+    /// @param buffer Incoming data from curl.
+    /// @param size Element size.
+    /// @param count Element count.
+    /// @param download Struct containing the pipe.
+    /// @return size * count. 0 if whatever is reading the pipe gave up, which stops the transfer.
+    size_t download_to_pipe(const char *buffer, size_t size, size_t count, curl::StreamDownloadStruct *download);
+
     /// @brief Function used to download files threaded.
     /// @param download Struct shared by both threads.
     void download_write_thread_function(sys::threadpool::JobData jobData);
 
+    /// @brief Flushes the last partial chunk, ends the stream and waits for the write thread to finish.
+    /// @param download Struct shared by both threads.
+    /// @param writeJob Handle returned when download_write_thread_function was pushed.
+    /// @param success Whether curl::perform succeeded.
+    /// @return True if the transfer and every write succeeded.
+    bool finish_threaded_download(curl::DownloadStruct *download, const sys::threadpool::JobHandle &writeJob, bool success);
+
     /// @brief Gets the value of a header from an array of headers.
     /// @param array Array of headers to search.
     /// @param header Header to search for.
@@ -0,0 +1,130 @@
+#pragma once
+#include "fs/CompressionDictionary.hpp"
+#include "fs/JournalBudget.hpp"
+#include "fs/SaveMetaData.hpp"
+#include "fslib.hpp"
+#include "sys/sys.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+#include <zstd.h>
+
+namespace fs
+{
+    /// @brief Extension used for indexed archive backups.
+    inline constexpr std::string_view EXTENSION_ARCHIVE = ".jksa";
+
+    /// @brief Single file backup compressed with zstd. The save meta is stored in the header and an index of every file is
+    /// stored at the end, so nothing has to be scanned to find a file or read the meta.
+    class BackupArchive final
+    {
+        public:
+            /// @brief Size recorded for directories.
+            static constexpr int64_t SIZE_DIRECTORY = -1;
+
+            /// @brief A single file or directory.
+            struct Entry
+            {
+                    std::string path{};
+                    int64_t size{};
+                    uint64_t offset{};
+                    uint32_t crc{};
+            };
+
+            BackupArchive() = default;
+
+            /// @brief Opens the archive at the path passed.
+            BackupArchive(const fslib::Path &path);
+
+            BackupArchive(const BackupArchive &)            = delete;
+            BackupArchive &operator=(const BackupArchive &) = delete;
+
+            /// @brief Opens the archive at the path passed and reads its index.
+            bool open(const fslib::Path &path);
+
+            /// @brief Returns whether or not the archive was opened successfully.
+            bool is_open() const noexcept;
+
+            /// @brief Compresses every file under root to a new archive at path. The archive is left open for reading after.
+            /// @param path Path to create the archive at.
+            /// @param root Root of the tree. Usually the save root.
+            /// @param saveMeta Save meta to store in the header.
+            /// @param task Optional. Task to display progress with.
+            /// @param dictionary Optional. Dictionary to compress with. It has to be stored in the same folder as the archive.
+            bool create(const fslib::Path &path,
+                        const fslib::Path &root,
+                        const fs::SaveMetaData &saveMeta,
+                        sys::ProgressTask *task                = nullptr,
+                        fs::CompressionDictionary *dictionary = nullptr);
+
+            /// @brief Extracts every file and directory to dest.
+            /// @note This doesn't issue the final commit. Call fs::commit_journal once everything is written.
+            bool restore(const fslib::Path &dest, fs::JournalBudget &journal, sys::ProgressTask *task = nullptr);
+
+            /// @brief Decompresses every file and compares it against the CRC32 stored when it was compressed.
+            bool verify(sys::ProgressTask *task = nullptr);
+
+            /// @brief Returns the entry with the path passed or nullptr if the archive doesn't have it.
+            const BackupArchive::Entry *find_entry(std::string_view path) const;
+
+            /// @brief Decompresses up to size bytes from the beginning of the file entry passed.
+            /// @return Number of bytes read or -1 on failure.
+            ssize_t read_file(const BackupArchive::Entry &entry, sys::Byte *buffer, size_t size);
+
+            /// @brief Returns every file and directory in the order they were stored.
+            const std::vector<BackupArchive::Entry> &get_entries() const noexcept;
+
+            /// @brief Returns whether or not the archive has any files in it.
+            bool has_contents() const noexcept;
+
+            /// @brief Returns the save meta stored in the header.
+            const fs::SaveMetaData &get_meta() const noexcept;
+
+            /// @brief Adds the number of files and their total size to the ints passed.
+            void get_information(int64_t &fileCount, int64_t &totalSize) const noexcept;
+
+        private:
+            /// @brief Path of the archive.
+            fslib::Path m_path{};
+
+            /// @brief Archive file. Kept open for reading once the index is loaded.
+            fslib::File m_archiveFile{};
+
+            /// @brief Whether or not the archive is usable.
+            bool m_isOpen{};
+
+            /// @brief Meta data of the save the archive was made from.
+            fs::SaveMetaData m_saveMeta{};
+
+            /// @brief ID of the dictionary the archive was compressed with. 0 if there isn't one.
+            uint32_t m_dictionaryId{};
+
+            /// @brief Dictionary loaded from the folder the archive is in when it needs one.
+            fs::CompressionDictionary m_dictionary{};
+
+            /// @brief Files and directories in the order they were stored.
+            std::vector<BackupArchive::Entry> m_entries{};
+
+            /// @brief Maps paths to their index in m_entries.
+            std::unordered_map<std::string, size_t> m_lookup{};
+
+            /// @brief Reads the header and the index at the end of the archive.
+            bool read_index();
+
+            /// @brief Loads the dictionary the archive was compressed with from the folder it's in.
+            bool load_dictionary();
+
+            /// @brief Writes a single file back out from its frames.
+            bool restore_file(const fslib::Path &path,
+                              const BackupArchive::Entry &entry,
+                              fs::JournalBudget &journal,
+                              sys::Byte *buffer,
+                              sys::Byte *compressed,
+                              ZSTD_DCtx *context,
+                              sys::ProgressTask *task);
+    };
+}
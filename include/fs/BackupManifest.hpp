@@ -0,0 +1,104 @@
+#pragma once
+#include "fs/MiniUnzip.hpp"
+#include "fs/MiniZip.hpp"
+#include "fslib.hpp"
+#include "sys/sys.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <switch.h>
+#include <vector>
+
+namespace fs
+{
+    /// @brief Lists every file and directory in a backup along with the backup that actually holds the data.
+    /// @note Incremental backups only store what changed. Everything else is pulled from the backup the manifest points to.
+    class BackupManifest final
+    {
+        public:
+            /// @brief SHA-256 of a file's contents.
+            using Hash = std::array<uint8_t, SHA256_HASH_SIZE>;
+
+            /// @brief Index of the backup the manifest belongs to in the origin table.
+            static constexpr uint16_t ORIGIN_SELF = 0;
+
+            /// @brief Size recorded for directories.
+            static constexpr int64_t SIZE_DIRECTORY = -1;
+
+            /// @brief A single file or directory.
+            struct Entry
+            {
+                    std::string path{};
+                    int64_t size{};
+                    BackupManifest::Hash hash{};
+                    uint16_t origin{};
+            };
+
+            BackupManifest() = default;
+
+            /// @brief Walks the directory passed and hashes every file in it.
+            /// @param root Root of the tree. Usually the save root.
+            /// @param task Optional. Task to display progress with.
+            bool build(const fslib::Path &root, sys::ProgressTask *task = nullptr);
+
+            /// @brief Reads the manifest from the backup at the path passed. Works for both folders and ZIPs.
+            bool read(const fslib::Path &backup);
+
+            /// @brief Reads the manifest from an open ZIP.
+            bool read(fs::MiniUnzip &unzip);
+
+            /// @brief Writes the manifest into the backup folder passed.
+            bool write(const fslib::Path &backup) const;
+
+            /// @brief Writes the manifest to the ZIP passed.
+            bool write(fs::MiniZip &zip) const;
+
+            /// @brief Points every unchanged file at the backup that already holds it instead of storing it again.
+            /// @param parent Manifest of the previous backup.
+            /// @param parentName Name of the previous backup in the same folder.
+            /// @return Number of files that don't need to be stored.
+            size_t inherit_from(const BackupManifest &parent, std::string_view parentName);
+
+            /// @brief Returns whether or not any data is stored in another backup.
+            bool is_incremental() const noexcept;
+
+            /// @brief Returns whether or not the backup named is needed to restore this one.
+            bool references(std::string_view backupName) const noexcept;
+
+            /// @brief Returns the name of the backup the entry's data is stored in. Empty for this backup.
+            std::string_view get_origin(const BackupManifest::Entry &entry) const noexcept;
+
+            /// @brief Returns the entries in the manifest.
+            const std::vector<BackupManifest::Entry> &get_entries() const noexcept;
+
+            /// @brief Returns the combined size of the files stored in this backup.
+            int64_t get_stored_size() const noexcept;
+
+            /// @brief Returns the POSIX time the manifest was created at.
+            uint64_t get_timestamp() const noexcept;
+
+        private:
+            /// @brief Time the manifest was built.
+            uint64_t m_timestamp{};
+
+            /// @brief Names of the backups data is stored in. The first is always this backup.
+            std::vector<std::string> m_origins{};
+
+            /// @brief Files and directories.
+            std::vector<BackupManifest::Entry> m_entries{};
+
+            /// @brief Recursive function that walks and hashes the tree.
+            bool build_directory(const fslib::Path &root, std::string_view relative, sys::ProgressTask *task);
+
+            /// @brief Returns the index of the backup name passed in the origin table, adding it if needed.
+            uint16_t add_origin(std::string_view backupName);
+
+            /// @brief Serializes the manifest.
+            std::vector<sys::Byte> serialize() const;
+
+            /// @brief Parses a serialized manifest.
+            bool deserialize(const sys::Byte *buffer, size_t bufferSize);
+    };
+}
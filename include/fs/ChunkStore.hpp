@@ -0,0 +1,137 @@
+#pragma once
+#include "fslib.hpp"
+#include "sys/sys.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <switch.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fs
+{
+    /// @brief Name of the folder the chunk store is kept in inside of a title's backup folder.
+    inline constexpr std::string_view NAME_CHUNK_STORE = ".jksv_store";
+
+    /// @brief Content addressed storage for the chunks deduplicated backups are made of.
+    /// @note Every unique chunk is stored once, compressed, in a pack file. The index maps a chunk's SHA-256 to where it is.
+    class ChunkStore final
+    {
+        public:
+            /// @brief SHA-256 of a chunk's uncompressed data.
+            using Hash = std::array<uint8_t, SHA256_HASH_SIZE>;
+
+            /// @brief The hash is already uniformly distributed, so the first eight bytes are enough for buckets.
+            struct HashHasher
+            {
+                    size_t operator()(const ChunkStore::Hash &hash) const noexcept
+                    {
+                        uint64_t value{};
+                        std::memcpy(&value, hash.data(), sizeof(uint64_t));
+                        return value;
+                    }
+            };
+
+            /// @brief Set of chunk hashes.
+            using HashSet = std::unordered_set<ChunkStore::Hash, ChunkStore::HashHasher>;
+
+            /// @brief Largest chunk the store will accept.
+            static constexpr size_t SIZE_CHUNK_MAX = 0x40000;
+
+            /// @brief Opens or creates the store at the path passed.
+            ChunkStore(const fslib::Path &storePath);
+
+            /// @brief Flushes anything pending to the SD.
+            ~ChunkStore();
+
+            ChunkStore(const ChunkStore &)            = delete;
+            ChunkStore &operator=(const ChunkStore &) = delete;
+
+            /// @brief Returns whether or not the store was opened or created successfully.
+            bool is_open() const noexcept;
+
+            /// @brief Returns whether or not the chunk is already stored.
+            bool contains(const ChunkStore::Hash &hash) const;
+
+            /// @brief Stores a chunk if it isn't already.
+            /// @param hash Hash of the data.
+            /// @param data Chunk data.
+            /// @param dataSize Size of the chunk. Must not be larger than SIZE_CHUNK_MAX.
+            bool write_chunk(const ChunkStore::Hash &hash, const sys::Byte *data, size_t dataSize);
+
+            /// @brief Reads a chunk to the buffer passed.
+            /// @return Size of the chunk or -1 if it's missing or couldn't be read.
+            ssize_t read_chunk(const ChunkStore::Hash &hash, sys::Byte *buffer, size_t bufferSize);
+
+            /// @brief Closes the current pack and writes the index if it changed.
+            bool flush();
+
+            /// @brief Removes every chunk not in the set passed. Packs that are mostly dead are rewritten.
+            bool prune(const ChunkStore::HashSet &liveChunks);
+
+        private:
+            /// @brief Where a chunk is stored.
+            struct Location
+            {
+                    uint32_t pack{};
+                    uint64_t offset{};
+                    uint32_t storedSize{};
+                    uint32_t size{};
+            };
+
+            /// @brief Path of the store.
+            fslib::Path m_storePath{};
+
+            /// @brief Whether or not the store is usable.
+            bool m_isOpen{};
+
+            /// @brief Whether or not the index needs to be written.
+            bool m_indexDirty{};
+
+            /// @brief Compression level from config.
+            int m_level{};
+
+            /// @brief Chunk locations.
+            std::unordered_map<ChunkStore::Hash, ChunkStore::Location, ChunkStore::HashHasher> m_index{};
+
+            /// @brief ID the next pack created will use.
+            uint32_t m_nextPack{};
+
+            /// @brief Pack currently being written to.
+            fslib::File m_packFile{};
+            uint32_t m_packID{};
+            uint64_t m_packSize{};
+
+            /// @brief Pack currently open for reading.
+            fslib::File m_readFile{};
+            uint32_t m_readID{};
+
+            /// @brief Staging buffer for compressed chunks.
+            std::unique_ptr<sys::Byte[]> m_compressBuffer{};
+            size_t m_compressSize{};
+
+            /// @brief Loads the index.
+            bool read_index();
+
+            /// @brief Writes the index.
+            bool write_index();
+
+            /// @brief Makes sure new packs never reuse the ID of one already on the SD.
+            bool find_next_pack();
+
+            /// @brief Closes the current pack and starts a new one.
+            bool open_new_pack();
+
+            /// @brief Opens the pack passed for reading if it isn't already.
+            bool open_read_pack(uint32_t pack);
+
+            /// @brief Writes stored data to the current pack and records its location.
+            bool append_to_pack(const ChunkStore::Hash &hash, const sys::Byte *data, uint32_t storedSize, uint32_t size);
+
+            /// @brief Returns the path of the pack with the ID passed.
+            fslib::Path get_pack_path(uint32_t pack) const;
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "fslib.hpp"
+#include "sys/sys.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <zstd.h>
+
+namespace fs
+{
+    /// @brief Name of the folder dictionaries are kept in inside of a title's backup folder.
+    inline constexpr std::string_view NAME_DICTIONARY_DIR = ".jksv_dict";
+
+    /// @brief Extension used for dictionary files. They're named after the ID zstd gives the dictionary.
+    inline constexpr std::string_view EXTENSION_DICTIONARY = ".zdict";
+
+    /// @brief zstd dictionary trained on a title's backups.
+    /// @note Archives record the ID of the dictionary they were compressed with. Every dictionary is kept under its own ID so
+    /// older archives can always find the one they need.
+    class CompressionDictionary final
+    {
+        public:
+            CompressionDictionary() = default;
+
+            /// @brief Frees the digested dictionaries.
+            ~CompressionDictionary();
+
+            CompressionDictionary(const CompressionDictionary &)            = delete;
+            CompressionDictionary &operator=(const CompressionDictionary &) = delete;
+
+            /// @brief Loads the dictionary with the ID passed from the title folder passed.
+            bool load(const fslib::Path &titleDir, uint32_t id);
+
+            /// @brief Loads the first valid dictionary in the title folder passed.
+            bool load_any(const fslib::Path &titleDir);
+
+            /// @brief Trains a new dictionary from the title's existing backups and writes it to the title folder.
+            /// @param titleDir Title's backup folder.
+            /// @param task Optional. Task to display the status with.
+            bool train(const fslib::Path &titleDir, sys::ProgressTask *task = nullptr);
+
+            /// @brief Returns whether or not a dictionary is loaded.
+            bool is_loaded() const noexcept;
+
+            /// @brief Returns the ID of the dictionary. 0 if nothing is loaded.
+            uint32_t get_id() const noexcept;
+
+            /// @brief Returns the dictionary digested for compressing at the level passed or nullptr on failure.
+            const ZSTD_CDict *get_compression_dictionary(int level);
+
+            /// @brief Returns the dictionary digested for decompressing or nullptr on failure.
+            const ZSTD_DDict *get_decompression_dictionary();
+
+        private:
+            /// @brief Raw dictionary data.
+            std::vector<sys::Byte> m_data{};
+
+            /// @brief ID zstd stored in the dictionary.
+            uint32_t m_id{};
+
+            /// @brief Digested dictionaries. These are only created once they're needed.
+            ZSTD_CDict *m_compressionDict{};
+            int m_compressionLevel{};
+            ZSTD_DDict *m_decompressionDict{};
+
+            /// @brief Reads and checks the dictionary file at the path passed.
+            bool read_file(const fslib::Path &path);
+
+            /// @brief Frees the digested dictionaries and clears the data.
+            void clear();
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "fslib.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace fs
+{
+    /// @brief Enumerates a directory tree up front so it can be copied as one job instead of file by file.
+    class CopyPlan final
+    {
+        public:
+            /// @brief A single file in the plan.
+            struct Entry
+            {
+                    fslib::Path source{};
+                    fslib::Path destination{};
+                    int64_t size{};
+            };
+
+            CopyPlan() = default;
+
+            /// @brief Walks source and builds the plan for copying it to destination.
+            /// @note The save meta and manifest files are skipped like they are everywhere else.
+            CopyPlan(const fslib::Path &source, const fslib::Path &destination);
+
+            /// @brief Returns whether or not the whole tree was read successfully.
+            bool is_valid() const noexcept;
+
+            /// @brief Orders the files from largest to smallest so big files start first and small ones fill the gaps.
+            void sort_largest_first();
+
+            /// @brief Creates every directory in the plan under the destination. Parents are always created first.
+            bool create_directories() const;
+
+            /// @brief Returns the directories in the order they were found.
+            const std::vector<fslib::Path> &get_directories() const noexcept;
+
+            /// @brief Returns the files in the plan.
+            const std::vector<CopyPlan::Entry> &get_files() const noexcept;
+
+            /// @brief Returns the combined size of every file in the plan.
+            int64_t get_total_size() const noexcept;
+
+            /// @brief Returns the number of files in the plan.
+            int64_t get_file_count() const noexcept;
+
+        private:
+            /// @brief Whether or not enumeration succeeded.
+            bool m_isValid{};
+
+            /// @brief Destination directories to create.
+            std::vector<fslib::Path> m_directories{};
+
+            /// @brief Files to copy.
+            std::vector<CopyPlan::Entry> m_files{};
+
+            /// @brief Total size of the files.
+            int64_t m_totalSize{};
+
+            /// @brief Recursive function that walks the tree.
+            bool enumerate(const fslib::Path &source, const fslib::Path &destination);
+    };
+}
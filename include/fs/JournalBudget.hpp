@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace fs
+{
+    /// @brief Tracks how much of a save's journal a restore has used so commits only happen when it's about to run out.
+    class JournalBudget final
+    {
+        public:
+            /// @brief Creates a new budget.
+            /// @param device Device to commit to.
+            /// @param journalSize Size of the save's journal. If this is 0 or less, the size is unknown and every file is
+            /// committed on its own instead.
+            JournalBudget(std::string_view device, int64_t journalSize);
+
+            /// @brief Returns whether or not commits are needed at all. The SD card is the only device that doesn't need them.
+            bool is_enabled() const noexcept;
+
+            /// @brief Returns whether writing size bytes would overrun what's left of the journal. This is used to split
+            /// files and is always false when the journal size is unknown.
+            bool needs_commit(int64_t size) const noexcept;
+
+            /// @brief Returns whether a commit should be issued before starting a file or entry that costs entryCost.
+            bool needs_commit_before(int64_t entryCost) const noexcept;
+
+            /// @brief Returns whether size bytes would fit in an empty journal.
+            bool fits_in_journal(int64_t size) const noexcept;
+
+            /// @brief Records size bytes of file data as written.
+            void consume(int64_t size) noexcept;
+
+            /// @brief Records the journal cost of creating a file or directory.
+            void consume_entry() noexcept;
+
+            /// @brief Commits the device and resets the usage.
+            /// @return True on success or if the device doesn't need commits.
+            bool commit();
+
+            /// @brief Returns the number of commits issued.
+            int get_commit_count() const noexcept;
+
+            /// @brief Returns the size of the journal entry overhead used for file and directory creation.
+            static constexpr int64_t get_entry_cost() noexcept { return SIZE_BLOCK; }
+
+        private:
+            /// @brief Save data is journaled in blocks of this size.
+            static constexpr int64_t SIZE_BLOCK = 0x4000;
+
+            /// @brief Device to commit.
+            std::string m_device{};
+
+            /// @brief Whether or not the device needs to be committed.
+            bool m_isEnabled{};
+
+            /// @brief Usable space in the journal after leaving a safety margin. 0 if the journal size is unknown.
+            int64_t m_budget{};
+
+            /// @brief Space used since the last commit.
+            int64_t m_used{};
+
+            /// @brief Number of commits issued.
+            int m_commitCount{};
+    };
+}
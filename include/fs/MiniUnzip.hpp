@@ -1,6 +1,7 @@
 #pragma once
 #include "fslib.hpp"
 
+#include <ctime>
 #include <minizip/unzip.h>
 #include <string_view>
 
@@ -38,12 +39,24 @@ namespace fs
             /// @brief Resets to the beginning file.
             bool reset();
 
+            /// @brief Goes to the next entry without opening it. Only the central directory is read.
+            bool next_entry();
+
+            /// @brief Gets the position of the current entry in the central directory.
+            bool get_position(unz64_file_pos &position);
+
+            /// @brief Jumps straight to the entry at the position passed and opens it.
+            bool go_to_position(const unz64_file_pos &position);
+
             /// @brief Reads from the currently open file to the buffer passed.
             ssize_t read(void *buffer, size_t bufferSize);
 
             /// @brief Returns if the entry is just a directory.
             bool is_directory() const noexcept;
 
+            /// @brief Returns the path of the ZIP so other threads can open their own handles to it.
+            const fslib::Path &get_path() const noexcept;
+
             /// @brief Returns the name of the current file.
             const char *get_filename() const noexcept;
 
@@ -53,7 +66,16 @@ namespace fs
             /// @brief Returns the uncompressed size of the the currently open file.
             uint64_t get_uncompressed_size() const noexcept;
 
+            /// @brief Returns the CRC32 recorded for the current file when it was written.
+            uint32_t get_crc() const noexcept;
+
+            /// @brief Returns the modification time recorded for the current file.
+            std::time_t get_modified_time() const noexcept;
+
         private:
+            /// @brief Path of the ZIP.
+            fslib::Path m_path{};
+
             /// @brief Underlying unzFile.
             unzFile m_unz{};
 
@@ -1,7 +1,10 @@
 #pragma once
+#include "fs/ZipPipe.hpp"
 #include "fslib.hpp"
 
+#include <cstdint>
 #include <minizip/zip.h>
+#include <string>
 #include <string_view>
 
 namespace fs
@@ -15,6 +18,11 @@ namespace fs
             /// @param path
             MiniZip(const fslib::Path &path);
 
+            /// @brief Constructor. Opens the ZIP as a stream into the pipe passed.
+            /// @param pipe Pipe to write the ZIP to.
+            /// @param localPath Optional. The ZIP is also written here.
+            MiniZip(fs::ZipPipe &pipe, const fslib::Path &localPath = {});
+
             /// @brief Closes the zipFile.
             ~MiniZip();
 
@@ -25,6 +33,12 @@ namespace fs
             /// @brief Opens a Zip file at path
             bool open(const fslib::Path &path);
 
+            /// @brief Opens a ZIP that's streamed into pipe as it's written. Each entry is released to the pipe once the next
+            /// one is opened and the rest when the ZIP is closed.
+            /// @param pipe Pipe to write the ZIP to. The pipe is closed as failed if the ZIP can't be opened.
+            /// @param localPath Optional. The ZIP is also written here.
+            bool open(fs::ZipPipe &pipe, const fslib::Path &localPath = {});
+
             /// @brief Manual call for closing the zipFile.
             void close();
 
@@ -35,12 +49,45 @@ namespace fs
             /// @brief Opens a new file with filename as the path.
             bool open_new_file(std::string_view filename, bool trimPath = false, size_t trimPlaces = 0);
 
+            /// @brief Opens a new file that's stored as is instead of being deflated.
+            /// @note For data that won't get any smaller, like saves that are already compressed or encrypted.
+            bool open_new_stored_file(std::string_view filename);
+
             /// @brief Closes the currently open file in the Zip.
             bool close_current_file();
 
             /// @brief Attempts to write the buffer passed to the currently opened file.
             bool write(const void *buffer, size_t dataSize);
 
+            /// @brief Opens a new file that takes raw deflate data through write instead of uncompressed data.
+            /// @param filename Path of the file. Trimmed the same way as open_new_file.
+            /// @param uncompressedSize Size of the file before it's compressed. Only used to decide whether ZIP64 is needed.
+            /// @param stored Optional. The data written is the file as is instead of deflate data.
+            /// @note This allows one entry to be deflated in pieces elsewhere and written as it comes in.
+            bool open_new_raw_file(std::string_view filename, uint64_t uncompressedSize, bool stored = false);
+
+            /// @brief Closes a file opened with open_new_raw_file.
+            /// @param uncompressedSize Size of the file before it was compressed.
+            /// @param crc CRC32 of the uncompressed data.
+            bool close_raw_file(uint64_t uncompressedSize, uint32_t crc);
+
+            /// @brief Adds a file whose data was already compressed to a raw deflate stream elsewhere.
+            /// @param filename Path of the file. Trimmed the same way as open_new_file.
+            /// @param data Raw deflate data.
+            /// @param dataSize Size of the deflate data.
+            /// @param uncompressedSize Size of the file before it was compressed.
+            /// @param crc CRC32 of the uncompressed data.
+            /// @param stored Optional. data is the file as is instead of deflate data.
+            bool add_raw_file(std::string_view filename,
+                              const void *data,
+                              size_t dataSize,
+                              uint64_t uncompressedSize,
+                              uint32_t crc,
+                              bool stored = false);
+
+            /// @brief Returns the compression level the ZIP was opened with.
+            int get_level() const noexcept;
+
         private:
             /// @brief Stores whether or not the zipFile was opened successfully.
             bool m_isOpen{};
@@ -50,5 +97,16 @@ namespace fs
 
             /// @brief Underlying ZIP file.
             zipFile m_zip{};
+
+            /// @brief Pipe the ZIP is streamed to if it was opened with one.
+            fs::ZipPipe *m_pipe{};
+
+            /// @brief Path of the ZIP and how many files were deflated or stored. Logged when the ZIP is closed.
+            std::string m_path{};
+            int m_deflatedCount{};
+            int m_storedCount{};
+
+            /// @brief Opens a new entry in the ZIP. Shared by the open functions above.
+            bool open_entry(std::string_view filename, int method, int level, bool raw, uint64_t uncompressedSize);
     };
 }
@@ -33,6 +33,9 @@ namespace fs
     /// @brief This is the filename used for the save data meta info.
     inline constexpr std::string_view NAME_SAVE_META = ".nx_save_meta.bin";
 
+    /// @brief This is the filename used for the file manifest written next to the meta for incremental backups.
+    inline constexpr std::string_view NAME_SAVE_MANIFEST = ".nx_save_manifest.bin";
+
     inline constexpr ssize_t SIZE_SAVE_META = sizeof(fs::SaveMetaData);
 
     /// @brief Didn't feel like a whole new file just for this. Fills an fs::SaveMetaData struct.
@@ -0,0 +1,98 @@
+#pragma once
+#include "fs/ChunkStore.hpp"
+#include "fs/JournalBudget.hpp"
+#include "fs/SaveMetaData.hpp"
+#include "fslib.hpp"
+#include "sys/sys.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs
+{
+    /// @brief Extension used for deduplicated backups.
+    inline constexpr std::string_view EXTENSION_SNAPSHOT = ".jksv";
+
+    /// @brief Index of a deduplicated backup. Lists every file in the save and the chunks it's made of.
+    class Snapshot final
+    {
+        public:
+            /// @brief Size recorded for directories.
+            static constexpr int64_t SIZE_DIRECTORY = -1;
+
+            /// @brief A single file or directory.
+            struct Entry
+            {
+                    std::string path{};
+                    int64_t size{};
+                    std::vector<fs::ChunkStore::Hash> chunks{};
+            };
+
+            Snapshot() = default;
+
+            /// @brief Creates a snapshot with the save meta passed.
+            Snapshot(const fs::SaveMetaData &saveMeta);
+
+            /// @brief Splits every file under root into chunks and stores the ones the store doesn't have yet.
+            /// @param root Root of the tree. Usually the save root.
+            /// @param store Store to write chunks to.
+            /// @param task Optional. Task to display progress with.
+            bool build(const fslib::Path &root, fs::ChunkStore &store, sys::ProgressTask *task = nullptr);
+
+            /// @brief Rebuilds the tree under dest from the chunks in the store.
+            /// @note This doesn't issue the final commit. Call fs::commit_journal once everything is written.
+            bool restore(const fslib::Path &dest,
+                         fs::ChunkStore &store,
+                         fs::JournalBudget &journal,
+                         sys::ProgressTask *task = nullptr);
+
+            /// @brief Reads the snapshot at the path passed.
+            bool read(const fslib::Path &path);
+
+            /// @brief Writes the snapshot to the path passed.
+            bool write(const fslib::Path &path) const;
+
+            /// @brief Adds every chunk the snapshot needs to the set passed.
+            void collect_chunks(fs::ChunkStore::HashSet &chunks) const;
+
+            /// @brief Returns the save meta stored with the snapshot.
+            const fs::SaveMetaData &get_meta() const noexcept;
+
+            /// @brief Adds the number of files and their total size to the ints passed.
+            void get_information(int64_t &fileCount, int64_t &totalSize) const noexcept;
+
+        private:
+            /// @brief Time the snapshot was created.
+            uint64_t m_timestamp{};
+
+            /// @brief Meta data of the save the snapshot was made from.
+            fs::SaveMetaData m_saveMeta{};
+
+            /// @brief Files and directories.
+            std::vector<Snapshot::Entry> m_entries{};
+
+            /// @brief Recursive function that walks the tree.
+            bool build_directory(const fslib::Path &root,
+                                 std::string_view relative,
+                                 fs::ChunkStore &store,
+                                 sys::Byte *window,
+                                 sys::ProgressTask *task);
+
+            /// @brief Chunks and stores a single file.
+            bool build_file(const fslib::Path &path,
+                            Snapshot::Entry &entry,
+                            fs::ChunkStore &store,
+                            sys::Byte *window,
+                            sys::ProgressTask *task);
+
+            /// @brief Writes a single file back out from its chunks.
+            bool restore_file(const fslib::Path &path,
+                              const Snapshot::Entry &entry,
+                              fs::ChunkStore &store,
+                              fs::JournalBudget &journal,
+                              sys::Byte *buffer,
+                              sys::ProgressTask *task);
+    };
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "fs/MiniUnzip.hpp"
+#include "fslib.hpp"
+
+#include <cstdint>
+#include <ctime>
+#include <minizip/unzip.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs
+{
+    /// @brief Read-only index of a ZIP's central directory. This allows the ZIP to be browsed like a directory and any entry
+    /// to be jumped to without scanning the whole ZIP.
+    class ZipIndex final
+    {
+        public:
+            /// @brief A single file or directory.
+            struct Entry
+            {
+                    std::string path{};
+                    std::string name{};
+                    int64_t size{};
+                    std::time_t modified{};
+                    bool isDirectory{};
+                    unz64_file_pos position{};
+            };
+
+            ZipIndex() = default;
+
+            /// @brief Indexes the ZIP at the path passed.
+            ZipIndex(const fslib::Path &path);
+
+            /// @brief Walks the central directory of the ZIP at the path passed and indexes every entry.
+            bool open(const fslib::Path &path);
+
+            /// @brief Returns whether or not the ZIP was indexed successfully.
+            bool is_open() const noexcept;
+
+            /// @brief Returns the path of the ZIP.
+            const fslib::Path &get_path() const noexcept;
+
+            /// @brief Returns the indexes of the entries in the directory passed or nullptr if it doesn't exist.
+            /// @param directory Directory inside of the ZIP. An empty string is the root.
+            const std::vector<size_t> *get_directory(const std::string &directory) const;
+
+            /// @brief Returns the entry at index.
+            const ZipIndex::Entry &get_entry(size_t index) const;
+
+            /// @brief Returns the entry with the path passed or nullptr if the ZIP doesn't have it.
+            const ZipIndex::Entry *find_entry(const std::string &path) const;
+
+            /// @brief Adds the number of directories, files, and their total size under directory to the ints passed.
+            void get_information(const std::string &directory,
+                                 int64_t &subDirCount,
+                                 int64_t &fileCount,
+                                 int64_t &totalSize) const;
+
+        private:
+            /// @brief Path of the ZIP.
+            fslib::Path m_path{};
+
+            /// @brief Whether or not the ZIP was indexed.
+            bool m_isOpen{};
+
+            /// @brief Every entry in the order they were found.
+            std::vector<ZipIndex::Entry> m_entries{};
+
+            /// @brief Maps paths to their index in m_entries.
+            std::unordered_map<std::string, size_t> m_lookup{};
+
+            /// @brief Maps directories to the entries directly inside of them.
+            std::unordered_map<std::string, std::vector<size_t>> m_directories{};
+
+            /// @brief Adds the current entry of unzip to the index.
+            void add_current_entry(fs::MiniUnzip &unzip);
+
+            /// @brief Adds an entry and any parent directories the ZIP doesn't list on its own.
+            size_t add_entry(const std::string &path, bool isDirectory);
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "sys/defines.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+namespace fs
+{
+    /// @brief Bounded pipe for a ZIP that's being read while it's still being written, like an upload or a download.
+    /// @note minizip goes back and patches the local header of every entry once it's closed, so everything from the start of
+    /// the open entry is held until MiniZip releases it. Only released data can be read. The writer blocks once the released
+    /// data that hasn't been read yet reaches the window size, so the pipe only grows past it by the size of one entry. The
+    /// whole capacity is reserved from the buffer budget up front and the pipe never grows past it. A pipe that couldn't get
+    /// its reservation fails every write, so has_reservation needs to be checked before it's used.
+    class ZipPipe final
+    {
+        public:
+            /// @brief Default window size.
+            static constexpr size_t SIZE_DEFAULT_WINDOW = 0x400000;
+
+            /// @brief Creates a new ZipPipe.
+            /// @param windowSize Maximum amount of released data waiting to be read before the writer blocks.
+            /// @param entrySize Largest entry the writer will hold open before releasing it. 0 for writers that only append.
+            ZipPipe(size_t windowSize = SIZE_DEFAULT_WINDOW, size_t entrySize = 0);
+
+            /// @brief Returns the pipe's capacity to the buffer budget.
+            ~ZipPipe();
+
+            ZipPipe(const ZipPipe &)            = delete;
+            ZipPipe &operator=(const ZipPipe &) = delete;
+
+            /// @brief Writer. Writes data at the offset passed. Blocks while the window is full.
+            /// @return False if the reader aborted or the offset was already released.
+            bool write(int64_t offset, const void *buffer, size_t size);
+
+            /// @brief Writer. Marks everything written so far as final so the reader can have it.
+            void release();
+
+            /// @brief Writer. Writes data to the end of the stream and releases it right away. For writers that never go back,
+            /// like downloads.
+            bool append(const void *buffer, size_t size);
+
+            /// @brief Writer. Ends the stream. Passing false marks it as failed.
+            void close(bool success = true);
+
+            /// @brief Reader. Blocks until released data is available and copies up to size bytes of it to buffer.
+            /// @return Number of bytes read. 0 at the end of the stream. -1 if the writer failed.
+            ssize_t read(void *buffer, size_t size);
+
+            /// @brief Reader. Gives up on the stream. Any writes after this fail.
+            void abort();
+
+            /// @brief Returns whether the writer failed or the reader aborted.
+            bool has_failed();
+
+            /// @brief Returns whether or not the pipe's capacity was reserved from the buffer budget.
+            bool has_reservation() const noexcept;
+
+        private:
+            /// @brief Maximum amount of released data that can wait to be read.
+            size_t m_windowSize{};
+
+            /// @brief Most the pipe can ever hold and whether or not it was reserved from the budget.
+            size_t m_capacity{};
+            bool m_isReserved{};
+
+            /// @brief Data that hasn't been read yet and the offset in the ZIP it starts at.
+            std::vector<sys::Byte> m_data{};
+            int64_t m_dataOffset{};
+
+            /// @brief Everything before this offset is final.
+            int64_t m_released{};
+
+            /// @brief Offset the reader is at.
+            int64_t m_readOffset{};
+
+            /// @brief State of the stream.
+            bool m_closed{};
+            bool m_failed{};
+
+            /// @brief Mutex and conditions for both sides.
+            std::mutex m_pipeMutex{};
+            std::condition_variable m_releasedCondition{};
+            std::condition_variable m_readCondition{};
+    };
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "fs/ZipPipe.hpp"
+#include "sys/defines.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <zlib.h>
+
+namespace fs
+{
+    /// @brief Reads a ZIP front to back from a ZipPipe using only the local headers. This allows a ZIP to be extracted while
+    /// it's still being downloaded.
+    /// @note Every entry is checked against its CRC and sizes as it's read. A ZIP that's cut short or damaged fails instead
+    /// of producing bad data. Encrypted entries and anything other than stored or deflated aren't supported.
+    class ZipStreamReader final
+    {
+        public:
+            /// @brief Creates a reader for the pipe passed.
+            ZipStreamReader(fs::ZipPipe &pipe);
+
+            /// @brief Frees the inflate stream.
+            ~ZipStreamReader();
+
+            ZipStreamReader(const ZipStreamReader &)            = delete;
+            ZipStreamReader &operator=(const ZipStreamReader &) = delete;
+
+            /// @brief Skips whatever is left of the current entry and moves to the next one.
+            /// @return False at the end of the ZIP or on failure. is_finished and has_failed tell them apart.
+            bool next_entry();
+
+            /// @brief Reads up to size bytes of the current entry's data.
+            /// @return Number of bytes read. 0 once the entry is finished and its CRC matched. -1 on failure.
+            ssize_t read(void *buffer, size_t size);
+
+            /// @brief Returns the name of the current entry.
+            const std::string &get_filename() const noexcept;
+
+            /// @brief Returns whether or not the current entry is a directory.
+            bool is_directory() const noexcept;
+
+            /// @brief Returns the uncompressed size of the current entry. This is 0 for entries with a data descriptor.
+            uint64_t get_uncompressed_size() const noexcept;
+
+            /// @brief Returns whether the size of the current entry is known before its data is read.
+            bool is_size_known() const noexcept;
+
+            /// @brief Returns whether the central directory was reached and the rest of the ZIP arrived intact.
+            bool is_finished() const noexcept;
+
+            /// @brief Returns whether the ZIP was damaged, unsupported, or the pipe failed.
+            bool has_failed() const noexcept;
+
+        private:
+            /// @brief Pipe the ZIP is read from.
+            fs::ZipPipe &m_pipe;
+
+            /// @brief Buffer data is read from the pipe into. Anything inflate doesn't use stays here for the next header.
+            std::unique_ptr<sys::Byte[]> m_buffer{};
+            size_t m_bufferOffset{};
+            size_t m_bufferLength{};
+
+            /// @brief Inflate stream used for deflated entries.
+            z_stream m_stream{};
+            bool m_streamInitialized{};
+
+            /// @brief Information from the current entry's local header.
+            std::string m_filename{};
+            uint16_t m_flags{};
+            uint16_t m_method{};
+            uint32_t m_crc{};
+            uint64_t m_compressedSize{};
+            uint64_t m_uncompressedSize{};
+            bool m_isZip64{};
+
+            /// @brief Progress through the current entry.
+            uint32_t m_runningCrc{};
+            uint64_t m_compressedRead{};
+            uint64_t m_uncompressedRead{};
+            bool m_entryOpen{};
+            bool m_entryFinished{};
+
+            /// @brief State of the whole ZIP.
+            bool m_finished{};
+            bool m_failed{};
+
+            /// @brief Parses the local header after its signature was read.
+            bool read_local_header();
+
+            /// @brief Reads the data descriptor if there is one and checks the entry against what was read.
+            bool finish_entry();
+
+            /// @brief Marks the reader as failed and logs why.
+            bool fail(const char *reason);
+
+            /// @brief Returns whether the entry's sizes come after its data instead of in its header.
+            bool has_data_descriptor() const noexcept;
+
+            /// @brief Moves what's left in the buffer to the front and reads more from the pipe.
+            /// @return False if the pipe has nothing left.
+            bool fill_buffer();
+
+            /// @brief Reads exactly size bytes through the buffer.
+            bool read_exact(void *buffer, size_t size);
+
+            /// @brief Reads everything left in the pipe once the central directory is reached.
+            bool drain_pipe();
+    };
+}
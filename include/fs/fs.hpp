@@ -1,10 +1,21 @@
 #pragma once
+#include "fs/BackupArchive.hpp"
+#include "fs/BackupManifest.hpp"
+#include "fs/ChunkStore.hpp"
+#include "fs/CompressionDictionary.hpp"
+#include "fs/CopyPlan.hpp"
+#include "fs/JournalBudget.hpp"
 #include "fs/MiniUnzip.hpp"
 #include "fs/MiniZip.hpp"
 #include "fs/SaveMetaData.hpp"
 #include "fs/ScopedSaveMount.hpp"
+#include "fs/Snapshot.hpp"
+#include "fs/ZipIndex.hpp"
+#include "fs/ZipPipe.hpp"
+#include "fs/ZipStreamReader.hpp"
 #include "fs/directory_functions.hpp"
 #include "fs/io.hpp"
 #include "fs/save_data_functions.hpp"
 #include "fs/save_mount.hpp"
+#include "fs/verify.hpp"
 #include "fs/zip.hpp"
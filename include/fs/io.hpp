@@ -1,4 +1,5 @@
 #pragma once
+#include "fs/JournalBudget.hpp"
 #include "fslib.hpp"
 #include "sys/sys.hpp"
 
@@ -6,6 +7,9 @@
 
 namespace fs
 {
+    /// @brief Files this size or smaller are read in a single call and written straight through on the calling thread.
+    inline constexpr int64_t SIZE_SMALL_FILE = 0x40000;
+
     /// @brief Copies source to destination.
     /// @param source Path to source file.
     /// @param destination Path to destination.
@@ -22,6 +26,14 @@ namespace fs
                           int64_t journalSize,
                           sys::ProgressTask *task = nullptr);
 
+    /// @brief Same as above, but the journal usage is tracked across every file written with the budget passed.
+    /// @param journal Journal budget shared by the whole restore.
+    /// @note This doesn't issue the final commit. Call fs::commit_journal once everything is written.
+    void copy_file_commit(const fslib::Path &source,
+                          const fslib::Path &destination,
+                          fs::JournalBudget &journal,
+                          sys::ProgressTask *task = nullptr);
+
     /// @brief Recursively copies source to destination.
     /// @param source Source path.
     /// @param destination Destination path.
@@ -38,4 +50,20 @@ namespace fs
                                int64_t journalSize,
                                sys::ProgressTask *task = nullptr);
 
+    /// @brief Same as above using a journal budget shared by the whole restore.
+    /// @note This doesn't issue the final commit. Call fs::commit_journal once everything is written.
+    void copy_directory_commit(const fslib::Path &source,
+                               const fslib::Path &destination,
+                               fs::JournalBudget &journal,
+                               sys::ProgressTask *task = nullptr);
+
+    /// @brief Issues the final commit for a restore and logs how many commits it took.
+    void commit_journal(fs::JournalBudget &journal);
+
+    /// @brief Returns the chunk size calibrated for the device passed. The SD is tuned separately from system storage, which
+    /// covers save data and the BIS partitions.
+    size_t get_device_chunk_size(std::string_view device);
+
+    /// @brief Returns the number of chunks shared between the read and write threads.
+    int get_queue_depth();
 } // namespace fs
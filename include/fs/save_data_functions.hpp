@@ -43,4 +43,12 @@ namespace fs
     /// @param extraOut Reference to the FsSaveDataExtraData to read to.
     /// @return True on success. False on failure.
     bool read_save_extra_data(const FsSaveDataInfo *saveInfo, FsSaveDataExtraData &extraOut) noexcept;
+
+    /// @brief Mounts the save passed and gets the number of files and total size of everything in it.
+    /// @param saveInfo Save to get the information of.
+    /// @param fileCount Int64_t to add the number of files to.
+    /// @param totalSize Int64_t to add the size of everything to.
+    /// @return True on success. False on failure.
+    /// @note This uses the default save mount, so it can't be called while a save is already mounted there.
+    bool get_save_data_information(const FsSaveDataInfo *saveInfo, int64_t &fileCount, int64_t &totalSize);
 } // namespace fs
@@ -0,0 +1,32 @@
+#pragma once
+#include "fslib.hpp"
+#include "sys/sys.hpp"
+
+#include <cstdint>
+
+namespace fs
+{
+    /// @brief Reads the file at path back and compares it against the size and CRC32 of the data that was written to it.
+    /// @param path Path of the file to check.
+    /// @param size Size the file should be.
+    /// @param crc CRC32 of the data that was written.
+    /// @param buffer Buffer to read with.
+    /// @param bufferSize Size of the buffer.
+    /// @param task Optional. Task to report a mismatch to.
+    /// @return True if the file matches.
+    bool verify_file(const fslib::Path &path,
+                     int64_t size,
+                     uint32_t crc,
+                     sys::Byte *buffer,
+                     size_t bufferSize,
+                     sys::ProgressTask *task = nullptr);
+
+    /// @brief Same as above, but allocates its own buffer.
+    bool verify_file(const fslib::Path &path, int64_t size, uint32_t crc, sys::ProgressTask *task = nullptr);
+
+    /// @brief Reads every entry in the ZIP back. minizip checks each against the CRC32 it stored while writing.
+    /// @param zipPath Path of the ZIP to check. This needs to be closed first.
+    /// @param task Optional. Task to display progress and report mismatches with.
+    /// @return True if every entry matches.
+    bool verify_zip(const fslib::Path &zipPath, sys::ProgressTask *task = nullptr);
+} // namespace fs
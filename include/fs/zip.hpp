@@ -2,6 +2,7 @@
 // Major to do: Stop using minizip and finish the ZipFile class.
 #include "fs/MiniUnzip.hpp"
 #include "fs/MiniZip.hpp"
+#include "fs/ZipStreamReader.hpp"
 #include "fs/fs.hpp"
 #include "fslib.hpp"
 
@@ -13,6 +14,10 @@ namespace fs
     /// @note Task is optional.
     void copy_directory_to_zip(const fslib::Path &source, fs::MiniZip &dest, sys::ProgressTask *Task = nullptr);
 
+    /// @brief Adds a single file to the ZIP. The device is trimmed from the path to get the name inside the ZIP.
+    /// @note Task is optional.
+    bool copy_file_to_zip(const fslib::Path &source, fs::MiniZip &dest, sys::ProgressTask *Task = nullptr);
+
     /// @brief Unzips source to destination.
     /// @note Task is optional.
     void copy_zip_to_directory(fs::MiniUnzip &source,
@@ -20,6 +25,31 @@ namespace fs
                                int64_t journalSize,
                                sys::ProgressTask *Task = nullptr);
 
+    /// @brief Same as above using a journal budget shared by the whole restore.
+    /// @note This doesn't issue the final commit. Call fs::commit_journal once everything is written.
+    void copy_zip_to_directory(fs::MiniUnzip &source,
+                               const fslib::Path &dest,
+                               fs::JournalBudget &journal,
+                               sys::ProgressTask *Task = nullptr);
+
+    /// @brief Extracts a ZIP as it streams in, starting with the entry source is on.
+    /// @param journal Budget the whole stream has to fit in. This never commits, so the caller can throw everything away if
+    /// the stream turns out to be damaged.
+    /// @param fitsOut Set to false if extracting stopped because the stream wouldn't fit in the journal without a commit.
+    /// @return True if every entry was extracted and the whole ZIP arrived intact.
+    bool copy_zip_stream_to_directory(fs::ZipStreamReader &source,
+                                      const fslib::Path &dest,
+                                      fs::JournalBudget &journal,
+                                      bool &fitsOut,
+                                      sys::ProgressTask *Task = nullptr);
+
+    /// @brief Extracts the entry currently open in source to dest using the journal budget passed.
+    /// @note The parent directory of dest needs to exist already.
+    bool copy_zip_file_commit(fs::MiniUnzip &source,
+                              const fslib::Path &dest,
+                              fs::JournalBudget &journal,
+                              sys::ProgressTask *Task = nullptr);
+
     /// @brief Returns whether or not zip has files inside besides the save meta.
     bool zip_has_contents(const fslib::Path &zipPath);
 } // namespace fs
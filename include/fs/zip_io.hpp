@@ -0,0 +1,13 @@
+#pragma once
+#include "fs/ZipPipe.hpp"
+
+#include <minizip/ioapi.h>
+
+namespace fs
+{
+    /// @brief Returns the file functions MiniZip and MiniUnzip open ZIPs with. These go through fslib with large
+    /// write-behind and read-ahead buffers instead of stdio, so minizip's small header writes and reads are batched.
+    /// @param pipe Optional. Everything written is also sent to the pipe. The file name passed to minizip can be empty to
+    /// only write to the pipe.
+    zlib_filefunc64_def get_zip_file_functions(fs::ZipPipe *pipe = nullptr);
+}
@@ -20,11 +20,24 @@ namespace remote
             /// @param source Path to upload the file from.
             bool upload_file(const fslib::Path &source, std::string_view name, sys::ProgressTask *task = nullptr) override;
 
+            /// @brief Creates an upload session for source and queues the upload itself on engine.
+            bool queue_upload(curl::TransferEngine &engine,
+                              const fslib::Path &source,
+                              std::string_view name,
+                              sys::ProgressTask *task            = nullptr,
+                              Storage::UploadCallback onFinished = {}) override;
+
             /// @brief Patches or updates the file on Google Drive.
             /// @param file Pointer to the item containing the data needed to update the file.
             /// @param source Source path to update from.
             bool patch_file(remote::Item *file, const fslib::Path &source, sys::ProgressTask *task = nullptr) override;
 
+            /// @brief Uploads a ZIP to the remote while it's still being written to pipe.
+            bool upload_stream(fs::ZipPipe &pipe, std::string_view name) override;
+
+            /// @brief Updates file on the remote with a ZIP that's still being written to pipe.
+            bool patch_stream(remote::Item *file, fs::ZipPipe &pipe) override;
+
             /// @brief Downloads a file from Google Drive.
             /// @param file Pointer to the item containing data to download the file.
             /// @param destination Location to write the downloaded file to.
@@ -32,6 +45,9 @@ namespace remote
                                const fslib::Path &destination,
                                sys::ProgressTask *task = nullptr) override;
 
+            /// @brief Downloads file into pipe so it can be read while it downloads.
+            bool download_stream(const remote::Item *file, fs::ZipPipe &pipe, sys::ProgressTask *task = nullptr) override;
+
             /// @brief Deletes an item from Google Drive.
             /// @param item Pointer to item containing data to delete the item.
             bool delete_item(const remote::Item *item) override;
@@ -41,6 +57,9 @@ namespace remote
             /// @param newName New name of the item.
             bool rename_item(remote::Item *item, std::string_view newName) override;
 
+            /// @brief Connects to the API ahead of time.
+            void preconnect() override;
+
             /// @brief Returns whether or not a sign in is required to use drive. AKA the refresh token is missing.
             bool sign_in_required() const;
 
@@ -96,5 +115,26 @@ namespace remote
             /// @param log Whether or not to log the error.
             /// @note This doesn't catch every error. Google's errors aren't consistent.
             bool error_occurred(json::Object &json, bool log = true) noexcept;
+
+            /// @brief Starts a resumable upload of a new file named name in the current parent.
+            /// @param locationOut String to write the location to upload the data to.
+            bool create_upload_session(std::string_view name, std::string &locationOut);
+
+            /// @brief Starts a resumable upload that replaces the data of file.
+            /// @param locationOut String to write the location to upload the data to.
+            bool create_patch_session(const remote::Item *file, std::string &locationOut);
+
+            /// @brief Uploads the file or pipe in uploadData to the session location passed.
+            /// @param response Optional. String to write the response to.
+            bool send_to_session(const std::string &location, curl::UploadStruct &uploadData, std::string *response);
+
+            /// @brief Uploads to a session created by create_upload_session and adds the new file to the list.
+            /// @param size Size of the file uploaded. Ignored for pipes.
+            bool upload_to_session(const std::string &location, curl::UploadStruct &uploadData, int64_t size);
+
+            /// @brief Parses the response to a finished upload and adds the new file to the list.
+            /// @param parent ID of the directory the file was uploaded to.
+            /// @param size Size of the file uploaded.
+            bool add_uploaded_file(const std::string &response, std::string_view parent, int64_t size);
     };
 } // namespace remote
@@ -1,10 +1,13 @@
 #pragma once
+#include "curl/TransferEngine.hpp"
 #include "curl/curl.hpp"
+#include "fs/ZipPipe.hpp"
 #include "fslib.hpp"
 #include "remote/Item.hpp"
 #include "sys/sys.hpp"
 
 #include <ctime>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -19,6 +22,9 @@ namespace remote
             /// @brief This makes writing some stuff for these classes way easier.
             using List = std::vector<remote::Item>;
 
+            /// @brief Definition for the function called once a queued upload is finished. It's passed whether it succeeded.
+            using UploadCallback = std::function<void(bool uploaded)>;
+
             /// @brief This just allocates the curl::Handle. Never mind.
             Storage(std::string_view prefix, bool supportsUtf8 = false);
 
@@ -76,11 +82,34 @@ namespace remote
             /// @param source Path to the file to upload.
             virtual bool upload_file(const fslib::Path &source, std::string_view name, sys::ProgressTask *task = nullptr) = 0;
 
+            /// @brief Queues an upload of a file from the SD card on the engine passed instead of waiting for it to finish.
+            /// @param engine Engine to queue the upload on. This blocks if the engine is already at its limit.
+            /// @param source Path to the file to upload. This needs to be left alone until the upload is finished.
+            /// @param name Name of the file on the remote.
+            /// @param onFinished Optional. Called by the engine's owner once the upload is finished and the list is updated.
+            /// @return False if the upload couldn't be queued. onFinished is never called then.
+            virtual bool queue_upload(curl::TransferEngine &engine,
+                                      const fslib::Path &source,
+                                      std::string_view name,
+                                      sys::ProgressTask *task            = nullptr,
+                                      Storage::UploadCallback onFinished = {}) = 0;
+
             /// @brief Patches or updates a file on the remote.
             /// @param item Item to be updated.
             /// @param source Path to the file to update with.
             virtual bool patch_file(remote::Item *file, const fslib::Path &source, sys::ProgressTask *task = nullptr) = 0;
 
+            /// @brief Uploads a ZIP to the remote while it's still being written to the pipe passed.
+            /// @param pipe Pipe to upload from. Whatever is writing to it should be stopped with abort() if this fails.
+            /// @param name Name of the file on the remote.
+            /// @note The size isn't known ahead of time, so this doesn't report progress. Whatever writes the ZIP does.
+            virtual bool upload_stream(fs::ZipPipe &pipe, std::string_view name) = 0;
+
+            /// @brief Same as above, but updates a file already on the remote.
+            /// @param file Item to be updated.
+            /// @param pipe Pipe to upload from.
+            virtual bool patch_stream(remote::Item *file, fs::ZipPipe &pipe) = 0;
+
             /// @brief Downloads a file from the remote.
             /// @param item Item to download.
             /// @param destination Path to download the file to.
@@ -88,6 +117,11 @@ namespace remote
                                        const fslib::Path &destination,
                                        sys::ProgressTask *task = nullptr) = 0;
 
+            /// @brief Downloads a file from the remote into a pipe so it can be read while it downloads.
+            /// @param item Item to download.
+            /// @param pipe Pipe to write to. This is always closed when the download ends, as failed if it didn't finish.
+            virtual bool download_stream(const remote::Item *file, fs::ZipPipe &pipe, sys::ProgressTask *task = nullptr) = 0;
+
             // General functions that apply to both.
             /// @brief Deletes a file or folder from the remote.
             /// @param item Item to delete.
@@ -98,6 +132,10 @@ namespace remote
             /// @param newName New name of the target item.
             virtual bool rename_item(remote::Item *item, std::string_view newName) = 0;
 
+            /// @brief Connects to the remote ahead of time so the next request can skip DNS and the TLS handshake.
+            /// @note This doesn't touch the storage's own handle, so it's safe to run while another request is in progress.
+            virtual void preconnect() = 0;
+
             /// @brief Returns whether or not the remote storage type supports UTF-8 for names or requires path safe titles.
             bool supports_utf8() const noexcept;
 
@@ -108,8 +146,9 @@ namespace remote
             /// @brief This is the size of the buffers used for snprintf'ing URLs together.
             static constexpr size_t SIZE_URL_BUFFER = 0x401;
 
-            /// @brief This is the size used for uploads.
-            static constexpr size_t SIZE_UPLOAD_BUFFER = 0x10000;
+            /// @brief Returns the buffer size curl should use for uploads. This follows the SD's calibrated chunk size within
+            /// the range curl accepts.
+            static long get_upload_buffer_size();
 
             /// @brief Curl handle.
             curl::Handle m_curl;
@@ -22,11 +22,24 @@ namespace remote
                              std::string_view remoteName,
                              sys::ProgressTask *task = nullptr) override;
 
+            /// @brief Queues an upload of source to the current parent on engine.
+            bool queue_upload(curl::TransferEngine &engine,
+                              const fslib::Path &source,
+                              std::string_view remoteName,
+                              sys::ProgressTask *task            = nullptr,
+                              Storage::UploadCallback onFinished = {}) override;
+
             /// @brief Patches or updates a file on the WebDav server.
             /// @param file Pointer to the file to update.
             /// @param source Path of the source file to update with.
             bool patch_file(remote::Item *file, const fslib::Path &source, sys::ProgressTask *task = nullptr) override;
 
+            /// @brief Uploads a ZIP to the remote while it's still being written to pipe.
+            bool upload_stream(fs::ZipPipe &pipe, std::string_view name) override;
+
+            /// @brief Updates file on the remote with a ZIP that's still being written to pipe.
+            bool patch_stream(remote::Item *file, fs::ZipPipe &pipe) override;
+
             /// @brief Downloads the passed file from the WebDav server.
             /// @param file Pointer to the file to download.
             /// @param destination Path to write the downloaded data from.
@@ -34,6 +47,9 @@ namespace remote
                                const fslib::Path &destination,
                                sys::ProgressTask *task = nullptr) override;
 
+            /// @brief Downloads file into pipe so it can be read while it downloads.
+            bool download_stream(const remote::Item *file, fs::ZipPipe &pipe, sys::ProgressTask *task = nullptr) override;
+
             /// @brief Deletes the target item from the WebDav server.
             /// @param item Item to delete.
             bool delete_item(const remote::Item *item) override;
@@ -43,6 +59,9 @@ namespace remote
             /// @param newName New name of the item.
             bool rename_item(remote::Item *item, std::string_view newName) override;
 
+            /// @brief Connects to the server ahead of time.
+            void preconnect() override;
+
         private:
             /// @brief Origin or server address.
             std::string m_origin{};
@@ -54,7 +73,8 @@ namespace remote
             std::string m_password{};
 
             /// @brief Appends the username and password to a WebDav curl request.
-            void append_credentials();
+            /// @param handle Handle making the request.
+            void append_credentials(curl::Handle &handle);
 
             /// @brief Requests PROPFIND to the url passed.
             /// @param url URL to PROPFIND with.
@@ -16,6 +16,9 @@ namespace remote
     /// @brief Initializes the remote service according to the config on the sdmc.
     void initialize(sys::threadpool::JobData jobData);
 
+    /// @brief Job that connects to the remote ahead of time if one is initialized.
+    void preconnect(sys::threadpool::JobData jobData);
+
     /// @brief Returns the pointer to the Storage instance.
     remote::Storage *get_remote_storage() noexcept;
 } // namespace remote
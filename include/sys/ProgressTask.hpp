@@ -1,6 +1,10 @@
 #pragma once
 #include "sys/Task.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
 namespace sys
 {
     /// @brief Derived class of Task that has methods for tracking progress.
@@ -31,9 +35,59 @@ namespace sys
             /// @return Current progress.
             double get_progress() const noexcept;
 
+            /// @brief Records a file that didn't match what was read when it was checked after writing. Thread safe.
+            void report_mismatch() noexcept;
+
+            /// @brief Returns the number of mismatches reported.
+            int get_mismatch_count() const noexcept;
+
+            /// @brief Starts tracking progress for the whole operation instead of just the current file.
+            /// @param totalBytes Number of bytes the operation is expected to process.
+            /// @param totalFiles Number of files the operation is expected to write.
+            void begin_operation(int64_t totalBytes, int64_t totalFiles) noexcept;
+
+            /// @brief Adds to the operation's goal for work whose size isn't known until something before it finishes.
+            void extend_operation(int64_t bytes, int64_t files) noexcept;
+
+            /// @brief Adds bytes processed to both the current file and the operation. Thread safe.
+            void add_progress(int64_t bytes) noexcept;
+
+            /// @brief Counts a file as finished for the operation. Thread safe.
+            void finish_file() noexcept;
+
+            /// @brief Returns whether or not begin_operation was called.
+            bool has_operation() const noexcept;
+
+            /// @brief Returns the progress of the whole operation.
+            double get_operation_progress() const noexcept;
+
+            /// @brief Returns the bytes processed and expected for the operation.
+            int64_t get_bytes_done() const noexcept;
+            int64_t get_bytes_total() const noexcept;
+
+            /// @brief Returns the files written and expected for the operation.
+            int64_t get_files_done() const noexcept;
+            int64_t get_files_total() const noexcept;
+
+            /// @brief Returns the time the operation began.
+            std::chrono::steady_clock::time_point get_operation_start() const noexcept;
+
         private:
-            // Current value and goal
-            double m_current{};
-            double m_goal{};
+            // Current value and goal. These are written from worker threads and read by the UI.
+            std::atomic<double> m_current{};
+            std::atomic<double> m_goal{};
+
+            // Whole operation counters.
+            std::atomic<bool> m_hasOperation{};
+            std::atomic<int64_t> m_bytesDone{};
+            std::atomic<int64_t> m_bytesTotal{};
+            std::atomic<int64_t> m_filesDone{};
+            std::atomic<int64_t> m_filesTotal{};
+
+            // Ticks of the steady clock the operation began at. time_point can't be read atomically by the UI on its own.
+            std::atomic<std::chrono::steady_clock::rep> m_operationStart{};
+
+            // Number of files that failed verification.
+            std::atomic<int> m_mismatches{};
     };
 } // namespace sys
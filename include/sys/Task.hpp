@@ -1,4 +1,5 @@
 #pragma once
+#include "sys/stats.hpp"
 #include "sys/threadpool.hpp"
 
 #include <atomic>
@@ -31,13 +32,16 @@ namespace sys
             Task();
 
             /// @brief Starts a new task.
-            Task(sys::threadpool::JobFunction function, sys::Task::TaskData taskData);
+            /// @param priority Optional. Priority the task is pushed to the pool with.
+            Task(sys::threadpool::JobFunction function,
+                 sys::Task::TaskData taskData,
+                 sys::threadpool::Priority priority = sys::threadpool::Priority::Bulk);
 
             /// @brief Returns if the thread has signaled it's finished running.
             /// @return True if the thread is still running. False if it isn't.
             bool is_running() const noexcept;
 
-            /// @brief Allows thread to signal it's finished.
+            /// @brief Allows thread to signal it's finished. A summary of the pool's activity while it ran is logged.
             /// @note Spawned task threads must call this when their work is finished.
             void complete() noexcept;
 
@@ -56,6 +60,9 @@ namespace sys
             std::atomic<bool> m_isRunning{};
 
         private:
+            // Pool counters from when the task was started.
+            sys::stats::Snapshot m_statsBegin{};
+
             // Status string the thread can set that the main thread can display.
             std::string m_status{};
 
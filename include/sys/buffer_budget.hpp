@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+
+namespace sys::buffer_budget
+{
+    /// @brief Sets the limit according to how much memory JKSV has to work with.
+    /// @note Applets get a much smaller heap than applications, so the limit is capped lower for them.
+    void initialize();
+
+    /// @brief Reserves as many chunks as the budget allows.
+    /// @param chunkCount Number of chunks wanted.
+    /// @param chunkSize Size of each chunk.
+    /// @return Number of chunks reserved. This is always at least one so a pipeline can never be starved completely.
+    size_t reserve(size_t chunkCount, size_t chunkSize) noexcept;
+
+    /// @brief Reserves size bytes only if the budget has room for all of them.
+    /// @param size Number of bytes wanted.
+    /// @return True if the bytes were reserved. They need to be returned with release.
+    bool try_reserve(size_t size) noexcept;
+
+    /// @brief Returns bytes reserved with reserve or try_reserve to the budget.
+    void release(size_t size) noexcept;
+
+    /// @brief Returns the limit in bytes.
+    size_t get_limit() noexcept;
+
+    /// @brief Holds chunks reserved from the budget and returns them when it goes out of scope.
+    class Reservation final
+    {
+        public:
+            /// @brief Reserves as many chunks as the budget allows. See reserve.
+            /// @param chunkCount Number of chunks wanted.
+            /// @param chunkSize Size of each chunk.
+            Reservation(size_t chunkCount, size_t chunkSize) noexcept
+                : m_chunkSize(chunkSize)
+                , m_chunkCount(sys::buffer_budget::reserve(chunkCount, chunkSize)) {};
+
+            /// @brief Returns the chunks to the budget.
+            ~Reservation() { sys::buffer_budget::release(m_chunkCount * m_chunkSize); }
+
+            Reservation(const Reservation &)            = delete;
+            Reservation &operator=(const Reservation &) = delete;
+
+            /// @brief Returns the number of chunks reserved.
+            inline size_t get_count() const noexcept { return m_chunkCount; }
+
+        private:
+            /// @brief Size of each chunk.
+            size_t m_chunkSize{};
+
+            /// @brief Number of chunks reserved.
+            size_t m_chunkCount{};
+    };
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace sys::stats
+{
+    /// @brief Number of buckets in a histogram. Bucket n holds samples shorter than 2^n microseconds. The last one holds
+    /// everything longer.
+    inline constexpr size_t COUNT_HISTOGRAM_BUCKETS = 24;
+
+    /// @brief Pipelines built on BufferQueue.
+    enum class Pipeline : uint8_t
+    {
+        FileCopy,
+        Zip,
+        Unzip,
+        Archive,
+        Download,
+        Count
+    };
+
+    /// @brief Number of pipelines tracked.
+    inline constexpr size_t COUNT_PIPELINES = static_cast<size_t>(Pipeline::Count);
+
+    /// @brief Histogram of durations in microseconds. Safe to record to from any thread.
+    class Histogram final
+    {
+        public:
+            Histogram() = default;
+
+            /// @brief Records a sample.
+            void record(uint64_t microseconds) noexcept;
+
+            /// @brief Returns the number of samples recorded.
+            uint64_t get_count() const noexcept;
+
+            /// @brief Returns the sum of every sample recorded.
+            uint64_t get_total() const noexcept;
+
+            /// @brief Returns the number of samples in the bucket passed.
+            uint64_t get_bucket(size_t bucket) const noexcept;
+
+            /// @brief Returns the upper bound of the bucket the percentile passed falls in.
+            /// @param percentile Percentile from 0 to 100.
+            uint64_t get_percentile(size_t percentile) const noexcept;
+
+        private:
+            /// @brief Buckets.
+            std::array<std::atomic<uint64_t>, COUNT_HISTOGRAM_BUCKETS> m_buckets{};
+
+            /// @brief Number of samples and their sum.
+            std::atomic<uint64_t> m_count{};
+            std::atomic<uint64_t> m_total{};
+    };
+
+    // clang-format off
+    struct PipelineStats
+    {
+        /// @brief Number of streams that have finished.
+        uint64_t streams{};
+
+        /// @brief Microseconds the producer spent waiting for a free chunk.
+        uint64_t producerStall{};
+
+        /// @brief Microseconds the consumer spent waiting for a filled chunk.
+        uint64_t consumerStall{};
+    };
+
+    struct Snapshot
+    {
+        /// @brief Time the snapshot was taken.
+        uint64_t time{};
+
+        /// @brief Job counts.
+        uint64_t jobsWaiting{};
+        uint64_t jobsRunning{};
+        uint64_t jobsCompleted{};
+
+        /// @brief Microseconds jobs have spent queued and running in total.
+        uint64_t timeQueued{};
+        uint64_t timeRunning{};
+
+        /// @brief Stalls for each pipeline.
+        std::array<sys::stats::PipelineStats, COUNT_PIPELINES> pipelines{};
+    };
+    // clang-format on
+
+    /// @brief Returns the current time in microseconds.
+    uint64_t get_time() noexcept;
+
+    /// @brief Records a job being pushed to the pool.
+    void job_queued() noexcept;
+
+    /// @brief Records a job being taken by a thread.
+    /// @param queued Microseconds the job spent waiting.
+    void job_started(uint64_t queued) noexcept;
+
+    /// @brief Records a job finishing.
+    /// @param running Microseconds the job spent running.
+    void job_finished(uint64_t running) noexcept;
+
+    /// @brief Records the stalls of a finished stream.
+    void record_pipeline(sys::stats::Pipeline pipeline, uint64_t producerStall, uint64_t consumerStall) noexcept;
+
+    /// @brief Returns the current counters.
+    sys::stats::Snapshot get_snapshot() noexcept;
+
+    /// @brief Returns the histogram of time jobs spent queued.
+    const sys::stats::Histogram &get_queued_histogram() noexcept;
+
+    /// @brief Returns the histogram of time jobs spent running.
+    const sys::stats::Histogram &get_running_histogram() noexcept;
+
+    /// @brief Returns the name of the pipeline passed.
+    std::string_view get_pipeline_name(sys::stats::Pipeline pipeline) noexcept;
+
+    /// @brief Logs what changed since the snapshot passed.
+    /// @param label What the summary is for.
+    /// @param begin Snapshot taken at the start.
+    void log_summary(std::string_view label, const sys::stats::Snapshot &begin);
+}
@@ -2,5 +2,7 @@
 #include "sys/ProgressTask.hpp"
 #include "sys/Task.hpp"
 #include "sys/Timer.hpp"
+#include "sys/buffer_budget.hpp"
 #include "sys/defines.hpp"
+#include "sys/stats.hpp"
 #include "sys/threadpool.hpp"
\ No newline at end of file
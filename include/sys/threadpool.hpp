@@ -1,7 +1,11 @@
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace sys::threadpool
 {
@@ -15,12 +19,91 @@ namespace sys::threadpool
     /// @brief Function definition.
     using JobFunction = std::function<void(JobData)>;
 
+    /// @brief Priority classes for jobs.
+    enum class Priority
+    {
+        /// @brief Short jobs the user is waiting on. Loading data, listings, metadata.
+        Interactive,
+        /// @brief Everything else. Copying, compression and transfers.
+        Bulk
+    };
+
+    /// @brief Handle to a job pushed to the pool. Copies refer to the same job.
+    class JobHandle
+    {
+        public:
+            /// @brief State shared between the handle and the worker running the job.
+            struct State
+            {
+                    sys::threadpool::JobFunction function{};
+                    sys::threadpool::JobData data{};
+                    uint64_t queuedAt{};
+                    std::mutex mutex{};
+                    std::condition_variable condition{};
+                    bool started{};
+                    bool finished{};
+            };
+
+            /// @brief Default constructor. The handle doesn't refer to a job.
+            JobHandle() = default;
+
+            /// @brief Creates a handle for the state passed. Only push_job should need this.
+            JobHandle(std::shared_ptr<JobHandle::State> state);
+
+            /// @brief Returns whether or not the handle refers to a job.
+            bool is_valid() const noexcept;
+
+            /// @brief Returns whether or not the job has finished running. Invalid handles are always finished.
+            bool is_finished() const;
+
+            /// @brief Blocks until the job has finished running.
+            /// @note Waiting on a job from another job only works while another worker is free to run it.
+            void wait() const;
+
+            /// @brief Runs the job on the calling thread if no thread has started it yet.
+            void run_if_pending() const;
+
+        private:
+            /// @brief Shared state.
+            std::shared_ptr<JobHandle::State> m_state{};
+    };
+
+    /// @brief Group of jobs that can be waited on together.
+    /// @note Jobs no thread has started by the time wait is called are run by the waiting thread, so a job can safely wait
+    /// on a group it pushed even when every other worker is busy.
+    class JobGroup
+    {
+        public:
+            JobGroup() = default;
+
+            /// @brief Adds a job to the group.
+            void add(sys::threadpool::JobHandle handle);
+
+            /// @brief Returns whether or not every job in the group has finished.
+            bool is_finished() const;
+
+            /// @brief Waits for every job in the group to finish and clears it. Jobs that haven't started are run here.
+            void wait();
+
+        private:
+            /// @brief Jobs in the group.
+            std::vector<sys::threadpool::JobHandle> m_handles{};
+    };
+
     /// @brief Initializes and starts the threads.
     void initialize();
 
     /// @brief Signals the threads to terminate and closes them.
     void exit();
 
-    /// @brief Pushes a job to the queue.
-    void push_job(sys::threadpool::JobFunction function, sys::threadpool::JobData);
-}
\ No newline at end of file
+    /// @brief Returns the number of threads in the pool that run bulk jobs.
+    /// @note This doesn't count the thread reserved for interactive jobs.
+    size_t get_thread_count() noexcept;
+
+    /// @brief Pushes a job to the pool.
+    /// @param priority Optional. Interactive jobs are taken before any bulk job and have a thread reserved for them.
+    /// @return Handle that can be used to wait on the job.
+    sys::threadpool::JobHandle push_job(sys::threadpool::JobFunction function,
+                                        sys::threadpool::JobData,
+                                        sys::threadpool::Priority priority = sys::threadpool::Priority::Bulk);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "appstates/BackupMenuState.hpp"
+#include "curl/TransferEngine.hpp"
 #include "sys/sys.hpp"
 
 #include <string>
@@ -10,6 +11,10 @@ namespace tasks::backup
     void create_new_backup_local(sys::threadpool::JobData taskData);
     void create_new_backup_remote(sys::threadpool::JobData taskData);
 
+    /// @brief ZIPs a new backup to the SD and queues the upload on engine instead of waiting for it.
+    /// @note Batch backups use this so the next save is compressed while earlier ones are still uploading.
+    void queue_new_backup_remote(BackupMenuState::TaskData taskData, curl::TransferEngine &engine);
+
     /// @brief Overwrites a pre-existing backup.
     void overwrite_backup_local(sys::threadpool::JobData taskData);
     void overwrite_backup_remote(sys::threadpool::JobData taskData);
@@ -27,4 +32,8 @@ namespace tasks::backup
 
     /// @brief Patches a pre-existing backup on the remote storage.
     void patch_backup(sys::threadpool::JobData taskData);
+
+    /// @brief Adds the size and file count of the save passed to the task's operation.
+    /// @note Batch backups call this for every save before starting so the time remaining covers all of them.
+    void add_save_to_operation(sys::ProgressTask *task, const FsSaveDataInfo *saveInfo);
 }
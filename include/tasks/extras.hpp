@@ -0,0 +1,7 @@
+#pragma once
+#include "sys/sys.hpp"
+
+namespace tasks::extras
+{
+    void calibrate_io(sys::threadpool::JobData taskData);
+}
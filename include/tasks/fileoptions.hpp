@@ -7,6 +7,9 @@ namespace tasks::fileoptions
     /// @brief Copies the source to destination passed through taskData.
     void copy_source_to_destination(sys::threadpool::JobData taskData);
 
+    /// @brief Extracts the ZIP entry passed through taskData to the destination.
+    void copy_zip_to_destination(sys::threadpool::JobData taskData);
+
     /// @brief Deletes the source path passed through taskData
     void delete_target(sys::threadpool::JobData taskData);
 }
\ No newline at end of file
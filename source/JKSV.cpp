@@ -90,12 +90,16 @@ JKSV::JKSV()
     // This needs the config init'd or read to work.
     JKSV::create_directories();
     sys::threadpool::initialize(); // This is the thread pool so JKSV isn't constantly creating and destroying threads.
+    sys::buffer_budget::initialize();
 
     // To do: Rearrange init so JKSV doesn't init so much.
     if (JKSV::applet_mode_check()) { return; }
 
     // Push the remote init.
-    sys::threadpool::push_job(remote::initialize, nullptr);
+    sys::threadpool::push_job(remote::initialize, nullptr, sys::threadpool::Priority::Interactive);
+
+    // This is only updated and drawn while the setting is enabled.
+    m_debugOverlay = DebugOverlayState::create();
 
     // Launch the loading init. Finish init is called afterwards.
     auto init_finish = []() { MainMenuState::create_and_push(); }; // Lambda that's exec'd after state is finished.
@@ -137,6 +141,9 @@ void JKSV::update()
 
     StateManager::update();
     ui::PopMessageManager::update();
+
+    const bool debugOverlay = config::get_by_key(config::keys::DEBUG_OVERLAY);
+    if (debugOverlay && m_debugOverlay) { m_debugOverlay->update(); }
 }
 
 void JKSV::render()
@@ -147,6 +154,9 @@ void JKSV::render()
     StateManager::render();
     ui::PopMessageManager::render();
 
+    const bool debugOverlay = config::get_by_key(config::keys::DEBUG_OVERLAY);
+    if (debugOverlay && m_debugOverlay) { m_debugOverlay->render(); }
+
     sdl::frame_end();
 }
 
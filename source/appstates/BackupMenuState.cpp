@@ -169,8 +169,14 @@ void BackupMenuState::refresh()
     int index{};
     for (const fslib::DirectoryEntry &entry : m_directoryListing)
     {
-        sm_backupMenu->add_option(entry.get_filename());
-        m_menuEntries.push_back({MenuEntryType::Local, index++});
+        // The chunk store and dictionaries aren't backups. The index still needs to advance so the others line up with the
+        // listing.
+        const int entryIndex = index++;
+        const char *filename = entry.get_filename();
+        if (filename == fs::NAME_CHUNK_STORE || filename == fs::NAME_DICTIONARY_DIR) { continue; }
+
+        sm_backupMenu->add_option(filename);
+        m_menuEntries.push_back({MenuEntryType::Local, entryIndex});
     }
 }
 
@@ -243,6 +249,11 @@ void BackupMenuState::initialize_remote_storage()
     remote::Storage *remote = remote::get_remote_storage();
     if (!remote) { return; }
 
+    // Whatever the user picks next likely goes to the remote, so the connection can be opened while they're choosing. The
+    // user isn't waiting on it, so it shouldn't hold up the listings and metadata they are.
+    const bool preconnect = config::get_by_key(config::keys::REMOTE_PRECONNECT);
+    if (preconnect) { sys::threadpool::push_job(remote::preconnect, nullptr, sys::threadpool::Priority::Bulk); }
+
     const bool supportsUtf8            = remote->supports_utf8();
     const std::string_view remoteTitle = supportsUtf8 ? m_titleInfo->get_title() : m_titleInfo->get_path_safe_title();
     const bool remoteDirExists         = remote->directory_exists(remoteTitle);
@@ -264,6 +275,8 @@ void BackupMenuState::name_and_create_backup()
     const bool autoName     = config::get_by_key(config::keys::AUTO_NAME_BACKUPS);
     const bool autoUpload   = config::get_by_key(config::keys::AUTO_UPLOAD);
     const bool exportZip    = autoUpload || config::get_by_key(config::keys::EXPORT_TO_ZIP);
+    const bool deduplicate  = config::get_by_key(config::keys::DEDUPLICATE_BACKUPS);
+    const bool archive      = config::get_by_key(config::keys::INDEXED_ARCHIVES);
     const bool zrHeld       = input::button_held(HidNpadButton_ZR);
     const bool autoNamed    = (autoName || zrHeld); // This can be eval'd here.
 
@@ -292,7 +305,9 @@ void BackupMenuState::name_and_create_backup()
     else
     {
         fslib::Path target{m_directoryPath / name};
-        if (!hasZipExt && (autoUpload || exportZip)) { target += STRING_ZIP_EXT; } // We're going to append zip either way.
+        if (deduplicate) { target += fs::EXTENSION_SNAPSHOT; }
+        else if (archive && !hasZipExt) { target += fs::EXTENSION_ARCHIVE; }
+        else if (!hasZipExt && (autoUpload || exportZip)) { target += STRING_ZIP_EXT; } // We're going to append zip either way.
 
         m_dataStruct->path = std::move(target);
         ProgressState::create_push_fade(tasks::backup::create_new_backup_local, m_dataStruct);
@@ -348,8 +363,24 @@ void BackupMenuState::confirm_restore()
         const char *popBackupEmpty = strings::get_by_name(strings::names::BACKUPMENU_POPS, 1);
 
         const fslib::Path target{m_directoryPath / m_directoryListing[entry.index]};
-        const bool targetIsDirectory = fslib::directory_exists(target);
-        const bool backupIsGood      = targetIsDirectory ? fs::directory_has_contents(target) : fs::zip_has_contents(target);
+        const std::string targetString = target.string();
+        const bool targetIsDirectory   = fslib::directory_exists(target);
+        const bool targetIsSnapshot    = std::strstr(targetString.c_str(), fs::EXTENSION_SNAPSHOT.data());
+        const bool targetIsArchive     = std::strstr(targetString.c_str(), fs::EXTENSION_ARCHIVE.data());
+
+        // Archives that can't be opened, like ones whose dictionary is gone, are caught here before the save is wiped.
+        fs::BackupArchive archive{};
+        if (targetIsArchive && !archive.open(target))
+        {
+            const char *popErrorReading = strings::get_by_name(strings::names::BACKUPMENU_POPS, 20);
+            ui::PopMessageManager::push_message(popTicks, popErrorReading);
+            return;
+        }
+
+        const bool backupIsGood = targetIsDirectory  ? fs::directory_has_contents(target)
+                                  : targetIsSnapshot ? fslib::file_exists(target)
+                                  : targetIsArchive  ? archive.has_contents()
+                                                     : fs::zip_has_contents(target);
         if (!backupIsGood)
         {
             ui::PopMessageManager::push_message(popTicks, popBackupEmpty);
@@ -408,15 +439,30 @@ void BackupMenuState::upload_backup()
     const MenuEntry &entry = m_menuEntries[selected];
     if (entry.type != BackupMenuState::MenuEntryType::Local) { return; }
 
+    // Deduplicated backups only make sense next to their chunk store, so they're treated like folders here. Remote storage
+    // only restores ZIPs, so archives are too.
     fslib::Path target{m_directoryPath / m_directoryListing[entry.index]};
-    const bool isDir = fslib::directory_exists(target);
-    if (isDir)
+    const std::string targetString = target.string();
+    const bool isDir               = fslib::directory_exists(target);
+    const bool isSnapshot          = std::strstr(targetString.c_str(), fs::EXTENSION_SNAPSHOT.data());
+    const bool isArchive           = std::strstr(targetString.c_str(), fs::EXTENSION_ARCHIVE.data());
+    if (isDir || isSnapshot || isArchive)
     {
         const char *popNotZip = strings::get_by_name(strings::names::BACKUPMENU_POPS, 13);
         ui::PopMessageManager::push_message(popTicks, popNotZip);
         return;
     }
 
+    // Incremental backups need the rest of their chain to restore, so they can't live on their own remotely.
+    fs::BackupManifest manifest{};
+    const bool isIncremental = manifest.read(target) && manifest.is_incremental();
+    if (isIncremental)
+    {
+        const char *popIncremental = strings::get_by_name(strings::names::BACKUPMENU_POPS, 18);
+        ui::PopMessageManager::push_message(popTicks, popIncremental);
+        return;
+    }
+
     m_dataStruct->path              = std::move(target);
     const std::string_view itemName = m_dataStruct->path.get_filename();
     const bool exists               = remote->file_exists(itemName);
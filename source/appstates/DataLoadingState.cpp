@@ -20,7 +20,8 @@ DataLoadingState::DataLoadingState(data::DataContext &context,
     , m_destructFunction(destructFunction)
 {
     DataLoadingState::initialize_static_members();
-    m_task = std::make_unique<sys::Task>(function, taskData);
+    // Loading holds up everything else, so it shouldn't wait behind anything still running.
+    m_task = std::make_unique<sys::Task>(function, taskData, sys::threadpool::Priority::Interactive);
 }
 
 //                      ---- Public functions ----
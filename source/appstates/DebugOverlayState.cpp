@@ -0,0 +1,91 @@
+#include "appstates/DebugOverlayState.hpp"
+
+#include "graphics/colors.hpp"
+#include "sdl.hpp"
+#include "stringutil.hpp"
+
+namespace
+{
+    /// @brief How often the lines are rebuilt in milliseconds.
+    constexpr uint64_t TICKS_REFRESH = 500;
+
+    /// @brief Position and size of the panel.
+    constexpr int PANEL_X      = 8;
+    constexpr int PANEL_Y      = 600;
+    constexpr int PANEL_WIDTH  = 640;
+    constexpr int LINE_HEIGHT  = 14;
+    constexpr int SIZE_FONT    = 12;
+    constexpr int SIZE_PADDING = 4;
+}
+
+//                      ---- Construction ----
+
+DebugOverlayState::DebugOverlayState()
+    : m_refreshTimer(TICKS_REFRESH)
+{
+    DebugOverlayState::refresh_lines();
+}
+
+//                      ---- Public functions ----
+
+void DebugOverlayState::update()
+{
+    if (!m_refreshTimer.is_triggered()) { return; }
+    DebugOverlayState::refresh_lines();
+}
+
+void DebugOverlayState::render()
+{
+    static constexpr int PANEL_HEIGHT = (LINE_HEIGHT * COUNT_LINES) + (SIZE_PADDING * 2);
+
+    sdl::render_rect_fill(sdl::Texture::Null, PANEL_X, PANEL_Y, PANEL_WIDTH, PANEL_HEIGHT, colors::SLIDE_PANEL_CLEAR);
+
+    int y = PANEL_Y + SIZE_PADDING;
+    for (const std::string &line : m_lines)
+    {
+        sdl::text::render(sdl::Texture::Null, PANEL_X + SIZE_PADDING, y, SIZE_FONT, sdl::text::NO_WRAP, colors::WHITE, line);
+        y += LINE_HEIGHT;
+    }
+}
+
+//                      ---- Private functions ----
+
+void DebugOverlayState::refresh_lines()
+{
+    const sys::stats::Snapshot snapshot  = sys::stats::get_snapshot();
+    const sys::stats::Histogram &queued  = sys::stats::get_queued_histogram();
+    const sys::stats::Histogram &running = sys::stats::get_running_histogram();
+    const uint64_t queuedCount           = queued.get_count();
+    const uint64_t runningCount          = running.get_count();
+    const uint64_t queuedAverage         = queuedCount > 0 ? queued.get_total() / queuedCount : 0;
+    const uint64_t runningAverage        = runningCount > 0 ? running.get_total() / runningCount : 0;
+
+    m_lines[0] = stringutil::get_formatted_string("Jobs: %llu waiting, %llu running, %llu completed. Threads: %zu + 1",
+                                                  snapshot.jobsWaiting,
+                                                  snapshot.jobsRunning,
+                                                  snapshot.jobsCompleted,
+                                                  sys::threadpool::get_thread_count());
+
+    m_lines[1] = stringutil::get_formatted_string("Queued: avg %llu us, p50 < %llu us, p99 < %llu us",
+                                                  queuedAverage,
+                                                  queued.get_percentile(50),
+                                                  queued.get_percentile(99));
+
+    m_lines[2] = stringutil::get_formatted_string("Running: avg %llu us, p50 < %llu us, p99 < %llu us",
+                                                  runningAverage,
+                                                  running.get_percentile(50),
+                                                  running.get_percentile(99));
+
+    for (size_t i = 0; i < sys::stats::COUNT_PIPELINES; i++)
+    {
+        const sys::stats::Pipeline pipeline    = static_cast<sys::stats::Pipeline>(i);
+        const sys::stats::PipelineStats &stats = snapshot.pipelines[i];
+        const std::string_view name            = sys::stats::get_pipeline_name(pipeline);
+
+        m_lines[3 + i] = stringutil::get_formatted_string("%s: %llu streams, stalled %llu ms producing, %llu ms consuming",
+                                                          name.data(),
+                                                          stats.streams,
+                                                          stats.producerStall / 1000,
+                                                          stats.consumerStall / 1000);
+    }
+}
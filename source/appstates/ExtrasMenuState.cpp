@@ -2,12 +2,14 @@
 
 #include "appstates/FileModeState.hpp"
 #include "appstates/MainMenuState.hpp"
+#include "appstates/ProgressState.hpp"
 #include "data/data.hpp"
 #include "error.hpp"
 #include "graphics/colors.hpp"
 #include "input.hpp"
 #include "keyboard.hpp"
 #include "strings/strings.hpp"
+#include "tasks/extras.hpp"
 #include "ui/PopMessageManager.hpp"
 
 #include <string_view>
@@ -26,7 +28,8 @@ namespace
         BIS_SAFE,
         BIS_SYSTEM,
         BIS_USER,
-        TERMINATE_PROCESS
+        TERMINATE_PROCESS,
+        CALIBRATE_IO
     };
 } // namespace
 
@@ -64,6 +67,7 @@ void ExtrasMenuState::update()
             case BIS_SYSTEM:        ExtrasMenuState::system_to_sd(); break;
             case BIS_USER:          ExtrasMenuState::user_to_sd(); break;
             case TERMINATE_PROCESS: ExtrasMenuState::terminate_process(); break;
+            case CALIBRATE_IO:      ExtrasMenuState::calibrate_io(); break;
         }
     }
     else if (bPressed) { BaseState::deactivate(); }
@@ -131,6 +135,12 @@ void ExtrasMenuState::user_to_sd()
 
 void ExtrasMenuState::terminate_process() {}
 
+void ExtrasMenuState::calibrate_io()
+{
+    auto taskData = std::make_shared<sys::Task::DataStruct>();
+    ProgressState::create_push_fade(tasks::extras::calibrate_io, taskData);
+}
+
 static void finish_reinitialization()
 {
     const int popTicks     = ui::PopMessageManager::DEFAULT_TICKS;
@@ -19,6 +19,13 @@ namespace
 
     /// @brief This is the target Y of the pop-up. The starting Y is the height of the screen.
     constexpr int TARGET_Y = 91;
+
+    /// @brief Prefixes for directories and files in the menus.
+    constexpr const char *DIR_PREFIX  = "[D] ";
+    constexpr const char *FILE_PREFIX = "[F] ";
+
+    /// @brief Extension of files that can be browsed like directories.
+    constexpr std::string_view STRING_ZIP_EXT = ".zip";
 }
 
 //                      ---- Construction ----
@@ -133,9 +140,6 @@ void FileModeState::initialize_menus()
 
 void FileModeState::initialize_directory_menu(const fslib::Path &path, fslib::Directory &directory, ui::Menu &menu)
 {
-    static constexpr const char *DIR_PREFIX  = "[D] ";
-    static constexpr const char *FILE_PREFIX = "[F] ";
-
     directory.open(path);
     if (!directory.is_open()) { return; }
 
@@ -154,6 +158,28 @@ void FileModeState::initialize_directory_menu(const fslib::Path &path, fslib::Di
     }
 }
 
+void FileModeState::initialize_zip_menu(const fs::ZipIndex &zip, const std::string &zipDir, ui::Menu &menu)
+{
+    const std::vector<size_t> *children = zip.get_directory(zipDir);
+    if (!children) { return; }
+
+    menu.reset();
+    menu.add_option(".");
+    menu.add_option("..");
+
+    for (const size_t index : *children)
+    {
+        const fs::ZipIndex::Entry &entry = zip.get_entry(index);
+
+        std::string option{};
+        if (entry.isDirectory) { option = DIR_PREFIX; }
+        else { option = FILE_PREFIX; }
+
+        option += entry.name;
+        menu.add_option(option);
+    }
+}
+
 void FileModeState::update_y() noexcept
 {
     // Update the transition.
@@ -205,6 +231,14 @@ void FileModeState::update_handle_input() noexcept
 
 void FileModeState::enter_selected(fslib::Path &path, fslib::Directory &directory, ui::Menu &menu)
 {
+    std::shared_ptr<fs::ZipIndex> &zip = FileModeState::get_source_zip();
+    std::string &zipDir                = FileModeState::get_source_zip_directory();
+    if (zip)
+    {
+        FileModeState::enter_selected_zip(zip, zipDir, menu);
+        return;
+    }
+
     const int selected = menu.get_selected();
 
     switch (selected)
@@ -216,11 +250,50 @@ void FileModeState::enter_selected(fslib::Path &path, fslib::Directory &director
             const int dirIndex                 = selected - 2;
             const fslib::DirectoryEntry &entry = directory[dirIndex];
             if (entry.is_directory()) { FileModeState::enter_directory(path, directory, menu, entry); }
+            else { FileModeState::enter_zip(path, zip, zipDir, menu, entry); }
         }
         break;
     }
 }
 
+void FileModeState::enter_selected_zip(std::shared_ptr<fs::ZipIndex> &zip, std::string &zipDir, ui::Menu &menu)
+{
+    const std::vector<size_t> *children = zip->get_directory(zipDir);
+    const int selected                  = menu.get_selected();
+    if (!children || selected < 2) { return; }
+
+    const int entryIndex             = selected - 2;
+    const fs::ZipIndex::Entry &entry = zip->get_entry((*children)[entryIndex]);
+    if (!entry.isDirectory) { return; }
+
+    zipDir = entry.path;
+    FileModeState::initialize_zip_menu(*zip, zipDir, menu);
+}
+
+void FileModeState::enter_zip(const fslib::Path &path,
+                              std::shared_ptr<fs::ZipIndex> &zip,
+                              std::string &zipDir,
+                              ui::Menu &menu,
+                              const fslib::DirectoryEntry &entry)
+{
+    const std::string_view filename = entry.get_filename();
+    const bool isZip                = filename.ends_with(STRING_ZIP_EXT);
+    if (!isZip) { return; }
+
+    auto newZip = std::make_shared<fs::ZipIndex>(path / entry);
+    if (!newZip->is_open())
+    {
+        const int popTicks          = ui::PopMessageManager::DEFAULT_TICKS;
+        const char *popErrorOpening = strings::get_by_name(strings::names::BACKUPMENU_POPS, 3);
+        ui::PopMessageManager::push_message(popTicks, popErrorOpening);
+        return;
+    }
+
+    zip = std::move(newZip);
+    zipDir.clear();
+    FileModeState::initialize_zip_menu(*zip, zipDir, menu);
+}
+
 void FileModeState::open_option_menu(fslib::Directory &directory, ui::Menu &menu)
 {
     const int selected = menu.get_selected();
@@ -233,6 +306,25 @@ void FileModeState::change_target() { m_target = m_target == Target::MountA ? Ta
 
 void FileModeState::up_one_directory(fslib::Path &path, fslib::Directory &directory, ui::Menu &menu)
 {
+    // Leaving the root of a ZIP goes back to the directory the ZIP is in.
+    std::shared_ptr<fs::ZipIndex> &zip = FileModeState::get_source_zip();
+    std::string &zipDir                = FileModeState::get_source_zip_directory();
+    if (zip && zipDir.empty())
+    {
+        zip.reset();
+        FileModeState::initialize_directory_menu(path, directory, menu);
+        return;
+    }
+    else if (zip)
+    {
+        const size_t lastSlash = zipDir.find_last_of('/');
+        if (lastSlash == zipDir.npos) { zipDir.clear(); }
+        else { zipDir.erase(lastSlash); }
+
+        FileModeState::initialize_zip_menu(*zip, zipDir, menu);
+        return;
+    }
+
     if (FileModeState::path_is_root(path)) { return; }
 
     size_t lastSlash = path.find_last_of('/');
@@ -273,6 +365,15 @@ fslib::Directory &FileModeState::get_source_directory() noexcept { return m_targ
 
 fslib::Directory &FileModeState::get_destination_directory() noexcept { return m_target == Target::MountA ? m_dirB : m_dirA; }
 
+std::shared_ptr<fs::ZipIndex> &FileModeState::get_source_zip() noexcept { return m_target == Target::MountA ? m_zipA : m_zipB; }
+
+std::shared_ptr<fs::ZipIndex> &FileModeState::get_destination_zip() noexcept
+{
+    return m_target == Target::MountA ? m_zipB : m_zipA;
+}
+
+std::string &FileModeState::get_source_zip_directory() noexcept { return m_target == Target::MountA ? m_zipDirA : m_zipDirB; }
+
 void FileModeState::deactivate_state() noexcept
 {
     // This should be already set to this, but just to be sure.
@@ -211,13 +211,21 @@ void FileOptionState::update_filemode_dest()
 
 void FileOptionState::copy_target()
 {
-    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
-
     if (FileOptionState::system_write_check())
     {
         FileOptionState::pop_system_error();
         return;
     }
+    else if (m_spawningState->get_destination_zip())
+    {
+        FileOptionState::pop_read_only_error();
+        return;
+    }
+    else if (m_spawningState->get_source_zip())
+    {
+        FileOptionState::copy_zip_target();
+        return;
+    }
 
     const int64_t journalSize = m_spawningState->m_journalSize;
 
@@ -225,21 +233,71 @@ void FileOptionState::copy_target()
     const fslib::Directory &sourceDir = m_spawningState->get_source_directory();
     const ui::Menu &sourceMenu        = m_spawningState->get_source_menu();
 
+    const int sourceSelected = sourceMenu.get_selected();
+    const int sourceIndex    = sourceSelected - 2;
+    const char *sourceName   = sourceSelected > 1 ? sourceDir[sourceIndex].get_filename() : nullptr;
+
+    fslib::Path fullSource{sourcePath};
+    if (sourceName) { fullSource /= sourceName; }
+
+    fslib::Path fullDest{};
+    if (!FileOptionState::get_copy_destination(sourceName, fullDest)) { return; }
+
+    // Reminder: JK, you move these. That's why the string is blank if they're declared past this point.
+    const std::string sourceString = fullSource.string();
+    const std::string destString   = fullDest.string();
+    m_dataStruct->sourcePath       = std::move(fullSource);
+    m_dataStruct->destPath         = std::move(fullDest);
+    m_dataStruct->journalSize      = journalSize;
+
+    const char *copyFormat  = strings::get_by_name(strings::names::FILEOPTION_CONFS, 0);
+    const std::string query = stringutil::get_formatted_string(copyFormat, sourceString.c_str(), destString.c_str());
+
+    ConfirmProgress::create_push_fade(query, false, tasks::fileoptions::copy_source_to_destination, nullptr, m_dataStruct);
+}
+
+void FileOptionState::copy_zip_target()
+{
+    std::shared_ptr<fs::ZipIndex> &zip = m_spawningState->get_source_zip();
+    const ui::Menu &sourceMenu         = m_spawningState->get_source_menu();
+    const int64_t journalSize          = m_spawningState->m_journalSize;
+
+    std::string zipEntry             = FileOptionState::get_zip_target();
+    const fs::ZipIndex::Entry *entry = zip->find_entry(zipEntry);
+    const bool entrySelected         = entry && sourceMenu.get_selected() > 1;
+
+    fslib::Path fullDest{};
+    const char *sourceName = entrySelected ? entry->name.c_str() : nullptr;
+    if (!FileOptionState::get_copy_destination(sourceName, fullDest)) { return; }
+
+    std::string sourceString = zip->get_path().string();
+    if (!zipEntry.empty()) { sourceString += "/" + zipEntry; }
+
+    const std::string destString = fullDest.string();
+    m_dataStruct->destPath       = std::move(fullDest);
+    m_dataStruct->journalSize    = journalSize;
+    m_dataStruct->zipIndex       = zip;
+    m_dataStruct->zipEntry       = std::move(zipEntry);
+
+    const char *copyFormat  = strings::get_by_name(strings::names::FILEOPTION_CONFS, 0);
+    const std::string query = stringutil::get_formatted_string(copyFormat, sourceString.c_str(), destString.c_str());
+
+    ConfirmProgress::create_push_fade(query, false, tasks::fileoptions::copy_zip_to_destination, nullptr, m_dataStruct);
+}
+
+bool FileOptionState::get_copy_destination(const char *sourceName, fslib::Path &fullDest)
+{
+    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
+
     const fslib::Path &destPath     = m_spawningState->get_destination_path();
     const fslib::Directory &destDir = m_spawningState->get_destination_directory();
     const ui::Menu &destMenu        = m_spawningState->get_destination_menu();
 
-    const int sourceSelected = sourceMenu.get_selected();
-    const int destSelected   = destMenu.get_selected();
-
-    const int sourceIndex = sourceSelected - 2;
-    const int destIndex   = destSelected - 2;
-
-    fslib::Path fullSource{sourcePath};
-    if (sourceSelected > 1) { fullSource /= sourceDir[sourceIndex]; }
+    const int destSelected = destMenu.get_selected();
+    const int destIndex    = destSelected - 2;
 
-    fslib::Path fullDest{destPath};
-    if (destSelected == 0 && sourceSelected > 1) { fullDest /= sourceDir[sourceIndex]; }
+    fullDest = destPath;
+    if (destSelected == 0 && sourceName) { fullDest /= sourceName; }
     if (destSelected > 1)
     {
         const fslib::DirectoryEntry &entry = destDir[destIndex];
@@ -248,24 +306,28 @@ void FileOptionState::copy_target()
             const char *errorFormat = strings::get_by_name(strings::names::FILEOPTION_POPS, 4);
             std::string pop         = stringutil::get_formatted_string(errorFormat, entry.get_filename());
             ui::PopMessageManager::push_message(popTicks, pop);
-            return;
+            return false;
         }
 
         fullDest /= entry;
-        if (sourceSelected > 1) { fullDest /= sourceDir[sourceIndex]; }
+        if (sourceName) { fullDest /= sourceName; }
     }
 
-    // Reminder: JK, you move these. That's why the string is blank if they're declared past this point.
-    const std::string sourceString = fullSource.string();
-    const std::string destString   = fullDest.string();
-    m_dataStruct->sourcePath       = std::move(fullSource);
-    m_dataStruct->destPath         = std::move(fullDest);
-    m_dataStruct->journalSize      = journalSize;
+    return true;
+}
 
-    const char *copyFormat  = strings::get_by_name(strings::names::FILEOPTION_CONFS, 0);
-    const std::string query = stringutil::get_formatted_string(copyFormat, sourceString.c_str(), destString.c_str());
+std::string FileOptionState::get_zip_target()
+{
+    const std::shared_ptr<fs::ZipIndex> &zip = m_spawningState->get_source_zip();
+    const std::string &zipDir                = m_spawningState->get_source_zip_directory();
+    const ui::Menu &sourceMenu               = m_spawningState->get_source_menu();
 
-    ConfirmProgress::create_push_fade(query, false, tasks::fileoptions::copy_source_to_destination, nullptr, m_dataStruct);
+    const std::vector<size_t> *children = zip->get_directory(zipDir);
+    const int selected                  = sourceMenu.get_selected();
+    if (!children || selected < 2) { return zipDir; }
+
+    const int entryIndex = selected - 2;
+    return zip->get_entry((*children)[entryIndex]).path;
 }
 
 void FileOptionState::delete_target()
@@ -275,6 +337,11 @@ void FileOptionState::delete_target()
         FileOptionState::pop_system_error();
         return;
     }
+    else if (m_spawningState->get_source_zip())
+    {
+        FileOptionState::pop_read_only_error();
+        return;
+    }
 
     const fslib::Path &targetPath     = m_spawningState->get_source_path();
     const fslib::Directory &targetDir = m_spawningState->get_source_directory();
@@ -308,6 +375,11 @@ void FileOptionState::rename_target()
         FileOptionState::pop_system_error();
         return;
     }
+    else if (m_spawningState->get_source_zip())
+    {
+        FileOptionState::pop_read_only_error();
+        return;
+    }
 
     const fslib::Path &targetPath = m_spawningState->get_source_path();
     fslib::Directory &targetDir   = m_spawningState->get_source_directory();
@@ -357,6 +429,11 @@ void FileOptionState::create_directory()
         FileOptionState::pop_system_error();
         return;
     }
+    else if (m_spawningState->get_source_zip())
+    {
+        FileOptionState::pop_read_only_error();
+        return;
+    }
 
     const fslib::Path &targetPath = m_spawningState->get_source_path();
     fslib::Directory &targetDir   = m_spawningState->get_source_directory();
@@ -384,6 +461,12 @@ void FileOptionState::create_directory()
 
 void FileOptionState::get_show_target_properties()
 {
+    if (m_spawningState->get_source_zip())
+    {
+        FileOptionState::get_show_zip_properties();
+        return;
+    }
+
     const fslib::Path &sourcePath     = m_spawningState->get_source_path();
     const fslib::Directory &sourceDir = m_spawningState->get_source_directory();
     const ui::Menu &sourceMenu        = m_spawningState->get_source_menu();
@@ -469,6 +552,51 @@ void FileOptionState::get_show_file_properties(const fslib::Path &path)
     MessageState::create_and_push(message);
 }
 
+void FileOptionState::get_show_zip_properties()
+{
+    static constexpr size_t BUFFER_SIZE = 0x40;
+
+    const std::shared_ptr<fs::ZipIndex> &zip = m_spawningState->get_source_zip();
+    const std::string zipEntry               = FileOptionState::get_zip_target();
+    const fs::ZipIndex::Entry *entry         = zip->find_entry(zipEntry);
+
+    std::string pathString = zip->get_path().string();
+    if (!zipEntry.empty()) { pathString += "/" + zipEntry; }
+
+    // The root of the ZIP doesn't have an entry.
+    if (!entry || entry->isDirectory)
+    {
+        int64_t subDirCount{};
+        int64_t fileCount{};
+        int64_t totalSize{};
+        zip->get_information(zipEntry, subDirCount, fileCount, totalSize);
+
+        const char *messageFormat    = strings::get_by_name(strings::names::FILEOPTION_MESSAGES, 0);
+        const std::string sizeString = get_size_string(totalSize);
+        const std::string message =
+            stringutil::get_formatted_string(messageFormat, pathString.c_str(), subDirCount, fileCount, sizeString.c_str());
+
+        MessageState::create_and_push(message);
+        return;
+    }
+
+    // ZIPs only record when an entry was last modified.
+    const std::tm modifiedTm       = *std::localtime(&entry->modified);
+    char lastModified[BUFFER_SIZE] = {0};
+    std::strftime(lastModified, BUFFER_SIZE, "%c", &modifiedTm);
+
+    const char *messageFormat    = strings::get_by_name(strings::names::FILEOPTION_MESSAGES, 1);
+    const std::string sizeString = get_size_string(entry->size);
+    const std::string message    = stringutil::get_formatted_string(messageFormat,
+                                                                 pathString.c_str(),
+                                                                 sizeString.c_str(),
+                                                                 lastModified,
+                                                                 lastModified,
+                                                                 lastModified);
+
+    MessageState::create_and_push(message);
+}
+
 void FileOptionState::pop_system_error()
 {
     const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
@@ -476,6 +604,13 @@ void FileOptionState::pop_system_error()
     ui::PopMessageManager::push_message(popTicks, error);
 }
 
+void FileOptionState::pop_read_only_error()
+{
+    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *error  = strings::get_by_name(strings::names::FILEOPTION_POPS, 7);
+    ui::PopMessageManager::push_message(popTicks, error);
+}
+
 void FileOptionState::deactivate_state()
 {
     sm_copyMenu->set_selected(0);
@@ -140,7 +140,10 @@ void MainMenuState::initialize_data_struct()
     m_dataStruct->spawningState = this;
 }
 
-void MainMenuState::check_for_update() { sys::threadpool::push_job(tasks::update::check_for_update, m_dataStruct); }
+void MainMenuState::check_for_update()
+{
+    sys::threadpool::push_job(tasks::update::check_for_update, m_dataStruct, sys::threadpool::Priority::Interactive);
+}
 
 void MainMenuState::push_target_state()
 {
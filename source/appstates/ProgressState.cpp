@@ -9,6 +9,8 @@
 #include "stringutil.hpp"
 #include "ui/PopMessageManager.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 
 namespace
@@ -25,10 +27,23 @@ namespace
 
     constexpr int COORD_TEXT_Y = 442;
 
+    constexpr int COORD_STATS_Y = 390;
+
     constexpr int COORD_DISPLAY_CENTER = 640;
     constexpr double SIZE_BAR_WIDTH    = 688.0f;
+
+    /// @brief How often the throughput is sampled.
+    constexpr std::chrono::milliseconds TICKS_SAMPLE{500};
+
+    /// @brief Weight given to the newest sample. Lower is smoother, but slower to react.
+    constexpr double WEIGHT_SAMPLE = 0.3;
+
+    constexpr double SIZE_MEGABYTE = 1048576.0;
 }
 
+// Defined at bottom.
+static std::string get_time_string(int64_t seconds);
+
 //                      ---- Construction ----
 
 ProgressState::ProgressState(sys::threadpool::JobFunction function, sys::Task::TaskData taskData)
@@ -88,6 +103,18 @@ void ProgressState::render()
     // This is the divider line.
     sdl::render_line(sdl::Texture::Null, 280, 421, 999, 421, colors::DIV_COLOR);
 
+    // Whole operations get their throughput and time remaining above the bar.
+    if (!m_statsString.empty())
+    {
+        sdl::text::render(sdl::Texture::Null,
+                          m_statsX,
+                          COORD_STATS_Y,
+                          BaseTask::FONT_SIZE,
+                          sdl::text::NO_WRAP,
+                          colors::WHITE,
+                          m_statsString);
+    }
+
     // Progress showing bar.
     sdl::render_rect_fill(sdl::Texture::Null, COORD_BAR_X, COORD_BAR_Y, barWidth, 32, colors::BLACK);
     sdl::render_rect_fill(sdl::Texture::Null, COORD_BAR_X, COORD_BAR_Y, m_progressBarWidth, 32, colors::BAR_GREEN);
@@ -142,8 +169,10 @@ void ProgressState::update_progress() noexcept
     // Cast pointer to the task. To do: Consider dynamic for this...
     auto *task = static_cast<sys::ProgressTask *>(m_task.get());
 
-    // Current progress.
-    const double current = task->get_progress();
+    // Current progress. Operations that know their total show that instead of the file being worked on.
+    const bool hasOperation = task->has_operation();
+    const double current    = hasOperation ? task->get_operation_progress() : task->get_progress();
+    if (hasOperation) { ProgressState::update_operation_stats(task); }
 
     // Update the width and actual progress.
     m_progressBarWidth = std::round(SIZE_BAR_WIDTH * current);
@@ -158,7 +187,53 @@ void ProgressState::update_progress() noexcept
 
     // Handle closing and updating.
     const bool taskRunning = m_task->is_running();
-    if (!taskRunning && m_state != State::Closing) { ProgressState::close_dialog(); }
+    if (taskRunning || m_state == State::Closing) { return; }
+
+    // Mismatches are only counted while the task runs so the user gets one message instead of one per file.
+    const int mismatches = task->get_mismatch_count();
+    if (mismatches > 0)
+    {
+        const int popTicks            = ui::PopMessageManager::DEFAULT_TICKS;
+        const char *popVerifyFormat   = strings::get_by_name(strings::names::IO_POPS, 1);
+        const std::string popMismatch = stringutil::get_formatted_string(popVerifyFormat, mismatches);
+        ui::PopMessageManager::push_message(popTicks, popMismatch);
+    }
+    ProgressState::close_dialog();
+}
+
+void ProgressState::update_operation_stats(sys::ProgressTask *task)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (m_sampleTime.time_since_epoch().count() == 0)
+    {
+        m_sampleTime  = task->get_operation_start();
+        m_sampleBytes = 0;
+    }
+
+    const auto elapsed = now - m_sampleTime;
+    if (elapsed < TICKS_SAMPLE) { return; }
+
+    // Averaging keeps the ETA from jumping around every time a small file or a commit stalls things for a moment.
+    const int64_t bytesDone = task->get_bytes_done();
+    const double seconds    = std::chrono::duration<double>(elapsed).count();
+    const double sample     = static_cast<double>(bytesDone - m_sampleBytes) / seconds;
+    m_throughput            = m_throughput > 0 ? (sample * WEIGHT_SAMPLE) + (m_throughput * (1.0 - WEIGHT_SAMPLE)) : sample;
+    m_sampleTime            = now;
+    m_sampleBytes           = bytesDone;
+
+    // Nothing sensible can be shown until something has actually been written.
+    const int64_t bytesLeft      = std::max<int64_t>(task->get_bytes_total() - bytesDone, 0);
+    const int64_t remaining      = m_throughput > 0 ? static_cast<int64_t>(bytesLeft / m_throughput) : 0;
+    const std::string timeString = m_throughput > 0 ? get_time_string(remaining) : "--:--";
+
+    const char *statsFormat = strings::get_by_name(strings::names::IO_STATUSES, 10);
+    const int filesDone     = static_cast<int>(task->get_files_done());
+    const int filesTotal    = static_cast<int>(std::max(task->get_files_total(), task->get_files_done()));
+    const double megabytes  = m_throughput / SIZE_MEGABYTE;
+    m_statsString = stringutil::get_formatted_string(statsFormat, megabytes, timeString.c_str(), filesDone, filesTotal);
+
+    const int statsWidth = sdl::text::get_width(BaseTask::FONT_SIZE, m_statsString);
+    m_statsX             = COORD_DISPLAY_CENTER - (statsWidth / 2);
 }
 
 void ProgressState::close_dialog()
@@ -173,3 +248,14 @@ void ProgressState::deactivate_state()
     FadeState::create_and_push(colors::DIM_BACKGROUND, colors::ALPHA_FADE_END, colors::ALPHA_FADE_BEGIN, nullptr);
     BaseState::deactivate();
 }
+
+//                      ---- Static functions ----
+
+static std::string get_time_string(int64_t seconds)
+{
+    const int hours   = static_cast<int>(seconds / 3600);
+    const int minutes = static_cast<int>((seconds / 60) % 60);
+    const int secs    = static_cast<int>(seconds % 60);
+    if (hours > 0) { return stringutil::get_formatted_string("%i:%02i:%02i", hours, minutes, secs); }
+    return stringutil::get_formatted_string("%i:%02i", minutes, secs);
+}
@@ -36,7 +36,7 @@ namespace
     };
 
     // This is needed to be able to get and set keys by index. Anything "NULL" isn't a key that can be easily toggled.
-    constexpr std::array<std::string_view, 25> CONFIG_KEY_ARRAY = {CONFIG_KEY_NULL,
+    constexpr std::array<std::string_view, 32> CONFIG_KEY_ARRAY = {CONFIG_KEY_NULL,
                                                                    CONFIG_KEY_NULL,
                                                                    config::keys::INCLUDE_DEVICE_SAVES,
                                                                    config::keys::AUTO_BACKUP_ON_RESTORE,
@@ -60,7 +60,14 @@ namespace
                                                                    config::keys::SHOW_CACHE_USER,
                                                                    config::keys::SHOW_SYSTEM_USER,
                                                                    config::keys::ENABLE_TRASH_BIN,
-                                                                   CONFIG_KEY_NULL};
+                                                                   CONFIG_KEY_NULL,
+                                                                   config::keys::INCREMENTAL_BACKUPS,
+                                                                   config::keys::DEDUPLICATE_BACKUPS,
+                                                                   config::keys::VERIFY_WRITES,
+                                                                   config::keys::INDEXED_ARCHIVES,
+                                                                   config::keys::TITLE_DICTIONARIES,
+                                                                   config::keys::DEBUG_OVERLAY,
+                                                                   config::keys::REMOTE_PRECONNECT};
 } // namespace
 
 //                      ---- Construction ----
@@ -127,8 +134,8 @@ void SettingsState::load_extra_strings()
 
 void SettingsState::update_menu_options()
 {
-    static constexpr std::array<int, 20> TOGGLE_INDEXES = {2,  3,  4,  5,  6,  7,  8,  9,  10, 11,
-                                                           12, 13, 14, 17, 18, 19, 20, 21, 22, 23};
+    static constexpr std::array<int, 27> TOGGLE_INDEXES = {2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,
+                                                           17, 18, 19, 20, 21, 22, 23, 25, 26, 27, 28, 29, 30, 31};
 
     for (const int index : TOGGLE_INDEXES)
     {
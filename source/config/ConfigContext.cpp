@@ -57,6 +57,17 @@ void config::ConfigContext::reset()
     m_configMap[config::keys::SHOW_CACHE_USER.data()]         = 0;
     m_configMap[config::keys::SHOW_SYSTEM_USER.data()]        = 0;
     m_configMap[config::keys::ENABLE_TRASH_BIN.data()]        = 0;
+    m_configMap[config::keys::INCREMENTAL_BACKUPS.data()]     = 0;
+    m_configMap[config::keys::DEDUPLICATE_BACKUPS.data()]     = 0;
+    m_configMap[config::keys::VERIFY_WRITES.data()]           = 0;
+    m_configMap[config::keys::INDEXED_ARCHIVES.data()]        = 0;
+    m_configMap[config::keys::TITLE_DICTIONARIES.data()]      = 0;
+    m_configMap[config::keys::DEBUG_OVERLAY.data()]           = 0;
+    m_configMap[config::keys::REMOTE_PRECONNECT.data()]       = 1;
+    m_configMap[config::keys::SD_CHUNK_SHIFT.data()]          = 19;
+    m_configMap[config::keys::SYSTEM_CHUNK_SHIFT.data()]      = 19;
+    m_configMap[config::keys::IO_QUEUE_DEPTH.data()]          = 4;
+    m_configMap[config::keys::REMOTE_TRANSFER_LIMIT.data()]   = 3;
     m_animationScaling                                        = DEFAULT_SCALING;
 }
 
@@ -0,0 +1,179 @@
+#include "curl/TransferEngine.hpp"
+
+#include "error.hpp"
+#include "logging/logger.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    /// @brief The limit is clamped to this. Past a few, the uploads are only fighting over the same connection.
+    constexpr size_t COUNT_TRANSFERS_MAX = 8;
+
+    /// @brief Size of the stack for the engine thread. TLS handshakes need a fair amount of it.
+    constexpr size_t SIZE_THREAD_STACK = 0x40000;
+
+    /// @brief Same priority as the pool's workers.
+    constexpr int PRIORITY_ENGINE = 0x2B;
+
+    /// @brief Longest the engine waits on sockets before checking curl's timers again.
+    constexpr int TIMEOUT_POLL = 1000;
+}
+
+//                      ---- Construction ----
+
+curl::TransferEngine::TransferEngine(size_t limit)
+    : m_limit(std::clamp<size_t>(limit, 1, COUNT_TRANSFERS_MAX))
+{
+    // This doesn't run in the pool. It'd hold a worker for the whole batch and could starve the jobs writing the ZIPs.
+    m_multi = curl_multi_init();
+    if (error::is_null(m_multi)) { return; }
+
+    const bool created = !error::libnx(
+        threadCreate(&m_thread, TransferEngine::engine_thread_function, this, nullptr, SIZE_THREAD_STACK, PRIORITY_ENGINE, -2));
+    if (!created) { return; }
+
+    m_isRunning = !error::libnx(threadStart(&m_thread));
+    if (!m_isRunning) { threadClose(&m_thread); }
+}
+
+curl::TransferEngine::~TransferEngine()
+{
+    TransferEngine::wait();
+
+    if (m_isRunning)
+    {
+        {
+            std::lock_guard engineGuard{m_engineMutex};
+            m_exit = true;
+        }
+        m_engineCondition.notify_all();
+        curl_multi_wakeup(m_multi);
+
+        error::libnx(threadWaitForExit(&m_thread));
+        error::libnx(threadClose(&m_thread));
+    }
+
+    if (m_multi) { curl_multi_cleanup(m_multi); }
+}
+
+//                      ---- Public functions ----
+
+void curl::TransferEngine::add(std::unique_ptr<curl::Transfer> transfer)
+{
+    if (!transfer) { return; }
+
+    // Without the thread, the best that can be done is performing it here.
+    if (!m_isRunning)
+    {
+        const bool performed = curl::perform(transfer->handle);
+        TransferEngine::complete_transfer(*transfer, performed);
+        return;
+    }
+
+    {
+        std::unique_lock engineGuard{m_engineMutex};
+        m_engineCondition.wait(engineGuard, [this]() { return m_inFlight < m_limit; });
+        m_pending.push_back(std::move(transfer));
+        ++m_inFlight;
+    }
+    m_engineCondition.notify_all();
+    curl_multi_wakeup(m_multi);
+
+    TransferEngine::run_completions();
+}
+
+void curl::TransferEngine::wait()
+{
+    {
+        std::unique_lock engineGuard{m_engineMutex};
+        m_engineCondition.wait(engineGuard, [this]() { return m_inFlight == 0; });
+    }
+
+    TransferEngine::run_completions();
+}
+
+//                      ---- Private functions ----
+
+void curl::TransferEngine::engine_thread_function(void *arg)
+{
+    TransferEngine *engine = static_cast<TransferEngine *>(arg);
+    engine->run();
+}
+
+void curl::TransferEngine::run()
+{
+    std::vector<std::unique_ptr<curl::Transfer>> running{};
+    while (true)
+    {
+        {
+            // The thread only sleeps here when there's nothing for curl to drive.
+            std::unique_lock engineGuard{m_engineMutex};
+            auto condition = [this, &running]() { return m_exit || !m_pending.empty() || !running.empty(); };
+            m_engineCondition.wait(engineGuard, condition);
+            if (m_exit && m_pending.empty() && running.empty()) { break; }
+
+            for (std::unique_ptr<curl::Transfer> &transfer : m_pending)
+            {
+                curl_multi_add_handle(m_multi, transfer->handle.get());
+                running.push_back(std::move(transfer));
+            }
+            m_pending.clear();
+        }
+
+        int active{};
+        const CURLMcode error = curl_multi_perform(m_multi, &active);
+        if (error != CURLM_OK) { logger::log("Error performing curl multi: %i.", error); }
+
+        TransferEngine::collect_finished(running);
+
+        // curl_multi_wakeup cuts this short when something new is added.
+        if (!running.empty()) { curl_multi_poll(m_multi, nullptr, 0, TIMEOUT_POLL, nullptr); }
+    }
+}
+
+void curl::TransferEngine::collect_finished(std::vector<std::unique_ptr<curl::Transfer>> &running)
+{
+    int remaining{};
+    CURLMsg *message{};
+    while ((message = curl_multi_info_read(m_multi, &remaining)))
+    {
+        if (message->msg != CURLMSG_DONE) { continue; }
+
+        // The message is freed when the handle is removed, so everything needed is read first.
+        CURL *handle          = message->easy_handle;
+        const CURLcode result = message->data.result;
+        curl_multi_remove_handle(m_multi, handle);
+        if (result != CURLE_OK) { logger::log("Error performing curl: %i.", result); }
+
+        auto isHandle = [handle](const std::unique_ptr<curl::Transfer> &transfer) { return transfer->handle.get() == handle; };
+        auto findTransfer = std::find_if(running.begin(), running.end(), isHandle);
+        if (findTransfer == running.end()) { continue; }
+
+        {
+            std::lock_guard engineGuard{m_engineMutex};
+            m_finished.emplace_back(std::move(*findTransfer), result == CURLE_OK);
+            --m_inFlight;
+        }
+        running.erase(findTransfer);
+        m_engineCondition.notify_all();
+    }
+}
+
+void curl::TransferEngine::run_completions()
+{
+    std::vector<TransferEngine::Finished> finished{};
+    {
+        std::lock_guard engineGuard{m_engineMutex};
+        finished.swap(m_finished);
+    }
+
+    for (auto &[transfer, performed] : finished) { TransferEngine::complete_transfer(*transfer, performed); }
+}
+
+void curl::TransferEngine::complete_transfer(curl::Transfer &transfer, bool performed)
+{
+    // The source is closed first so the completion is free to delete it.
+    transfer.source.close();
+    if (transfer.complete) { transfer.complete(transfer, performed); }
+}
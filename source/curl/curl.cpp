@@ -4,19 +4,92 @@
 #include "logging/logger.hpp"
 #include "stringutil.hpp"
 
-#include <condition_variable>
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <mutex>
 
 namespace
 {
-    /// @brief Size of the buffer used for uploading files.
-    constexpr size_t SIZE_UPLOAD_BUFFER      = 0x10000;
     constexpr size_t SIZE_DOWNLOAD_THRESHOLD = 0x400000;
+
+    /// @brief Idle connections are probed after this many seconds and then every KEEPALIVE_INTERVAL seconds after.
+    constexpr long KEEPALIVE_IDLE     = 60;
+    constexpr long KEEPALIVE_INTERVAL = 30;
+
+    /// @brief Timeout for preconnecting. This is shorter than normal since nothing is waiting on it.
+    constexpr long TIMEOUT_PRECONNECT = 3;
+
+    /// @brief DNS cache and TLS sessions shared between every handle.
+    CURLSH *s_share{};
+
+    /// @brief One mutex for each kind of data curl locks in the share.
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> s_shareMutexes{};
 } // namespace
 
-bool curl::initialize() { return curl_global_init(CURL_GLOBAL_ALL) == CURLE_OK; }
+// Defined at bottom.
+static void lock_share(CURL *handle, curl_lock_data data, curl_lock_access access, void *userData);
+static void unlock_share(CURL *handle, curl_lock_data data, void *userData);
+
+bool curl::initialize()
+{
+    if (curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK) { return false; }
+
+    // The share is only an optimization. Handles still work without it.
+    s_share = curl_share_init();
+    if (error::is_null(s_share)) { return true; }
+
+    curl_share_setopt(s_share, CURLSHOPT_LOCKFUNC, lock_share);
+    curl_share_setopt(s_share, CURLSHOPT_UNLOCKFUNC, unlock_share);
+    curl_share_setopt(s_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(s_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    return true;
+}
+
+void curl::exit()
+{
+    // curl refuses to free the share while a handle is still using it. It's left alone then so those handles don't end up
+    // pointing at freed memory.
+    if (s_share && curl_share_cleanup(s_share) == CURLSHE_OK) { s_share = nullptr; }
+    curl_global_cleanup();
+}
+
+curl::Handle curl::new_handle()
+{
+    curl::Handle handle{curl_easy_init(), curl_easy_cleanup};
+    if (handle && s_share) { curl::set_option(handle, CURLOPT_SHARE, s_share); }
+
+    return handle;
+}
+
+void curl::reset_handle(curl::Handle &curl)
+{
+    // curl_easy_reset keeps the handle's connections and caches, but the options need to be set again.
+    curl_easy_reset(curl.get());
+    curl::set_option(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl::set_option(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl::set_option(curl, CURLOPT_USERAGENT, curl::STRING_USER_AGENT);
+    curl::set_option(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    curl::set_option(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl::set_option(curl, CURLOPT_TCP_KEEPIDLE, KEEPALIVE_IDLE);
+    curl::set_option(curl, CURLOPT_TCP_KEEPINTVL, KEEPALIVE_INTERVAL);
+    if (s_share) { curl::set_option(curl, CURLOPT_SHARE, s_share); }
+}
+
+void curl::preconnect(std::string_view url)
+{
+    curl::Handle handle = curl::new_handle();
+    if (!handle) { return; }
 
-void curl::exit() { curl_global_cleanup(); }
+    curl::reset_handle(handle);
+    curl::set_option(handle, CURLOPT_URL, url.data());
+    curl::set_option(handle, CURLOPT_NOBODY, 1L);
+    curl::set_option(handle, CURLOPT_TIMEOUT, TIMEOUT_PRECONNECT);
+
+    // The connection closes with the handle, but the lookup and TLS session stay in the share for the next request.
+    curl::perform(handle);
+}
 
 bool curl::perform(curl::Handle &handle)
 {
@@ -44,11 +117,22 @@ size_t curl::read_data_from_file(char *buffer, size_t size, size_t count, curl::
     sys::ProgressTask *task = upload->task;
 
     ssize_t readSize = source->read(buffer, size * count);
-    if (task) { task->update_current(static_cast<double>(source->tell())); }
+    if (task && readSize > 0) { task->add_progress(readSize); }
 
     return readSize;
 }
 
+size_t curl::read_data_from_pipe(char *buffer, size_t size, size_t count, curl::UploadStruct *upload)
+{
+    if (error::is_null(upload) || error::is_null(upload->pipe)) { return CURL_READFUNC_ABORT; }
+
+    const ssize_t readSize = upload->pipe->read(buffer, size * count);
+    if (readSize < 0) { return CURL_READFUNC_ABORT; }
+
+    upload->pipeSize += readSize;
+    return readSize;
+}
+
 size_t curl::write_header_array(const char *buffer, size_t size, size_t count, curl::HeaderArray *array)
 {
     array->emplace_back(buffer, buffer + (size * count));
@@ -68,17 +152,42 @@ size_t curl::write_data_to_file(const char *buffer, size_t size, size_t count, f
 
 size_t curl::download_file_threaded(const char *buffer, size_t size, size_t count, curl::DownloadStruct *download)
 {
-    auto &bufferQueue = download->bufferQueue;
+    auto &bufferQueue      = download->bufferQueue;
+    const size_t chunkSize = bufferQueue.get_chunk_size();
 
     const size_t downloadSize = size * count;
-    auto chunkBuffer          = std::make_unique<sys::Byte[]>(downloadSize);
-    std::copy(buffer, buffer + downloadSize, chunkBuffer.get());
+    for (size_t i = 0; i < downloadSize;)
+    {
+        if (!download->writeBuffer) { download->writeBuffer = bufferQueue.get_write_buffer(); }
+
+        // Returning anything other than downloadSize makes curl abort the transfer.
+        if (!download->writeBuffer) { return 0; }
 
-    while (!bufferQueue.try_push(chunkBuffer, downloadSize)) { std::this_thread::sleep_for(std::chrono::microseconds(10)); }
+        const size_t copySize = std::min(chunkSize - download->writeOffset, downloadSize - i);
+        std::memcpy(download->writeBuffer + download->writeOffset, buffer + i, copySize);
+        download->writeOffset += copySize;
+        i += copySize;
+
+        if (download->writeOffset >= chunkSize)
+        {
+            bufferQueue.push(download->writeOffset);
+            download->writeBuffer = nullptr;
+            download->writeOffset = 0;
+        }
+    }
 
     return downloadSize;
 }
 
+size_t curl::download_to_pipe(const char *buffer, size_t size, size_t count, curl::StreamDownloadStruct *download)
+{
+    const size_t downloadSize = size * count;
+    if (!download->pipe->append(buffer, downloadSize)) { return 0; }
+
+    if (download->task) { download->task->add_progress(static_cast<int64_t>(downloadSize)); }
+    return downloadSize;
+}
+
 void curl::download_write_thread_function(sys::threadpool::JobData jobData)
 {
     auto castData = std::static_pointer_cast<curl::DownloadStruct>(jobData);
@@ -86,22 +195,36 @@ void curl::download_write_thread_function(sys::threadpool::JobData jobData)
     auto &bufferQueue       = castData->bufferQueue;
     fslib::File &dest       = *castData->dest;
     sys::ProgressTask *task = castData->task;
-    int64_t fileSize        = castData->fileSize;
-    auto &writeComplete     = castData->writeComplete;
 
-    for (int64_t i = 0; i < fileSize;)
+    BufferQueue::Chunk chunk{};
+    while (bufferQueue.get_front(chunk))
     {
-        BufferQueue::QueuePair queuePair{};
-        while (!bufferQueue.get_front(queuePair)) { BufferQueue::default_delay(); }
-
-        auto &[chunkBuffer, bufferSize] = queuePair;
-        dest.write(chunkBuffer.get(), bufferSize);
-        i += bufferSize;
+        const ssize_t written = dest.write(chunk.buffer, chunk.size);
+        bufferQueue.pop();
+        if (written != static_cast<ssize_t>(chunk.size))
+        {
+            logger::log("Error writing download: %s", fslib::error::get_string());
+            bufferQueue.abort();
+            break;
+        }
 
-        if (task) { task->update_current(static_cast<double>(i)); }
+        if (task) { task->add_progress(static_cast<int64_t>(chunk.size)); }
     }
+}
+
+bool curl::finish_threaded_download(curl::DownloadStruct *download,
+                                    const sys::threadpool::JobHandle &writeJob,
+                                    bool success)
+{
+    auto &bufferQueue = download->bufferQueue;
+
+    if (success && download->writeBuffer && download->writeOffset > 0) { bufferQueue.push(download->writeOffset); }
+    download->writeBuffer = nullptr;
+    download->writeOffset = 0;
+    bufferQueue.close(success);
 
-    writeComplete.release();
+    writeJob.wait();
+    return success && !bufferQueue.has_failed();
 }
 
 bool curl::get_header_value(const curl::HeaderArray &array, std::string_view header, std::string &valueOut)
@@ -189,3 +312,17 @@ void curl::prepare_upload(curl::Handle &curl)
     curl::set_option(curl, CURLOPT_UPLOAD, 1L);
     curl::set_option(curl, CURLOPT_ACCEPT_ENCODING, "");
 }
+
+//                      ---- Static functions ----
+
+static void lock_share(CURL *handle, curl_lock_data data, curl_lock_access access, void *userData)
+{
+    if (data < 0 || data >= CURL_LOCK_DATA_LAST) { return; }
+    s_shareMutexes[data].lock();
+}
+
+static void unlock_share(CURL *handle, curl_lock_data data, void *userData)
+{
+    if (data < 0 || data >= CURL_LOCK_DATA_LAST) { return; }
+    s_shareMutexes[data].unlock();
+}
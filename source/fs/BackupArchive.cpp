@@ -0,0 +1,672 @@
+#include "fs/BackupArchive.hpp"
+
+#include "BufferQueue.hpp"
+#include "config/config.hpp"
+#include "error.hpp"
+#include "fs/io.hpp"
+#include "fs/verify.hpp"
+#include "logging/logger.hpp"
+#include "strings/strings.hpp"
+#include "stringutil.hpp"
+#include "ui/PopMessageManager.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <zlib.h>
+
+namespace
+{
+    /// @brief Magic written to the beginning and end of archives. JKSA.
+    constexpr uint32_t ARCHIVE_MAGIC = 0x41534B4A;
+
+    /// @brief Current revision of the format. Revision 1 added the ID of the dictionary right after the header.
+    constexpr uint8_t ARCHIVE_REVISION = 0x01;
+
+    /// @brief Files are compressed in independent frames of this size. Only the last frame of a file can be smaller.
+    constexpr size_t SIZE_ARCHIVE_FRAME = 0x40000;
+
+    /// @brief Largest a compressed frame can be.
+    constexpr size_t SIZE_FRAME_BOUND = ZSTD_COMPRESSBOUND(SIZE_ARCHIVE_FRAME);
+
+    /// @brief Smallest an index entry can be. Used to reject corrupt entry counts before allocating for them.
+    constexpr size_t SIZE_INDEX_ENTRY_MIN = sizeof(uint16_t) + sizeof(int64_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+    /// @brief zstd level used when the ZIP compression level is 0.
+    constexpr int LEVEL_ZSTD_FASTEST = -1;
+
+    // clang-format off
+    struct ArchiveHeader
+    {
+        uint32_t         magic{};
+        uint8_t          revision{};
+        fs::SaveMetaData saveMeta{};
+    } __attribute__((packed));
+
+    struct ArchiveFooter
+    {
+        uint64_t indexOffset{};
+        uint32_t entryCount{};
+        uint32_t magic{};
+    } __attribute__((packed));
+
+    struct ArchiveWriter
+    {
+        fslib::File archiveFile{};
+        ZSTD_CCtx *context{};
+        int level{};
+        const ZSTD_CDict *dictionary{};
+        uint64_t offset{};
+        std::unique_ptr<sys::Byte[]> readBuffer{};
+        std::unique_ptr<sys::Byte[]> frameBuffer{};
+    };
+
+    struct ArchiveReadStruct : sys::threadpool::DataStruct
+    {
+        ArchiveReadStruct(size_t chunkSize) : bufferQueue(sys::stats::Pipeline::Archive, fs::get_queue_depth(), chunkSize) {};
+
+        fslib::File *archiveFile{};
+        const ZSTD_DDict *dictionary{};
+        int64_t size{};
+        BufferQueue bufferQueue;
+    };
+    // clang-format on
+}
+
+// Definitions at bottom.
+static bool pack_directory(ArchiveWriter &writer,
+                           const fslib::Path &root,
+                           std::string_view relative,
+                           std::vector<fs::BackupArchive::Entry> &entries,
+                           sys::ProgressTask *task);
+static bool pack_file(ArchiveWriter &writer,
+                      const fslib::Path &path,
+                      fs::BackupArchive::Entry &entry,
+                      sys::ProgressTask *task);
+static bool read_frame(fslib::File &archiveFile,
+                       ZSTD_DCtx *context,
+                       const ZSTD_DDict *dictionary,
+                       sys::Byte *compressed,
+                       sys::Byte *output,
+                       size_t outputSize);
+static void append_bytes(std::vector<sys::Byte> &buffer, const void *data, size_t dataSize);
+static bool read_bytes(const sys::Byte *&cursor, const sys::Byte *end, void *dataOut, size_t dataSize);
+
+//                      ---- Construction ----
+
+fs::BackupArchive::BackupArchive(const fslib::Path &path) { BackupArchive::open(path); }
+
+//                      ---- Thread functions ----
+
+// Decompresses frames ahead of the thread writing them to the save.
+static void archive_read_thread_function(sys::threadpool::JobData jobData)
+{
+    auto castData = std::static_pointer_cast<ArchiveReadStruct>(jobData);
+
+    auto &bufferQueue            = castData->bufferQueue;
+    fslib::File &archiveFile     = *castData->archiveFile;
+    const ZSTD_DDict *dictionary = castData->dictionary;
+    const int64_t fileSize       = castData->size;
+
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    auto compressed    = std::make_unique<sys::Byte[]>(SIZE_FRAME_BOUND);
+
+    bool frameRead = context != nullptr;
+    for (int64_t i = 0; frameRead && i < fileSize;)
+    {
+        sys::Byte *chunkBuffer = bufferQueue.get_write_buffer();
+        if (!chunkBuffer) { break; }
+
+        const size_t frameSize = std::min(SIZE_ARCHIVE_FRAME, static_cast<size_t>(fileSize - i));
+        frameRead              = read_frame(archiveFile, context, dictionary, compressed.get(), chunkBuffer, frameSize);
+        if (!frameRead) { break; }
+
+        bufferQueue.push(frameSize);
+        i += frameSize;
+    }
+    ZSTD_freeDCtx(context);
+    bufferQueue.close(frameRead);
+}
+
+//                      ---- Public functions ----
+
+bool fs::BackupArchive::open(const fslib::Path &path)
+{
+    m_isOpen = false;
+    m_path   = path;
+    m_entries.clear();
+    m_lookup.clear();
+
+    m_archiveFile.open(path, FsOpenMode_Read);
+    if (error::fslib(m_archiveFile.is_open())) { return false; }
+
+    m_isOpen = BackupArchive::read_index() && BackupArchive::load_dictionary();
+    return m_isOpen;
+}
+
+bool fs::BackupArchive::is_open() const noexcept { return m_isOpen; }
+
+bool fs::BackupArchive::create(const fslib::Path &path,
+                               const fslib::Path &root,
+                               const fs::SaveMetaData &saveMeta,
+                               sys::ProgressTask *task,
+                               fs::CompressionDictionary *dictionary)
+{
+    m_archiveFile.close();
+    m_isOpen = false;
+    m_entries.clear();
+    m_lookup.clear();
+
+    ArchiveWriter writer{};
+    writer.archiveFile.open(path, FsOpenMode_Create | FsOpenMode_Write);
+    if (error::fslib(writer.archiveFile.is_open())) { return false; }
+
+    // zstd's 1-9 line up well enough with the ZIP levels. 0 means speed matters more than size.
+    const int zipLevel = config::get_by_key(config::keys::ZIP_COMPRESSION_LEVEL);
+    writer.level       = zipLevel > 0 ? zipLevel : LEVEL_ZSTD_FASTEST;
+    writer.context     = ZSTD_createCCtx();
+    writer.offset      = sizeof(ArchiveHeader) + sizeof(uint32_t);
+    writer.readBuffer  = std::make_unique<sys::Byte[]>(SIZE_ARCHIVE_FRAME);
+    writer.frameBuffer = std::make_unique<sys::Byte[]>(sizeof(uint32_t) + SIZE_FRAME_BOUND);
+
+    // A dictionary that can't be digested just means the archive is compressed without one.
+    writer.dictionary           = dictionary ? dictionary->get_compression_dictionary(writer.level) : nullptr;
+    const uint32_t dictionaryId = writer.dictionary ? dictionary->get_id() : 0;
+
+    const ArchiveHeader header = {.magic = ARCHIVE_MAGIC, .revision = ARCHIVE_REVISION, .saveMeta = saveMeta};
+    const bool headerWritten   = writer.archiveFile.write(&header, sizeof(ArchiveHeader)) == sizeof(ArchiveHeader) &&
+                               writer.archiveFile.write(&dictionaryId, sizeof(uint32_t)) == sizeof(uint32_t);
+    const bool packed = headerWritten && !error::is_null(writer.context) && pack_directory(writer, root, {}, m_entries, task);
+    ZSTD_freeCCtx(writer.context);
+    if (!packed) { return false; }
+
+    // The index is written last so files can be compressed straight to the archive without knowing where they'll end up.
+    std::vector<sys::Byte> index{};
+    for (const BackupArchive::Entry &entry : m_entries)
+    {
+        const uint16_t pathLength = static_cast<uint16_t>(entry.path.length());
+        append_bytes(index, &pathLength, sizeof(uint16_t));
+        append_bytes(index, entry.path.data(), pathLength);
+        append_bytes(index, &entry.size, sizeof(int64_t));
+        append_bytes(index, &entry.offset, sizeof(uint64_t));
+        append_bytes(index, &entry.crc, sizeof(uint32_t));
+    }
+
+    const ArchiveFooter footer = {.indexOffset = writer.offset,
+                                  .entryCount  = static_cast<uint32_t>(m_entries.size()),
+                                  .magic       = ARCHIVE_MAGIC};
+    append_bytes(index, &footer, sizeof(ArchiveFooter));
+
+    const ssize_t indexSize = index.size();
+    const bool indexWritten = writer.archiveFile.write(index.data(), indexSize) == indexSize;
+    writer.archiveFile.close();
+
+    return indexWritten && BackupArchive::open(path);
+}
+
+bool fs::BackupArchive::restore(const fslib::Path &dest, fs::JournalBudget &journal, sys::ProgressTask *task)
+{
+    if (!m_isOpen) { return false; }
+
+    const ZSTD_DDict *dictionary = m_dictionary.get_decompression_dictionary();
+    if (m_dictionaryId != 0 && error::is_null(dictionary)) { return false; }
+
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    if (error::is_null(context)) { return false; }
+
+    auto buffer     = std::make_unique<sys::Byte[]>(SIZE_ARCHIVE_FRAME);
+    auto compressed = std::make_unique<sys::Byte[]>(SIZE_FRAME_BOUND);
+
+    // Directories are always listed before anything inside of them.
+    bool restored{true};
+    for (const BackupArchive::Entry &entry : m_entries)
+    {
+        const fslib::Path fullDest{dest / entry.path};
+        if (entry.size == SIZE_DIRECTORY)
+        {
+            const bool exists = fslib::directory_exists(fullDest);
+            if (!exists && !error::fslib(fslib::create_directories_recursively(fullDest))) { journal.consume_entry(); }
+            continue;
+        }
+
+        const bool fileRestored =
+            BackupArchive::restore_file(fullDest, entry, journal, buffer.get(), compressed.get(), context, task);
+        if (!fileRestored)
+        {
+            logger::log("Error restoring %s from %s.", entry.path.c_str(), m_path.string().c_str());
+            restored = false;
+        }
+    }
+    ZSTD_freeDCtx(context);
+
+    return restored;
+}
+
+bool fs::BackupArchive::verify(sys::ProgressTask *task)
+{
+    if (!m_isOpen) { return false; }
+
+    const char *statusTemplate = strings::get_by_name(strings::names::IO_STATUSES, 7);
+
+    const ZSTD_DDict *dictionary = m_dictionary.get_decompression_dictionary();
+    if (m_dictionaryId != 0 && error::is_null(dictionary)) { return false; }
+
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    if (error::is_null(context)) { return false; }
+
+    auto buffer     = std::make_unique<sys::Byte[]>(SIZE_ARCHIVE_FRAME);
+    auto compressed = std::make_unique<sys::Byte[]>(SIZE_FRAME_BOUND);
+
+    bool allMatch{true};
+    for (const BackupArchive::Entry &entry : m_entries)
+    {
+        if (entry.size == SIZE_DIRECTORY) { continue; }
+
+        if (task)
+        {
+            std::string status = stringutil::get_formatted_string(statusTemplate, entry.path.c_str());
+            task->set_status(status);
+            task->reset(static_cast<double>(entry.size));
+        }
+
+        m_archiveFile.seek(entry.offset, m_archiveFile.BEGINNING);
+
+        uLong crc = crc32(0L, Z_NULL, 0);
+        bool frameRead{true};
+        for (int64_t i = 0; i < entry.size;)
+        {
+            const size_t frameSize = std::min(SIZE_ARCHIVE_FRAME, static_cast<size_t>(entry.size - i));
+            frameRead = read_frame(m_archiveFile, context, dictionary, compressed.get(), buffer.get(), frameSize);
+            if (!frameRead) { break; }
+
+            crc = crc32(crc, buffer.get(), static_cast<uInt>(frameSize));
+            i += frameSize;
+            if (task) { task->add_progress(static_cast<int64_t>(frameSize)); }
+        }
+
+        if (!frameRead || crc != entry.crc)
+        {
+            logger::log("Verification failed for %s in %s.", entry.path.c_str(), m_path.string().c_str());
+            if (task) { task->report_mismatch(); }
+            allMatch = false;
+        }
+    }
+    ZSTD_freeDCtx(context);
+
+    return allMatch;
+}
+
+ssize_t fs::BackupArchive::read_file(const BackupArchive::Entry &entry, sys::Byte *buffer, size_t size)
+{
+    if (!m_isOpen || entry.size == SIZE_DIRECTORY) { return -1; }
+
+    const ZSTD_DDict *dictionary = m_dictionary.get_decompression_dictionary();
+    if (m_dictionaryId != 0 && error::is_null(dictionary)) { return -1; }
+
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    if (error::is_null(context)) { return -1; }
+
+    // Frames can only be decompressed whole, so the last one is decompressed to a buffer and whatever fits is copied.
+    auto frameBuffer = std::make_unique<sys::Byte[]>(SIZE_ARCHIVE_FRAME);
+    auto compressed  = std::make_unique<sys::Byte[]>(SIZE_FRAME_BOUND);
+    m_archiveFile.seek(entry.offset, m_archiveFile.BEGINNING);
+
+    const size_t readSize = std::min(size, static_cast<size_t>(entry.size));
+    size_t copied{};
+    bool frameRead{true};
+    while (copied < readSize)
+    {
+        const size_t frameSize = std::min(SIZE_ARCHIVE_FRAME, static_cast<size_t>(entry.size) - copied);
+        frameRead = read_frame(m_archiveFile, context, dictionary, compressed.get(), frameBuffer.get(), frameSize);
+        if (!frameRead) { break; }
+
+        const size_t copySize = std::min(frameSize, readSize - copied);
+        std::memcpy(&buffer[copied], frameBuffer.get(), copySize);
+        copied += copySize;
+    }
+    ZSTD_freeDCtx(context);
+
+    return frameRead ? static_cast<ssize_t>(copied) : -1;
+}
+
+const std::vector<fs::BackupArchive::Entry> &fs::BackupArchive::get_entries() const noexcept { return m_entries; }
+
+const fs::BackupArchive::Entry *fs::BackupArchive::find_entry(std::string_view path) const
+{
+    const auto findEntry = m_lookup.find(std::string{path});
+    if (findEntry == m_lookup.end()) { return nullptr; }
+
+    return &m_entries[findEntry->second];
+}
+
+bool fs::BackupArchive::has_contents() const noexcept
+{
+    return std::any_of(m_entries.begin(), m_entries.end(), [](const BackupArchive::Entry &entry) {
+        return entry.size != BackupArchive::SIZE_DIRECTORY;
+    });
+}
+
+const fs::SaveMetaData &fs::BackupArchive::get_meta() const noexcept { return m_saveMeta; }
+
+void fs::BackupArchive::get_information(int64_t &fileCount, int64_t &totalSize) const noexcept
+{
+    for (const BackupArchive::Entry &entry : m_entries)
+    {
+        if (entry.size == BackupArchive::SIZE_DIRECTORY) { continue; }
+        totalSize += entry.size;
+        ++fileCount;
+    }
+}
+
+//                      ---- Private functions ----
+
+bool fs::BackupArchive::read_index()
+{
+    const std::string pathString = m_path.string();
+    const int64_t fileSize       = m_archiveFile.get_size();
+    const int64_t indexEnd       = fileSize - static_cast<int64_t>(sizeof(ArchiveFooter));
+
+    ArchiveHeader header{};
+    ArchiveFooter footer{};
+    const bool sizeGood   = indexEnd >= static_cast<int64_t>(sizeof(ArchiveHeader) + sizeof(uint32_t));
+    const bool headerRead = sizeGood && m_archiveFile.read(&header, sizeof(ArchiveHeader)) == sizeof(ArchiveHeader);
+
+    // Archives newer than this build might be laid out differently, so they aren't guessed at.
+    if (headerRead && header.revision > ARCHIVE_REVISION)
+    {
+        logger::log("Error reading archive %s: Revision %u isn't supported.", pathString.c_str(), header.revision);
+        return false;
+    }
+
+    // Revision 0 archives never had a dictionary.
+    m_dictionaryId            = 0;
+    const bool hasDictionary  = headerRead && header.revision >= 0x01;
+    const bool idRead         = !hasDictionary || m_archiveFile.read(&m_dictionaryId, sizeof(uint32_t)) == sizeof(uint32_t);
+    const uint64_t dataOffset = sizeof(ArchiveHeader) + (hasDictionary ? sizeof(uint32_t) : 0);
+    if (headerRead && idRead) { m_archiveFile.seek(indexEnd, m_archiveFile.BEGINNING); }
+
+    const bool footerRead =
+        headerRead && idRead && m_archiveFile.read(&footer, sizeof(ArchiveFooter)) == sizeof(ArchiveFooter);
+    const bool magicMatch = footerRead && header.magic == ARCHIVE_MAGIC && footer.magic == ARCHIVE_MAGIC;
+    const bool indexFits  = magicMatch && footer.indexOffset >= dataOffset &&
+                           footer.indexOffset <= static_cast<uint64_t>(indexEnd);
+    const int64_t indexSize = indexFits ? indexEnd - static_cast<int64_t>(footer.indexOffset) : 0;
+    if (!indexFits || footer.entryCount > static_cast<uint64_t>(indexSize) / SIZE_INDEX_ENTRY_MIN)
+    {
+        logger::log("Error reading archive %s: Invalid header.", pathString.c_str());
+        return false;
+    }
+
+    auto buffer = std::make_unique<sys::Byte[]>(indexSize);
+    m_archiveFile.seek(footer.indexOffset, m_archiveFile.BEGINNING);
+    if (m_archiveFile.read(buffer.get(), indexSize) != indexSize) { return false; }
+
+    const sys::Byte *cursor = buffer.get();
+    const sys::Byte *end    = buffer.get() + indexSize;
+
+    m_saveMeta = header.saveMeta;
+    m_entries.resize(footer.entryCount);
+    m_lookup.reserve(footer.entryCount);
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        BackupArchive::Entry &entry = m_entries[i];
+
+        uint16_t pathLength{};
+        const bool lengthRead = read_bytes(cursor, end, &pathLength, sizeof(uint16_t));
+        const bool pathFits   = lengthRead && static_cast<size_t>(end - cursor) >= pathLength;
+        if (pathFits)
+        {
+            entry.path.assign(reinterpret_cast<const char *>(cursor), pathLength);
+            cursor += pathLength;
+        }
+
+        const bool sizeRead   = pathFits && read_bytes(cursor, end, &entry.size, sizeof(int64_t));
+        const bool offsetRead = sizeRead && read_bytes(cursor, end, &entry.offset, sizeof(uint64_t));
+        const bool crcRead    = offsetRead && read_bytes(cursor, end, &entry.crc, sizeof(uint32_t));
+        if (!crcRead)
+        {
+            logger::log("Error reading archive %s: Entry is truncated.", pathString.c_str());
+            return false;
+        }
+
+        m_lookup[entry.path] = i;
+    }
+
+    return true;
+}
+
+bool fs::BackupArchive::load_dictionary()
+{
+    if (m_dictionaryId == 0) { return true; }
+
+    // The dictionary is looked for next to the archive. Archives copied somewhere without it can't be read.
+    const size_t lastSlash = m_path.find_last_of('/');
+    const bool loaded      = lastSlash != m_path.NOT_FOUND && m_dictionary.load(m_path.sub_path(lastSlash), m_dictionaryId);
+    if (!loaded)
+    {
+        const std::string pathString = m_path.string();
+        logger::log("Error reading archive %s: Dictionary %08X is missing.", pathString.c_str(), m_dictionaryId);
+    }
+
+    return loaded;
+}
+
+bool fs::BackupArchive::restore_file(const fslib::Path &path,
+                                     const BackupArchive::Entry &entry,
+                                     fs::JournalBudget &journal,
+                                     sys::Byte *buffer,
+                                     sys::Byte *compressed,
+                                     ZSTD_DCtx *context,
+                                     sys::ProgressTask *task)
+{
+    const int popTicks          = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popCommitFailed = strings::get_by_name(strings::names::IO_POPS, 0);
+    const char *ioStatus        = strings::get_by_name(strings::names::IO_STATUSES, 12);
+
+    // Commit between files while nothing is open if the whole file would fit in a fresh journal.
+    const int64_t fileSize  = entry.size;
+    const int64_t entryCost = fs::JournalBudget::get_entry_cost() + fileSize;
+    const bool commitFirst  = journal.needs_commit_before(entryCost);
+    if (commitFirst && !journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+    fslib::File destFile{path, FsOpenMode_Create | FsOpenMode_Write, fileSize};
+    if (error::fslib(destFile.is_open())) { return false; }
+    journal.consume_entry();
+
+    if (task)
+    {
+        std::string status = stringutil::get_formatted_string(ioStatus, path.get_filename());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    const ZSTD_DDict *dictionary = m_dictionary.get_decompression_dictionary();
+    m_archiveFile.seek(entry.offset, m_archiveFile.BEGINNING);
+
+    // Files that are a single frame are decompressed right here. Anything larger is decompressed ahead by the pool.
+    bool written{true};
+    if (fileSize <= static_cast<int64_t>(SIZE_ARCHIVE_FRAME) && journal.fits_in_journal(entryCost))
+    {
+        const size_t frameSize = static_cast<size_t>(fileSize);
+        const bool frameRead =
+            frameSize == 0 || read_frame(m_archiveFile, context, dictionary, compressed, buffer, frameSize);
+        written = frameRead && (frameSize == 0 || destFile.write(buffer, fileSize) == fileSize);
+        journal.consume(fileSize);
+        if (task) { task->add_progress(fileSize); }
+    }
+    else
+    {
+        auto sharedData         = std::make_shared<ArchiveReadStruct>(SIZE_ARCHIVE_FRAME);
+        sharedData->archiveFile = &m_archiveFile;
+        sharedData->dictionary  = dictionary;
+        sharedData->size        = fileSize;
+        auto &bufferQueue       = sharedData->bufferQueue;
+
+        int64_t i{};
+        BufferQueue::Chunk chunk{};
+        sys::threadpool::push_job(archive_read_thread_function, sharedData);
+        while (bufferQueue.get_front(chunk))
+        {
+            const size_t bufferSize = chunk.size;
+            const bool commitNeeded = journal.needs_commit(static_cast<int64_t>(bufferSize));
+            if (commitNeeded)
+            {
+                destFile.close();
+                if (!journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+                destFile.open(path, FsOpenMode_Write);
+                destFile.seek(i, destFile.BEGINNING);
+            }
+
+            written = destFile.write(chunk.buffer, bufferSize) == static_cast<ssize_t>(bufferSize);
+            bufferQueue.pop();
+            if (!written)
+            {
+                bufferQueue.abort();
+                break;
+            }
+
+            i += bufferSize;
+            journal.consume(static_cast<int64_t>(bufferSize));
+            if (task) { task->add_progress(static_cast<int64_t>(bufferSize)); }
+        }
+        bufferQueue.wait_closed();
+        written = written && !bufferQueue.has_failed();
+    }
+    destFile.close();
+    if (task) { task->finish_file(); }
+
+    const bool verify = config::get_by_key(config::keys::VERIFY_WRITES);
+    if (written && verify) { fs::verify_file(path, fileSize, entry.crc, task); }
+
+    return written;
+}
+
+//                      ---- Static functions ----
+
+static bool pack_directory(ArchiveWriter &writer,
+                           const fslib::Path &root,
+                           std::string_view relative,
+                           std::vector<fs::BackupArchive::Entry> &entries,
+                           sys::ProgressTask *task)
+{
+    const fslib::Path directoryPath{relative.empty() ? root : root / relative};
+    fslib::Directory directory{directoryPath};
+    if (error::fslib(directory.is_open())) { return false; }
+
+    for (const fslib::DirectoryEntry &dirEntry : directory)
+    {
+        const char *filename = dirEntry.get_filename();
+        if (filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
+
+        std::string path = relative.empty() ? std::string{filename} : std::string{relative} + "/" + filename;
+        if (dirEntry.is_directory())
+        {
+            entries.push_back({.path = path, .size = fs::BackupArchive::SIZE_DIRECTORY});
+            if (!pack_directory(writer, root, path, entries, task)) { return false; }
+            continue;
+        }
+
+        fs::BackupArchive::Entry entry{.path = std::move(path), .size = dirEntry.get_size()};
+        if (!pack_file(writer, directoryPath / filename, entry, task)) { return false; }
+
+        entries.push_back(std::move(entry));
+    }
+
+    return true;
+}
+
+static bool pack_file(ArchiveWriter &writer,
+                      const fslib::Path &path,
+                      fs::BackupArchive::Entry &entry,
+                      sys::ProgressTask *task)
+{
+    const char *ioStatus = strings::get_by_name(strings::names::IO_STATUSES, 11);
+
+    fslib::File sourceFile{path, FsOpenMode_Read};
+    if (error::fslib(sourceFile.is_open())) { return false; }
+
+    const int64_t fileSize = entry.size;
+    if (task)
+    {
+        const std::string pathString = path.string();
+        std::string status           = stringutil::get_formatted_string(ioStatus, pathString.c_str());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    // Every frame but the last is the same size, so only the compressed size is stored in front of each one.
+    uLong crc            = crc32(0L, Z_NULL, 0);
+    sys::Byte *frameData = writer.frameBuffer.get() + sizeof(uint32_t);
+    entry.offset         = writer.offset;
+    for (int64_t i = 0; i < fileSize;)
+    {
+        const size_t frameSize = std::min(SIZE_ARCHIVE_FRAME, static_cast<size_t>(fileSize - i));
+        const ssize_t readSize = sourceFile.read(writer.readBuffer.get(), frameSize);
+        if (readSize != static_cast<ssize_t>(frameSize))
+        {
+            logger::log("Error reading %s: %s", path.string().c_str(), fslib::error::get_string());
+            return false;
+        }
+
+        crc = crc32(crc, writer.readBuffer.get(), static_cast<uInt>(frameSize));
+
+        // The digested dictionary already has the level baked into it.
+        const sys::Byte *source      = writer.readBuffer.get();
+        const ZSTD_CDict *dictionary = writer.dictionary;
+        const size_t compressedSize =
+            dictionary ? ZSTD_compress_usingCDict(writer.context, frameData, SIZE_FRAME_BOUND, source, frameSize, dictionary)
+                       : ZSTD_compressCCtx(writer.context, frameData, SIZE_FRAME_BOUND, source, frameSize, writer.level);
+        if (ZSTD_isError(compressedSize))
+        {
+            logger::log("Error compressing %s: %s", path.string().c_str(), ZSTD_getErrorName(compressedSize));
+            return false;
+        }
+
+        const uint32_t storedSize = static_cast<uint32_t>(compressedSize);
+        const ssize_t writeSize   = sizeof(uint32_t) + compressedSize;
+        std::memcpy(writer.frameBuffer.get(), &storedSize, sizeof(uint32_t));
+        if (writer.archiveFile.write(writer.frameBuffer.get(), writeSize) != writeSize) { return false; }
+
+        i += frameSize;
+        writer.offset += writeSize;
+        if (task) { task->add_progress(static_cast<int64_t>(frameSize)); }
+    }
+    entry.crc = crc;
+
+    if (task) { task->finish_file(); }
+    return true;
+}
+
+static bool read_frame(fslib::File &archiveFile,
+                       ZSTD_DCtx *context,
+                       const ZSTD_DDict *dictionary,
+                       sys::Byte *compressed,
+                       sys::Byte *output,
+                       size_t outputSize)
+{
+    uint32_t storedSize{};
+    const bool sizeRead = archiveFile.read(&storedSize, sizeof(uint32_t)) == sizeof(uint32_t);
+    if (!sizeRead || storedSize > SIZE_FRAME_BOUND) { return false; }
+    else if (archiveFile.read(compressed, storedSize) != storedSize) { return false; }
+
+    const size_t result = dictionary
+                              ? ZSTD_decompress_usingDDict(context, output, outputSize, compressed, storedSize, dictionary)
+                              : ZSTD_decompressDCtx(context, output, outputSize, compressed, storedSize);
+    return !ZSTD_isError(result) && result == outputSize;
+}
+
+static void append_bytes(std::vector<sys::Byte> &buffer, const void *data, size_t dataSize)
+{
+    const sys::Byte *bytes = static_cast<const sys::Byte *>(data);
+    buffer.insert(buffer.end(), bytes, bytes + dataSize);
+}
+
+static bool read_bytes(const sys::Byte *&cursor, const sys::Byte *end, void *dataOut, size_t dataSize)
+{
+    if (static_cast<size_t>(end - cursor) < dataSize) { return false; }
+
+    std::memcpy(dataOut, cursor, dataSize);
+    cursor += dataSize;
+    return true;
+}
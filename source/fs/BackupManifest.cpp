@@ -0,0 +1,362 @@
+#include "fs/BackupManifest.hpp"
+
+#include "error.hpp"
+#include "fs/SaveMetaData.hpp"
+#include "logging/logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <unordered_map>
+
+namespace
+{
+    /// @brief Magic written to the beginning of the manifest. JKMF.
+    constexpr uint32_t MANIFEST_MAGIC = 0x464D4B4A;
+
+    /// @brief Current revision of the format.
+    constexpr uint8_t MANIFEST_REVISION = 0x00;
+
+    /// @brief Size of the buffer used to hash files.
+    constexpr size_t SIZE_HASH_BUFFER = 0x80000;
+
+    /// @brief Manifests larger than this are rejected before anything is allocated for them. This is far more than any real
+    /// save's file list needs.
+    constexpr int64_t SIZE_MANIFEST_MAX = 0x1000000;
+
+    /// @brief Smallest an origin and an entry can be in the file. The counts in the header are checked against these.
+    constexpr size_t SIZE_ORIGIN_MIN = sizeof(uint16_t);
+    constexpr size_t SIZE_ENTRY_MIN  = sizeof(uint16_t) + sizeof(int64_t) + sizeof(fs::BackupManifest::Hash) + sizeof(uint16_t);
+
+    // clang-format off
+    struct ManifestHeader
+    {
+        uint32_t magic{};
+        uint8_t  revision{};
+        uint64_t timestamp{};
+        uint16_t originCount{};
+        uint32_t entryCount{};
+    } __attribute__((packed));
+    // clang-format on
+}
+
+// Definitions at bottom.
+static bool hash_file(const fslib::Path &path, int64_t fileSize, fs::BackupManifest::Hash &hashOut, sys::ProgressTask *task);
+static bool manifest_size_is_valid(int64_t fileSize);
+static void append_bytes(std::vector<sys::Byte> &buffer, const void *data, size_t dataSize);
+static void append_string(std::vector<sys::Byte> &buffer, std::string_view string);
+static bool read_bytes(const sys::Byte *&cursor, const sys::Byte *end, void *dataOut, size_t dataSize);
+static bool read_string(const sys::Byte *&cursor, const sys::Byte *end, std::string &stringOut);
+
+//                      ---- Public functions ----
+
+bool fs::BackupManifest::build(const fslib::Path &root, sys::ProgressTask *task)
+{
+    m_timestamp = static_cast<uint64_t>(std::time(nullptr));
+    m_origins.assign(1, std::string{});
+    m_entries.clear();
+
+    return BackupManifest::build_directory(root, {}, task);
+}
+
+bool fs::BackupManifest::read(const fslib::Path &backup)
+{
+    if (!fslib::directory_exists(backup))
+    {
+        fs::MiniUnzip unzip{backup};
+        if (!unzip.is_open()) { return false; }
+
+        return BackupManifest::read(unzip);
+    }
+
+    fslib::File manifestFile{backup / fs::NAME_SAVE_MANIFEST, FsOpenMode_Read};
+    if (!manifestFile.is_open()) { return false; }
+
+    const int64_t fileSize = manifestFile.get_size();
+    if (!manifest_size_is_valid(fileSize)) { return false; }
+
+    auto buffer         = std::make_unique<sys::Byte[]>(fileSize);
+    const bool readGood = manifestFile.read(buffer.get(), fileSize) == fileSize;
+    return readGood && BackupManifest::deserialize(buffer.get(), fileSize);
+}
+
+bool fs::BackupManifest::read(fs::MiniUnzip &unzip)
+{
+    if (!unzip.locate_file(fs::NAME_SAVE_MANIFEST)) { return false; }
+
+    const int64_t fileSize = unzip.get_uncompressed_size();
+    if (!manifest_size_is_valid(fileSize)) { return false; }
+
+    auto buffer         = std::make_unique<sys::Byte[]>(fileSize);
+    const bool readGood = unzip.read(buffer.get(), fileSize) == fileSize;
+    return readGood && BackupManifest::deserialize(buffer.get(), fileSize);
+}
+
+bool fs::BackupManifest::write(const fslib::Path &backup) const
+{
+    const std::vector<sys::Byte> buffer = BackupManifest::serialize();
+    const ssize_t bufferSize            = buffer.size();
+
+    fslib::File manifestFile{backup / fs::NAME_SAVE_MANIFEST, FsOpenMode_Create | FsOpenMode_Write, bufferSize};
+    if (error::fslib(manifestFile.is_open())) { return false; }
+
+    return manifestFile.write(buffer.data(), bufferSize) == bufferSize;
+}
+
+bool fs::BackupManifest::write(fs::MiniZip &zip) const
+{
+    const std::vector<sys::Byte> buffer = BackupManifest::serialize();
+
+    const bool opened  = zip.open_new_file(fs::NAME_SAVE_MANIFEST);
+    const bool written = opened && zip.write(buffer.data(), buffer.size());
+    const bool closed  = opened && zip.close_current_file();
+    return opened && written && closed;
+}
+
+size_t fs::BackupManifest::inherit_from(const BackupManifest &parent, std::string_view parentName)
+{
+    std::unordered_map<std::string_view, const BackupManifest::Entry *> parentFiles{};
+    for (const BackupManifest::Entry &entry : parent.m_entries)
+    {
+        if (entry.size == SIZE_DIRECTORY) { continue; }
+        parentFiles.emplace(entry.path, &entry);
+    }
+
+    size_t inherited{};
+    for (BackupManifest::Entry &entry : m_entries)
+    {
+        if (entry.size == SIZE_DIRECTORY) { continue; }
+
+        const auto findEntry = parentFiles.find(entry.path);
+        if (findEntry == parentFiles.end()) { continue; }
+
+        const BackupManifest::Entry &parentEntry = *findEntry->second;
+        const bool unchanged                     = parentEntry.size == entry.size && parentEntry.hash == entry.hash;
+        if (!unchanged) { continue; }
+
+        // Files the parent inherited point straight at the backup holding them so the chain never needs to be walked.
+        const bool parentStored       = parentEntry.origin == ORIGIN_SELF;
+        const std::string_view origin = parentStored ? parentName : parent.get_origin(parentEntry);
+        entry.origin                  = BackupManifest::add_origin(origin);
+        ++inherited;
+    }
+
+    return inherited;
+}
+
+bool fs::BackupManifest::is_incremental() const noexcept
+{
+    auto isInherited = [](const BackupManifest::Entry &entry) { return entry.origin != ORIGIN_SELF; };
+    return std::any_of(m_entries.begin(), m_entries.end(), isInherited);
+}
+
+bool fs::BackupManifest::references(std::string_view backupName) const noexcept
+{
+    // The first origin is always this backup.
+    return std::find(m_origins.begin() + 1, m_origins.end(), backupName) != m_origins.end();
+}
+
+std::string_view fs::BackupManifest::get_origin(const BackupManifest::Entry &entry) const noexcept
+{
+    if (entry.origin >= m_origins.size()) { return {}; }
+    return m_origins[entry.origin];
+}
+
+const std::vector<fs::BackupManifest::Entry> &fs::BackupManifest::get_entries() const noexcept { return m_entries; }
+
+int64_t fs::BackupManifest::get_stored_size() const noexcept
+{
+    int64_t storedSize{};
+    for (const BackupManifest::Entry &entry : m_entries)
+    {
+        if (entry.size != SIZE_DIRECTORY && entry.origin == ORIGIN_SELF) { storedSize += entry.size; }
+    }
+    return storedSize;
+}
+
+uint64_t fs::BackupManifest::get_timestamp() const noexcept { return m_timestamp; }
+
+//                      ---- Private functions ----
+
+bool fs::BackupManifest::build_directory(const fslib::Path &root, std::string_view relative, sys::ProgressTask *task)
+{
+    const fslib::Path directoryPath{relative.empty() ? root : root / relative};
+    fslib::Directory directory{directoryPath};
+    if (error::fslib(directory.is_open())) { return false; }
+
+    for (const fslib::DirectoryEntry &entry : directory)
+    {
+        const char *filename = entry.get_filename();
+        if (filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
+
+        std::string path = relative.empty() ? std::string{filename} : std::string{relative} + "/" + filename;
+        if (entry.is_directory())
+        {
+            m_entries.push_back({path, SIZE_DIRECTORY, {}, ORIGIN_SELF});
+            if (!BackupManifest::build_directory(root, path, task)) { return false; }
+            continue;
+        }
+
+        BackupManifest::Entry fileEntry{std::move(path), entry.get_size(), {}, ORIGIN_SELF};
+        const bool hashed = hash_file(directoryPath / filename, fileEntry.size, fileEntry.hash, task);
+        if (!hashed) { return false; }
+
+        m_entries.push_back(std::move(fileEntry));
+    }
+
+    return true;
+}
+
+uint16_t fs::BackupManifest::add_origin(std::string_view backupName)
+{
+    const auto findOrigin = std::find(m_origins.begin() + 1, m_origins.end(), backupName);
+    if (findOrigin != m_origins.end()) { return static_cast<uint16_t>(findOrigin - m_origins.begin()); }
+
+    m_origins.emplace_back(backupName);
+    return static_cast<uint16_t>(m_origins.size() - 1);
+}
+
+std::vector<sys::Byte> fs::BackupManifest::serialize() const
+{
+    const ManifestHeader header = {.magic       = MANIFEST_MAGIC,
+                                   .revision    = MANIFEST_REVISION,
+                                   .timestamp   = m_timestamp,
+                                   .originCount = static_cast<uint16_t>(m_origins.size()),
+                                   .entryCount  = static_cast<uint32_t>(m_entries.size())};
+
+    std::vector<sys::Byte> buffer{};
+    append_bytes(buffer, &header, sizeof(ManifestHeader));
+    for (const std::string &origin : m_origins) { append_string(buffer, origin); }
+    for (const BackupManifest::Entry &entry : m_entries)
+    {
+        append_string(buffer, entry.path);
+        append_bytes(buffer, &entry.size, sizeof(int64_t));
+        append_bytes(buffer, entry.hash.data(), entry.hash.size());
+        append_bytes(buffer, &entry.origin, sizeof(uint16_t));
+    }
+
+    return buffer;
+}
+
+bool fs::BackupManifest::deserialize(const sys::Byte *buffer, size_t bufferSize)
+{
+    const sys::Byte *cursor = buffer;
+    const sys::Byte *end    = buffer + bufferSize;
+
+    ManifestHeader header{};
+    const bool headerRead = read_bytes(cursor, end, &header, sizeof(ManifestHeader));
+    if (!headerRead || header.magic != MANIFEST_MAGIC || header.originCount == 0)
+    {
+        logger::log("Error reading backup manifest: Invalid header.");
+        return false;
+    }
+
+    // The counts are checked before anything is allocated so a damaged manifest can't ask for more than it could hold.
+    const size_t remaining  = static_cast<size_t>(end - cursor);
+    const size_t originSize = static_cast<size_t>(header.originCount) * SIZE_ORIGIN_MIN;
+    const bool countsFit    = originSize <= remaining && header.entryCount <= (remaining - originSize) / SIZE_ENTRY_MIN;
+    if (!countsFit)
+    {
+        logger::log("Error reading backup manifest: Counts are larger than the manifest.");
+        return false;
+    }
+
+    m_timestamp = header.timestamp;
+    m_origins.resize(header.originCount);
+    m_entries.resize(header.entryCount);
+
+    for (std::string &origin : m_origins)
+    {
+        if (!read_string(cursor, end, origin)) { return false; }
+    }
+
+    for (BackupManifest::Entry &entry : m_entries)
+    {
+        const bool pathRead   = read_string(cursor, end, entry.path);
+        const bool sizeRead   = pathRead && read_bytes(cursor, end, &entry.size, sizeof(int64_t));
+        const bool hashRead   = sizeRead && read_bytes(cursor, end, entry.hash.data(), entry.hash.size());
+        const bool originRead = hashRead && read_bytes(cursor, end, &entry.origin, sizeof(uint16_t));
+        if (!originRead || entry.origin >= header.originCount)
+        {
+            logger::log("Error reading backup manifest: Entry is truncated or invalid.");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//                      ---- Static functions ----
+
+static bool hash_file(const fslib::Path &path, int64_t fileSize, fs::BackupManifest::Hash &hashOut, sys::ProgressTask *task)
+{
+    fslib::File file{path, FsOpenMode_Read};
+    if (error::fslib(file.is_open())) { return false; }
+
+    const size_t bufferSize = fileSize > 0 ? std::min(static_cast<size_t>(fileSize), SIZE_HASH_BUFFER) : 1;
+    auto buffer             = std::make_unique<sys::Byte[]>(bufferSize);
+
+    Sha256Context context{};
+    sha256ContextCreate(&context);
+
+    if (task) { task->reset(static_cast<double>(fileSize)); }
+    for (int64_t i = 0; i < fileSize;)
+    {
+        const ssize_t readSize = file.read(buffer.get(), bufferSize);
+        if (readSize <= 0)
+        {
+            logger::log("Error hashing %s: %s", path.string().c_str(), fslib::error::get_string());
+            return false;
+        }
+
+        sha256ContextUpdate(&context, buffer.get(), readSize);
+        i += readSize;
+        if (task) { task->add_progress(readSize); }
+    }
+
+    sha256ContextGetHash(&context, hashOut.data());
+    return true;
+}
+
+static bool manifest_size_is_valid(int64_t fileSize)
+{
+    // The size comes from the backup itself, so it can't be trusted with an allocation.
+    if (fileSize >= 0 && fileSize <= SIZE_MANIFEST_MAX) { return true; }
+
+    logger::log("Error reading backup manifest: Size %lli is invalid.", static_cast<long long>(fileSize));
+    return false;
+}
+
+static void append_bytes(std::vector<sys::Byte> &buffer, const void *data, size_t dataSize)
+{
+    const sys::Byte *bytes = static_cast<const sys::Byte *>(data);
+    buffer.insert(buffer.end(), bytes, bytes + dataSize);
+}
+
+static void append_string(std::vector<sys::Byte> &buffer, std::string_view string)
+{
+    const uint16_t length = static_cast<uint16_t>(string.length());
+    append_bytes(buffer, &length, sizeof(uint16_t));
+    append_bytes(buffer, string.data(), length);
+}
+
+static bool read_bytes(const sys::Byte *&cursor, const sys::Byte *end, void *dataOut, size_t dataSize)
+{
+    if (static_cast<size_t>(end - cursor) < dataSize) { return false; }
+
+    std::memcpy(dataOut, cursor, dataSize);
+    cursor += dataSize;
+    return true;
+}
+
+static bool read_string(const sys::Byte *&cursor, const sys::Byte *end, std::string &stringOut)
+{
+    uint16_t length{};
+    if (!read_bytes(cursor, end, &length, sizeof(uint16_t))) { return false; }
+    if (static_cast<size_t>(end - cursor) < length) { return false; }
+
+    stringOut.assign(reinterpret_cast<const char *>(cursor), length);
+    cursor += length;
+    return true;
+}
@@ -0,0 +1,321 @@
+#include "fs/ChunkStore.hpp"
+
+#include "config/config.hpp"
+#include "error.hpp"
+#include "logging/logger.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+namespace
+{
+    /// @brief Magic written to the beginning of the index. JKCS.
+    constexpr uint32_t INDEX_MAGIC = 0x53434B4A;
+
+    /// @brief Current revision of the index.
+    constexpr uint8_t INDEX_REVISION = 0x00;
+
+    /// @brief Packs are rolled over once they pass this size.
+    constexpr uint64_t SIZE_PACK_LIMIT = 0x2000000;
+
+    constexpr std::string_view NAME_INDEX      = "index.bin";
+    constexpr std::string_view NAME_INDEX_TEMP = "index.tmp";
+    constexpr const char *STRING_PACK_EXT      = ".pack";
+
+    // clang-format off
+    struct IndexHeader
+    {
+        uint32_t magic{};
+        uint8_t  revision{};
+        uint32_t nextPack{};
+        uint32_t entryCount{};
+    } __attribute__((packed));
+
+    struct IndexEntry
+    {
+        uint8_t  hash[SHA256_HASH_SIZE]{};
+        uint32_t pack{};
+        uint64_t offset{};
+        uint32_t storedSize{};
+        uint32_t size{};
+    } __attribute__((packed));
+    // clang-format on
+}
+
+//                      ---- Construction ----
+
+fs::ChunkStore::ChunkStore(const fslib::Path &storePath)
+    : m_storePath(storePath)
+    , m_level(config::get_by_key(config::keys::ZIP_COMPRESSION_LEVEL))
+    , m_compressSize(compressBound(SIZE_CHUNK_MAX))
+{
+    const bool exists      = fslib::directory_exists(m_storePath);
+    const bool createError = !exists && error::fslib(fslib::create_directory(m_storePath));
+    if (createError) { return; }
+
+    m_compressBuffer = std::make_unique<sys::Byte[]>(m_compressSize);
+    m_isOpen         = ChunkStore::read_index() && ChunkStore::find_next_pack();
+}
+
+fs::ChunkStore::~ChunkStore() { ChunkStore::flush(); }
+
+//                      ---- Public functions ----
+
+bool fs::ChunkStore::is_open() const noexcept { return m_isOpen; }
+
+bool fs::ChunkStore::contains(const ChunkStore::Hash &hash) const { return m_index.find(hash) != m_index.end(); }
+
+bool fs::ChunkStore::write_chunk(const ChunkStore::Hash &hash, const sys::Byte *data, size_t dataSize)
+{
+    if (!m_isOpen || dataSize > SIZE_CHUNK_MAX) { return false; }
+    else if (ChunkStore::contains(hash)) { return true; }
+
+    // Chunks that don't shrink are stored as is. A stored size equal to the size means raw.
+    uLongf compressedSize = m_compressSize;
+    const bool compress   = m_level > 0 && dataSize > 0;
+    const bool compressed = compress && compress2(m_compressBuffer.get(), &compressedSize, data, dataSize, m_level) == Z_OK &&
+                            compressedSize < dataSize;
+
+    const sys::Byte *storedData = compressed ? m_compressBuffer.get() : data;
+    const uint32_t storedSize   = compressed ? compressedSize : dataSize;
+    return ChunkStore::append_to_pack(hash, storedData, storedSize, dataSize);
+}
+
+ssize_t fs::ChunkStore::read_chunk(const ChunkStore::Hash &hash, sys::Byte *buffer, size_t bufferSize)
+{
+    const auto findChunk = m_index.find(hash);
+    if (findChunk == m_index.end()) { return -1; }
+
+    const ChunkStore::Location &location = findChunk->second;
+    if (location.size > bufferSize || !ChunkStore::open_read_pack(location.pack)) { return -1; }
+
+    const bool compressed    = location.storedSize < location.size;
+    sys::Byte *readTarget    = compressed ? m_compressBuffer.get() : buffer;
+    const ssize_t storedSize = location.storedSize;
+
+    m_readFile.seek(location.offset, m_readFile.BEGINNING);
+    if (m_readFile.read(readTarget, storedSize) != storedSize) { return -1; }
+    else if (!compressed) { return location.size; }
+
+    uLongf size             = bufferSize;
+    const bool decompressed = uncompress(buffer, &size, readTarget, storedSize) == Z_OK && size == location.size;
+    if (!decompressed) { return -1; }
+
+    return location.size;
+}
+
+bool fs::ChunkStore::flush()
+{
+    m_packFile.close();
+    if (!m_isOpen || !m_indexDirty) { return true; }
+
+    return ChunkStore::write_index();
+}
+
+bool fs::ChunkStore::prune(const ChunkStore::HashSet &liveChunks)
+{
+    if (!m_isOpen || !ChunkStore::flush()) { return false; }
+
+    // Drop every chunk nothing references anymore and tally what's left in each pack.
+    std::unordered_map<uint32_t, uint64_t> liveBytes{};
+    const size_t indexSize = m_index.size();
+    for (auto iter = m_index.begin(); iter != m_index.end();)
+    {
+        if (liveChunks.find(iter->first) == liveChunks.end())
+        {
+            iter = m_index.erase(iter);
+            continue;
+        }
+
+        liveBytes[iter->second.pack] += iter->second.storedSize;
+        ++iter;
+    }
+    m_indexDirty = m_index.size() != indexSize;
+
+    fslib::Directory storeDir{m_storePath};
+    if (error::fslib(storeDir.is_open())) { return false; }
+
+    // Packs that are less than half live get their chunks moved to a new pack. Empty ones are just deleted.
+    std::vector<uint32_t> deadPacks{};
+    std::unordered_set<uint32_t> rewritePacks{};
+    for (const fslib::DirectoryEntry &entry : storeDir)
+    {
+        const char *filename = entry.get_filename();
+        if (!std::strstr(filename, STRING_PACK_EXT)) { continue; }
+
+        const uint32_t pack     = std::strtoul(filename, nullptr, 16);
+        const uint64_t packLive = liveBytes[pack];
+        const uint64_t packSize = entry.get_size();
+        const bool mostlyDead   = packLive * 2 < packSize;
+        if (packLive == 0) { deadPacks.push_back(pack); }
+        else if (mostlyDead) { rewritePacks.insert(pack); }
+    }
+
+    for (auto &[hash, location] : m_index)
+    {
+        if (rewritePacks.find(location.pack) == rewritePacks.end()) { continue; }
+        else if (!ChunkStore::open_read_pack(location.pack)) { return false; }
+
+        const ssize_t storedSize = location.storedSize;
+        m_readFile.seek(location.offset, m_readFile.BEGINNING);
+        if (m_readFile.read(m_compressBuffer.get(), storedSize) != storedSize) { return false; }
+
+        // The data is moved as is. Compression doesn't need to be redone.
+        const ChunkStore::Hash chunkHash = hash;
+        const uint32_t size              = location.size;
+        if (!ChunkStore::append_to_pack(chunkHash, m_compressBuffer.get(), storedSize, size)) { return false; }
+    }
+    m_readFile.close();
+
+    // Old packs are only deleted once the index pointing to the new ones is written.
+    if (!ChunkStore::flush()) { return false; }
+    deadPacks.insert(deadPacks.end(), rewritePacks.begin(), rewritePacks.end());
+    for (const uint32_t pack : deadPacks) { error::fslib(fslib::delete_file(ChunkStore::get_pack_path(pack))); }
+
+    logger::log("Chunk store pruned: %zu chunk(s) left, %zu pack(s) removed.", m_index.size(), deadPacks.size());
+    return true;
+}
+
+//                      ---- Private functions ----
+
+bool fs::ChunkStore::read_index()
+{
+    const fslib::Path indexPath{m_storePath / NAME_INDEX};
+    if (!fslib::file_exists(indexPath)) { return true; }
+
+    fslib::File indexFile{indexPath, FsOpenMode_Read};
+    if (error::fslib(indexFile.is_open())) { return false; }
+
+    // The count is checked against what's actually in the file before reserving anything for it.
+    IndexHeader header{};
+    const int64_t indexSize = indexFile.get_size();
+    const bool headerRead   = indexFile.read(&header, sizeof(IndexHeader)) == sizeof(IndexHeader);
+    const int64_t entrySize = headerRead ? indexSize - static_cast<int64_t>(sizeof(IndexHeader)) : 0;
+    const bool countFits    = headerRead && header.entryCount <= static_cast<uint64_t>(entrySize) / sizeof(IndexEntry);
+    if (!headerRead || header.magic != INDEX_MAGIC || !countFits)
+    {
+        logger::log("Error reading chunk store index: Invalid header.");
+        return false;
+    }
+
+    m_nextPack = header.nextPack;
+    m_index.reserve(header.entryCount);
+    for (uint32_t i = 0; i < header.entryCount; i++)
+    {
+        IndexEntry entry{};
+        if (indexFile.read(&entry, sizeof(IndexEntry)) != sizeof(IndexEntry))
+        {
+            logger::log("Error reading chunk store index: Index is truncated.");
+            return false;
+        }
+
+        ChunkStore::Hash hash{};
+        std::memcpy(hash.data(), entry.hash, SHA256_HASH_SIZE);
+        m_index.emplace(hash, ChunkStore::Location{entry.pack, entry.offset, entry.storedSize, entry.size});
+    }
+
+    return true;
+}
+
+bool fs::ChunkStore::write_index()
+{
+    const IndexHeader header = {.magic      = INDEX_MAGIC,
+                                .revision   = INDEX_REVISION,
+                                .nextPack   = m_nextPack,
+                                .entryCount = static_cast<uint32_t>(m_index.size())};
+
+    std::vector<IndexEntry> entries{};
+    entries.reserve(m_index.size());
+    for (const auto &[hash, location] : m_index)
+    {
+        IndexEntry &entry = entries.emplace_back();
+        std::memcpy(entry.hash, hash.data(), SHA256_HASH_SIZE);
+        entry.pack       = location.pack;
+        entry.offset     = location.offset;
+        entry.storedSize = location.storedSize;
+        entry.size       = location.size;
+    }
+
+    // The index is written to a temp file first so a failed write never leaves the store without one.
+    const fslib::Path indexPath{m_storePath / NAME_INDEX};
+    const fslib::Path tempPath{m_storePath / NAME_INDEX_TEMP};
+    const ssize_t entriesSize = entries.size() * sizeof(IndexEntry);
+    const ssize_t indexSize   = sizeof(IndexHeader) + entriesSize;
+    {
+        fslib::File tempFile{tempPath, FsOpenMode_Create | FsOpenMode_Write, indexSize};
+        if (error::fslib(tempFile.is_open())) { return false; }
+
+        const bool headerWritten  = tempFile.write(&header, sizeof(IndexHeader)) == sizeof(IndexHeader);
+        const bool entriesWritten = headerWritten && tempFile.write(entries.data(), entriesSize) == entriesSize;
+        if (!entriesWritten) { return false; }
+    }
+
+    const bool exists      = fslib::file_exists(indexPath);
+    const bool deleteError = exists && error::fslib(fslib::delete_file(indexPath));
+    const bool renameError = !deleteError && error::fslib(fslib::rename_file(tempPath, indexPath));
+    if (deleteError || renameError) { return false; }
+
+    m_indexDirty = false;
+    return true;
+}
+
+bool fs::ChunkStore::find_next_pack()
+{
+    fslib::Directory storeDir{m_storePath};
+    if (error::fslib(storeDir.is_open())) { return false; }
+
+    // Packs written before the index was saved can't be reused or they'd be truncated.
+    for (const fslib::DirectoryEntry &entry : storeDir)
+    {
+        const char *filename = entry.get_filename();
+        if (!std::strstr(filename, STRING_PACK_EXT)) { continue; }
+
+        const uint32_t pack = std::strtoul(filename, nullptr, 16);
+        if (pack >= m_nextPack) { m_nextPack = pack + 1; }
+    }
+
+    return true;
+}
+
+bool fs::ChunkStore::open_new_pack()
+{
+    m_packFile.close();
+
+    m_packID   = m_nextPack++;
+    m_packSize = 0;
+    m_packFile.open(ChunkStore::get_pack_path(m_packID), FsOpenMode_Create | FsOpenMode_Write);
+    return !error::fslib(m_packFile.is_open());
+}
+
+bool fs::ChunkStore::open_read_pack(uint32_t pack)
+{
+    if (m_readFile.is_open() && m_readID == pack) { return true; }
+
+    m_readID = pack;
+    m_readFile.open(ChunkStore::get_pack_path(pack), FsOpenMode_Read);
+    return !error::fslib(m_readFile.is_open());
+}
+
+bool fs::ChunkStore::append_to_pack(const ChunkStore::Hash &hash, const sys::Byte *data, uint32_t storedSize, uint32_t size)
+{
+    const bool needsPack = !m_packFile.is_open() || m_packSize >= SIZE_PACK_LIMIT;
+    if (needsPack && !ChunkStore::open_new_pack()) { return false; }
+
+    const ssize_t written = m_packFile.write(data, storedSize);
+    if (written != static_cast<ssize_t>(storedSize)) { return false; }
+
+    m_index[hash] = {m_packID, m_packSize, storedSize, size};
+    m_packSize += storedSize;
+    m_indexDirty = true;
+    return true;
+}
+
+fslib::Path fs::ChunkStore::get_pack_path(uint32_t pack) const
+{
+    char packName[0x20] = {0};
+    std::snprintf(packName, 0x20, "%08X%s", pack, STRING_PACK_EXT);
+    return m_storePath / packName;
+}
@@ -0,0 +1,336 @@
+#include "fs/CompressionDictionary.hpp"
+
+#include "error.hpp"
+#include "fs/BackupArchive.hpp"
+#include "fs/ChunkStore.hpp"
+#include "fs/MiniUnzip.hpp"
+#include "fs/SaveMetaData.hpp"
+#include "logging/logger.hpp"
+#include "strings/strings.hpp"
+#include "stringutil.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <zdict.h>
+
+namespace
+{
+    /// @brief Largest dictionary that's trained. Saves are small, so there's rarely enough data to make a bigger one useful.
+    constexpr size_t SIZE_DICTIONARY_MAX = 0x10000;
+
+    /// @brief Smallest dictionary worth training.
+    constexpr size_t SIZE_DICTIONARY_MIN = 0x1000;
+
+    /// @brief Dictionary files larger than this aren't trusted.
+    constexpr int64_t SIZE_DICTIONARY_FILE_MAX = 0x100000;
+
+    /// @brief zstd wants roughly this many times the size of the dictionary in samples.
+    constexpr size_t SAMPLE_RATIO = 10;
+
+    /// @brief Only the beginning of each file is sampled. Archive frames are compressed on their own, so this doesn't
+    /// need to be larger than one.
+    constexpr size_t SIZE_SAMPLE_MAX = 0x20000;
+
+    /// @brief Total sample data read from backups. Training needs a few times this in memory.
+    constexpr size_t SIZE_SAMPLES_MAX = 0x800000;
+
+    /// @brief Fewer samples than this don't make a useful dictionary.
+    constexpr size_t SAMPLE_COUNT_MIN = 8;
+
+    /// @brief Extension used for ZIP backups.
+    constexpr std::string_view EXTENSION_ZIP = ".zip";
+
+    // clang-format off
+    struct SampleSet
+    {
+        std::vector<sys::Byte> data{};
+        std::vector<size_t> sizes{};
+    };
+    // clang-format on
+}
+
+// Defined at bottom.
+static fslib::Path get_dictionary_path(const fslib::Path &titleDir, uint32_t id);
+static void sample_directory(const fslib::Path &directoryPath, SampleSet &samples);
+static void sample_zip(const fslib::Path &zipPath, SampleSet &samples);
+static void sample_archive(const fslib::Path &archivePath, SampleSet &samples);
+static sys::Byte *begin_sample(SampleSet &samples, int64_t fileSize, size_t &sampleSize);
+static void end_sample(SampleSet &samples, size_t sampleSize, ssize_t read);
+static bool is_sample_set_full(const SampleSet &samples);
+
+//                      ---- Construction ----
+
+fs::CompressionDictionary::~CompressionDictionary() { CompressionDictionary::clear(); }
+
+//                      ---- Public functions ----
+
+bool fs::CompressionDictionary::load(const fslib::Path &titleDir, uint32_t id)
+{
+    const fslib::Path dictPath{get_dictionary_path(titleDir, id)};
+    if (!CompressionDictionary::read_file(dictPath)) { return false; }
+    else if (m_id != id)
+    {
+        logger::log("Dictionary %s doesn't match the ID it's named after.", dictPath.string().c_str());
+        CompressionDictionary::clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool fs::CompressionDictionary::load_any(const fslib::Path &titleDir)
+{
+    const fslib::Path dictDir{titleDir / fs::NAME_DICTIONARY_DIR};
+    fslib::Directory dictListing{dictDir};
+    if (!dictListing.is_open()) { return false; }
+
+    for (const fslib::DirectoryEntry &entry : dictListing)
+    {
+        const char *filename = entry.get_filename();
+        if (entry.is_directory() || !std::strstr(filename, fs::EXTENSION_DICTIONARY.data())) { continue; }
+        else if (CompressionDictionary::read_file(dictDir / filename)) { return true; }
+    }
+
+    return false;
+}
+
+bool fs::CompressionDictionary::train(const fslib::Path &titleDir, sys::ProgressTask *task)
+{
+    const std::string titleString = titleDir.string();
+    if (task)
+    {
+        const char *statusTraining = strings::get_by_name(strings::names::BACKUPMENU_STATUS, 2);
+        task->set_status(statusTraining);
+    }
+
+    fslib::Directory titleListing{titleDir};
+    if (error::fslib(titleListing.is_open())) { return false; }
+
+    // Every kind of backup that can be read without anything else is sampled. Snapshots need the chunk store, so they're
+    // skipped.
+    SampleSet samples{};
+    samples.data.reserve(SIZE_SAMPLES_MAX);
+    for (const fslib::DirectoryEntry &entry : titleListing)
+    {
+        if (is_sample_set_full(samples)) { break; }
+
+        const char *filename = entry.get_filename();
+        const fslib::Path path{titleDir / filename};
+        const bool isStorage = filename == fs::NAME_CHUNK_STORE || filename == fs::NAME_DICTIONARY_DIR;
+        if (entry.is_directory() && !isStorage) { sample_directory(path, samples); }
+        else if (std::strstr(filename, EXTENSION_ZIP.data())) { sample_zip(path, samples); }
+        else if (std::strstr(filename, fs::EXTENSION_ARCHIVE.data())) { sample_archive(path, samples); }
+    }
+
+    const size_t sampleCount = samples.sizes.size();
+    const size_t capacity    = std::min(SIZE_DICTIONARY_MAX, samples.data.size() / SAMPLE_RATIO);
+    if (sampleCount < SAMPLE_COUNT_MIN || capacity < SIZE_DICTIONARY_MIN)
+    {
+        logger::log("Not enough backup data in %s to train a dictionary.", titleString.c_str());
+        return false;
+    }
+
+    std::vector<sys::Byte> dictionary(capacity);
+    const size_t dictSize = ZDICT_trainFromBuffer(dictionary.data(),
+                                                  capacity,
+                                                  samples.data.data(),
+                                                  samples.sizes.data(),
+                                                  static_cast<unsigned>(sampleCount));
+    if (ZDICT_isError(dictSize))
+    {
+        logger::log("Error training dictionary for %s: %s", titleString.c_str(), ZDICT_getErrorName(dictSize));
+        return false;
+    }
+    dictionary.resize(dictSize);
+
+    const uint32_t id = ZDICT_getDictID(dictionary.data(), dictSize);
+    if (id == 0) { return false; }
+
+    const fslib::Path dictDir{titleDir / fs::NAME_DICTIONARY_DIR};
+    const bool needsDir = !fslib::directory_exists(dictDir);
+    if (needsDir && error::fslib(fslib::create_directory(dictDir))) { return false; }
+
+    // A dictionary that's only partially written would look like a damaged one, so it's removed instead.
+    const fslib::Path dictPath{get_dictionary_path(titleDir, id)};
+    fslib::File dictFile{dictPath, FsOpenMode_Create | FsOpenMode_Write, static_cast<int64_t>(dictSize)};
+    if (error::fslib(dictFile.is_open())) { return false; }
+
+    const bool written = dictFile.write(dictionary.data(), dictSize) == static_cast<ssize_t>(dictSize);
+    dictFile.close();
+    if (!written)
+    {
+        error::fslib(fslib::delete_file(dictPath));
+        return false;
+    }
+
+    CompressionDictionary::clear();
+    m_data = std::move(dictionary);
+    m_id   = id;
+    logger::log("Trained dictionary %08X for %s from %zu samples.", id, titleString.c_str(), sampleCount);
+
+    return true;
+}
+
+bool fs::CompressionDictionary::is_loaded() const noexcept { return m_id != 0; }
+
+uint32_t fs::CompressionDictionary::get_id() const noexcept { return m_id; }
+
+const ZSTD_CDict *fs::CompressionDictionary::get_compression_dictionary(int level)
+{
+    if (m_id == 0) { return nullptr; }
+    else if (m_compressionDict && m_compressionLevel == level) { return m_compressionDict; }
+
+    ZSTD_freeCDict(m_compressionDict);
+    m_compressionDict  = ZSTD_createCDict(m_data.data(), m_data.size(), level);
+    m_compressionLevel = level;
+
+    return m_compressionDict;
+}
+
+const ZSTD_DDict *fs::CompressionDictionary::get_decompression_dictionary()
+{
+    if (m_id == 0) { return nullptr; }
+    else if (!m_decompressionDict) { m_decompressionDict = ZSTD_createDDict(m_data.data(), m_data.size()); }
+
+    return m_decompressionDict;
+}
+
+//                      ---- Private functions ----
+
+bool fs::CompressionDictionary::read_file(const fslib::Path &path)
+{
+    CompressionDictionary::clear();
+
+    fslib::File dictFile{path, FsOpenMode_Read};
+    if (!dictFile.is_open()) { return false; }
+
+    const int64_t fileSize = dictFile.get_size();
+    if (fileSize <= 0 || fileSize > SIZE_DICTIONARY_FILE_MAX)
+    {
+        logger::log("Error reading dictionary %s: Invalid size.", path.string().c_str());
+        return false;
+    }
+
+    std::vector<sys::Byte> data(fileSize);
+    if (dictFile.read(data.data(), fileSize) != fileSize) { return false; }
+
+    // Raw content dictionaries have no ID. Only ones zstd trained are accepted.
+    const uint32_t id = ZDICT_getDictID(data.data(), data.size());
+    if (id == 0)
+    {
+        logger::log("Error reading dictionary %s: Not a zstd dictionary.", path.string().c_str());
+        return false;
+    }
+
+    m_data = std::move(data);
+    m_id   = id;
+    return true;
+}
+
+void fs::CompressionDictionary::clear()
+{
+    ZSTD_freeCDict(m_compressionDict);
+    ZSTD_freeDDict(m_decompressionDict);
+    m_compressionDict   = nullptr;
+    m_decompressionDict = nullptr;
+    m_id                = 0;
+    m_data.clear();
+}
+
+//                      ---- Static functions ----
+
+static fslib::Path get_dictionary_path(const fslib::Path &titleDir, uint32_t id)
+{
+    const std::string filename = stringutil::get_formatted_string("%08X%s", id, fs::EXTENSION_DICTIONARY.data());
+    return titleDir / fs::NAME_DICTIONARY_DIR / filename;
+}
+
+static void sample_directory(const fslib::Path &directoryPath, SampleSet &samples)
+{
+    fslib::Directory directory{directoryPath};
+    if (!directory.is_open()) { return; }
+
+    for (const fslib::DirectoryEntry &entry : directory)
+    {
+        if (is_sample_set_full(samples)) { return; }
+
+        const char *filename = entry.get_filename();
+        if (filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
+
+        const fslib::Path path{directoryPath / filename};
+        if (entry.is_directory())
+        {
+            sample_directory(path, samples);
+            continue;
+        }
+
+        fslib::File file{path, FsOpenMode_Read};
+        if (!file.is_open()) { continue; }
+
+        size_t sampleSize{};
+        sys::Byte *sample = begin_sample(samples, file.get_size(), sampleSize);
+        if (sample) { end_sample(samples, sampleSize, file.read(sample, sampleSize)); }
+    }
+}
+
+static void sample_zip(const fslib::Path &zipPath, SampleSet &samples)
+{
+    fs::MiniUnzip unzip{zipPath};
+    if (!unzip.is_open() || !unzip.reset()) { return; }
+
+    do {
+        if (is_sample_set_full(samples)) { return; }
+
+        const char *filename = unzip.get_filename();
+        if (unzip.is_directory() || filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
+
+        size_t sampleSize{};
+        const int64_t fileSize = static_cast<int64_t>(unzip.get_uncompressed_size());
+        sys::Byte *sample      = begin_sample(samples, fileSize, sampleSize);
+        if (sample) { end_sample(samples, sampleSize, unzip.read(sample, sampleSize)); }
+    } while (unzip.next_file());
+}
+
+static void sample_archive(const fslib::Path &archivePath, SampleSet &samples)
+{
+    // Archives compressed with a dictionary that's gone won't open and are skipped.
+    fs::BackupArchive archive{archivePath};
+    if (!archive.is_open()) { return; }
+
+    for (const fs::BackupArchive::Entry &entry : archive.get_entries())
+    {
+        if (is_sample_set_full(samples)) { return; }
+        else if (entry.size == fs::BackupArchive::SIZE_DIRECTORY) { continue; }
+
+        size_t sampleSize{};
+        sys::Byte *sample = begin_sample(samples, entry.size, sampleSize);
+        if (sample) { end_sample(samples, sampleSize, archive.read_file(entry, sample, sampleSize)); }
+    }
+}
+
+static sys::Byte *begin_sample(SampleSet &samples, int64_t fileSize, size_t &sampleSize)
+{
+    const size_t used = samples.data.size();
+    if (fileSize <= 0 || used >= SIZE_SAMPLES_MAX) { return nullptr; }
+
+    sampleSize = std::min({static_cast<size_t>(fileSize), SIZE_SAMPLE_MAX, SIZE_SAMPLES_MAX - used});
+    samples.data.resize(used + sampleSize);
+
+    return &samples.data[used];
+}
+
+static void end_sample(SampleSet &samples, size_t sampleSize, ssize_t read)
+{
+    // Anything that couldn't be read is dropped. A short read still makes a usable sample.
+    const size_t start = samples.data.size() - sampleSize;
+    if (read <= 0)
+    {
+        samples.data.resize(start);
+        return;
+    }
+
+    samples.data.resize(start + read);
+    samples.sizes.push_back(read);
+}
+
+static bool is_sample_set_full(const SampleSet &samples) { return samples.data.size() >= SIZE_SAMPLES_MAX; }
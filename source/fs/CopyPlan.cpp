@@ -0,0 +1,72 @@
+#include "fs/CopyPlan.hpp"
+
+#include "error.hpp"
+#include "fs/SaveMetaData.hpp"
+
+#include <algorithm>
+
+//                      ---- Construction ----
+
+fs::CopyPlan::CopyPlan(const fslib::Path &source, const fslib::Path &destination)
+{
+    m_isValid = CopyPlan::enumerate(source, destination);
+}
+
+//                      ---- Public functions ----
+
+bool fs::CopyPlan::is_valid() const noexcept { return m_isValid; }
+
+void fs::CopyPlan::sort_largest_first()
+{
+    auto largerFirst = [](const CopyPlan::Entry &a, const CopyPlan::Entry &b) { return a.size > b.size; };
+    std::stable_sort(m_files.begin(), m_files.end(), largerFirst);
+}
+
+bool fs::CopyPlan::create_directories() const
+{
+    for (const fslib::Path &directory : m_directories)
+    {
+        const bool exists      = fslib::directory_exists(directory);
+        const bool createError = !exists && error::fslib(fslib::create_directory(directory));
+        if (createError) { return false; }
+    }
+    return true;
+}
+
+const std::vector<fslib::Path> &fs::CopyPlan::get_directories() const noexcept { return m_directories; }
+
+const std::vector<fs::CopyPlan::Entry> &fs::CopyPlan::get_files() const noexcept { return m_files; }
+
+int64_t fs::CopyPlan::get_total_size() const noexcept { return m_totalSize; }
+
+int64_t fs::CopyPlan::get_file_count() const noexcept { return static_cast<int64_t>(m_files.size()); }
+
+//                      ---- Private functions ----
+
+bool fs::CopyPlan::enumerate(const fslib::Path &source, const fslib::Path &destination)
+{
+    fslib::Directory sourceDir{source};
+    if (error::fslib(sourceDir.is_open())) { return false; }
+
+    for (const fslib::DirectoryEntry &entry : sourceDir)
+    {
+        const char *filename = entry.get_filename();
+        if (filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
+
+        fslib::Path fullSource{source / filename};
+        fslib::Path fullDest{destination / filename};
+        if (entry.is_directory())
+        {
+            m_directories.push_back(fullDest);
+            if (!CopyPlan::enumerate(fullSource, fullDest)) { return false; }
+        }
+        else
+        {
+            const int64_t size = entry.get_size();
+            m_files.push_back({std::move(fullSource), std::move(fullDest), size});
+            m_totalSize += size;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,75 @@
+#include "fs/JournalBudget.hpp"
+
+#include "error.hpp"
+#include "fslib.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    /// @brief Fraction of the journal that is held back in case the block estimate is off.
+    constexpr int64_t JOURNAL_MARGIN_DIVISOR = 16;
+
+    /// @brief The SD card isn't journaled, so it's never committed.
+    constexpr std::string_view DEVICE_SDMC = "sdmc";
+}
+
+// Defined at bottom.
+static int64_t align_to_block(int64_t size, int64_t blockSize);
+
+//                      ---- Construction ----
+
+fs::JournalBudget::JournalBudget(std::string_view device, int64_t journalSize)
+    : m_device(device)
+    , m_isEnabled(device != DEVICE_SDMC)
+{
+    // Save types without a known journal size are committed after every file like before budgets existed.
+    if (journalSize <= 0) { return; }
+
+    // Keep at least one block of margin. Tiny journals still get to use at least one block.
+    const int64_t margin = std::max(journalSize / JOURNAL_MARGIN_DIVISOR, SIZE_BLOCK);
+    m_budget             = std::max(journalSize - margin, SIZE_BLOCK);
+}
+
+//                      ---- Public functions ----
+
+bool fs::JournalBudget::is_enabled() const noexcept { return m_isEnabled; }
+
+bool fs::JournalBudget::needs_commit(int64_t size) const noexcept
+{
+    if (!m_isEnabled || m_budget <= 0 || m_used == 0) { return false; }
+    return m_used + align_to_block(size, SIZE_BLOCK) > m_budget;
+}
+
+bool fs::JournalBudget::needs_commit_before(int64_t entryCost) const noexcept
+{
+    if (!m_isEnabled || m_used == 0) { return false; }
+    else if (m_budget <= 0) { return true; }
+
+    // A file that can't fit even in an empty journal gets split anyway, so there's no point committing in front of it.
+    return JournalBudget::needs_commit(entryCost) && JournalBudget::fits_in_journal(entryCost);
+}
+
+bool fs::JournalBudget::fits_in_journal(int64_t size) const noexcept
+{
+    return m_budget <= 0 || align_to_block(size, SIZE_BLOCK) <= m_budget;
+}
+
+void fs::JournalBudget::consume(int64_t size) noexcept { m_used += align_to_block(size, SIZE_BLOCK); }
+
+void fs::JournalBudget::consume_entry() noexcept { m_used += SIZE_BLOCK; }
+
+bool fs::JournalBudget::commit()
+{
+    if (!JournalBudget::is_enabled()) { return true; }
+
+    m_used = 0;
+    ++m_commitCount;
+    return !error::fslib(fslib::commit_data_to_file_system(m_device));
+}
+
+int fs::JournalBudget::get_commit_count() const noexcept { return m_commitCount; }
+
+//                      ---- Static functions ----
+
+static int64_t align_to_block(int64_t size, int64_t blockSize) { return (size + blockSize - 1) / blockSize * blockSize; }
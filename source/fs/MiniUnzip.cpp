@@ -1,6 +1,7 @@
 #include "fs/MiniUnzip.hpp"
 
 #include "error.hpp"
+#include "fs/zip_io.hpp"
 #include "logging/logger.hpp"
 
 //                      ---- Construction ----
@@ -17,10 +18,12 @@ bool fs::MiniUnzip::open(const fslib::Path &path)
 {
     MiniUnzip::close();
 
-    const std::string pathString = path.string();
-    m_unz                        = unzOpen64(pathString.c_str());
+    const std::string pathString      = path.string();
+    zlib_filefunc64_def fileFunctions = fs::get_zip_file_functions();
+    m_unz                             = unzOpen2_64(pathString.c_str(), &fileFunctions);
     if (error::is_null(m_unz) || !MiniUnzip::reset()) { return false; }
     m_isOpen = true;
+    m_path   = path;
     return true;
 }
 
@@ -61,6 +64,23 @@ bool fs::MiniUnzip::reset()
     return firstFile && getInfo && opened;
 }
 
+bool fs::MiniUnzip::next_entry()
+{
+    if (unzGoToNextFile(m_unz) != UNZ_OK) { return false; }
+    return unzGetCurrentFileInfo64(m_unz, &m_fileInfo, m_filename, FS_MAX_PATH, nullptr, 0, nullptr, 0) == UNZ_OK;
+}
+
+bool fs::MiniUnzip::get_position(unz64_file_pos &position) { return unzGetFilePos64(m_unz, &position) == UNZ_OK; }
+
+bool fs::MiniUnzip::go_to_position(const unz64_file_pos &position)
+{
+    if (unzGoToFilePos64(m_unz, &position) != UNZ_OK) { return false; }
+
+    const bool getInfo = unzGetCurrentFileInfo64(m_unz, &m_fileInfo, m_filename, FS_MAX_PATH, nullptr, 0, nullptr, 0) == UNZ_OK;
+    const bool opened  = getInfo && unzOpenCurrentFile(m_unz) == UNZ_OK;
+    return getInfo && opened;
+}
+
 ssize_t fs::MiniUnzip::read(void *buffer, size_t bufferSize) { return unzReadCurrentFile(m_unz, buffer, bufferSize); }
 
 bool fs::MiniUnzip::is_directory() const noexcept
@@ -70,8 +90,27 @@ bool fs::MiniUnzip::is_directory() const noexcept
     return m_filename[length - 1] == '/';
 }
 
+const fslib::Path &fs::MiniUnzip::get_path() const noexcept { return m_path; }
+
 const char *fs::MiniUnzip::get_filename() const noexcept { return m_filename; }
 
 uint64_t fs::MiniUnzip::get_compressed_size() const noexcept { return m_fileInfo.compressed_size; }
 
 uint64_t fs::MiniUnzip::get_uncompressed_size() const noexcept { return m_fileInfo.uncompressed_size; }
+
+uint32_t fs::MiniUnzip::get_crc() const noexcept { return m_fileInfo.crc; }
+
+std::time_t fs::MiniUnzip::get_modified_time() const noexcept
+{
+    const tm_unz &date = m_fileInfo.tmu_date;
+    std::tm time{};
+    time.tm_sec   = date.tm_sec;
+    time.tm_min   = date.tm_min;
+    time.tm_hour  = date.tm_hour;
+    time.tm_mday  = date.tm_mday;
+    time.tm_mon   = date.tm_mon;
+    time.tm_year  = date.tm_year - 1900;
+    time.tm_isdst = -1;
+
+    return std::mktime(&time);
+}
@@ -2,12 +2,14 @@
 
 #include "config/config.hpp"
 #include "error.hpp"
+#include "fs/zip_io.hpp"
 #include "logging/logger.hpp"
 
 #include <ctime>
 
 // Definition at bottom.
 static zip_fileinfo create_zip_file_info();
+static std::string_view trim_device(std::string_view filename);
 
 //                      ---- Construction ----
 
@@ -17,6 +19,12 @@ fs::MiniZip::MiniZip(const fslib::Path &path)
     MiniZip::open(path);
 }
 
+fs::MiniZip::MiniZip(fs::ZipPipe &pipe, const fslib::Path &localPath)
+    : m_level(config::get_by_key(config::keys::ZIP_COMPRESSION_LEVEL))
+{
+    MiniZip::open(pipe, localPath);
+}
+
 fs::MiniZip::~MiniZip() { MiniZip::close(); }
 
 //                      ---- Public functions ----
@@ -27,10 +35,36 @@ bool fs::MiniZip::open(const fslib::Path &path)
 {
     MiniZip::close();
 
-    const std::string pathString = path.string();
-    m_zip                        = zipOpen64(pathString.c_str(), APPEND_STATUS_CREATE);
+    const std::string pathString      = path.string();
+    zlib_filefunc64_def fileFunctions = fs::get_zip_file_functions();
+    m_zip                             = zipOpen2_64(pathString.c_str(), APPEND_STATUS_CREATE, nullptr, &fileFunctions);
     if (error::is_null(m_zip)) { return false; }
-    m_isOpen = true;
+    m_isOpen        = true;
+    m_pipe          = nullptr;
+    m_path          = pathString;
+    m_deflatedCount = 0;
+    m_storedCount   = 0;
+    return true;
+}
+
+bool fs::MiniZip::open(fs::ZipPipe &pipe, const fslib::Path &localPath)
+{
+    MiniZip::close();
+
+    // An empty name tells the file functions there's no local copy.
+    const std::string pathString      = localPath.is_valid() ? localPath.string() : std::string{};
+    zlib_filefunc64_def fileFunctions = fs::get_zip_file_functions(&pipe);
+    m_zip                             = zipOpen2_64(pathString.c_str(), APPEND_STATUS_CREATE, nullptr, &fileFunctions);
+    if (error::is_null(m_zip))
+    {
+        pipe.close(false);
+        return false;
+    }
+    m_isOpen        = true;
+    m_pipe          = &pipe;
+    m_path          = pathString.empty() ? "ZIP stream" : pathString;
+    m_deflatedCount = 0;
+    m_storedCount   = 0;
     return true;
 }
 
@@ -39,6 +73,12 @@ void fs::MiniZip::close()
     if (!m_isOpen) { return; }
     zipClose(m_zip, nullptr);
     m_isOpen = false;
+
+    const int fileCount = m_deflatedCount + m_storedCount;
+    if (fileCount > 0)
+    {
+        logger::log("%s: %i files deflated, %i stored without compression.", m_path.c_str(), m_deflatedCount, m_storedCount);
+    }
 }
 
 void fs::MiniZip::add_directory(std::string_view filename)
@@ -46,18 +86,23 @@ void fs::MiniZip::add_directory(std::string_view filename)
     std::string zipPath{filename};
     if (zipPath.back() != '/') { zipPath.append("/"); }
 
-    MiniZip::open_new_file(zipPath);
+    // Directory entries have no data, so they're stored and left out of the counts.
+    MiniZip::open_entry(zipPath, 0, 0, false, 0);
     MiniZip::close_current_file();
 }
 
 bool fs::MiniZip::open_new_file(std::string_view filename, bool trimPath, size_t trimPlaces)
 {
-    const size_t pathBegin = filename.find_first_of('/');
-    if (pathBegin != filename.npos) { filename = filename.substr(pathBegin + 1); }
+    const bool opened = MiniZip::open_entry(filename, Z_DEFLATED, m_level, false, 0);
+    if (opened) { ++m_deflatedCount; }
+    return opened;
+}
 
-    const zip_fileinfo fileInfo = create_zip_file_info();
-    return zipOpenNewFileInZip64(m_zip, filename.data(), &fileInfo, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, m_level, 0) ==
-           ZIP_OK;
+bool fs::MiniZip::open_new_stored_file(std::string_view filename)
+{
+    const bool opened = MiniZip::open_entry(filename, 0, 0, false, 0);
+    if (opened) { ++m_storedCount; }
+    return opened;
 }
 
 bool fs::MiniZip::close_current_file() { return zipCloseFileInZip(m_zip) == ZIP_OK; }
@@ -68,6 +113,64 @@ bool fs::MiniZip::write(const void *buffer, size_t dataSize)
     return zipWriteInFileInZip(m_zip, buffer, dataSize) == ZIP_OK;
 }
 
+bool fs::MiniZip::open_new_raw_file(std::string_view filename, uint64_t uncompressedSize, bool stored)
+{
+    // The entry is opened raw so minizip writes the data as is. The level is still passed so the header flags match.
+    const int method  = stored ? 0 : Z_DEFLATED;
+    const int level   = stored ? 0 : m_level;
+    const bool opened = MiniZip::open_entry(filename, method, level, true, uncompressedSize);
+    if (opened && stored) { ++m_storedCount; }
+    else if (opened) { ++m_deflatedCount; }
+    return opened;
+}
+
+bool fs::MiniZip::close_raw_file(uint64_t uncompressedSize, uint32_t crc)
+{
+    return zipCloseFileInZipRaw64(m_zip, uncompressedSize, crc) == ZIP_OK;
+}
+
+bool fs::MiniZip::add_raw_file(std::string_view filename,
+                               const void *data,
+                               size_t dataSize,
+                               uint64_t uncompressedSize,
+                               uint32_t crc,
+                               bool stored)
+{
+    if (!MiniZip::open_new_raw_file(filename, uncompressedSize, stored)) { return false; }
+
+    const bool written = dataSize == 0 || MiniZip::write(data, dataSize);
+    const bool closed  = MiniZip::close_raw_file(uncompressedSize, crc);
+    return written && closed;
+}
+
+int fs::MiniZip::get_level() const noexcept { return m_level; }
+
+//                      ---- Private functions ----
+
+bool fs::MiniZip::open_entry(std::string_view filename, int method, int level, bool raw, uint64_t uncompressedSize)
+{
+    if (!m_isOpen) { return false; }
+
+    // The last entry was closed and patched, so everything before this one is final.
+    if (m_pipe) { m_pipe->release(); }
+
+    filename                    = trim_device(filename);
+    const zip_fileinfo fileInfo = create_zip_file_info();
+    const int zip64             = uncompressedSize >= 0xFFFFFFFF ? 1 : 0;
+    return zipOpenNewFileInZip2_64(m_zip,
+                                   filename.data(),
+                                   &fileInfo,
+                                   nullptr,
+                                   0,
+                                   nullptr,
+                                   0,
+                                   nullptr,
+                                   method,
+                                   level,
+                                   raw ? 1 : 0,
+                                   zip64) == ZIP_OK;
+}
+
 //                      ---- Static functions ----
 
 static zip_fileinfo create_zip_file_info()
@@ -86,3 +189,10 @@ static zip_fileinfo create_zip_file_info()
 
     return fileInfo;
 }
+
+static std::string_view trim_device(std::string_view filename)
+{
+    const size_t pathBegin = filename.find_first_of('/');
+    if (pathBegin != filename.npos) { filename = filename.substr(pathBegin + 1); }
+    return filename;
+}
@@ -0,0 +1,386 @@
+#include "fs/Snapshot.hpp"
+
+#include "error.hpp"
+#include "logging/logger.hpp"
+#include "strings/strings.hpp"
+#include "stringutil.hpp"
+#include "ui/PopMessageManager.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+namespace
+{
+    /// @brief Magic written to the beginning of snapshots. JKSS.
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x53534B4A;
+
+    /// @brief Current revision of the format.
+    constexpr uint8_t SNAPSHOT_REVISION = 0x00;
+
+    /// @brief Smallest an entry can be in the file. Path length, size, and chunk count.
+    constexpr size_t SIZE_ENTRY_MIN = sizeof(uint16_t) + sizeof(int64_t) + sizeof(uint32_t);
+
+    /// @brief Chunk boundaries are never placed before this.
+    constexpr size_t SIZE_CHUNK_MIN = 0x4000;
+
+    /// @brief Size of the window files are chunked through. Twice the max so a full chunk is always available.
+    constexpr size_t SIZE_CHUNK_WINDOW = fs::ChunkStore::SIZE_CHUNK_MAX * 2;
+
+    /// @brief A boundary is placed when the top 16 bits of the rolling hash are zero. This averages out to 64KB chunks.
+    constexpr uint64_t MASK_CHUNK_BOUNDARY = 0xFFFF000000000000;
+
+    /// @brief Random values the gear hash is rolled with. Generated with splitmix64 so every build cuts the same chunks.
+    constexpr std::array<uint64_t, 256> GEAR_TABLE = []() {
+        std::array<uint64_t, 256> table{};
+        uint64_t state = 0x4A4B53565F434443;
+        for (uint64_t &value : table)
+        {
+            state += 0x9E3779B97F4A7C15;
+            uint64_t mixed = state;
+            mixed          = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9;
+            mixed          = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EB;
+            value          = mixed ^ (mixed >> 31);
+        }
+        return table;
+    }();
+
+    // clang-format off
+    struct SnapshotHeader
+    {
+        uint32_t         magic{};
+        uint8_t          revision{};
+        uint64_t         timestamp{};
+        fs::SaveMetaData saveMeta{};
+        uint32_t         entryCount{};
+    } __attribute__((packed));
+    // clang-format on
+}
+
+// Definitions at bottom.
+static size_t find_chunk_boundary(const sys::Byte *data, size_t dataSize);
+static void append_bytes(std::vector<sys::Byte> &buffer, const void *data, size_t dataSize);
+static bool read_bytes(const sys::Byte *&cursor, const sys::Byte *end, void *dataOut, size_t dataSize);
+
+//                      ---- Construction ----
+
+fs::Snapshot::Snapshot(const fs::SaveMetaData &saveMeta)
+    : m_saveMeta(saveMeta) {};
+
+//                      ---- Public functions ----
+
+bool fs::Snapshot::build(const fslib::Path &root, fs::ChunkStore &store, sys::ProgressTask *task)
+{
+    m_timestamp = static_cast<uint64_t>(std::time(nullptr));
+    m_entries.clear();
+
+    auto window = std::make_unique<sys::Byte[]>(SIZE_CHUNK_WINDOW);
+    return Snapshot::build_directory(root, {}, store, window.get(), task);
+}
+
+bool fs::Snapshot::restore(const fslib::Path &dest,
+                           fs::ChunkStore &store,
+                           fs::JournalBudget &journal,
+                           sys::ProgressTask *task)
+{
+    auto buffer = std::make_unique<sys::Byte[]>(fs::ChunkStore::SIZE_CHUNK_MAX);
+
+    // Directories are always listed before anything inside of them.
+    bool restored{true};
+    for (const Snapshot::Entry &entry : m_entries)
+    {
+        const fslib::Path fullDest{dest / entry.path};
+        if (entry.size == SIZE_DIRECTORY)
+        {
+            const bool exists = fslib::directory_exists(fullDest);
+            if (!exists && !error::fslib(fslib::create_directories_recursively(fullDest))) { journal.consume_entry(); }
+            continue;
+        }
+
+        const bool fileRestored = Snapshot::restore_file(fullDest, entry, store, journal, buffer.get(), task);
+        if (!fileRestored) { restored = false; }
+    }
+
+    return restored;
+}
+
+bool fs::Snapshot::read(const fslib::Path &path)
+{
+    fslib::File snapshotFile{path, FsOpenMode_Read};
+    if (error::fslib(snapshotFile.is_open())) { return false; }
+
+    const int64_t fileSize = snapshotFile.get_size();
+    auto buffer            = std::make_unique<sys::Byte[]>(fileSize);
+    if (snapshotFile.read(buffer.get(), fileSize) != fileSize) { return false; }
+
+    const sys::Byte *cursor = buffer.get();
+    const sys::Byte *end    = buffer.get() + fileSize;
+
+    SnapshotHeader header{};
+    const bool headerRead = read_bytes(cursor, end, &header, sizeof(SnapshotHeader));
+    const bool countFits  = headerRead && header.entryCount <= static_cast<size_t>(end - cursor) / SIZE_ENTRY_MIN;
+    if (!headerRead || header.magic != SNAPSHOT_MAGIC || !countFits)
+    {
+        logger::log("Error reading snapshot %s: Invalid header.", path.string().c_str());
+        return false;
+    }
+
+    m_timestamp = header.timestamp;
+    m_saveMeta  = header.saveMeta;
+    m_entries.resize(header.entryCount);
+    for (Snapshot::Entry &entry : m_entries)
+    {
+        uint16_t pathLength{};
+        uint32_t chunkCount{};
+        const bool lengthRead = read_bytes(cursor, end, &pathLength, sizeof(uint16_t));
+        const bool pathFits   = lengthRead && static_cast<size_t>(end - cursor) >= pathLength;
+        if (pathFits)
+        {
+            entry.path.assign(reinterpret_cast<const char *>(cursor), pathLength);
+            cursor += pathLength;
+        }
+
+        const bool sizeRead  = pathFits && read_bytes(cursor, end, &entry.size, sizeof(int64_t));
+        const bool countRead = sizeRead && read_bytes(cursor, end, &chunkCount, sizeof(uint32_t));
+        const bool hashesFit = countRead && static_cast<size_t>(end - cursor) / SHA256_HASH_SIZE >= chunkCount;
+        if (!hashesFit)
+        {
+            logger::log("Error reading snapshot %s: Entry is truncated.", path.string().c_str());
+            return false;
+        }
+
+        entry.chunks.resize(chunkCount);
+        for (fs::ChunkStore::Hash &hash : entry.chunks) { read_bytes(cursor, end, hash.data(), SHA256_HASH_SIZE); }
+    }
+
+    return true;
+}
+
+bool fs::Snapshot::write(const fslib::Path &path) const
+{
+    const SnapshotHeader header = {.magic      = SNAPSHOT_MAGIC,
+                                   .revision   = SNAPSHOT_REVISION,
+                                   .timestamp  = m_timestamp,
+                                   .saveMeta   = m_saveMeta,
+                                   .entryCount = static_cast<uint32_t>(m_entries.size())};
+
+    std::vector<sys::Byte> buffer{};
+    append_bytes(buffer, &header, sizeof(SnapshotHeader));
+    for (const Snapshot::Entry &entry : m_entries)
+    {
+        const uint16_t pathLength = static_cast<uint16_t>(entry.path.length());
+        const uint32_t chunkCount = static_cast<uint32_t>(entry.chunks.size());
+        append_bytes(buffer, &pathLength, sizeof(uint16_t));
+        append_bytes(buffer, entry.path.data(), pathLength);
+        append_bytes(buffer, &entry.size, sizeof(int64_t));
+        append_bytes(buffer, &chunkCount, sizeof(uint32_t));
+        for (const fs::ChunkStore::Hash &hash : entry.chunks) { append_bytes(buffer, hash.data(), hash.size()); }
+    }
+
+    const ssize_t bufferSize = buffer.size();
+    fslib::File snapshotFile{path, FsOpenMode_Create | FsOpenMode_Write, bufferSize};
+    if (error::fslib(snapshotFile.is_open())) { return false; }
+
+    return snapshotFile.write(buffer.data(), bufferSize) == bufferSize;
+}
+
+void fs::Snapshot::collect_chunks(fs::ChunkStore::HashSet &chunks) const
+{
+    for (const Snapshot::Entry &entry : m_entries) { chunks.insert(entry.chunks.begin(), entry.chunks.end()); }
+}
+
+const fs::SaveMetaData &fs::Snapshot::get_meta() const noexcept { return m_saveMeta; }
+
+void fs::Snapshot::get_information(int64_t &fileCount, int64_t &totalSize) const noexcept
+{
+    for (const Snapshot::Entry &entry : m_entries)
+    {
+        if (entry.size == Snapshot::SIZE_DIRECTORY) { continue; }
+        totalSize += entry.size;
+        ++fileCount;
+    }
+}
+
+//                      ---- Private functions ----
+
+bool fs::Snapshot::build_directory(const fslib::Path &root,
+                                   std::string_view relative,
+                                   fs::ChunkStore &store,
+                                   sys::Byte *window,
+                                   sys::ProgressTask *task)
+{
+    const fslib::Path directoryPath{relative.empty() ? root : root / relative};
+    fslib::Directory directory{directoryPath};
+    if (error::fslib(directory.is_open())) { return false; }
+
+    for (const fslib::DirectoryEntry &dirEntry : directory)
+    {
+        const char *filename = dirEntry.get_filename();
+        if (filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
+
+        std::string path = relative.empty() ? std::string{filename} : std::string{relative} + "/" + filename;
+        if (dirEntry.is_directory())
+        {
+            m_entries.push_back({path, SIZE_DIRECTORY, {}});
+            if (!Snapshot::build_directory(root, path, store, window, task)) { return false; }
+            continue;
+        }
+
+        Snapshot::Entry entry{std::move(path), dirEntry.get_size(), {}};
+        const bool built = Snapshot::build_file(directoryPath / filename, entry, store, window, task);
+        if (!built) { return false; }
+
+        m_entries.push_back(std::move(entry));
+    }
+
+    return true;
+}
+
+bool fs::Snapshot::build_file(const fslib::Path &path,
+                              Snapshot::Entry &entry,
+                              fs::ChunkStore &store,
+                              sys::Byte *window,
+                              sys::ProgressTask *task)
+{
+    const char *ioStatus = strings::get_by_name(strings::names::IO_STATUSES, 0);
+
+    fslib::File sourceFile{path, FsOpenMode_Read};
+    if (error::fslib(sourceFile.is_open())) { return false; }
+
+    const int64_t fileSize = entry.size;
+    if (task)
+    {
+        const std::string pathString = path.string();
+        std::string status           = stringutil::get_formatted_string(ioStatus, pathString.c_str());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    // The window is kept topped off so a boundary is only ever forced at the max chunk size or the end of the file.
+    int64_t readTotal{};
+    size_t windowSize{};
+    while (readTotal < fileSize || windowSize > 0)
+    {
+        const size_t readSize = std::min(SIZE_CHUNK_WINDOW - windowSize, static_cast<size_t>(fileSize - readTotal));
+        if (readSize > 0)
+        {
+            const ssize_t read = sourceFile.read(&window[windowSize], readSize);
+            if (read <= 0)
+            {
+                logger::log("Error reading %s: %s", path.string().c_str(), fslib::error::get_string());
+                return false;
+            }
+
+            windowSize += read;
+            readTotal += read;
+        }
+
+        const size_t chunkSize = find_chunk_boundary(window, windowSize);
+        fs::ChunkStore::Hash hash{};
+        sha256CalculateHash(hash.data(), window, chunkSize);
+        if (!store.write_chunk(hash, window, chunkSize)) { return false; }
+        entry.chunks.push_back(hash);
+
+        windowSize -= chunkSize;
+        std::memmove(window, &window[chunkSize], windowSize);
+
+        if (task) { task->add_progress(static_cast<int64_t>(chunkSize)); }
+    }
+
+    if (task) { task->finish_file(); }
+    return true;
+}
+
+bool fs::Snapshot::restore_file(const fslib::Path &path,
+                                const Snapshot::Entry &entry,
+                                fs::ChunkStore &store,
+                                fs::JournalBudget &journal,
+                                sys::Byte *buffer,
+                                sys::ProgressTask *task)
+{
+    const int popTicks          = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popCommitFailed = strings::get_by_name(strings::names::IO_POPS, 0);
+    const char *ioStatus        = strings::get_by_name(strings::names::IO_STATUSES, 0);
+
+    // Commit between files while nothing is open if the whole file would fit in a fresh journal.
+    const int64_t fileSize  = entry.size;
+    const int64_t entryCost = fs::JournalBudget::get_entry_cost() + fileSize;
+    const bool commitFirst  = journal.needs_commit_before(entryCost);
+    if (commitFirst && !journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+    fslib::File destFile{path, FsOpenMode_Create | FsOpenMode_Write, fileSize};
+    if (error::fslib(destFile.is_open())) { return false; }
+    journal.consume_entry();
+
+    if (task)
+    {
+        std::string status = stringutil::get_formatted_string(ioStatus, path.get_filename());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    int64_t offset{};
+    for (const fs::ChunkStore::Hash &hash : entry.chunks)
+    {
+        const ssize_t chunkSize = store.read_chunk(hash, buffer, fs::ChunkStore::SIZE_CHUNK_MAX);
+        if (chunkSize < 0)
+        {
+            logger::log("Error restoring %s: Chunk is missing from the store.", entry.path.c_str());
+            return false;
+        }
+
+        const bool commitNeeded = journal.needs_commit(chunkSize);
+        if (commitNeeded)
+        {
+            destFile.close();
+            if (!journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+            destFile.open(path, FsOpenMode_Write);
+            destFile.seek(offset, destFile.BEGINNING);
+        }
+
+        if (destFile.write(buffer, chunkSize) != chunkSize) { return false; }
+
+        offset += chunkSize;
+        journal.consume(chunkSize);
+        if (task) { task->add_progress(chunkSize); }
+    }
+
+    if (task) { task->finish_file(); }
+    return true;
+}
+
+//                      ---- Static functions ----
+
+static size_t find_chunk_boundary(const sys::Byte *data, size_t dataSize)
+{
+    if (dataSize <= SIZE_CHUNK_MIN) { return dataSize; }
+
+    // Bytes before the minimum are skipped entirely. They'd never be a boundary anyway.
+    const size_t scanEnd = std::min(dataSize, fs::ChunkStore::SIZE_CHUNK_MAX);
+    uint64_t hash{};
+    for (size_t i = SIZE_CHUNK_MIN; i < scanEnd; i++)
+    {
+        hash = (hash << 1) + GEAR_TABLE[data[i]];
+        if ((hash & MASK_CHUNK_BOUNDARY) == 0) { return i + 1; }
+    }
+
+    return scanEnd;
+}
+
+static void append_bytes(std::vector<sys::Byte> &buffer, const void *data, size_t dataSize)
+{
+    const sys::Byte *bytes = static_cast<const sys::Byte *>(data);
+    buffer.insert(buffer.end(), bytes, bytes + dataSize);
+}
+
+static bool read_bytes(const sys::Byte *&cursor, const sys::Byte *end, void *dataOut, size_t dataSize)
+{
+    if (static_cast<size_t>(end - cursor) < dataSize) { return false; }
+
+    std::memcpy(dataOut, cursor, dataSize);
+    cursor += dataSize;
+    return true;
+}
@@ -0,0 +1,128 @@
+#include "fs/ZipIndex.hpp"
+
+#include "fs/SaveMetaData.hpp"
+#include "logging/logger.hpp"
+
+//                      ---- Construction ----
+
+fs::ZipIndex::ZipIndex(const fslib::Path &path) { ZipIndex::open(path); }
+
+//                      ---- Public functions ----
+
+bool fs::ZipIndex::open(const fslib::Path &path)
+{
+    m_path   = path;
+    m_isOpen = false;
+    m_entries.clear();
+    m_lookup.clear();
+    m_directories.clear();
+
+    fs::MiniUnzip unzip{path};
+    if (!unzip.is_open())
+    {
+        logger::log("Error indexing ZIP: %s could not be opened.", path.string().c_str());
+        return false;
+    }
+
+    // The root always exists, even if the ZIP is empty.
+    m_directories[std::string{}];
+    do {
+        ZipIndex::add_current_entry(unzip);
+    } while (unzip.next_entry());
+
+    m_isOpen = true;
+    return true;
+}
+
+bool fs::ZipIndex::is_open() const noexcept { return m_isOpen; }
+
+const fslib::Path &fs::ZipIndex::get_path() const noexcept { return m_path; }
+
+const std::vector<size_t> *fs::ZipIndex::get_directory(const std::string &directory) const
+{
+    const auto findDir = m_directories.find(directory);
+    if (findDir == m_directories.end()) { return nullptr; }
+
+    return &findDir->second;
+}
+
+const fs::ZipIndex::Entry &fs::ZipIndex::get_entry(size_t index) const { return m_entries[index]; }
+
+const fs::ZipIndex::Entry *fs::ZipIndex::find_entry(const std::string &path) const
+{
+    const auto findEntry = m_lookup.find(path);
+    if (findEntry == m_lookup.end()) { return nullptr; }
+
+    return &m_entries[findEntry->second];
+}
+
+void fs::ZipIndex::get_information(const std::string &directory,
+                                   int64_t &subDirCount,
+                                   int64_t &fileCount,
+                                   int64_t &totalSize) const
+{
+    const std::vector<size_t> *children = ZipIndex::get_directory(directory);
+    if (!children) { return; }
+
+    for (const size_t index : *children)
+    {
+        const ZipIndex::Entry &entry = m_entries[index];
+        if (entry.isDirectory)
+        {
+            ++subDirCount;
+            ZipIndex::get_information(entry.path, subDirCount, fileCount, totalSize);
+        }
+        else
+        {
+            ++fileCount;
+            totalSize += entry.size;
+        }
+    }
+}
+
+//                      ---- Private functions ----
+
+void fs::ZipIndex::add_current_entry(fs::MiniUnzip &unzip)
+{
+    std::string path       = unzip.get_filename();
+    const bool isDirectory = unzip.is_directory();
+    if (isDirectory) { path.pop_back(); }
+
+    // JKSV's own files aren't part of the save.
+    const bool isMeta = path == fs::NAME_SAVE_META || path == fs::NAME_SAVE_MANIFEST;
+    if (path.empty() || isMeta) { return; }
+
+    unz64_file_pos position{};
+    if (!unzip.get_position(position))
+    {
+        logger::log("Error indexing ZIP: Couldn't get the position of %s.", path.c_str());
+        return;
+    }
+
+    const size_t index     = ZipIndex::add_entry(path, isDirectory);
+    ZipIndex::Entry &entry = m_entries[index];
+    entry.size             = isDirectory ? 0 : static_cast<int64_t>(unzip.get_uncompressed_size());
+    entry.modified         = unzip.get_modified_time();
+    entry.position         = position;
+}
+
+size_t fs::ZipIndex::add_entry(const std::string &path, bool isDirectory)
+{
+    // Directories can be listed after something inside of them has already added them.
+    const auto findEntry = m_lookup.find(path);
+    if (findEntry != m_lookup.end()) { return findEntry->second; }
+
+    const size_t lastSlash = path.find_last_of('/');
+    const bool hasParent   = lastSlash != path.npos;
+    std::string parent     = hasParent ? path.substr(0, lastSlash) : std::string{};
+    if (hasParent) { ZipIndex::add_entry(parent, true); }
+
+    const size_t index = m_entries.size();
+    ZipIndex::Entry entry{.path = path, .name = hasParent ? path.substr(lastSlash + 1) : path, .isDirectory = isDirectory};
+    m_entries.push_back(std::move(entry));
+    m_lookup[path] = index;
+    m_directories[parent].push_back(index);
+    if (isDirectory) { m_directories[path]; }
+
+    return index;
+}
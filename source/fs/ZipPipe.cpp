@@ -0,0 +1,147 @@
+#include "fs/ZipPipe.hpp"
+
+#include "logging/logger.hpp"
+#include "sys/buffer_budget.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    /// @brief Data that was read is only erased from the front once there's at least this much of it.
+    constexpr size_t SIZE_COMPACT = 0x100000;
+
+    /// @brief Room on top of the window and entry for the write that fills them, headers, and data deflate couldn't shrink.
+    constexpr size_t SIZE_WRITE_MARGIN = 0x100000;
+}
+
+//                      ---- Construction ----
+
+fs::ZipPipe::ZipPipe(size_t windowSize, size_t entrySize)
+    : m_windowSize(windowSize > 0 ? windowSize : SIZE_DEFAULT_WINDOW)
+    , m_capacity(m_windowSize + entrySize + SIZE_WRITE_MARGIN)
+    , m_isReserved(sys::buffer_budget::try_reserve(m_capacity))
+{
+    // Reserving the whole capacity now means the vector never has to reallocate and double itself later.
+    if (m_isReserved) { m_data.reserve(m_capacity); }
+    else { m_failed = true; }
+}
+
+fs::ZipPipe::~ZipPipe()
+{
+    if (m_isReserved) { sys::buffer_budget::release(m_capacity); }
+}
+
+//                      ---- Public functions ----
+
+bool fs::ZipPipe::write(int64_t offset, const void *buffer, size_t size)
+{
+    std::unique_lock pipeGuard{m_pipeMutex};
+    m_readCondition.wait(pipeGuard,
+                         [this]() { return m_failed || m_released - m_readOffset < static_cast<int64_t>(m_windowSize); });
+    if (m_failed) { return false; }
+
+    if (offset < m_released)
+    {
+        logger::log("Error writing to ZIP pipe: Offset %lli was already released.", offset);
+        return false;
+    }
+
+    // Data that was already read is dropped early if it's the only thing keeping this from fitting.
+    const size_t readLength = m_readOffset - m_dataOffset;
+    if (offset - m_dataOffset + size > m_capacity && readLength > 0)
+    {
+        m_data.erase(m_data.begin(), m_data.begin() + readLength);
+        m_dataOffset = m_readOffset;
+    }
+
+    const size_t position = offset - m_dataOffset;
+    if (position + size > m_capacity)
+    {
+        logger::log("Error writing to ZIP pipe: Writing %zu bytes would overflow the pipe.", size);
+        return false;
+    }
+    else if (position + size > m_data.size()) { m_data.resize(position + size); }
+    std::memcpy(&m_data[position], buffer, size);
+
+    return true;
+}
+
+void fs::ZipPipe::release()
+{
+    {
+        std::lock_guard pipeGuard{m_pipeMutex};
+        m_released = m_dataOffset + static_cast<int64_t>(m_data.size());
+    }
+    m_releasedCondition.notify_one();
+}
+
+bool fs::ZipPipe::append(const void *buffer, size_t size)
+{
+    int64_t offset{};
+    {
+        std::lock_guard pipeGuard{m_pipeMutex};
+        offset = m_dataOffset + static_cast<int64_t>(m_data.size());
+    }
+
+    if (!ZipPipe::write(offset, buffer, size)) { return false; }
+    ZipPipe::release();
+
+    return true;
+}
+
+void fs::ZipPipe::close(bool success)
+{
+    {
+        std::lock_guard pipeGuard{m_pipeMutex};
+        m_released = m_dataOffset + static_cast<int64_t>(m_data.size());
+        m_closed   = true;
+        if (!success) { m_failed = true; }
+    }
+    m_releasedCondition.notify_all();
+    m_readCondition.notify_all();
+}
+
+ssize_t fs::ZipPipe::read(void *buffer, size_t size)
+{
+    std::unique_lock pipeGuard{m_pipeMutex};
+    m_releasedCondition.wait(pipeGuard, [this]() { return m_failed || m_closed || m_readOffset < m_released; });
+    if (m_failed) { return -1; }
+    else if (m_readOffset >= m_released) { return 0; }
+
+    const size_t position = m_readOffset - m_dataOffset;
+    const size_t readSize = std::min(size, static_cast<size_t>(m_released - m_readOffset));
+    std::memcpy(buffer, &m_data[position], readSize);
+    m_readOffset += readSize;
+
+    // Erasing the front shifts everything after it, so it's only done in large steps.
+    const size_t readLength = m_readOffset - m_dataOffset;
+    if (readLength >= SIZE_COMPACT)
+    {
+        m_data.erase(m_data.begin(), m_data.begin() + readLength);
+        m_dataOffset = m_readOffset;
+    }
+
+    pipeGuard.unlock();
+    m_readCondition.notify_one();
+
+    return readSize;
+}
+
+void fs::ZipPipe::abort()
+{
+    {
+        std::lock_guard pipeGuard{m_pipeMutex};
+        m_failed = true;
+    }
+    m_releasedCondition.notify_all();
+    m_readCondition.notify_all();
+}
+
+bool fs::ZipPipe::has_failed()
+{
+    std::lock_guard pipeGuard{m_pipeMutex};
+    return m_failed;
+}
+
+bool fs::ZipPipe::has_reservation() const noexcept { return m_isReserved; }
@@ -0,0 +1,341 @@
+#include "fs/ZipStreamReader.hpp"
+
+#include "logging/logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    /// @brief Size of the buffer the pipe is read into.
+    constexpr size_t SIZE_STREAM_BUFFER = 0x10000;
+
+    /// @brief Size of the local header after its signature.
+    constexpr size_t SIZE_LOCAL_HEADER = 26;
+
+    /// @brief Signatures of the records a ZIP is made of.
+    constexpr uint32_t SIGNATURE_LOCAL_HEADER      = 0x04034B50;
+    constexpr uint32_t SIGNATURE_DATA_DESCRIPTOR   = 0x08074B50;
+    constexpr uint32_t SIGNATURE_CENTRAL_DIRECTORY = 0x02014B50;
+    constexpr uint32_t SIGNATURE_END_OF_DIRECTORY  = 0x06054B50;
+
+    /// @brief ID of the extra field ZIP64 sizes are stored in.
+    constexpr uint16_t ID_EXTRA_ZIP64 = 0x0001;
+
+    /// @brief Sizes set to this in the header are in the ZIP64 extra field instead.
+    constexpr uint32_t SIZE_ZIP64_MARKER = 0xFFFFFFFF;
+
+    /// @brief General purpose flags.
+    constexpr uint16_t FLAG_ENCRYPTED       = 0x0001;
+    constexpr uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
+}
+
+// Defined at bottom.
+static uint16_t read_uint16(const sys::Byte *data);
+static uint32_t read_uint32(const sys::Byte *data);
+static uint64_t read_uint64(const sys::Byte *data);
+
+//                      ---- Construction ----
+
+fs::ZipStreamReader::ZipStreamReader(fs::ZipPipe &pipe)
+    : m_pipe(pipe)
+    , m_buffer(std::make_unique<sys::Byte[]>(SIZE_STREAM_BUFFER))
+{
+    m_streamInitialized = inflateInit2(&m_stream, -MAX_WBITS) == Z_OK;
+}
+
+fs::ZipStreamReader::~ZipStreamReader()
+{
+    if (m_streamInitialized) { inflateEnd(&m_stream); }
+}
+
+//                      ---- Public functions ----
+
+bool fs::ZipStreamReader::next_entry()
+{
+    if (m_failed || m_finished) { return false; }
+
+    // Whatever wasn't read of the current entry still has to be inflated to reach the next header. It's checked the same.
+    std::array<sys::Byte, 0x1000> skipBuffer{};
+    while (m_entryOpen && !m_entryFinished)
+    {
+        if (ZipStreamReader::read(skipBuffer.data(), skipBuffer.size()) < 0) { return false; }
+    }
+    m_entryOpen = false;
+
+    std::array<sys::Byte, 4> signatureBytes{};
+    if (!ZipStreamReader::read_exact(signatureBytes.data(), signatureBytes.size()))
+    {
+        return ZipStreamReader::fail("ZIP ended before the central directory.");
+    }
+
+    const uint32_t signature = read_uint32(signatureBytes.data());
+    if (signature == SIGNATURE_CENTRAL_DIRECTORY || signature == SIGNATURE_END_OF_DIRECTORY)
+    {
+        m_finished = ZipStreamReader::drain_pipe();
+        return false;
+    }
+    else if (signature != SIGNATURE_LOCAL_HEADER) { return ZipStreamReader::fail("Unexpected signature."); }
+
+    return ZipStreamReader::read_local_header();
+}
+
+ssize_t fs::ZipStreamReader::read(void *buffer, size_t size)
+{
+    if (m_failed || !m_entryOpen) { return -1; }
+    else if (m_entryFinished) { return 0; }
+
+    sys::Byte *dest = static_cast<sys::Byte *>(buffer);
+    size_t produced{};
+    bool finished{};
+    if (m_method == 0)
+    {
+        produced = static_cast<size_t>(std::min<uint64_t>(size, m_compressedSize - m_compressedRead));
+        if (!ZipStreamReader::read_exact(dest, produced))
+        {
+            ZipStreamReader::fail("Entry was cut short.");
+            return -1;
+        }
+
+        m_compressedRead += produced;
+        finished = m_compressedRead == m_compressedSize;
+    }
+    else
+    {
+        m_stream.next_out  = dest;
+        m_stream.avail_out = static_cast<uInt>(size);
+        while (m_stream.avail_out > 0 && !finished)
+        {
+            if (m_bufferOffset == m_bufferLength && !ZipStreamReader::fill_buffer())
+            {
+                ZipStreamReader::fail("Entry was cut short.");
+                return -1;
+            }
+
+            // Entries with a known size are never allowed to inflate past it into the next header.
+            size_t available = m_bufferLength - m_bufferOffset;
+            if (!ZipStreamReader::has_data_descriptor())
+            {
+                available = static_cast<size_t>(std::min<uint64_t>(available, m_compressedSize - m_compressedRead));
+            }
+
+            if (available == 0)
+            {
+                ZipStreamReader::fail("Deflate data doesn't end where the header says it does.");
+                return -1;
+            }
+
+            m_stream.next_in  = &m_buffer[m_bufferOffset];
+            m_stream.avail_in = static_cast<uInt>(available);
+            const int result  = inflate(&m_stream, Z_NO_FLUSH);
+            const size_t used = available - m_stream.avail_in;
+            m_bufferOffset += used;
+            m_compressedRead += used;
+
+            finished = result == Z_STREAM_END;
+            if (!finished && result != Z_OK && result != Z_BUF_ERROR)
+            {
+                ZipStreamReader::fail("Deflate data is damaged.");
+                return -1;
+            }
+        }
+        produced = size - m_stream.avail_out;
+    }
+
+    m_runningCrc = crc32(m_runningCrc, dest, static_cast<uInt>(produced));
+    m_uncompressedRead += produced;
+    if (finished)
+    {
+        m_entryFinished = true;
+        if (!ZipStreamReader::finish_entry()) { return -1; }
+    }
+
+    return produced;
+}
+
+const std::string &fs::ZipStreamReader::get_filename() const noexcept { return m_filename; }
+
+bool fs::ZipStreamReader::is_directory() const noexcept { return !m_filename.empty() && m_filename.back() == '/'; }
+
+uint64_t fs::ZipStreamReader::get_uncompressed_size() const noexcept { return m_uncompressedSize; }
+
+bool fs::ZipStreamReader::is_size_known() const noexcept { return !ZipStreamReader::has_data_descriptor(); }
+
+bool fs::ZipStreamReader::is_finished() const noexcept { return m_finished; }
+
+bool fs::ZipStreamReader::has_failed() const noexcept { return m_failed; }
+
+//                      ---- Private functions ----
+
+bool fs::ZipStreamReader::read_local_header()
+{
+    std::array<sys::Byte, SIZE_LOCAL_HEADER> header{};
+    if (!ZipStreamReader::read_exact(header.data(), header.size()))
+    {
+        return ZipStreamReader::fail("Local header was cut short.");
+    }
+
+    m_flags                    = read_uint16(&header[2]);
+    m_method                   = read_uint16(&header[4]);
+    m_crc                      = read_uint32(&header[10]);
+    m_compressedSize           = read_uint32(&header[14]);
+    m_uncompressedSize         = read_uint32(&header[18]);
+    const uint16_t nameLength  = read_uint16(&header[22]);
+    const uint16_t extraLength = read_uint16(&header[24]);
+
+    m_filename.assign(nameLength, '\0');
+    auto extra = std::make_unique<sys::Byte[]>(extraLength);
+    if (!ZipStreamReader::read_exact(m_filename.data(), nameLength) || !ZipStreamReader::read_exact(extra.get(), extraLength))
+    {
+        return ZipStreamReader::fail("Local header was cut short.");
+    }
+
+    // Sizes that don't fit in 32 bits are moved to the ZIP64 extra field in the same order.
+    m_isZip64 = false;
+    for (size_t i = 0; i + 4 <= extraLength;)
+    {
+        const uint16_t id        = read_uint16(&extra[i]);
+        const uint16_t fieldSize = read_uint16(&extra[i + 2]);
+        const size_t fieldEnd    = std::min<size_t>(i + 4 + fieldSize, extraLength);
+        size_t field             = i + 4;
+        if (id == ID_EXTRA_ZIP64)
+        {
+            m_isZip64 = true;
+            if (m_uncompressedSize == SIZE_ZIP64_MARKER && field + 8 <= fieldEnd)
+            {
+                m_uncompressedSize = read_uint64(&extra[field]);
+                field += 8;
+            }
+            if (m_compressedSize == SIZE_ZIP64_MARKER && field + 8 <= fieldEnd)
+            {
+                m_compressedSize = read_uint64(&extra[field]);
+            }
+        }
+        i = fieldEnd;
+    }
+
+    const bool isStored = m_method == 0;
+    if (m_flags & FLAG_ENCRYPTED) { return ZipStreamReader::fail("Encrypted entries aren't supported."); }
+    else if (!isStored && m_method != Z_DEFLATED) { return ZipStreamReader::fail("Compression method isn't supported."); }
+    else if (!isStored && !m_streamInitialized) { return ZipStreamReader::fail("Inflate couldn't be initialized."); }
+
+    // Stored data has no end marker, so there's no way to find where it stops without the size.
+    const bool sizeUnknown = ZipStreamReader::has_data_descriptor() && m_compressedSize == 0;
+    if (isStored && sizeUnknown && !ZipStreamReader::is_directory())
+    {
+        return ZipStreamReader::fail("Stored entries with a data descriptor can't be streamed.");
+    }
+
+    if (!isStored) { inflateReset(&m_stream); }
+    m_runningCrc       = crc32(0, nullptr, 0);
+    m_compressedRead   = 0;
+    m_uncompressedRead = 0;
+    m_entryOpen        = true;
+    m_entryFinished    = false;
+
+    return true;
+}
+
+bool fs::ZipStreamReader::finish_entry()
+{
+    if (ZipStreamReader::has_data_descriptor())
+    {
+        // The signature is optional, so the first four bytes are either it or the CRC.
+        std::array<sys::Byte, 24> descriptor{};
+        if (!ZipStreamReader::read_exact(descriptor.data(), 4))
+        {
+            return ZipStreamReader::fail("Data descriptor was cut short.");
+        }
+
+        const bool hasSignature = read_uint32(descriptor.data()) == SIGNATURE_DATA_DESCRIPTOR;
+        const size_t sizesSize  = m_isZip64 ? 16 : 8;
+        const size_t readSize   = sizesSize + (hasSignature ? 4 : 0);
+        if (!ZipStreamReader::read_exact(&descriptor[4], readSize))
+        {
+            return ZipStreamReader::fail("Data descriptor was cut short.");
+        }
+
+        const sys::Byte *fields = hasSignature ? &descriptor[4] : descriptor.data();
+        m_crc                   = read_uint32(fields);
+        m_compressedSize        = m_isZip64 ? read_uint64(&fields[4]) : read_uint32(&fields[4]);
+        m_uncompressedSize      = m_isZip64 ? read_uint64(&fields[12]) : read_uint32(&fields[8]);
+    }
+
+    if (m_runningCrc != m_crc) { return ZipStreamReader::fail("CRC doesn't match."); }
+    else if (m_compressedRead != m_compressedSize || m_uncompressedRead != m_uncompressedSize)
+    {
+        return ZipStreamReader::fail("Size doesn't match.");
+    }
+
+    return true;
+}
+
+bool fs::ZipStreamReader::fail(const char *reason)
+{
+    logger::log("Error reading %s from ZIP stream: %s", m_filename.c_str(), reason);
+    m_failed = true;
+
+    // Whatever is writing to the pipe has no reason to keep going.
+    m_pipe.abort();
+    return false;
+}
+
+bool fs::ZipStreamReader::has_data_descriptor() const noexcept { return m_flags & FLAG_DATA_DESCRIPTOR; }
+
+bool fs::ZipStreamReader::fill_buffer()
+{
+    const size_t remaining = m_bufferLength - m_bufferOffset;
+    if (remaining > 0 && m_bufferOffset > 0) { std::memmove(m_buffer.get(), &m_buffer[m_bufferOffset], remaining); }
+    m_bufferOffset = 0;
+    m_bufferLength = remaining;
+
+    const ssize_t readSize = m_pipe.read(&m_buffer[m_bufferLength], SIZE_STREAM_BUFFER - m_bufferLength);
+    if (readSize <= 0) { return false; }
+
+    m_bufferLength += readSize;
+    return true;
+}
+
+bool fs::ZipStreamReader::read_exact(void *buffer, size_t size)
+{
+    sys::Byte *dest = static_cast<sys::Byte *>(buffer);
+    for (size_t copied = 0; copied < size;)
+    {
+        if (m_bufferOffset == m_bufferLength && !ZipStreamReader::fill_buffer()) { return false; }
+
+        const size_t copySize = std::min(size - copied, m_bufferLength - m_bufferOffset);
+        std::memcpy(&dest[copied], &m_buffer[m_bufferOffset], copySize);
+        m_bufferOffset += copySize;
+        copied += copySize;
+    }
+
+    return true;
+}
+
+bool fs::ZipStreamReader::drain_pipe()
+{
+    // The central directory isn't needed, but the download should still finish cleanly.
+    m_bufferOffset = 0;
+    m_bufferLength = 0;
+    while (true)
+    {
+        const ssize_t readSize = m_pipe.read(m_buffer.get(), SIZE_STREAM_BUFFER);
+        if (readSize == 0) { return true; }
+        else if (readSize < 0) { return ZipStreamReader::fail("The end of the ZIP didn't arrive."); }
+    }
+}
+
+//                      ---- Static functions ----
+
+static uint16_t read_uint16(const sys::Byte *data) { return data[0] | (data[1] << 8); }
+
+static uint32_t read_uint32(const sys::Byte *data)
+{
+    return static_cast<uint32_t>(read_uint16(data)) | (static_cast<uint32_t>(read_uint16(&data[2])) << 16);
+}
+
+static uint64_t read_uint64(const sys::Byte *data)
+{
+    return static_cast<uint64_t>(read_uint32(data)) | (static_cast<uint64_t>(read_uint32(&data[4])) << 32);
+}
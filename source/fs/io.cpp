@@ -1,8 +1,11 @@
 #include "fs/io.hpp"
 
 #include "BufferQueue.hpp"
+#include "config/config.hpp"
 #include "error.hpp"
+#include "fs/CopyPlan.hpp"
 #include "fs/SaveMetaData.hpp"
+#include "fs/verify.hpp"
 #include "fslib.hpp"
 #include "logging/logger.hpp"
 #include "strings/strings.hpp"
@@ -10,27 +13,62 @@
 #include "sys/sys.hpp"
 #include "ui/PopMessageManager.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <zlib.h>
 
 namespace
 {
-    /// @brief Number of buffers before the queue is considered full.
-    constexpr int SIZE_QUEUE_LIMIT = 128;
+    /// @brief Device name of the SD card.
+    constexpr std::string_view DEVICE_SDMC = "sdmc";
 
-    // Size of buffer shared between threads.
-    // constexpr size_t SIZE_FILE_BUFFER = 0x600000;
-    // This one is just for testing something.
-    constexpr size_t SIZE_FILE_BUFFER = 0x80000;
+    /// @brief Range calibrated chunk sizes are allowed in as shifts. Anything else means the config is old or was edited.
+    constexpr uint8_t SHIFT_CHUNK_MIN     = 16;
+    constexpr uint8_t SHIFT_CHUNK_MAX     = 21;
+    constexpr uint8_t SHIFT_CHUNK_DEFAULT = 19;
+
+    /// @brief Range for the number of chunks in the ring shared between the reader and writer.
+    constexpr int COUNT_QUEUE_MIN     = 2;
+    constexpr int COUNT_QUEUE_MAX     = 8;
+    constexpr int COUNT_QUEUE_DEFAULT = 4;
+
+    /// @brief Number of small files a directory copy worker claims at once.
+    constexpr size_t COUNT_SMALL_BATCH = 16;
 
     // clang-format off
     struct FileThreadStruct : sys::threadpool::DataStruct
     {
-        BufferQueue bufferQueue{SIZE_QUEUE_LIMIT};
+        FileThreadStruct(size_t chunkSize) : bufferQueue(sys::stats::Pipeline::FileCopy, fs::get_queue_depth(), chunkSize) {};
+
+        BufferQueue bufferQueue;
         fslib::File *source{};
+        bool verify{};
+        uint32_t crc{};
+    };
+
+    struct DirectoryCopyStruct : sys::threadpool::DataStruct
+    {
+        fs::CopyPlan plan{};
+        sys::ProgressTask *task{};
+        size_t chunkSize{};
+        bool verify{};
+        std::atomic<size_t> nextFile{};
     };
     // clang-format on
 } // namespace
 
+// Defined at bottom.
+static size_t get_chunk_size(int64_t fileSize, size_t maxSize);
+static size_t get_copy_chunk_size(const fslib::Path &source, const fslib::Path &destination);
+static bool copy_small_file(fslib::File &sourceFile, fslib::File &destFile, int64_t fileSize, uLong *crcOut);
+static bool claim_files(DirectoryCopyStruct &copyData, size_t &firstOut, size_t &lastOut);
+static void run_directory_copy(DirectoryCopyStruct &copyData);
+static bool copy_file_synchronous(const fs::CopyPlan::Entry &entry,
+                                  sys::Byte *buffer,
+                                  size_t bufferSize,
+                                  DirectoryCopyStruct &copyData);
+
 static void read_thread_function(sys::threadpool::JobData jobData)
 {
     auto castData = std::static_pointer_cast<FileThreadStruct>(jobData);
@@ -39,14 +77,32 @@ static void read_thread_function(sys::threadpool::JobData jobData)
     fslib::File &source    = *castData->source;
     const int64_t fileSize = source.get_size();
 
+    const size_t chunkSize = bufferQueue.get_chunk_size();
+
     for (int64_t i = 0; i < fileSize;)
     {
-        auto chunkBuffer = std::make_unique<sys::Byte[]>(SIZE_FILE_BUFFER);
-        ssize_t readSize = source.read(chunkBuffer.get(), SIZE_FILE_BUFFER);
+        sys::Byte *chunkBuffer = bufferQueue.get_write_buffer();
+        if (!chunkBuffer) { break; }
 
-        while (!bufferQueue.try_push(chunkBuffer, readSize)) { BufferQueue::default_delay(); }
+        const ssize_t readSize = source.read(chunkBuffer, chunkSize);
+        if (readSize <= 0)
+        {
+            bufferQueue.close(false);
+            return;
+        }
+
+        // Hashing here overlaps with the writer instead of adding another pass over the source.
+        if (castData->verify) { castData->crc = crc32(castData->crc, chunkBuffer, static_cast<uInt>(readSize)); }
+        bufferQueue.push(readSize);
         i += readSize;
     }
+    bufferQueue.close();
+}
+
+static void directory_copy_thread_function(sys::threadpool::JobData jobData)
+{
+    auto castData = std::static_pointer_cast<DirectoryCopyStruct>(jobData);
+    run_directory_copy(*castData);
 }
 
 void fs::copy_file(const fslib::Path &source, const fslib::Path &destination, sys::ProgressTask *task)
@@ -58,6 +114,7 @@ void fs::copy_file(const fslib::Path &source, const fslib::Path &destination, sy
     if (error::fslib(sourceFile.is_open()) || error::fslib(destFile.is_open())) { return; }
 
     const int64_t sourceSize = sourceFile.get_size();
+    const bool verify        = config::get_by_key(config::keys::VERIFY_WRITES);
     if (task)
     {
         const std::string sourceString = source.string();
@@ -66,39 +123,88 @@ void fs::copy_file(const fslib::Path &source, const fslib::Path &destination, sy
         task->reset(static_cast<double>(sourceSize));
     }
 
-    auto sharedData    = std::make_shared<FileThreadStruct>();
-    sharedData->source = &sourceFile;
-    auto &bufferQueue  = sharedData->bufferQueue;
-
-    sys::threadpool::push_job(read_thread_function, sharedData);
-    for (int64_t i = 0; i < sourceSize;)
+    // Handing a few KB to another thread costs more than just copying it.
+    if (sourceSize <= fs::SIZE_SMALL_FILE)
     {
-        BufferQueue::QueuePair queuePair{};
-        while (!bufferQueue.get_front(queuePair)) { BufferQueue::default_delay(); }
+        uLong crc{};
+        const bool copied = copy_small_file(sourceFile, destFile, sourceSize, verify ? &crc : nullptr);
+        destFile.close();
+        if (task)
+        {
+            task->add_progress(sourceSize);
+            task->finish_file();
+        }
+
+        if (!copied) { logger::log("Error copying %s: %s", source.string().c_str(), fslib::error::get_string()); }
+        else if (verify) { fs::verify_file(destination, sourceSize, crc, task); }
+        return;
+    }
 
-        auto &[buffer, bufferSize] = queuePair;
-        destFile.write(buffer.get(), bufferSize);
+    const size_t chunkSize = get_chunk_size(sourceSize, get_copy_chunk_size(source, destination));
+    auto sharedData        = std::make_shared<FileThreadStruct>(chunkSize);
+    sharedData->source     = &sourceFile;
+    sharedData->verify     = verify;
+    auto &bufferQueue      = sharedData->bufferQueue;
 
-        i += bufferSize;
+    sys::threadpool::push_job(read_thread_function, sharedData);
 
-        if (task) { task->update_current(static_cast<double>(i)); }
+    bool written{true};
+    BufferQueue::Chunk chunk{};
+    while (bufferQueue.get_front(chunk))
+    {
+        written = destFile.write(chunk.buffer, chunk.size) == static_cast<ssize_t>(chunk.size);
+        bufferQueue.pop();
+        if (!written)
+        {
+            bufferQueue.abort();
+            break;
+        }
+
+        if (task) { task->add_progress(static_cast<int64_t>(chunk.size)); }
     }
+    bufferQueue.wait_closed();
+    destFile.close();
+    if (task) { task->finish_file(); }
+
+    const bool failed = bufferQueue.has_failed();
+    if (failed) { logger::log("Error copying %s: %s", source.string().c_str(), fslib::error::get_string()); }
+    else if (written && sharedData->verify) { fs::verify_file(destination, sourceSize, sharedData->crc, task); }
 }
 
 void fs::copy_file_commit(const fslib::Path &source,
                           const fslib::Path &destination,
                           int64_t journalSize,
                           sys::ProgressTask *task)
+{
+    fs::JournalBudget journal{destination.get_device_name(), journalSize};
+    fs::copy_file_commit(source, destination, journal, task);
+    fs::commit_journal(journal);
+}
+
+void fs::copy_file_commit(const fslib::Path &source,
+                          const fslib::Path &destination,
+                          fs::JournalBudget &journal,
+                          sys::ProgressTask *task)
 {
     const int popTicks                     = ui::PopMessageManager::DEFAULT_TICKS;
     const std::string_view popCommitFailed = strings::get_by_name(strings::names::IO_POPS, 0);
     const char *copyingStatus              = strings::get_by_name(strings::names::IO_STATUSES, 0);
 
     fslib::File sourceFile{source, FsOpenMode_Read};
-    fslib::File destFile{destination, FsOpenMode_Create | FsOpenMode_Write, sourceFile.get_size()};
-    if (error::fslib(sourceFile.is_open()) || error::fslib(destFile.is_open())) { return; }
+    if (error::fslib(sourceFile.is_open())) { return; }
 
+    // Committing between files is cheap since nothing is open. Only do it if the whole file would fit afterwards, otherwise
+    // it's going to be split mid-file anyway.
     const int64_t sourceSize = sourceFile.get_size();
+    const int64_t entryCost  = fs::JournalBudget::get_entry_cost() + sourceSize;
+    const bool commitFirst   = journal.needs_commit_before(entryCost);
+    if (commitFirst && !journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+    fslib::File destFile{destination, FsOpenMode_Create | FsOpenMode_Write, sourceSize};
+    if (error::fslib(destFile.is_open())) { return; }
+    journal.consume_entry();
+
+    const bool verify = config::get_by_key(config::keys::VERIFY_WRITES);
     if (task)
     {
         const std::string sourceString = source.string();
@@ -107,64 +213,98 @@ void fs::copy_file_commit(const fslib::Path &source,
         task->reset(static_cast<double>(sourceSize));
     }
 
-    auto sharedData    = std::make_shared<FileThreadStruct>();
-    sharedData->source = &sourceFile;
-    auto &bufferQueue  = sharedData->bufferQueue;
+    // If a small file fits in the journal, the commit above already made room for it. Files that can't fit at all still go
+    // through the chunked path so they can be split between commits.
+    if (sourceSize <= fs::SIZE_SMALL_FILE && journal.fits_in_journal(entryCost))
+    {
+        uLong crc{};
+        const bool copied = copy_small_file(sourceFile, destFile, sourceSize, verify ? &crc : nullptr);
+        destFile.close();
+        journal.consume(sourceSize);
+        if (task)
+        {
+            task->add_progress(sourceSize);
+            task->finish_file();
+        }
 
-    int64_t journalCount{};
+        if (!copied) { logger::log("Error copying %s: %s", source.string().c_str(), fslib::error::get_string()); }
+        else if (verify) { fs::verify_file(destination, sourceSize, crc, task); }
+        return;
+    }
+
+    const size_t chunkSize = get_chunk_size(sourceSize, get_copy_chunk_size(source, destination));
+    auto sharedData        = std::make_shared<FileThreadStruct>(chunkSize);
+    sharedData->source     = &sourceFile;
+    sharedData->verify     = verify;
+    auto &bufferQueue      = sharedData->bufferQueue;
+
+    int64_t i{};
+    bool written{true};
+    BufferQueue::Chunk chunk{};
     sys::threadpool::push_job(read_thread_function, sharedData);
-    for (int64_t i = 0; i < sourceSize;)
+    while (bufferQueue.get_front(chunk))
     {
-        BufferQueue::QueuePair queuePair{};
-        while (!bufferQueue.get_front(queuePair)) { BufferQueue::default_delay(); }
-
-        const auto &[buffer, bufferSize] = queuePair;
-        const bool needsCommit           = journalCount + static_cast<int64_t>(bufferSize) >= journalSize;
+        const size_t bufferSize = chunk.size;
+        const bool needsCommit  = journal.needs_commit(static_cast<int64_t>(bufferSize));
         if (needsCommit)
         {
             destFile.close();
-            const bool commitError = error::fslib(fslib::commit_data_to_file_system(destination.get_device_name()));
             // To do: Handle this better. Threads current have no way of communicating errors.
-            if (commitError) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+            if (!journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
 
             destFile.open(destination, FsOpenMode_Write);
             destFile.seek(i, destFile.BEGINNING);
         }
 
-        destFile.write(buffer.get(), bufferSize);
+        written = destFile.write(chunk.buffer, bufferSize) == static_cast<ssize_t>(bufferSize);
+        bufferQueue.pop();
+        if (!written)
+        {
+            bufferQueue.abort();
+            break;
+        }
 
         i += bufferSize;
-        journalCount += bufferSize;
-        if (task) { task->update_current(static_cast<double>(i)); }
+        journal.consume(static_cast<int64_t>(bufferSize));
+        if (task) { task->add_progress(static_cast<int64_t>(bufferSize)); }
     }
+    bufferQueue.wait_closed();
     destFile.close();
+    if (task) { task->finish_file(); }
 
-    const bool commitError = error::fslib(fslib::commit_data_to_file_system(destination.get_device_name()));
-    if (commitError) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+    // Reading back doesn't touch the journal, so this is safe to do before the data is committed.
+    const bool failed = bufferQueue.has_failed();
+    if (failed) { logger::log("Error copying %s: %s", source.string().c_str(), fslib::error::get_string()); }
+    else if (written && sharedData->verify) { fs::verify_file(destination, sourceSize, sharedData->crc, task); }
 }
 
 void fs::copy_directory(const fslib::Path &source, const fslib::Path &destination, sys::ProgressTask *task)
 {
-    fslib::Directory sourceDir{source};
-    if (error::fslib(sourceDir.is_open())) { return; }
-
-    for (const fslib::DirectoryEntry &entry : sourceDir)
+    auto sharedData       = std::make_shared<DirectoryCopyStruct>();
+    sharedData->plan      = fs::CopyPlan{source, destination};
+    sharedData->task      = task;
+    sharedData->chunkSize = get_copy_chunk_size(source, destination);
+    sharedData->verify    = config::get_by_key(config::keys::VERIFY_WRITES);
+
+    fs::CopyPlan &plan = sharedData->plan;
+    if (!plan.is_valid() || !plan.create_directories()) { return; }
+    plan.sort_largest_first();
+
+    if (task) { task->reset(static_cast<double>(plan.get_total_size())); }
+
+    // The calling thread is a worker too, so the pool only needs to supply the rest.
+    const size_t fileCount   = plan.get_files().size();
+    const size_t workerCount = std::min(sys::threadpool::get_thread_count(), fileCount);
+    sys::threadpool::JobGroup workers{};
+    for (size_t i = 1; i < workerCount; i++)
     {
-        const char *filename = entry.get_filename();
-        if (filename == fs::NAME_SAVE_META) { continue; }
+        workers.add(sys::threadpool::push_job(directory_copy_thread_function, sharedData));
+    }
 
-        const fslib::Path fullSource{source / filename};
-        const fslib::Path fullDest{destination / filename};
-        if (entry.is_directory())
-        {
-            const bool destExists  = fslib::directory_exists(fullDest);
-            const bool createError = !destExists && error::fslib(fslib::create_directory(fullDest));
-            if (!destExists && createError) { continue; }
+    run_directory_copy(*sharedData);
 
-            fs::copy_directory(fullSource, fullDest, task);
-        }
-        else { fs::copy_file(fullSource, fullDest, task); }
-    }
+    // Workers that haven't started by now are run here and find nothing left to claim.
+    workers.wait();
 }
 
 void fs::copy_directory_commit(const fslib::Path &source,
@@ -172,26 +312,171 @@ void fs::copy_directory_commit(const fslib::Path &source,
                                int64_t journalSize,
                                sys::ProgressTask *task)
 {
-    fslib::Directory sourceDir{source};
-    if (error::fslib(sourceDir.is_open())) { return; }
+    fs::JournalBudget journal{destination.get_device_name(), journalSize};
+    fs::copy_directory_commit(source, destination, journal, task);
+    fs::commit_journal(journal);
+}
 
-    for (const fslib::DirectoryEntry &entry : sourceDir)
+void fs::copy_directory_commit(const fslib::Path &source,
+                               const fslib::Path &destination,
+                               fs::JournalBudget &journal,
+                               sys::ProgressTask *task)
+{
+    const fs::CopyPlan plan{source, destination};
+    if (!plan.is_valid()) { return; }
+
+    // Save data can't be committed with files open for writing, so files are copied one at a time here.
+    for (const fslib::Path &directory : plan.get_directories())
     {
-        const char *filename = entry.get_filename();
-        if (filename == fs::NAME_SAVE_META) { continue; }
+        const bool exists      = fslib::directory_exists(directory);
+        const bool createError = !exists && error::fslib(fslib::create_directory(directory));
+        if (createError) { return; }
+        if (!exists) { journal.consume_entry(); }
+    }
 
-        const fslib::Path fullSource{source / filename};
-        const fslib::Path fullDest{destination / filename};
-        if (entry.is_directory())
+    for (const fs::CopyPlan::Entry &entry : plan.get_files())
+    {
+        fs::copy_file_commit(entry.source, entry.destination, journal, task);
+    }
+}
+
+void fs::commit_journal(fs::JournalBudget &journal)
+{
+    const int popTicks                     = ui::PopMessageManager::DEFAULT_TICKS;
+    const std::string_view popCommitFailed = strings::get_by_name(strings::names::IO_POPS, 0);
+
+    if (!journal.is_enabled()) { return; }
+    if (!journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+    logger::log("Restore finished after %i commit(s).", journal.get_commit_count());
+}
+
+size_t fs::get_device_chunk_size(std::string_view device)
+{
+    const bool isSD     = device == DEVICE_SDMC;
+    const uint8_t shift = config::get_by_key(isSD ? config::keys::SD_CHUNK_SHIFT : config::keys::SYSTEM_CHUNK_SHIFT);
+    const bool inRange  = shift >= SHIFT_CHUNK_MIN && shift <= SHIFT_CHUNK_MAX;
+    return static_cast<size_t>(1) << (inRange ? shift : SHIFT_CHUNK_DEFAULT);
+}
+
+int fs::get_queue_depth()
+{
+    const int depth = config::get_by_key(config::keys::IO_QUEUE_DEPTH);
+    return depth >= COUNT_QUEUE_MIN && depth <= COUNT_QUEUE_MAX ? depth : COUNT_QUEUE_DEFAULT;
+}
+
+//                      ---- Static functions ----
+
+static size_t get_chunk_size(int64_t fileSize, size_t maxSize)
+{
+    // Small files shouldn't allocate a full sized ring.
+    if (fileSize <= 0) { return 1; }
+    return std::min(static_cast<size_t>(fileSize), maxSize);
+}
+
+static size_t get_copy_chunk_size(const fslib::Path &source, const fslib::Path &destination)
+{
+    // The side that wants larger requests wins. Smaller ones only add calls on the other side.
+    const size_t sourceChunk = fs::get_device_chunk_size(source.get_device_name());
+    const size_t destChunk   = fs::get_device_chunk_size(destination.get_device_name());
+    return std::max(sourceChunk, destChunk);
+}
+
+static void run_directory_copy(DirectoryCopyStruct &copyData)
+{
+    const auto &files = copyData.plan.get_files();
+    std::unique_ptr<sys::Byte[]> buffer{};
+    size_t bufferSize{};
+
+    size_t first{}, last{};
+    while (claim_files(copyData, first, last))
+    {
+        // Files are largest first, so the first one claimed decides how big this worker's buffer needs to be.
+        if (!buffer)
         {
-            const bool destExists  = fslib::directory_exists(fullDest);
-            const bool createError = !destExists && error::fslib(fslib::create_directory(fullDest));
-            const bool commitError =
-                !createError && error::fslib(fslib::commit_data_to_file_system(fullDest.get_device_name()));
-            if (!destExists && (createError || commitError)) { continue; }
+            bufferSize = get_chunk_size(files[first].size, copyData.chunkSize);
+            buffer     = std::make_unique<sys::Byte[]>(bufferSize);
+        }
 
-            fs::copy_directory_commit(fullSource, fullDest, journalSize, task);
+        for (size_t i = first; i < last; i++)
+        {
+            const bool copied = copy_file_synchronous(files[i], buffer.get(), bufferSize, copyData);
+            if (!copied) { logger::log("Error copying %s: %s", files[i].source.string().c_str(), fslib::error::get_string()); }
         }
-        else { fs::copy_file_commit(fullSource, fullDest, journalSize, task); }
     }
 }
+
+static bool copy_file_synchronous(const fs::CopyPlan::Entry &entry,
+                                  sys::Byte *buffer,
+                                  size_t bufferSize,
+                                  DirectoryCopyStruct &copyData)
+{
+    const char *statusTemplate = strings::get_by_name(strings::names::IO_STATUSES, 0);
+    sys::ProgressTask *task    = copyData.task;
+
+    fslib::File sourceFile{entry.source, FsOpenMode_Read};
+    fslib::File destFile{entry.destination, FsOpenMode_Create | FsOpenMode_Write, entry.size};
+    if (error::fslib(sourceFile.is_open()) || error::fslib(destFile.is_open())) { return false; }
+
+    if (task)
+    {
+        const std::string sourceString = entry.source.string();
+        std::string status             = stringutil::get_formatted_string(statusTemplate, sourceString.c_str());
+        task->set_status(status);
+    }
+
+    uLong crc{};
+    for (int64_t i = 0; i < entry.size;)
+    {
+        const ssize_t readSize = sourceFile.read(buffer, bufferSize);
+        if (readSize <= 0) { return false; }
+
+        const ssize_t written = destFile.write(buffer, readSize);
+        if (written != readSize) { return false; }
+        if (copyData.verify) { crc = crc32(crc, buffer, static_cast<uInt>(readSize)); }
+
+        i += readSize;
+        if (task) { task->add_progress(readSize); }
+    }
+    destFile.close();
+    if (task) { task->finish_file(); }
+
+    // A mismatch is reported through the task. The copy itself still succeeded as far as the caller is concerned.
+    if (copyData.verify) { fs::verify_file(entry.destination, entry.size, crc, buffer, bufferSize, task); }
+    return true;
+}
+
+static bool copy_small_file(fslib::File &sourceFile, fslib::File &destFile, int64_t fileSize, uLong *crcOut)
+{
+    if (fileSize <= 0) { return true; }
+
+    auto buffer = std::make_unique<sys::Byte[]>(fileSize);
+
+    const ssize_t readSize = sourceFile.read(buffer.get(), fileSize);
+    if (readSize != fileSize) { return false; }
+
+    const ssize_t written = destFile.write(buffer.get(), fileSize);
+    if (written != fileSize) { return false; }
+
+    if (crcOut) { *crcOut = crc32(*crcOut, buffer.get(), static_cast<uInt>(fileSize)); }
+    return true;
+}
+
+static bool claim_files(DirectoryCopyStruct &copyData, size_t &firstOut, size_t &lastOut)
+{
+    // Large files are claimed one at a time so they spread across workers. Once the files are small, a whole batch is
+    // claimed at once so workers aren't trading the counter back and forth every few KB.
+    const auto &files      = copyData.plan.get_files();
+    const size_t fileCount = files.size();
+
+    size_t first = copyData.nextFile.load();
+    size_t count{};
+    do {
+        if (first >= fileCount) { return false; }
+        count = files[first].size <= fs::SIZE_SMALL_FILE ? COUNT_SMALL_BATCH : 1;
+    } while (!copyData.nextFile.compare_exchange_weak(first, first + count));
+
+    firstOut = first;
+    lastOut  = std::min(first + count, fileCount);
+    return true;
+}
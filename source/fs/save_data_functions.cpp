@@ -1,6 +1,9 @@
 #include "fs/save_data_functions.hpp"
 
 #include "error.hpp"
+#include "fs/ScopedSaveMount.hpp"
+#include "fs/directory_functions.hpp"
+#include "fs/save_mount.hpp"
 #include "logging/logger.hpp"
 
 namespace
@@ -106,3 +109,12 @@ bool fs::read_save_extra_data(const FsSaveDataInfo *saveInfo, FsSaveDataExtraDat
 
     return !readError;
 }
+
+bool fs::get_save_data_information(const FsSaveDataInfo *saveInfo, int64_t &fileCount, int64_t &totalSize)
+{
+    fs::ScopedSaveMount saveMount{fs::DEFAULT_SAVE_MOUNT, saveInfo, false};
+    if (!saveMount.is_open()) { return false; }
+
+    int64_t subDirCount{};
+    return fs::get_directory_information(fs::DEFAULT_SAVE_ROOT, subDirCount, fileCount, totalSize);
+}
@@ -0,0 +1,117 @@
+#include "fs/verify.hpp"
+
+#include "error.hpp"
+#include "fs/MiniUnzip.hpp"
+#include "logging/logger.hpp"
+#include "strings/strings.hpp"
+#include "stringutil.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <zlib.h>
+
+namespace
+{
+    /// @brief Size of the buffer used to read data back.
+    constexpr size_t SIZE_VERIFY_BUFFER = 0x80000;
+}
+
+// Defined at bottom.
+static size_t get_buffer_size(int64_t fileSize);
+
+bool fs::verify_file(const fslib::Path &path,
+                     int64_t size,
+                     uint32_t crc,
+                     sys::Byte *buffer,
+                     size_t bufferSize,
+                     sys::ProgressTask *task)
+{
+    fslib::File file{path, FsOpenMode_Read};
+    bool matches = file.is_open() && file.get_size() == size;
+
+    uLong fileCrc = crc32(0L, Z_NULL, 0);
+    for (int64_t i = 0; matches && i < size;)
+    {
+        const ssize_t readSize = file.read(buffer, bufferSize);
+        if (readSize <= 0)
+        {
+            matches = false;
+            break;
+        }
+
+        fileCrc = crc32(fileCrc, buffer, static_cast<uInt>(readSize));
+        i += readSize;
+        if (task) { task->add_progress(readSize); }
+    }
+    matches = matches && fileCrc == crc;
+
+    if (!matches)
+    {
+        logger::log("Verification failed for %s.", path.string().c_str());
+        if (task) { task->report_mismatch(); }
+    }
+
+    return matches;
+}
+
+bool fs::verify_file(const fslib::Path &path, int64_t size, uint32_t crc, sys::ProgressTask *task)
+{
+    const size_t bufferSize = get_buffer_size(size);
+    auto buffer             = std::make_unique<sys::Byte[]>(bufferSize);
+    return fs::verify_file(path, size, crc, buffer.get(), bufferSize, task);
+}
+
+bool fs::verify_zip(const fslib::Path &zipPath, sys::ProgressTask *task)
+{
+    const char *statusTemplate = strings::get_by_name(strings::names::IO_STATUSES, 7);
+
+    fs::MiniUnzip unzip{zipPath};
+    if (!unzip.is_open())
+    {
+        logger::log("Verification failed for %s: ZIP couldn't be opened.", zipPath.string().c_str());
+        if (task) { task->report_mismatch(); }
+        return false;
+    }
+
+    auto buffer = std::make_unique<sys::Byte[]>(SIZE_VERIFY_BUFFER);
+    bool allMatch{true};
+    do {
+        if (unzip.is_directory()) { continue; }
+
+        const char *filename   = unzip.get_filename();
+        const int64_t fileSize = unzip.get_uncompressed_size();
+        if (task)
+        {
+            std::string status = stringutil::get_formatted_string(statusTemplate, filename);
+            task->set_status(status);
+            task->reset(static_cast<double>(fileSize));
+        }
+
+        // minizip only compares the CRC once the whole entry has been read. Closing early would hide a short entry.
+        int64_t i{};
+        ssize_t readSize{};
+        while ((readSize = unzip.read(buffer.get(), SIZE_VERIFY_BUFFER)) > 0)
+        {
+            i += readSize;
+            if (task) { task->add_progress(readSize); }
+        }
+
+        const bool matches = readSize == 0 && i == fileSize && unzip.close_current_file();
+        if (!matches)
+        {
+            logger::log("Verification failed for %s in %s.", filename, zipPath.string().c_str());
+            if (task) { task->report_mismatch(); }
+            allMatch = false;
+        }
+    } while (unzip.next_file());
+
+    return allMatch;
+}
+
+//                      ---- Static functions ----
+
+static size_t get_buffer_size(int64_t fileSize)
+{
+    if (fileSize <= 0) { return 1; }
+    return std::min(static_cast<size_t>(fileSize), SIZE_VERIFY_BUFFER);
+}
@@ -4,42 +4,208 @@
 #include "config/config.hpp"
 #include "error.hpp"
 #include "fs/SaveMetaData.hpp"
+#include "fs/io.hpp"
+#include "fs/verify.hpp"
 #include "logging/logger.hpp"
 #include "strings/strings.hpp"
 #include "stringutil.hpp"
 #include "sys/sys.hpp"
 #include "ui/PopMessageManager.hpp"
 
+#include <algorithm>
+#include <array>
+#include <condition_variable>
 #include <cstring>
 #include <ctime>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <zlib.h>
 
 namespace
 {
-    /// @brief Buffer limit for queues.
-    constexpr int SIZE_BUFFER_LIMIT = 128;
+    /// @brief Entries larger than this are streamed by the writer instead of being deflated to memory by a worker.
+    constexpr int64_t SIZE_DEFLATE_ENTRY_MAX = 0x400000;
 
-    /// @brief Buffer size used for writing files to ZIP.
-    constexpr size_t SIZE_ZIP_BUFFER = 0x10000;
+    /// @brief Size of the buffer entries are read with before being deflated.
+    constexpr size_t SIZE_DEFLATE_READ = 0x40000;
 
-    /// @brief Buffer size used for decompressing files from ZIP.
-    constexpr size_t SIZE_UNZIP_BUFFER = 0x80000;
+    /// @brief How many entries past the last one written can be deflated ahead of time. Fewer are used if the buffer budget
+    /// can't cover them.
+    constexpr size_t COUNT_DEFLATE_AHEAD = 4;
+
+    /// @brief Size of the blocks large entries are split into.
+    constexpr size_t SIZE_DEFLATE_BLOCK = 0x100000;
+
+    /// @brief Each block is primed with this much of the data before it so splitting costs almost nothing in ratio.
+    constexpr size_t SIZE_DEFLATE_DICTIONARY = 0x8000;
+
+    /// @brief Room on top of compressBound for the empty stored block a sync flush ends with.
+    constexpr size_t SIZE_DEFLATE_FLUSH = 0x40;
+
+    /// @brief Number of blocks that can be read, deflated, or waiting to be written at once. Fewer are used if the buffer
+    /// budget can't cover them.
+    constexpr size_t COUNT_DEFLATE_BLOCKS = 4;
+
+    /// @brief How much of the start of a file is test compressed to decide whether it's worth deflating.
+    constexpr size_t SIZE_COMPRESSION_SAMPLE = 0x10000;
+
+    /// @brief Files smaller than this are always deflated. Sampling them costs more than it could save.
+    constexpr int64_t SIZE_COMPRESSION_SAMPLE_MIN = 0x1000;
+
+    /// @brief Files whose sample doesn't compress below this percentage of its size are stored instead.
+    constexpr size_t PERCENT_COMPRESSION_STORE = 97;
+
+    /// @brief Entries larger than this are streamed by the writer instead of being inflated to memory by a worker.
+    constexpr int64_t SIZE_INFLATE_ENTRY_MAX = 0x400000;
+
+    /// @brief Size of the pieces the writer streams large entries and writes inflated ones in.
+    constexpr size_t SIZE_INFLATE_WRITE = 0x40000;
+
+    /// @brief How many entries past the last one written can be inflated ahead of time. Fewer are used if the buffer budget
+    /// can't cover them.
+    constexpr size_t COUNT_INFLATE_AHEAD = 4;
 
     // Shared struct for Zip/File IO
     // clang-format off
     struct ZipReadStruct : sys::threadpool::DataStruct
     {
+        ZipReadStruct(size_t chunkSize) : bufferQueue(sys::stats::Pipeline::Zip, fs::get_queue_depth(), chunkSize) {};
+
         fslib::File *source{};
-        BufferQueue bufferQueue{SIZE_BUFFER_LIMIT};
+        BufferQueue bufferQueue;
     };
 
     struct UnzipReadStruct : sys::threadpool::DataStruct
     {
+        UnzipReadStruct(size_t chunkSize) : bufferQueue(sys::stats::Pipeline::Unzip, fs::get_queue_depth(), chunkSize) {};
+
         fs::MiniUnzip *unzip{};
-        BufferQueue bufferQueue{SIZE_BUFFER_LIMIT};
+        BufferQueue bufferQueue;
+    };
+
+    struct DeflateEntry
+    {
+        fslib::Path source{};
+        int64_t size{};
+        bool isDirectory{};
+
+        // Filled by whichever thread deflates the entry. Only read by the writer once finished is set.
+        std::unique_ptr<sys::Byte[]> data{};
+        size_t dataSize{};
+        uint32_t crc{};
+        bool stored{};
+        bool deflated{};
+        bool finished{};
+    };
+
+    struct DeflateBlock
+    {
+        // The dictionary is copied to the front of input and the block's data follows it.
+        std::unique_ptr<sys::Byte[]> input{};
+        std::unique_ptr<sys::Byte[]> output{};
+        size_t dictionarySize{};
+        size_t inputSize{};
+        size_t outputSize{};
+        uint32_t crc{};
+        bool last{};
+        bool deflated{};
+        bool finished{};
+    };
+
+    struct BlockZipStruct : sys::threadpool::DataStruct
+    {
+        std::array<DeflateBlock, COUNT_DEFLATE_BLOCKS> blocks{};
+        size_t slotCount{};
+        size_t blockCount{};
+        size_t outputSize{};
+        int level{};
+        size_t nextBlock{};
+        size_t readBlocks{};
+        bool stopped{};
+        std::mutex blockMutex{};
+        std::condition_variable blockCondition{};
+    };
+
+    struct InflateEntry
+    {
+        std::string filename{};
+        int64_t size{};
+        uint32_t crc{};
+        bool isDirectory{};
+        unz64_file_pos position{};
+
+        // Filled by whichever thread inflates the entry. Only read by the writer once finished is set.
+        std::unique_ptr<sys::Byte[]> data{};
+        bool inflated{};
+        bool finished{};
+    };
+
+    struct ParallelUnzipStruct : sys::threadpool::DataStruct
+    {
+        fslib::Path zipPath{};
+        std::vector<InflateEntry> entries{};
+        size_t aheadCount{};
+        size_t nextEntry{};
+        size_t writtenEntries{};
+        std::mutex entryMutex{};
+        std::condition_variable entryCondition{};
+    };
+
+    struct ParallelZipStruct : sys::threadpool::DataStruct
+    {
+        std::vector<DeflateEntry> entries{};
+        int level{};
+        size_t aheadCount{};
+        size_t nextEntry{};
+        size_t writtenEntries{};
+        std::mutex entryMutex{};
+        std::condition_variable entryCondition{};
     };
     // clang-format on
 } // namespace
 
+// Defined at bottom.
+static size_t get_chunk_size(int64_t fileSize, size_t maxSize);
+static bool zip_small_file(fslib::File &sourceFile, fs::MiniZip &dest, int64_t fileSize);
+static bool unzip_small_file(fs::MiniUnzip &unzip, fslib::File &destFile, int64_t fileSize);
+static void verify_extracted_file(fs::MiniUnzip &unzip, const fslib::Path &dest, int64_t fileSize, sys::ProgressTask *task);
+static void collect_zip_entries(const fslib::Path &source, std::vector<DeflateEntry> &entries);
+static bool claim_entry(ParallelZipStruct &zipData, size_t &entryOut);
+static void deflate_claimed_entry(ParallelZipStruct &zipData, size_t index, sys::Byte *readBuffer);
+static bool deflate_entry(DeflateEntry &entry, int level, sys::Byte *readBuffer);
+static bool store_entry(DeflateEntry &entry, fslib::File &sourceFile);
+static bool write_zip_entry(DeflateEntry &entry, fs::MiniZip &dest, sys::Byte *readBuffer, sys::ProgressTask *task);
+static bool zip_file_synchronous(const fslib::Path &source,
+                                 fs::MiniZip &dest,
+                                 sys::Byte *buffer,
+                                 bool store,
+                                 sys::ProgressTask *task);
+static bool zip_file_in_blocks(fslib::File &sourceFile, const fslib::Path &source, fs::MiniZip &dest, sys::ProgressTask *task);
+static bool read_block(BlockZipStruct &zipData, size_t index, fslib::File &sourceFile, int64_t fileSize);
+static bool claim_block(BlockZipStruct &zipData, size_t &blockOut);
+static void deflate_claimed_block(BlockZipStruct &zipData, size_t index);
+static bool deflate_block(DeflateBlock &block, int level, size_t outputSize);
+static bool should_store_file(fslib::File &sourceFile, int64_t fileSize, int level);
+static void collect_unzip_entries(fs::MiniUnzip &unzip, std::vector<InflateEntry> &entries);
+static bool claim_unzip_entry(ParallelUnzipStruct &unzipData, size_t &entryOut);
+static void inflate_claimed_entry(ParallelUnzipStruct &unzipData, size_t index, fs::MiniUnzip &unzip);
+static bool inflate_entry(InflateEntry &entry, fs::MiniUnzip &unzip);
+static bool create_parent_directories(const fslib::Path &path, fs::JournalBudget &journal);
+static bool write_stream_entry(fs::ZipStreamReader &reader,
+                               const fslib::Path &dest,
+                               fs::JournalBudget &journal,
+                               sys::Byte *buffer,
+                               bool &fitsOut,
+                               sys::ProgressTask *task);
+static bool read_held_entry(fs::ZipStreamReader &reader, sys::Byte *buffer, int64_t size);
+static bool write_unzip_entry(InflateEntry &entry,
+                              fs::MiniUnzip &unzip,
+                              const fslib::Path &dest,
+                              fs::JournalBudget &journal,
+                              sys::Byte *buffer,
+                              sys::ProgressTask *task);
+
 // Function for reading files for Zipping.
 static void zip_read_thread_function(sys::threadpool::JobData jobData)
 {
@@ -51,12 +217,68 @@ static void zip_read_thread_function(sys::threadpool::JobData jobData)
 
     for (int64_t i = 0; i < fileSize;)
     {
-        auto chunkBuffer = std::make_unique<sys::Byte[]>(SIZE_ZIP_BUFFER);
-        ssize_t readSize = source.read(chunkBuffer.get(), SIZE_ZIP_BUFFER);
+        sys::Byte *chunkBuffer = bufferQueue.get_write_buffer();
+        if (!chunkBuffer) { break; }
 
-        while (!bufferQueue.try_push(chunkBuffer, readSize)) { BufferQueue::default_delay(); }
+        const ssize_t readSize = source.read(chunkBuffer, bufferQueue.get_chunk_size());
+        if (readSize <= 0)
+        {
+            bufferQueue.close(false);
+            return;
+        }
+
+        bufferQueue.push(readSize);
         i += readSize;
     }
+    bufferQueue.close();
+}
+
+// Function workers use to deflate entries ahead of the writer.
+static void parallel_zip_thread_function(sys::threadpool::JobData jobData)
+{
+    auto castData = std::static_pointer_cast<ParallelZipStruct>(jobData);
+
+    auto &entries    = castData->entries;
+    auto readBuffer  = std::make_unique<sys::Byte[]>(SIZE_DEFLATE_READ);
+    auto canContinue = [&]()
+    {
+        const bool allClaimed = castData->nextEntry >= entries.size();
+        return allClaimed || castData->nextEntry < castData->writtenEntries + castData->aheadCount;
+    };
+
+    while (true)
+    {
+        size_t index{};
+        {
+            std::unique_lock entryGuard{castData->entryMutex};
+            castData->entryCondition.wait(entryGuard, canContinue);
+            if (castData->nextEntry >= entries.size()) { break; }
+            index = castData->nextEntry++;
+        }
+        deflate_claimed_entry(*castData, index, readBuffer.get());
+    }
+}
+
+// Function workers use to deflate the blocks of a single large entry.
+static void block_zip_thread_function(sys::threadpool::JobData jobData)
+{
+    auto castData    = std::static_pointer_cast<BlockZipStruct>(jobData);
+    auto canContinue = [&]()
+    {
+        const bool allClaimed = castData->stopped || castData->nextBlock >= castData->blockCount;
+        return allClaimed || castData->nextBlock < castData->readBlocks;
+    };
+
+    while (true)
+    {
+        size_t index{};
+        {
+            std::unique_lock blockGuard{castData->blockMutex};
+            castData->blockCondition.wait(blockGuard, canContinue);
+            if (!claim_block(*castData, index)) { break; }
+        }
+        deflate_claimed_block(*castData, index);
+    }
 }
 
 // Function for reading data from Zip to buffer.
@@ -70,145 +292,359 @@ static void unzip_read_thread_function(sys::threadpool::JobData jobData)
 
     for (int64_t i = 0; i < fileSize;)
     {
-        auto chunkBuffer = std::make_unique<sys::Byte[]>(SIZE_UNZIP_BUFFER);
-        ssize_t readSize = unzip.read(chunkBuffer.get(), SIZE_UNZIP_BUFFER);
+        sys::Byte *chunkBuffer = bufferQueue.get_write_buffer();
+        if (!chunkBuffer) { break; }
 
-        while (!bufferQueue.try_push(chunkBuffer, readSize)) { BufferQueue::default_delay(); }
+        const ssize_t readSize = unzip.read(chunkBuffer, bufferQueue.get_chunk_size());
+        if (readSize <= 0)
+        {
+            bufferQueue.close(false);
+            return;
+        }
+
+        bufferQueue.push(readSize);
         i += readSize;
     }
+    bufferQueue.close();
+}
+
+// Function workers use to inflate entries ahead of the writer. Each worker reads through its own handle to the ZIP.
+static void parallel_unzip_thread_function(sys::threadpool::JobData jobData)
+{
+    auto castData = std::static_pointer_cast<ParallelUnzipStruct>(jobData);
+
+    auto &entries    = castData->entries;
+    auto canContinue = [&]()
+    {
+        const bool allClaimed = castData->nextEntry >= entries.size();
+        return allClaimed || castData->nextEntry < castData->writtenEntries + castData->aheadCount;
+    };
+
+    fs::MiniUnzip unzip{};
+    while (true)
+    {
+        size_t index{};
+        {
+            std::unique_lock entryGuard{castData->entryMutex};
+            castData->entryCondition.wait(entryGuard, canContinue);
+            if (castData->nextEntry >= entries.size()) { break; }
+            index = castData->nextEntry++;
+        }
+
+        // Opened on the first claim so workers that start after everything is claimed don't bother.
+        if (!unzip.is_open()) { unzip.open(castData->zipPath); }
+        inflate_claimed_entry(*castData, index, unzip);
+    }
 }
 
 void fs::copy_directory_to_zip(const fslib::Path &source, fs::MiniZip &dest, sys::ProgressTask *task)
+{
+    auto sharedData   = std::make_shared<ParallelZipStruct>();
+    sharedData->level = dest.get_level();
+
+    auto &entries = sharedData->entries;
+    collect_zip_entries(source, entries);
+    if (entries.empty()) { return; }
+
+    // Every entry deflated ahead can hold up to the worst case for the largest one a worker will take.
+    sys::buffer_budget::Reservation reservation{COUNT_DEFLATE_AHEAD, compressBound(SIZE_DEFLATE_ENTRY_MAX)};
+    sharedData->aheadCount = reservation.get_count();
+
+    // Entries are deflated ahead by the pool while this thread appends them in order. This thread deflates too whenever
+    // the entry it needs next hasn't been picked up yet.
+    const size_t workerCount = std::min({sys::threadpool::get_thread_count(), entries.size(), sharedData->aheadCount});
+    sys::threadpool::JobGroup workers{};
+    for (size_t i = 1; i < workerCount; i++)
+    {
+        workers.add(sys::threadpool::push_job(parallel_zip_thread_function, sharedData));
+    }
+
+    auto readBuffer = std::make_unique<sys::Byte[]>(SIZE_DEFLATE_READ);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        while (true)
+        {
+            size_t index{};
+            {
+                std::unique_lock entryGuard{sharedData->entryMutex};
+                if (entries[i].finished) { break; }
+                else if (!claim_entry(*sharedData, index))
+                {
+                    sharedData->entryCondition.wait(entryGuard, [&]() { return entries[i].finished; });
+                    break;
+                }
+            }
+            deflate_claimed_entry(*sharedData, index, readBuffer.get());
+        }
+
+        DeflateEntry &entry = entries[i];
+        if (!write_zip_entry(entry, dest, readBuffer.get(), task))
+        {
+            logger::log("Error adding %s to ZIP.", entry.source.string().c_str());
+        }
+        entry.data.reset();
+
+        {
+            std::lock_guard entryGuard{sharedData->entryMutex};
+            sharedData->writtenEntries = i + 1;
+        }
+        sharedData->entryCondition.notify_all();
+    }
+
+    // Every entry is finished by this point, so the workers only need to notice there's nothing left to claim.
+    workers.wait();
+}
+
+bool fs::copy_file_to_zip(const fslib::Path &source, fs::MiniZip &dest, sys::ProgressTask *task)
 {
     const char *ioStatus = strings::get_by_name(strings::names::IO_STATUSES, 1);
 
-    fslib::Directory sourceDir{source};
-    if (error::fslib(sourceDir.is_open())) { return; }
+    fslib::File sourceFile{source, FsOpenMode_Read};
+    if (error::fslib(sourceFile.is_open())) { return false; }
 
-    for (const fslib::DirectoryEntry &entry : sourceDir)
+    // Large files are split into blocks that are deflated across the pool instead. Files that won't shrink skip all of that.
+    const int64_t fileSize = sourceFile.get_size();
+    const bool store       = should_store_file(sourceFile, fileSize, dest.get_level());
+    if (!store && fileSize > SIZE_DEFLATE_ENTRY_MAX) { return zip_file_in_blocks(sourceFile, source, dest, task); }
+
+    const std::string sourceString = source.string();
+    const bool newZipFile          = store ? dest.open_new_stored_file(sourceString) : dest.open_new_file(sourceString);
+    if (!newZipFile) { return false; }
+
+    if (task)
     {
-        const fslib::Path fullSource{source / entry};
-        if (entry.is_directory())
+        std::string status = stringutil::get_formatted_string(ioStatus, sourceString.c_str());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    if (fileSize <= fs::SIZE_SMALL_FILE)
+    {
+        const bool zipped = zip_small_file(sourceFile, dest, fileSize);
+        dest.close_current_file();
+        if (task)
         {
-            dest.add_directory(fullSource.string());
-            fs::copy_directory_to_zip(fullSource, dest, task);
+            task->add_progress(fileSize);
+            task->finish_file();
         }
-        else
+
+        if (!zipped) { logger::log("Error adding %s to ZIP.", sourceString.c_str()); }
+        return zipped;
+    }
+
+    // Reads are sized for the device the file is on. The ZIP side is buffered by minizip.
+    const size_t chunkSize = get_chunk_size(fileSize, fs::get_device_chunk_size(source.get_device_name()));
+    auto sharedData        = std::make_shared<ZipReadStruct>(chunkSize);
+    sharedData->source     = &sourceFile;
+    auto &bufferQueue      = sharedData->bufferQueue;
+
+    sys::threadpool::push_job(zip_read_thread_function, sharedData);
+
+    bool written{true};
+    BufferQueue::Chunk chunk{};
+    while (bufferQueue.get_front(chunk))
+    {
+        written = dest.write(chunk.buffer, chunk.size);
+        bufferQueue.pop();
+        if (!written)
         {
-            fslib::File sourceFile{fullSource, FsOpenMode_Read};
-            const std::string sourceString = fullSource.string();
-            const bool newZipFile          = dest.open_new_file(sourceString);
-            if (error::fslib(sourceFile.is_open()) || !newZipFile) { continue; }
+            bufferQueue.abort();
+            break;
+        }
 
-            const int64_t fileSize = sourceFile.get_size();
-            auto sharedData        = std::make_shared<ZipReadStruct>();
-            sharedData->source     = &sourceFile;
-            auto &bufferQueue      = sharedData->bufferQueue;
+        if (task) { task->add_progress(static_cast<int64_t>(chunk.size)); }
+    }
+    bufferQueue.wait_closed();
+    dest.close_current_file();
+    if (task) { task->finish_file(); }
 
-            if (task)
-            {
-                std::string status = stringutil::get_formatted_string(ioStatus, sourceString.c_str());
-                task->set_status(status);
-                task->reset(static_cast<double>(fileSize));
-            }
+    const bool failed = bufferQueue.has_failed();
+    if (failed) { logger::log("Error adding %s to ZIP.", sourceString.c_str()); }
 
-            sys::threadpool::push_job(zip_read_thread_function, sharedData);
-            for (int64_t i = 0; i < fileSize;)
-            {
-                BufferQueue::QueuePair queuePair{};
-                while (!bufferQueue.get_front(queuePair)) { BufferQueue::default_delay(); }
+    return written && !failed;
+}
+
+void fs::copy_zip_to_directory(fs::MiniUnzip &unzip, const fslib::Path &dest, int64_t journalSize, sys::ProgressTask *task)
+{
+    fs::JournalBudget journal{dest.get_device_name(), journalSize};
+    fs::copy_zip_to_directory(unzip, dest, journal, task);
+    fs::commit_journal(journal);
+}
+
+void fs::copy_zip_to_directory(fs::MiniUnzip &unzip,
+                               const fslib::Path &dest,
+                               fs::JournalBudget &journal,
+                               sys::ProgressTask *task)
+{
+    auto sharedData     = std::make_shared<ParallelUnzipStruct>();
+    sharedData->zipPath = unzip.get_path();
 
-                auto &[buffer, bufferSize] = queuePair;
-                dest.write(buffer.get(), bufferSize);
+    auto &entries = sharedData->entries;
+    collect_unzip_entries(unzip, entries);
+    if (entries.empty()) { return; }
 
-                i += bufferSize;
+    sys::buffer_budget::Reservation reservation{COUNT_INFLATE_AHEAD, static_cast<size_t>(SIZE_INFLATE_ENTRY_MAX)};
+    sharedData->aheadCount = reservation.get_count();
 
-                if (task) { task->update_current(static_cast<double>(i)); }
+    // Entries are inflated ahead by the pool through their own handles while this thread writes them in order. Writing stays
+    // on this thread so the journal is only ever touched from one place.
+    const size_t workerCount = std::min({sys::threadpool::get_thread_count(), entries.size(), sharedData->aheadCount});
+    sys::threadpool::JobGroup workers{};
+    for (size_t i = 1; i < workerCount; i++)
+    {
+        workers.add(sys::threadpool::push_job(parallel_unzip_thread_function, sharedData));
+    }
+
+    auto buffer = std::make_unique<sys::Byte[]>(SIZE_INFLATE_WRITE);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        while (true)
+        {
+            size_t index{};
+            {
+                std::unique_lock entryGuard{sharedData->entryMutex};
+                if (entries[i].finished) { break; }
+                else if (!claim_unzip_entry(*sharedData, index))
+                {
+                    sharedData->entryCondition.wait(entryGuard, [&]() { return entries[i].finished; });
+                    break;
+                }
             }
-            dest.close_current_file();
+            inflate_claimed_entry(*sharedData, index, unzip);
         }
+
+        InflateEntry &entry = entries[i];
+        if (!write_unzip_entry(entry, unzip, dest, journal, buffer.get(), task))
+        {
+            logger::log("Error extracting %s from ZIP.", entry.filename.c_str());
+        }
+        entry.data.reset();
+
+        {
+            std::lock_guard entryGuard{sharedData->entryMutex};
+            sharedData->writtenEntries = i + 1;
+        }
+        sharedData->entryCondition.notify_all();
     }
+
+    // The workers' handles to the ZIP are closed as they exit.
+    workers.wait();
 }
 
-void fs::copy_zip_to_directory(fs::MiniUnzip &unzip, const fslib::Path &dest, int64_t journalSize, sys::ProgressTask *task)
+bool fs::copy_zip_file_commit(fs::MiniUnzip &unzip,
+                              const fslib::Path &dest,
+                              fs::JournalBudget &journal,
+                              sys::ProgressTask *task)
 {
-    if (!unzip.reset()) { return; }
     const int popTicks          = ui::PopMessageManager::DEFAULT_TICKS;
     const char *popCommitFailed = strings::get_by_name(strings::names::IO_POPS, 0);
     const char *statusTemplate  = strings::get_by_name(strings::names::IO_STATUSES, 2);
-    const bool needCommits      = journalSize > 0;
 
-    do {
-        if (unzip.get_filename() == fs::NAME_SAVE_META) { continue; }
-        else if (unzip.is_directory())
+    // Commit between entries while nothing is open if the whole entry would fit in a fresh journal.
+    const int64_t fileSize  = unzip.get_uncompressed_size();
+    const int64_t entryCost = fs::JournalBudget::get_entry_cost() + fileSize;
+    const bool commitFirst  = journal.needs_commit_before(entryCost);
+    if (commitFirst && !journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+    fslib::File destFile{dest, FsOpenMode_Create | FsOpenMode_Write, fileSize};
+    if (error::fslib(destFile.is_open())) { return false; }
+    journal.consume_entry();
+
+    if (task)
+    {
+        std::string status = stringutil::get_formatted_string(statusTemplate, dest.get_filename());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    // Entries that can't fit in the journal at all still go through the chunked path so they can be split between commits.
+    const bool verify = config::get_by_key(config::keys::VERIFY_WRITES);
+    if (fileSize <= fs::SIZE_SMALL_FILE && journal.fits_in_journal(entryCost))
+    {
+        const bool extracted = unzip_small_file(unzip, destFile, fileSize);
+        destFile.close();
+        journal.consume(fileSize);
+        if (task)
         {
-            // Just do this and continue.
-            const fslib::Path dirPath{dest / unzip.get_filename()};
-            error::fslib(fslib::create_directories_recursively(dirPath));
-            continue;
+            task->add_progress(fileSize);
+            task->finish_file();
         }
 
-        fslib::Path fullDest{dest / unzip.get_filename()};
-        const size_t lastDir = fullDest.find_last_of('/');
-        if (lastDir == fullDest.NOT_FOUND) { continue; }
+        if (!extracted) { logger::log("Error extracting %s from ZIP.", unzip.get_filename()); }
+        else if (verify) { verify_extracted_file(unzip, dest, fileSize, task); }
+        return extracted;
+    }
+
+    const size_t chunkSize = get_chunk_size(fileSize, fs::get_device_chunk_size(dest.get_device_name()));
+    auto sharedData        = std::make_shared<UnzipReadStruct>(chunkSize);
+    sharedData->unzip      = &unzip;
+    auto &bufferQueue      = sharedData->bufferQueue;
 
-        if (lastDir > 0)
+    int64_t i{};
+    bool written{true};
+    BufferQueue::Chunk chunk{};
+    sys::threadpool::push_job(unzip_read_thread_function, sharedData);
+    while (bufferQueue.get_front(chunk))
+    {
+        const size_t bufferSize = chunk.size;
+        const bool commitNeeded = journal.needs_commit(static_cast<int64_t>(bufferSize));
+        if (commitNeeded)
         {
-            const fslib::Path dirPath{fullDest.sub_path(lastDir)};
-            const bool isValid     = dirPath.is_valid();
-            const bool exists      = isValid && fslib::directory_exists(dirPath);
-            const bool createError = isValid && !exists && error::fslib(fslib::create_directories_recursively(dirPath));
-            bool commitError       = !createError && error::fslib(fslib::commit_data_to_file_system(dirPath.get_device_name()));
-            if (isValid && !exists && (createError || commitError)) { continue; }
-        }
+            destFile.close();
+            if (!journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); } // To do: How to recover?
 
-        const int64_t fileSize = unzip.get_uncompressed_size();
-        fslib::File destFile{fullDest, FsOpenMode_Create | FsOpenMode_Write, fileSize};
-        if (error::fslib(destFile.is_open())) { continue; }
+            destFile.open(dest, FsOpenMode_Write);
+            destFile.seek(i, destFile.BEGINNING);
+        }
 
-        if (task)
+        written = destFile.write(chunk.buffer, bufferSize) == static_cast<ssize_t>(bufferSize);
+        bufferQueue.pop();
+        if (!written)
         {
-            std::string status = stringutil::get_formatted_string(statusTemplate, fullDest.get_filename());
-            task->set_status(status);
-            task->reset(static_cast<double>(fileSize));
+            bufferQueue.abort();
+            break;
         }
 
-        auto sharedData   = std::make_shared<UnzipReadStruct>();
-        sharedData->unzip = &unzip;
-        auto &bufferQueue = sharedData->bufferQueue;
+        i += bufferSize;
+        journal.consume(static_cast<int64_t>(bufferSize));
 
-        int64_t journalCount{};
-        sys::threadpool::push_job(unzip_read_thread_function, sharedData);
-        for (int64_t i = 0; i < fileSize;)
-        {
-            BufferQueue::QueuePair queuePair{};
-            while (!bufferQueue.get_front(queuePair)) { BufferQueue::default_delay(); }
+        if (task) { task->add_progress(static_cast<int64_t>(bufferSize)); }
+    }
+    bufferQueue.wait_closed();
+    destFile.close();
+    if (task) { task->finish_file(); }
 
-            auto &[buffer, bufferSize] = queuePair;
-            const bool commitNeeded    = needCommits && journalCount + static_cast<int64_t>(bufferSize) >= journalSize;
-            if (commitNeeded)
-            {
-                destFile.close();
-                const bool commitError = error::fslib(fslib::commit_data_to_file_system(dest.get_device_name()));
-                if (commitError) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); } // To do: How to recover?
+    const bool failed = bufferQueue.has_failed();
+    if (failed) { logger::log("Error extracting %s from ZIP.", unzip.get_filename()); }
+    else if (written && verify) { verify_extracted_file(unzip, dest, fileSize, task); }
 
-                destFile.open(fullDest, FsOpenMode_Write);
-                destFile.seek(i, destFile.BEGINNING);
-                journalCount = 0;
-            }
+    return written && !failed;
+}
 
-            destFile.write(buffer.get(), bufferSize);
+bool fs::copy_zip_stream_to_directory(fs::ZipStreamReader &reader,
+                                      const fslib::Path &dest,
+                                      fs::JournalBudget &journal,
+                                      bool &fitsOut,
+                                      sys::ProgressTask *task)
+{
+    fitsOut = true;
 
-            i += bufferSize;
-            journalCount += bufferSize;
+    // Everything goes through this one buffer. Entries up to SIZE_INFLATE_ENTRY_MAX are held in it whole.
+    sys::buffer_budget::Reservation reservation{1, static_cast<size_t>(SIZE_INFLATE_ENTRY_MAX)};
+    auto buffer = std::make_unique<sys::Byte[]>(SIZE_INFLATE_ENTRY_MAX);
+    do {
+        // JKSV's own files aren't part of the save. next_entry still checks them on the way past.
+        const std::string &filename = reader.get_filename();
+        if (filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
 
-            if (task) { task->update_current(static_cast<double>(i)); }
+        if (!write_stream_entry(reader, dest, journal, buffer.get(), fitsOut, task))
+        {
+            logger::log("Error extracting %s from ZIP stream.", filename.c_str());
+            return false;
         }
-        destFile.close();
+    } while (reader.next_entry());
 
-        const bool commitError = needCommits && error::fslib(fslib::commit_data_to_file_system(dest.get_device_name()));
-        if (commitError) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
-    } while (unzip.next_file());
+    return reader.is_finished();
 }
 
 bool fs::zip_has_contents(const fslib::Path &zipPath)
@@ -221,3 +657,654 @@ bool fs::zip_has_contents(const fslib::Path &zipPath)
     } while (unzip.next_file());
     return false;
 }
+
+//                      ---- Static functions ----
+
+static size_t get_chunk_size(int64_t fileSize, size_t maxSize)
+{
+    if (fileSize <= 0) { return 1; }
+    return std::min(static_cast<size_t>(fileSize), maxSize);
+}
+
+static bool zip_small_file(fslib::File &sourceFile, fs::MiniZip &dest, int64_t fileSize)
+{
+    if (fileSize <= 0) { return true; }
+
+    auto buffer            = std::make_unique<sys::Byte[]>(fileSize);
+    const ssize_t readSize = sourceFile.read(buffer.get(), fileSize);
+    return readSize == fileSize && dest.write(buffer.get(), fileSize);
+}
+
+static bool unzip_small_file(fs::MiniUnzip &unzip, fslib::File &destFile, int64_t fileSize)
+{
+    if (fileSize <= 0) { return true; }
+
+    // unzReadCurrentFile can return less than asked for, so this needs to loop until the whole entry is in.
+    auto buffer = std::make_unique<sys::Byte[]>(fileSize);
+    for (int64_t i = 0; i < fileSize;)
+    {
+        const ssize_t readSize = unzip.read(buffer.get() + i, fileSize - i);
+        if (readSize <= 0) { return false; }
+        i += readSize;
+    }
+
+    return destFile.write(buffer.get(), fileSize) == fileSize;
+}
+
+static void verify_extracted_file(fs::MiniUnzip &unzip, const fslib::Path &dest, int64_t fileSize, sys::ProgressTask *task)
+{
+    // minizip already checked the CRC while inflating. That same CRC is what the written file is compared against.
+    const bool crcGood = unzip.close_current_file();
+    if (!crcGood)
+    {
+        logger::log("Verification failed for %s: CRC mismatch in ZIP.", unzip.get_filename());
+        if (task) { task->report_mismatch(); }
+    }
+    else { fs::verify_file(dest, fileSize, unzip.get_crc(), task); }
+}
+
+static void collect_zip_entries(const fslib::Path &source, std::vector<DeflateEntry> &entries)
+{
+    fslib::Directory sourceDir{source};
+    if (error::fslib(sourceDir.is_open())) { return; }
+
+    for (const fslib::DirectoryEntry &entry : sourceDir)
+    {
+        const fslib::Path fullSource{source / entry};
+        const bool isDirectory = entry.is_directory();
+        entries.push_back({.source = fullSource, .size = isDirectory ? 0 : entry.get_size(), .isDirectory = isDirectory});
+
+        if (isDirectory) { collect_zip_entries(fullSource, entries); }
+    }
+}
+
+static bool claim_entry(ParallelZipStruct &zipData, size_t &entryOut)
+{
+    // The caller must hold the entry mutex.
+    const bool allClaimed = zipData.nextEntry >= zipData.entries.size();
+    const bool tooFar     = zipData.nextEntry >= zipData.writtenEntries + zipData.aheadCount;
+    if (allClaimed || tooFar) { return false; }
+
+    entryOut = zipData.nextEntry++;
+    return true;
+}
+
+static void deflate_claimed_entry(ParallelZipStruct &zipData, size_t index, sys::Byte *readBuffer)
+{
+    // Directories and large files are left for the writer. Anything that fails here is retried by the writer too.
+    DeflateEntry &entry   = zipData.entries[index];
+    const bool deflatable = !entry.isDirectory && entry.size <= SIZE_DEFLATE_ENTRY_MAX;
+    const bool deflated   = deflatable && deflate_entry(entry, zipData.level, readBuffer);
+    if (!deflated) { entry.data.reset(); }
+
+    {
+        std::lock_guard entryGuard{zipData.entryMutex};
+        entry.deflated = deflated;
+        entry.finished = true;
+    }
+    zipData.entryCondition.notify_all();
+}
+
+static bool deflate_entry(DeflateEntry &entry, int level, sys::Byte *readBuffer)
+{
+    fslib::File sourceFile{entry.source, FsOpenMode_Read};
+    if (!sourceFile.is_open()) { return false; }
+    else if (should_store_file(sourceFile, entry.size, level)) { return store_entry(entry, sourceFile); }
+
+    // Negative window bits gives a raw stream without the zlib header, which is what ZIP entries store.
+    z_stream stream{};
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) { return false; }
+
+    // The output is sized for the worst case so deflate never has to be called again for more room.
+    const uLong outputSize = deflateBound(&stream, static_cast<uLong>(entry.size));
+    entry.data             = std::make_unique<sys::Byte[]>(outputSize);
+    stream.next_out        = entry.data.get();
+    stream.avail_out       = static_cast<uInt>(outputSize);
+
+    uLong crc  = crc32(0L, Z_NULL, 0);
+    int result = Z_OK;
+    int64_t i{};
+    do {
+        const size_t wanted    = std::min(SIZE_DEFLATE_READ, static_cast<size_t>(entry.size - i));
+        const ssize_t readSize = wanted > 0 ? sourceFile.read(readBuffer, wanted) : 0;
+        if (readSize < 0 || (wanted > 0 && readSize == 0)) { break; }
+
+        crc = crc32(crc, readBuffer, static_cast<uInt>(readSize));
+        i += readSize;
+
+        stream.next_in  = readBuffer;
+        stream.avail_in = static_cast<uInt>(readSize);
+        result          = deflate(&stream, i >= entry.size ? Z_FINISH : Z_NO_FLUSH);
+    } while (result == Z_OK && i < entry.size);
+
+    const bool finished = i == entry.size && result == Z_STREAM_END;
+    entry.dataSize      = stream.total_out;
+    entry.crc           = crc;
+    deflateEnd(&stream);
+
+    return finished;
+}
+
+static bool store_entry(DeflateEntry &entry, fslib::File &sourceFile)
+{
+    // The file is read straight into the entry's buffer. Stored entries are written to the ZIP exactly as read.
+    entry.data             = std::make_unique<sys::Byte[]>(entry.size);
+    const ssize_t readSize = sourceFile.read(entry.data.get(), entry.size);
+    if (readSize != entry.size) { return false; }
+
+    entry.dataSize = entry.size;
+    entry.crc      = crc32(crc32(0L, Z_NULL, 0), entry.data.get(), static_cast<uInt>(entry.size));
+    entry.stored   = true;
+    return true;
+}
+
+static bool write_zip_entry(DeflateEntry &entry, fs::MiniZip &dest, sys::Byte *readBuffer, sys::ProgressTask *task)
+{
+    const std::string sourceString = entry.source.string();
+    if (entry.isDirectory)
+    {
+        dest.add_directory(sourceString);
+        return true;
+    }
+    else if (!entry.deflated && entry.size > SIZE_DEFLATE_ENTRY_MAX)
+    {
+        fslib::File sourceFile{entry.source, FsOpenMode_Read};
+        if (error::fslib(sourceFile.is_open())) { return false; }
+        else if (!should_store_file(sourceFile, entry.size, dest.get_level()))
+        {
+            return zip_file_in_blocks(sourceFile, entry.source, dest, task);
+        }
+
+        // zip_file_synchronous opens the file itself.
+        sourceFile.close();
+        return zip_file_synchronous(entry.source, dest, readBuffer, true, task);
+    }
+    else if (!entry.deflated) { return zip_file_synchronous(entry.source, dest, readBuffer, false, task); }
+
+    if (task)
+    {
+        const char *ioStatus = strings::get_by_name(strings::names::IO_STATUSES, 1);
+        std::string status   = stringutil::get_formatted_string(ioStatus, sourceString.c_str());
+        task->set_status(status);
+        task->reset(static_cast<double>(entry.size));
+    }
+
+    const bool added = dest.add_raw_file(sourceString, entry.data.get(), entry.dataSize, entry.size, entry.crc, entry.stored);
+    if (task)
+    {
+        task->add_progress(entry.size);
+        task->finish_file();
+    }
+    return added;
+}
+
+static bool zip_file_synchronous(const fslib::Path &source,
+                                 fs::MiniZip &dest,
+                                 sys::Byte *buffer,
+                                 bool store,
+                                 sys::ProgressTask *task)
+{
+    // The pool can be busy deflating, so this can't hand reading off to another thread the way copy_file_to_zip does.
+    const char *ioStatus = strings::get_by_name(strings::names::IO_STATUSES, 1);
+
+    fslib::File sourceFile{source, FsOpenMode_Read};
+    const std::string sourceString = source.string();
+    const bool newZipFile          = store ? dest.open_new_stored_file(sourceString) : dest.open_new_file(sourceString);
+    if (error::fslib(sourceFile.is_open()) || !newZipFile) { return false; }
+
+    const int64_t fileSize = sourceFile.get_size();
+    if (task)
+    {
+        std::string status = stringutil::get_formatted_string(ioStatus, sourceString.c_str());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    bool written{true};
+    for (int64_t i = 0; written && i < fileSize;)
+    {
+        const ssize_t readSize = sourceFile.read(buffer, SIZE_DEFLATE_READ);
+        written                = readSize > 0 && dest.write(buffer, readSize);
+        if (!written) { break; }
+
+        i += readSize;
+        if (task) { task->add_progress(readSize); }
+    }
+    dest.close_current_file();
+    if (task) { task->finish_file(); }
+
+    return written;
+}
+
+static bool zip_file_in_blocks(fslib::File &sourceFile, const fslib::Path &source, fs::MiniZip &dest, sys::ProgressTask *task)
+{
+    const char *ioStatus = strings::get_by_name(strings::names::IO_STATUSES, 1);
+
+    const int64_t fileSize         = sourceFile.get_size();
+    const std::string sourceString = source.string();
+    if (!dest.open_new_raw_file(sourceString, fileSize)) { return false; }
+
+    if (task)
+    {
+        std::string status = stringutil::get_formatted_string(ioStatus, sourceString.c_str());
+        task->set_status(status);
+        task->reset(static_cast<double>(fileSize));
+    }
+
+    auto sharedData        = std::make_shared<BlockZipStruct>();
+    sharedData->blockCount = (fileSize + SIZE_DEFLATE_BLOCK - 1) / SIZE_DEFLATE_BLOCK;
+    sharedData->outputSize = compressBound(SIZE_DEFLATE_BLOCK) + SIZE_DEFLATE_FLUSH;
+    sharedData->level      = dest.get_level();
+
+    // A single slot still works. Every block is just read, deflated, and written before the next.
+    const size_t slotSize = SIZE_DEFLATE_DICTIONARY + SIZE_DEFLATE_BLOCK + sharedData->outputSize;
+    sys::buffer_budget::Reservation reservation{COUNT_DEFLATE_BLOCKS, slotSize};
+    sharedData->slotCount = reservation.get_count();
+    for (size_t i = 0; i < sharedData->slotCount; i++)
+    {
+        DeflateBlock &block = sharedData->blocks[i];
+        block.input         = std::make_unique<sys::Byte[]>(SIZE_DEFLATE_DICTIONARY + SIZE_DEFLATE_BLOCK);
+        block.output        = std::make_unique<sys::Byte[]>(sharedData->outputSize);
+    }
+
+    const size_t slotCount   = sharedData->slotCount;
+    const size_t blockCount  = sharedData->blockCount;
+    const size_t workerCount = std::min({sys::threadpool::get_thread_count(), blockCount, slotCount});
+    sys::threadpool::JobGroup workers{};
+    for (size_t i = 1; i < workerCount; i++) { workers.add(sys::threadpool::push_job(block_zip_thread_function, sharedData)); }
+
+    // Reading stays on this thread and runs ahead as slots free up. Each block ends on a byte boundary with a sync flush and
+    // only the last one is marked final, so written back to back they form one ordinary deflate stream.
+    uLong crc = crc32(0L, Z_NULL, 0);
+    bool success{true};
+    size_t readCount{};
+    for (size_t i = 0; success && i < blockCount; i++)
+    {
+        for (; success && readCount < blockCount && readCount < i + slotCount; readCount++)
+        {
+            success = read_block(*sharedData, readCount, sourceFile, fileSize);
+        }
+        if (!success) { break; }
+
+        DeflateBlock &block = sharedData->blocks[i % slotCount];
+        while (true)
+        {
+            size_t index{};
+            {
+                std::unique_lock blockGuard{sharedData->blockMutex};
+                if (block.finished) { break; }
+                else if (!claim_block(*sharedData, index))
+                {
+                    sharedData->blockCondition.wait(blockGuard, [&]() { return block.finished; });
+                    break;
+                }
+            }
+            deflate_claimed_block(*sharedData, index);
+        }
+
+        success = block.deflated && dest.write(block.output.get(), block.outputSize);
+        if (!success) { break; }
+
+        crc = crc32_combine(crc, block.crc, static_cast<z_off_t>(block.inputSize));
+        if (task) { task->add_progress(static_cast<int64_t>(block.inputSize)); }
+    }
+
+    // Workers still waiting for blocks need to be told there won't be any more.
+    {
+        std::lock_guard blockGuard{sharedData->blockMutex};
+        sharedData->stopped = true;
+    }
+    sharedData->blockCondition.notify_all();
+    workers.wait();
+
+    const bool closed = dest.close_raw_file(fileSize, crc);
+    if (task) { task->finish_file(); }
+    if (!success) { logger::log("Error adding %s to ZIP in blocks.", sourceString.c_str()); }
+
+    return success && closed;
+}
+
+static bool read_block(BlockZipStruct &zipData, size_t index, fslib::File &sourceFile, int64_t fileSize)
+{
+    DeflateBlock &block          = zipData.blocks[index % zipData.slotCount];
+    const DeflateBlock &previous = zipData.blocks[(index + zipData.slotCount - 1) % zipData.slotCount];
+
+    // The end of the previous block is still in its slot. It can only be reused once this block has been written.
+    const size_t dictionarySize = index > 0 ? std::min(SIZE_DEFLATE_DICTIONARY, previous.inputSize) : 0;
+    if (dictionarySize > 0)
+    {
+        const sys::Byte *previousEnd = &previous.input[previous.dictionarySize + previous.inputSize];
+        std::memcpy(block.input.get(), previousEnd - dictionarySize, dictionarySize);
+    }
+
+    const int64_t offset  = static_cast<int64_t>(index * SIZE_DEFLATE_BLOCK);
+    const size_t readSize = std::min(SIZE_DEFLATE_BLOCK, static_cast<size_t>(fileSize - offset));
+    for (size_t i = 0; i < readSize;)
+    {
+        const ssize_t bytesRead = sourceFile.read(&block.input[dictionarySize + i], readSize - i);
+        if (bytesRead <= 0) { return false; }
+        i += bytesRead;
+    }
+
+    {
+        std::lock_guard blockGuard{zipData.blockMutex};
+        block.dictionarySize = dictionarySize;
+        block.inputSize      = readSize;
+        block.last           = index + 1 == zipData.blockCount;
+        block.deflated       = false;
+        block.finished       = false;
+        zipData.readBlocks   = index + 1;
+    }
+    zipData.blockCondition.notify_all();
+    return true;
+}
+
+static bool claim_block(BlockZipStruct &zipData, size_t &blockOut)
+{
+    // The caller must hold the block mutex.
+    const bool stopped = zipData.stopped || zipData.nextBlock >= zipData.blockCount;
+    if (stopped || zipData.nextBlock >= zipData.readBlocks) { return false; }
+
+    blockOut = zipData.nextBlock++;
+    return true;
+}
+
+static void deflate_claimed_block(BlockZipStruct &zipData, size_t index)
+{
+    DeflateBlock &block = zipData.blocks[index % zipData.slotCount];
+    const bool deflated = deflate_block(block, zipData.level, zipData.outputSize);
+
+    {
+        std::lock_guard blockGuard{zipData.blockMutex};
+        block.deflated = deflated;
+        block.finished = true;
+    }
+    zipData.blockCondition.notify_all();
+}
+
+static bool deflate_block(DeflateBlock &block, int level, size_t outputSize)
+{
+    z_stream stream{};
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) { return false; }
+
+    const bool hasDictionary = block.dictionarySize > 0;
+    if (hasDictionary && deflateSetDictionary(&stream, block.input.get(), static_cast<uInt>(block.dictionarySize)) != Z_OK)
+    {
+        deflateEnd(&stream);
+        return false;
+    }
+
+    sys::Byte *data  = &block.input[block.dictionarySize];
+    stream.next_in   = data;
+    stream.avail_in  = static_cast<uInt>(block.inputSize);
+    stream.next_out  = block.output.get();
+    stream.avail_out = static_cast<uInt>(outputSize);
+
+    // A sync flush with room to spare leaves nothing behind, so one call is always enough.
+    const int result    = deflate(&stream, block.last ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool complete = stream.avail_in == 0 && stream.avail_out > 0;
+    const bool deflated = complete && (block.last ? result == Z_STREAM_END : result == Z_OK);
+
+    block.outputSize = stream.total_out;
+    block.crc        = crc32(0L, data, static_cast<uInt>(block.inputSize));
+    deflateEnd(&stream);
+
+    return deflated;
+}
+
+static bool should_store_file(fslib::File &sourceFile, int64_t fileSize, int level)
+{
+    // Deflating at level 0 only wraps the data in stored blocks, so storing it outright is always better.
+    if (level == 0) { return true; }
+    else if (fileSize < SIZE_COMPRESSION_SAMPLE_MIN) { return false; }
+
+    // The sample is compressed at the fastest level. Data that doesn't shrink at all there won't at higher levels either.
+    const size_t sampleSize = std::min(SIZE_COMPRESSION_SAMPLE, static_cast<size_t>(fileSize));
+    uLongf compressedSize   = compressBound(sampleSize);
+    auto sample             = std::make_unique<sys::Byte[]>(sampleSize);
+    auto compressed         = std::make_unique<sys::Byte[]>(compressedSize);
+
+    const ssize_t readSize = sourceFile.read(sample.get(), sampleSize);
+    sourceFile.seek(0, sourceFile.BEGINNING);
+    if (readSize != static_cast<ssize_t>(sampleSize)) { return false; }
+
+    const int result = compress2(compressed.get(), &compressedSize, sample.get(), sampleSize, Z_BEST_SPEED);
+    if (result != Z_OK) { return false; }
+
+    return compressedSize * 100 >= sampleSize * PERCENT_COMPRESSION_STORE;
+}
+
+static void collect_unzip_entries(fs::MiniUnzip &unzip, std::vector<InflateEntry> &entries)
+{
+    if (!unzip.reset()) { return; }
+
+    // Only the central directory is walked here. Nothing is opened until an entry is inflated.
+    do {
+        const char *filename = unzip.get_filename();
+        if (filename == fs::NAME_SAVE_META || filename == fs::NAME_SAVE_MANIFEST) { continue; }
+
+        InflateEntry entry{.filename    = filename,
+                           .size        = static_cast<int64_t>(unzip.get_uncompressed_size()),
+                           .crc         = unzip.get_crc(),
+                           .isDirectory = unzip.is_directory()};
+        if (!unzip.get_position(entry.position)) { continue; }
+
+        entries.push_back(std::move(entry));
+    } while (unzip.next_entry());
+}
+
+static bool claim_unzip_entry(ParallelUnzipStruct &unzipData, size_t &entryOut)
+{
+    // The caller must hold the entry mutex.
+    const bool allClaimed = unzipData.nextEntry >= unzipData.entries.size();
+    const bool tooFar     = unzipData.nextEntry >= unzipData.writtenEntries + unzipData.aheadCount;
+    if (allClaimed || tooFar) { return false; }
+
+    entryOut = unzipData.nextEntry++;
+    return true;
+}
+
+static void inflate_claimed_entry(ParallelUnzipStruct &unzipData, size_t index, fs::MiniUnzip &unzip)
+{
+    // Directories and large files are left for the writer. Anything that fails here is retried by the writer too.
+    InflateEntry &entry   = unzipData.entries[index];
+    const bool inflatable = !entry.isDirectory && entry.size <= SIZE_INFLATE_ENTRY_MAX && unzip.is_open();
+    const bool inflated   = inflatable && inflate_entry(entry, unzip);
+    if (!inflated) { entry.data.reset(); }
+
+    {
+        std::lock_guard entryGuard{unzipData.entryMutex};
+        entry.inflated = inflated;
+        entry.finished = true;
+    }
+    unzipData.entryCondition.notify_all();
+}
+
+static bool inflate_entry(InflateEntry &entry, fs::MiniUnzip &unzip)
+{
+    if (!unzip.go_to_position(entry.position)) { return false; }
+
+    entry.data = std::make_unique<sys::Byte[]>(entry.size);
+    for (int64_t i = 0; i < entry.size;)
+    {
+        const ssize_t readSize = unzip.read(&entry.data[i], entry.size - i);
+        if (readSize <= 0) { return false; }
+        i += readSize;
+    }
+
+    // minizip only checks the CRC once the whole entry has been read and the entry is closed.
+    return unzip.close_current_file();
+}
+
+static bool create_parent_directories(const fslib::Path &path, fs::JournalBudget &journal)
+{
+    const size_t lastDir = path.find_last_of('/');
+    if (lastDir == path.NOT_FOUND) { return false; }
+    else if (lastDir == 0) { return true; }
+
+    const fslib::Path dirPath{path.sub_path(lastDir)};
+    if (!dirPath.is_valid() || fslib::directory_exists(dirPath)) { return true; }
+    else if (error::fslib(fslib::create_directories_recursively(dirPath))) { return false; }
+
+    journal.consume_entry();
+    return true;
+}
+
+static bool write_unzip_entry(InflateEntry &entry,
+                              fs::MiniUnzip &unzip,
+                              const fslib::Path &dest,
+                              fs::JournalBudget &journal,
+                              sys::Byte *buffer,
+                              sys::ProgressTask *task)
+{
+    const int popTicks          = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popCommitFailed = strings::get_by_name(strings::names::IO_POPS, 0);
+    const char *statusTemplate  = strings::get_by_name(strings::names::IO_STATUSES, 2);
+
+    const fslib::Path fullDest{dest / entry.filename};
+    if (entry.isDirectory)
+    {
+        const bool exists = fslib::directory_exists(fullDest);
+        if (!exists && !error::fslib(fslib::create_directories_recursively(fullDest))) { journal.consume_entry(); }
+        return true;
+    }
+    else if (!create_parent_directories(fullDest, journal)) { return false; }
+
+    // The pool can be busy inflating, so entries that weren't inflated ahead are streamed here instead of handing reading
+    // off to another thread the way copy_zip_file_commit does.
+    if (!entry.inflated && !unzip.go_to_position(entry.position)) { return false; }
+
+    // Commit between entries while nothing is open if the whole entry would fit in a fresh journal.
+    const int64_t entryCost = fs::JournalBudget::get_entry_cost() + entry.size;
+    const bool commitFirst  = journal.needs_commit_before(entryCost);
+    if (commitFirst && !journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+    fslib::File destFile{fullDest, FsOpenMode_Create | FsOpenMode_Write, entry.size};
+    if (error::fslib(destFile.is_open())) { return false; }
+    journal.consume_entry();
+
+    if (task)
+    {
+        std::string status = stringutil::get_formatted_string(statusTemplate, fullDest.get_filename());
+        task->set_status(status);
+        task->reset(static_cast<double>(entry.size));
+    }
+
+    bool written{true};
+    for (int64_t i = 0; i < entry.size;)
+    {
+        const size_t wanted = std::min(SIZE_INFLATE_WRITE, static_cast<size_t>(entry.size - i));
+        ssize_t chunkSize   = wanted;
+        sys::Byte *chunk    = entry.inflated ? &entry.data[i] : buffer;
+        if (!entry.inflated) { chunkSize = unzip.read(buffer, wanted); }
+
+        written = chunkSize > 0;
+        if (!written) { break; }
+
+        if (journal.needs_commit(chunkSize))
+        {
+            destFile.close();
+            if (!journal.commit()) { ui::PopMessageManager::push_message(popTicks, popCommitFailed); }
+
+            destFile.open(fullDest, FsOpenMode_Write);
+            destFile.seek(i, destFile.BEGINNING);
+        }
+
+        written = destFile.write(chunk, chunkSize) == chunkSize;
+        if (!written) { break; }
+
+        i += chunkSize;
+        journal.consume(chunkSize);
+        if (task) { task->add_progress(chunkSize); }
+    }
+    destFile.close();
+    if (task) { task->finish_file(); }
+
+    const bool verify = config::get_by_key(config::keys::VERIFY_WRITES);
+    if (!written) { return false; }
+    else if (verify && entry.inflated) { fs::verify_file(fullDest, entry.size, entry.crc, task); }
+    else if (verify) { verify_extracted_file(unzip, fullDest, entry.size, task); }
+
+    return true;
+}
+
+static bool write_stream_entry(fs::ZipStreamReader &reader,
+                               const fslib::Path &dest,
+                               fs::JournalBudget &journal,
+                               sys::Byte *buffer,
+                               bool &fitsOut,
+                               sys::ProgressTask *task)
+{
+    const char *statusTemplate = strings::get_by_name(strings::names::IO_STATUSES, 2);
+
+    std::string filename = reader.get_filename();
+    if (reader.is_directory())
+    {
+        filename.pop_back();
+        const fslib::Path dirPath{dest / filename};
+        const bool exists = filename.empty() || fslib::directory_exists(dirPath);
+        if (!exists && !error::fslib(fslib::create_directories_recursively(dirPath))) { journal.consume_entry(); }
+        return true;
+    }
+
+    const fslib::Path fullDest{dest / filename};
+    if (!create_parent_directories(fullDest, journal)) { return false; }
+
+    if (task)
+    {
+        std::string status = stringutil::get_formatted_string(statusTemplate, fullDest.get_filename());
+        task->set_status(status);
+    }
+
+    // Entries that fit are read and checked in full before the file is created, so a damaged one never reaches the save.
+    const int64_t size = static_cast<int64_t>(reader.get_uncompressed_size());
+    const bool held    = reader.is_size_known() && size <= SIZE_INFLATE_ENTRY_MAX;
+    if (held && !read_held_entry(reader, buffer, size)) { return false; }
+
+    // Nothing is committed until the whole stream has been checked. A stream that would need a commit stops instead.
+    const int64_t entryCost = fs::JournalBudget::get_entry_cost() + size;
+    fitsOut                 = !journal.needs_commit(entryCost);
+    if (!fitsOut) { return false; }
+
+    // Sizes from a data descriptor aren't known until the end, so the file is allowed to grow past what it's created with.
+    const uint32_t openMode = FsOpenMode_Write | FsOpenMode_Append;
+    fslib::File destFile{fullDest, FsOpenMode_Create | openMode, size};
+    if (error::fslib(destFile.is_open())) { return false; }
+    journal.consume_entry();
+
+    bool written{true};
+    for (int64_t i = 0;;)
+    {
+        const size_t heldLeft   = held ? std::min(SIZE_INFLATE_WRITE, static_cast<size_t>(size - i)) : 0;
+        const ssize_t chunkSize = held ? static_cast<ssize_t>(heldLeft) : reader.read(buffer, SIZE_INFLATE_WRITE);
+        const sys::Byte *chunk  = held ? &buffer[i] : buffer;
+
+        // Streamed entries end once the reader has checked the CRC.
+        written = chunkSize >= 0;
+        if (chunkSize <= 0) { break; }
+
+        fitsOut = !journal.needs_commit(chunkSize);
+        written = fitsOut && destFile.write(chunk, chunkSize) == chunkSize;
+        if (!written) { break; }
+
+        i += chunkSize;
+        journal.consume(chunkSize);
+    }
+    destFile.close();
+
+    return written;
+}
+
+static bool read_held_entry(fs::ZipStreamReader &reader, sys::Byte *buffer, int64_t size)
+{
+    for (int64_t i = 0; i < size;)
+    {
+        const ssize_t readSize = reader.read(&buffer[i], size - i);
+        if (readSize <= 0) { return false; }
+        i += readSize;
+    }
+
+    // The CRC is only checked once the reader sees the end of the entry, so this has to come back empty.
+    sys::Byte extra{};
+    return reader.read(&extra, 1) == 0;
+}
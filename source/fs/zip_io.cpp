@@ -0,0 +1,265 @@
+#include "fs/zip_io.hpp"
+
+#include "error.hpp"
+#include "fslib.hpp"
+#include "logging/logger.hpp"
+#include "sys/sys.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    /// @brief Size of the buffer used when writing. Local headers, data descriptors and the central directory are
+    /// written a few bytes at a time.
+    constexpr size_t SIZE_WRITE_BUFFER = 0x100000;
+
+    /// @brief Size of the buffer used when reading.
+    constexpr size_t SIZE_READ_BUFFER = 0x80000;
+
+    // clang-format off
+    struct BufferedFile
+    {
+        fslib::File file{};
+        fs::ZipPipe *pipe{};
+        std::unique_ptr<sys::Byte[]> buffer{};
+        size_t bufferSize{};
+        int64_t bufferOffset{};
+        size_t bufferLength{};
+        bool dirty{};
+        int64_t offset{};
+        int64_t fileSize{};
+        bool error{};
+    };
+    // clang-format on
+}
+
+// Defined at bottom.
+static voidpf ZCALLBACK buffered_open(voidpf opaque, const void *filename, int mode);
+static uLong ZCALLBACK buffered_read(voidpf opaque, voidpf stream, void *buffer, uLong size);
+static uLong ZCALLBACK buffered_write(voidpf opaque, voidpf stream, const void *buffer, uLong size);
+static ZPOS64_T ZCALLBACK buffered_tell(voidpf opaque, voidpf stream);
+static long ZCALLBACK buffered_seek(voidpf opaque, voidpf stream, ZPOS64_T offset, int origin);
+static int ZCALLBACK buffered_close(voidpf opaque, voidpf stream);
+static int ZCALLBACK buffered_error(voidpf opaque, voidpf stream);
+static bool flush_buffer(BufferedFile &bufferedFile);
+
+zlib_filefunc64_def fs::get_zip_file_functions(fs::ZipPipe *pipe)
+{
+    // clang-format off
+    const zlib_filefunc64_def fileFunctions = {.zopen64_file = buffered_open,
+                                               .zread_file   = buffered_read,
+                                               .zwrite_file  = buffered_write,
+                                               .ztell64_file = buffered_tell,
+                                               .zseek64_file = buffered_seek,
+                                               .zclose_file  = buffered_close,
+                                               .zerror_file  = buffered_error,
+                                               .opaque       = pipe};
+    // clang-format on
+
+    return fileFunctions;
+}
+
+//                      ---- Static functions ----
+
+static voidpf ZCALLBACK buffered_open(voidpf opaque, const void *filename, int mode)
+{
+    const bool create   = mode & ZLIB_FILEFUNC_MODE_CREATE;
+    const bool existing = mode & ZLIB_FILEFUNC_MODE_EXISTING;
+    const bool readOnly = (mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) == ZLIB_FILEFUNC_MODE_READ;
+
+    uint32_t openMode{};
+    if (create) { openMode = FsOpenMode_Create | FsOpenMode_Write | FsOpenMode_Append; }
+    else if (existing) { openMode = FsOpenMode_Read | FsOpenMode_Write | FsOpenMode_Append; }
+    else if (readOnly) { openMode = FsOpenMode_Read; }
+    else { return nullptr; }
+
+    auto bufferedFile  = std::make_unique<BufferedFile>();
+    bufferedFile->pipe = static_cast<fs::ZipPipe *>(opaque);
+
+    // Streams only going to the pipe don't have a file.
+    const char *pathString = static_cast<const char *>(filename);
+    const bool pipeOnly    = bufferedFile->pipe && (!pathString || pathString[0] == '\0');
+    if (pipeOnly) { return bufferedFile.release(); }
+
+    const fslib::Path path{pathString};
+    bufferedFile->file.open(path, openMode);
+    if (error::fslib(bufferedFile->file.is_open()))
+    {
+        logger::log("Error opening %s for minizip.", path.string().c_str());
+        return nullptr;
+    }
+
+    bufferedFile->bufferSize = readOnly ? SIZE_READ_BUFFER : SIZE_WRITE_BUFFER;
+    bufferedFile->buffer     = std::make_unique<sys::Byte[]>(bufferedFile->bufferSize);
+    bufferedFile->fileSize   = bufferedFile->file.get_size();
+
+    return bufferedFile.release();
+}
+
+static uLong ZCALLBACK buffered_read(voidpf opaque, voidpf stream, void *buffer, uLong size)
+{
+    BufferedFile &bufferedFile = *static_cast<BufferedFile *>(stream);
+    if (bufferedFile.dirty && !flush_buffer(bufferedFile)) { return 0; }
+
+    sys::Byte *dest = static_cast<sys::Byte *>(buffer);
+    uLong copied{};
+    while (copied < size)
+    {
+        const int64_t bufferEnd = bufferedFile.bufferOffset + static_cast<int64_t>(bufferedFile.bufferLength);
+        const bool inBuffer     = bufferedFile.offset >= bufferedFile.bufferOffset && bufferedFile.offset < bufferEnd;
+        const size_t remaining  = size - copied;
+        if (inBuffer)
+        {
+            const size_t bufferPosition = bufferedFile.offset - bufferedFile.bufferOffset;
+            const size_t copySize       = std::min(remaining, bufferedFile.bufferLength - bufferPosition);
+            std::memcpy(&dest[copied], &bufferedFile.buffer[bufferPosition], copySize);
+            bufferedFile.offset += copySize;
+            copied += copySize;
+            continue;
+        }
+
+        // Reads at least as large as the buffer skip it entirely.
+        const bool readDirect = remaining >= bufferedFile.bufferSize;
+        sys::Byte *target     = readDirect ? &dest[copied] : bufferedFile.buffer.get();
+        const size_t readSize = readDirect ? remaining : bufferedFile.bufferSize;
+
+        bufferedFile.file.seek(bufferedFile.offset, bufferedFile.file.BEGINNING);
+        const ssize_t read = bufferedFile.file.read(target, readSize);
+        if (read <= 0) { break; }
+
+        if (readDirect)
+        {
+            bufferedFile.offset += read;
+            copied += read;
+            continue;
+        }
+
+        bufferedFile.bufferOffset = bufferedFile.offset;
+        bufferedFile.bufferLength = read;
+    }
+
+    return copied;
+}
+
+static uLong ZCALLBACK buffered_write(voidpf opaque, voidpf stream, const void *buffer, uLong size)
+{
+    BufferedFile &bufferedFile = *static_cast<BufferedFile *>(stream);
+    if (bufferedFile.pipe && !bufferedFile.pipe->write(bufferedFile.offset, buffer, size))
+    {
+        bufferedFile.error = true;
+        return 0;
+    }
+
+    if (!bufferedFile.file.is_open())
+    {
+        bufferedFile.offset += size;
+        bufferedFile.fileSize = std::max(bufferedFile.fileSize, bufferedFile.offset);
+        return size;
+    }
+
+    // Anything cached from reading is stale once the file is written to.
+    if (!bufferedFile.dirty) { bufferedFile.bufferLength = 0; }
+
+    // Writes landing inside or right after what's buffered are merged. This catches minizip going back to patch the CRC
+    // and sizes into the local header of a file that hasn't been flushed yet.
+    const int64_t bufferEnd   = bufferedFile.bufferOffset + static_cast<int64_t>(bufferedFile.bufferLength);
+    const int64_t bufferLimit = bufferedFile.bufferOffset + static_cast<int64_t>(bufferedFile.bufferSize);
+    const int64_t writeEnd    = bufferedFile.offset + static_cast<int64_t>(size);
+    const bool isEmpty        = bufferedFile.bufferLength == 0;
+    const bool isInside       = bufferedFile.offset >= bufferedFile.bufferOffset && bufferedFile.offset <= bufferEnd;
+    const bool fits           = isEmpty || (isInside && writeEnd <= bufferLimit);
+    const bool writeDirect    = size >= bufferedFile.bufferSize;
+    if ((writeDirect || !fits) && !flush_buffer(bufferedFile)) { return 0; }
+
+    if (writeDirect)
+    {
+        bufferedFile.file.seek(bufferedFile.offset, bufferedFile.file.BEGINNING);
+        const ssize_t written = bufferedFile.file.write(buffer, size);
+        if (written != static_cast<ssize_t>(size))
+        {
+            bufferedFile.error = true;
+            return 0;
+        }
+
+        bufferedFile.offset += size;
+        bufferedFile.fileSize = std::max(bufferedFile.fileSize, bufferedFile.offset);
+        return size;
+    }
+
+    if (bufferedFile.bufferLength == 0) { bufferedFile.bufferOffset = bufferedFile.offset; }
+
+    const size_t bufferPosition = bufferedFile.offset - bufferedFile.bufferOffset;
+    std::memcpy(&bufferedFile.buffer[bufferPosition], buffer, size);
+    bufferedFile.bufferLength = std::max(bufferedFile.bufferLength, bufferPosition + size);
+    bufferedFile.dirty        = true;
+    bufferedFile.offset += size;
+    bufferedFile.fileSize = std::max(bufferedFile.fileSize, bufferedFile.offset);
+
+    return size;
+}
+
+static ZPOS64_T ZCALLBACK buffered_tell(voidpf opaque, voidpf stream)
+{
+    const BufferedFile &bufferedFile = *static_cast<const BufferedFile *>(stream);
+    return bufferedFile.offset;
+}
+
+static long ZCALLBACK buffered_seek(voidpf opaque, voidpf stream, ZPOS64_T offset, int origin)
+{
+    BufferedFile &bufferedFile = *static_cast<BufferedFile *>(stream);
+
+    // Only the position is tracked here. The file itself is seeked when the buffer is filled or flushed.
+    int64_t newOffset{};
+    switch (origin)
+    {
+        case ZLIB_FILEFUNC_SEEK_SET: newOffset = offset; break;
+        case ZLIB_FILEFUNC_SEEK_CUR: newOffset = bufferedFile.offset + offset; break;
+        case ZLIB_FILEFUNC_SEEK_END: newOffset = bufferedFile.fileSize + offset; break;
+        default:                     return -1;
+    }
+
+    if (newOffset < 0) { return -1; }
+    bufferedFile.offset = newOffset;
+    return 0;
+}
+
+static int ZCALLBACK buffered_close(voidpf opaque, voidpf stream)
+{
+    std::unique_ptr<BufferedFile> bufferedFile{static_cast<BufferedFile *>(stream)};
+
+    const bool flushed = flush_buffer(*bufferedFile);
+    bufferedFile->file.close();
+
+    const bool success = flushed && !bufferedFile->error;
+    if (bufferedFile->pipe) { bufferedFile->pipe->close(success); }
+
+    return success ? 0 : -1;
+}
+
+static int ZCALLBACK buffered_error(voidpf opaque, voidpf stream)
+{
+    const BufferedFile &bufferedFile = *static_cast<const BufferedFile *>(stream);
+    return bufferedFile.error ? 1 : 0;
+}
+
+static bool flush_buffer(BufferedFile &bufferedFile)
+{
+    const bool needsFlush     = bufferedFile.dirty && bufferedFile.bufferLength > 0;
+    const size_t length       = bufferedFile.bufferLength;
+    bufferedFile.dirty        = false;
+    bufferedFile.bufferLength = 0;
+    if (!needsFlush) { return true; }
+
+    bufferedFile.file.seek(bufferedFile.bufferOffset, bufferedFile.file.BEGINNING);
+    const ssize_t written = bufferedFile.file.write(bufferedFile.buffer.get(), length);
+    if (written != static_cast<ssize_t>(length))
+    {
+        logger::log("Error flushing ZIP buffer: %zi of %zu bytes written.", written, length);
+        bufferedFile.error = true;
+        return false;
+    }
+
+    return true;
+}
@@ -158,78 +158,55 @@ bool remote::GoogleDrive::upload_file(const fslib::Path &source, std::string_vie
         return false;
     }
 
-    curl::HeaderList headers = curl::new_header_list();
-    curl::append_header(headers, m_authHeader);
-    curl::append_header(headers, HEADER_CONTENT_TYPE_JSON);
-
-    // I don't know if I like this much. Looks like I'm using a high level language instead of a real one.
-    remote::URL url{URL_DRIVE_UPLOAD_API};
-    url.append_parameter("uploadType", "resumable");
-
-    // Json to post.
-    json::Object postJson  = json::new_object(json_object_new_object);
-    json_object *driveName = json_object_new_string(name.data());
-    json::add_object(postJson, JSON_KEY_NAME, driveName);
-    if (!m_parent.empty())
-    {
-        json_object *parentArray = json_object_new_array();
-        json_object *parentId    = json_object_new_string(m_parent.c_str());
-        json_object_array_add(parentArray, parentId);
-        json::add_object(postJson, JSON_KEY_PARENTS, parentArray);
-    }
-
-    curl::HeaderArray headerArray;
-    curl::prepare_post(m_curl);
-    curl::set_option(m_curl, CURLOPT_HTTPHEADER, headers.get());
-    curl::set_option(m_curl, CURLOPT_HEADERFUNCTION, curl::write_header_array);
-    curl::set_option(m_curl, CURLOPT_HEADERDATA, &headerArray);
-    curl::set_option(m_curl, CURLOPT_URL, url.get());
-    curl::set_option(m_curl, CURLOPT_POSTFIELDS, json_object_get_string(postJson.get()));
-
-    if (!curl::perform(m_curl)) { return false; }
-
-    // Extract the location from the headers.
     std::string location;
-    if (!curl::get_header_value(headerArray, HEADER_UPLOAD_LOCATION.data(), location))
-    {
-        logger::log("Error uploading file: Couldn't extract upload location from headers.");
-        return false;
-    }
+    if (!GoogleDrive::create_upload_session(name, location)) { return false; }
 
     const int64_t sourceSize = sourceFile.get_size();
     if (task) { task->reset(static_cast<double>(sourceSize)); }
 
-    std::string response;
     curl::UploadStruct uploadData = {.source = &sourceFile, .task = task};
-    // This is the actual upload. This doesn't need the authentication header to work for some reason?
-    curl::prepare_upload(m_curl);
-    curl::set_option(m_curl, CURLOPT_URL, location.c_str());
-    curl::set_option(m_curl, CURLOPT_READFUNCTION, curl::read_data_from_file);
-    curl::set_option(m_curl, CURLOPT_READDATA, &uploadData);
-    curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::write_response_string);
-    curl::set_option(m_curl, CURLOPT_WRITEDATA, &response);
+    return GoogleDrive::upload_to_session(location, uploadData, sourceSize);
+}
 
-    if (!curl::perform(m_curl)) { return false; }
+bool remote::GoogleDrive::queue_upload(curl::TransferEngine &engine,
+                                       const fslib::Path &source,
+                                       std::string_view name,
+                                       sys::ProgressTask *task,
+                                       Storage::UploadCallback onFinished)
+{
+    if (!GoogleDrive::token_is_valid() && !GoogleDrive::refresh_token()) { return false; }
 
-    json::Object responseParser = json::new_object(json_tokener_parse, response.c_str());
-    if (!responseParser)
+    auto transfer = std::make_unique<curl::Transfer>();
+    if (!transfer->source.open(source, FsOpenMode_Read))
     {
-        logger::log("Error uploading file: response could not be parsed.");
+        logger::log("Error queueing upload: %s", fslib::error::get_string());
         return false;
     }
 
-    json_object *id       = json::get_object(responseParser, JSON_KEY_ID);
-    json_object *filename = json::get_object(responseParser, JSON_KEY_NAME);
-    if (!id || !filename)
+    // The session is created here so only the upload itself runs on the engine.
+    std::string location;
+    if (!GoogleDrive::create_upload_session(name, location)) { return false; }
+
+    const int64_t sourceSize = transfer->source.get_size();
+    transfer->upload         = {.source = &transfer->source, .task = task};
+
+    curl::Handle &handle = transfer->handle;
+    curl::prepare_upload(handle);
+    curl::set_option(handle, CURLOPT_URL, location.c_str());
+    curl::set_option(handle, CURLOPT_UPLOAD_BUFFERSIZE, Storage::get_upload_buffer_size());
+    curl::set_option(handle, CURLOPT_READFUNCTION, curl::read_data_from_file);
+    curl::set_option(handle, CURLOPT_READDATA, &transfer->upload);
+    curl::set_option(handle, CURLOPT_WRITEFUNCTION, curl::write_response_string);
+    curl::set_option(handle, CURLOPT_WRITEDATA, &transfer->response);
+
+    // The parent is captured now since the caller is free to change directories before this finishes.
+    transfer->complete = [this, parent = m_parent, sourceSize, onFinished](curl::Transfer &transfer, bool performed)
     {
-        logger::log("Error uploading file: server response is missing data required.");
-        return false;
-    }
-
-    const char *idString   = json_object_get_string(id);
-    const char *nameString = json_object_get_string(filename);
-    m_list.emplace_back(nameString, idString, m_parent, sourceSize, false);
+        const bool uploaded = performed && GoogleDrive::add_uploaded_file(transfer.response, parent, sourceSize);
+        if (onFinished) { onFinished(uploaded); }
+    };
 
+    engine.add(std::move(transfer));
     return true;
 }
 
@@ -246,47 +223,44 @@ bool remote::GoogleDrive::patch_file(remote::Item *file, const fslib::Path &sour
         return false;
     }
 
-    curl::HeaderList header = curl::new_header_list();
-    curl::append_header(header, m_authHeader);
+    std::string location;
+    if (!GoogleDrive::create_patch_session(file, location)) { return false; }
 
-    remote::URL url{URL_DRIVE_UPLOAD_API};
-    url.append_path(file->get_id()).append_parameter("uploadType", "resumable");
+    if (task) { task->reset(static_cast<double>(sourceFile.get_size())); }
 
-    std::string response;
-    curl::HeaderArray headerArray;
-    curl::reset_handle(m_curl);
-    curl::set_option(m_curl, CURLOPT_CUSTOMREQUEST, "PATCH");
-    curl::set_option(m_curl, CURLOPT_HTTPHEADER, header.get());
-    curl::set_option(m_curl, CURLOPT_HEADERFUNCTION, curl::write_header_array);
-    curl::set_option(m_curl, CURLOPT_HEADERDATA, &headerArray);
-    curl::set_option(m_curl, CURLOPT_URL, url.get());
-    curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::write_response_string);
-    curl::set_option(m_curl, CURLOPT_WRITEDATA, &response);
+    // For some reason, this doesn't need the auth header.
+    curl::UploadStruct uploadData = {.source = &sourceFile, .task = task};
+    if (!GoogleDrive::send_to_session(location, uploadData, nullptr)) { return false; }
 
-    if (!curl::perform(m_curl)) { return false; }
+    // Update the file size with the source file size.
+    file->set_size(sourceFile.get_size());
+
+    return true;
+}
+
+bool remote::GoogleDrive::upload_stream(fs::ZipPipe &pipe, std::string_view name)
+{
+    if (!GoogleDrive::token_is_valid() && !GoogleDrive::refresh_token()) { return false; }
 
-    // This is the target location to upload to.
     std::string location;
-    if (!curl::get_header_value(headerArray, HEADER_UPLOAD_LOCATION, location))
-    {
-        logger::log(STRING_PATCH_ERROR, "Location could not be read from headers!");
-        return false;
-    }
+    if (!GoogleDrive::create_upload_session(name, location)) { return false; }
 
-    if (task) { task->reset(static_cast<double>(sourceFile.get_size())); }
+    // Without a size, curl sends this chunked the same way as the file uploads above.
+    curl::UploadStruct uploadData = {.pipe = &pipe};
+    return GoogleDrive::upload_to_session(location, uploadData, 0);
+}
 
-    // For some reason, this doesn't need the auth header.
-    curl::UploadStruct uploadData = {.source = &sourceFile, .task = task};
+bool remote::GoogleDrive::patch_stream(remote::Item *file, fs::ZipPipe &pipe)
+{
+    if (!GoogleDrive::token_is_valid() && !GoogleDrive::refresh_token()) { return false; }
 
-    curl::prepare_upload(m_curl);
-    curl::set_option(m_curl, CURLOPT_URL, location.c_str());
-    curl::set_option(m_curl, CURLOPT_READFUNCTION, curl::read_data_from_file);
-    curl::set_option(m_curl, CURLOPT_READDATA, &uploadData);
+    std::string location;
+    if (!GoogleDrive::create_patch_session(file, location)) { return false; }
 
-    if (!curl::perform(m_curl)) { return false; }
+    curl::UploadStruct uploadData = {.pipe = &pipe};
+    if (!GoogleDrive::send_to_session(location, uploadData, nullptr)) { return false; }
 
-    // Update the file size with the source file size.
-    file->set_size(sourceFile.get_size());
+    file->set_size(uploadData.pipeSize);
 
     return true;
 }
@@ -319,12 +293,39 @@ bool remote::GoogleDrive::download_file(const remote::Item *file, const fslib::P
     curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::download_file_threaded);
     curl::set_option(m_curl, CURLOPT_WRITEDATA, download.get());
 
-    sys::threadpool::push_job(curl::download_write_thread_function, download);
-    if (!curl::perform(m_curl)) { return false; }
+    const auto writeJob  = sys::threadpool::push_job(curl::download_write_thread_function, download);
+    const bool performed = curl::perform(m_curl);
 
-    download->writeComplete.acquire();
+    return curl::finish_threaded_download(download.get(), writeJob, performed);
+}
 
-    return true;
+bool remote::GoogleDrive::download_stream(const remote::Item *file, fs::ZipPipe &pipe, sys::ProgressTask *task)
+{
+    if (!GoogleDrive::token_is_valid() && !GoogleDrive::refresh_token())
+    {
+        pipe.close(false);
+        return false;
+    }
+
+    curl::HeaderList header = curl::new_header_list();
+    curl::append_header(header, m_authHeader);
+
+    remote::URL url{URL_DRIVE_FILE_API};
+    url.append_path(file->get_id()).append_parameter("alt", "media");
+
+    if (task) { task->reset(static_cast<double>(file->get_size())); }
+
+    curl::StreamDownloadStruct download{.pipe = &pipe, .task = task};
+    curl::prepare_get(m_curl);
+    curl::set_option(m_curl, CURLOPT_HTTPHEADER, header.get());
+    curl::set_option(m_curl, CURLOPT_URL, url.get());
+    curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::download_to_pipe);
+    curl::set_option(m_curl, CURLOPT_WRITEDATA, &download);
+
+    const bool performed = curl::perform(m_curl);
+    pipe.close(performed);
+
+    return performed;
 }
 
 bool remote::GoogleDrive::delete_item(const remote::Item *item)
@@ -403,6 +404,8 @@ bool remote::GoogleDrive::rename_item(remote::Item *item, std::string_view newNa
     return true;
 }
 
+void remote::GoogleDrive::preconnect() { curl::preconnect(URL_DRIVE_FILE_API); }
+
 bool remote::GoogleDrive::sign_in_required() const { return !m_isInitialized || m_refreshToken.empty(); }
 
 bool remote::GoogleDrive::get_sign_in_data(std::string &message, std::string &code, std::time_t &expiration, int &wait)
@@ -691,6 +694,132 @@ bool remote::GoogleDrive::process_listing(json::Object &json)
     return true;
 }
 
+bool remote::GoogleDrive::create_upload_session(std::string_view name, std::string &locationOut)
+{
+    curl::HeaderList headers = curl::new_header_list();
+    curl::append_header(headers, m_authHeader);
+    curl::append_header(headers, HEADER_CONTENT_TYPE_JSON);
+
+    // I don't know if I like this much. Looks like I'm using a high level language instead of a real one.
+    remote::URL url{URL_DRIVE_UPLOAD_API};
+    url.append_parameter("uploadType", "resumable");
+
+    // Json to post.
+    json::Object postJson  = json::new_object(json_object_new_object);
+    json_object *driveName = json_object_new_string(name.data());
+    json::add_object(postJson, JSON_KEY_NAME, driveName);
+    if (!m_parent.empty())
+    {
+        json_object *parentArray = json_object_new_array();
+        json_object *parentId    = json_object_new_string(m_parent.c_str());
+        json_object_array_add(parentArray, parentId);
+        json::add_object(postJson, JSON_KEY_PARENTS, parentArray);
+    }
+
+    curl::HeaderArray headerArray;
+    curl::prepare_post(m_curl);
+    curl::set_option(m_curl, CURLOPT_HTTPHEADER, headers.get());
+    curl::set_option(m_curl, CURLOPT_HEADERFUNCTION, curl::write_header_array);
+    curl::set_option(m_curl, CURLOPT_HEADERDATA, &headerArray);
+    curl::set_option(m_curl, CURLOPT_URL, url.get());
+    curl::set_option(m_curl, CURLOPT_POSTFIELDS, json_object_get_string(postJson.get()));
+
+    if (!curl::perform(m_curl)) { return false; }
+
+    // Extract the location from the headers.
+    if (!curl::get_header_value(headerArray, HEADER_UPLOAD_LOCATION.data(), locationOut))
+    {
+        logger::log("Error uploading file: Couldn't extract upload location from headers.");
+        return false;
+    }
+
+    return true;
+}
+
+bool remote::GoogleDrive::create_patch_session(const remote::Item *file, std::string &locationOut)
+{
+    curl::HeaderList header = curl::new_header_list();
+    curl::append_header(header, m_authHeader);
+
+    remote::URL url{URL_DRIVE_UPLOAD_API};
+    url.append_path(file->get_id()).append_parameter("uploadType", "resumable");
+
+    std::string response;
+    curl::HeaderArray headerArray;
+    curl::reset_handle(m_curl);
+    curl::set_option(m_curl, CURLOPT_CUSTOMREQUEST, "PATCH");
+    curl::set_option(m_curl, CURLOPT_HTTPHEADER, header.get());
+    curl::set_option(m_curl, CURLOPT_HEADERFUNCTION, curl::write_header_array);
+    curl::set_option(m_curl, CURLOPT_HEADERDATA, &headerArray);
+    curl::set_option(m_curl, CURLOPT_URL, url.get());
+    curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::write_response_string);
+    curl::set_option(m_curl, CURLOPT_WRITEDATA, &response);
+
+    if (!curl::perform(m_curl)) { return false; }
+
+    // This is the target location to upload to.
+    if (!curl::get_header_value(headerArray, HEADER_UPLOAD_LOCATION, locationOut))
+    {
+        logger::log("Error patching file: Location could not be read from headers!");
+        return false;
+    }
+
+    return true;
+}
+
+bool remote::GoogleDrive::send_to_session(const std::string &location, curl::UploadStruct &uploadData, std::string *response)
+{
+    const auto readFunction = uploadData.pipe ? curl::read_data_from_pipe : curl::read_data_from_file;
+
+    // This is the actual upload. This doesn't need the authentication header to work for some reason?
+    curl::prepare_upload(m_curl);
+    curl::set_option(m_curl, CURLOPT_URL, location.c_str());
+    curl::set_option(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, Storage::get_upload_buffer_size());
+    curl::set_option(m_curl, CURLOPT_READFUNCTION, readFunction);
+    curl::set_option(m_curl, CURLOPT_READDATA, &uploadData);
+    if (response)
+    {
+        curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::write_response_string);
+        curl::set_option(m_curl, CURLOPT_WRITEDATA, response);
+    }
+
+    return curl::perform(m_curl);
+}
+
+bool remote::GoogleDrive::upload_to_session(const std::string &location, curl::UploadStruct &uploadData, int64_t size)
+{
+    std::string response;
+    if (!GoogleDrive::send_to_session(location, uploadData, &response)) { return false; }
+
+    // Streams don't know their size until they're finished.
+    const int64_t itemSize = uploadData.pipe ? uploadData.pipeSize : size;
+    return GoogleDrive::add_uploaded_file(response, m_parent, itemSize);
+}
+
+bool remote::GoogleDrive::add_uploaded_file(const std::string &response, std::string_view parent, int64_t size)
+{
+    json::Object responseParser = json::new_object(json_tokener_parse, response.c_str());
+    if (!responseParser)
+    {
+        logger::log("Error uploading file: response could not be parsed.");
+        return false;
+    }
+
+    json_object *id       = json::get_object(responseParser, JSON_KEY_ID);
+    json_object *filename = json::get_object(responseParser, JSON_KEY_NAME);
+    if (!id || !filename)
+    {
+        logger::log("Error uploading file: server response is missing data required.");
+        return false;
+    }
+
+    const char *idString   = json_object_get_string(id);
+    const char *nameString = json_object_get_string(filename);
+    m_list.emplace_back(nameString, idString, parent, size, false);
+
+    return true;
+}
+
 bool remote::GoogleDrive::error_occurred(json::Object &json, bool log) noexcept
 {
     json_object *error = json::get_object(json, "error");
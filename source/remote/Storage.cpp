@@ -1,5 +1,6 @@
 #include "remote/Storage.hpp"
 
+#include "fs/io.hpp"
 #include "logging/logger.hpp"
 
 #include <algorithm>
@@ -85,6 +86,18 @@ bool remote::Storage::supports_utf8() const noexcept { return m_utf8Paths; }
 
 std::string_view remote::Storage::get_prefix() const noexcept { return m_prefix; }
 
+//                      ---- Protected functions ----
+
+long remote::Storage::get_upload_buffer_size()
+{
+    // These are the limits curl documents for CURLOPT_UPLOAD_BUFFERSIZE.
+    static constexpr size_t SIZE_CURL_MIN = 0x4000;
+    static constexpr size_t SIZE_CURL_MAX = 0x200000;
+
+    const size_t chunkSize = fs::get_device_chunk_size("sdmc");
+    return static_cast<long>(std::clamp(chunkSize, SIZE_CURL_MIN, SIZE_CURL_MAX));
+}
+
 //                      ---- Private functions ----
 
 remote::Storage::List::iterator remote::Storage::find_directory_by_name(std::string_view name) noexcept
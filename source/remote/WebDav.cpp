@@ -97,7 +97,7 @@ bool remote::WebDav::create_directory(std::string_view name)
     url.append_path(m_parent).append_path(escapedName).append_slash();
 
     curl::reset_handle(m_curl);
-    WebDav::append_credentials();
+    WebDav::append_credentials(m_curl);
     curl::set_option(m_curl, CURLOPT_URL, url.get());
     curl::set_option(m_curl, CURLOPT_CUSTOMREQUEST, "MKCOL");
 
@@ -141,10 +141,10 @@ bool remote::WebDav::upload_file(const fslib::Path &source, std::string_view rem
 
     curl::UploadStruct uploadData{.source = &sourceFile, .task = task};
     curl::reset_handle(m_curl);
-    WebDav::append_credentials();
+    WebDav::append_credentials(m_curl);
     curl::set_option(m_curl, CURLOPT_URL, url.get());
     curl::set_option(m_curl, CURLOPT_UPLOAD, 1L);
-    curl::set_option(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, Storage::SIZE_UPLOAD_BUFFER);
+    curl::set_option(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, Storage::get_upload_buffer_size());
     curl::set_option(m_curl, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(fileSize));
     curl::set_option(m_curl, CURLOPT_READFUNCTION, curl::read_data_from_file);
     curl::set_option(m_curl, CURLOPT_READDATA, &uploadData);
@@ -157,6 +157,54 @@ bool remote::WebDav::upload_file(const fslib::Path &source, std::string_view rem
     return true;
 }
 
+bool remote::WebDav::queue_upload(curl::TransferEngine &engine,
+                                  const fslib::Path &source,
+                                  std::string_view remoteName,
+                                  sys::ProgressTask *task,
+                                  Storage::UploadCallback onFinished)
+{
+    static constexpr const char *STRING_ERROR_QUEUEING = "Error queueing upload to WebDav: %s";
+
+    auto transfer = std::make_unique<curl::Transfer>();
+    if (error::fslib(transfer->source.open(source, FsOpenMode_Read))) { return false; }
+
+    std::string escapedName{};
+    const bool nameEscaped = curl::escape_string(m_curl, remoteName, escapedName);
+    if (!nameEscaped)
+    {
+        logger::log(STRING_ERROR_QUEUEING, "Failed to escape filename!");
+        return false;
+    }
+
+    const int64_t fileSize = transfer->source.get_size();
+    transfer->upload       = {.source = &transfer->source, .task = task};
+
+    remote::URL url{m_origin};
+    url.append_path(m_parent).append_path(escapedName);
+
+    curl::Handle &handle = transfer->handle;
+    curl::reset_handle(handle);
+    WebDav::append_credentials(handle);
+    curl::set_option(handle, CURLOPT_URL, url.get());
+    curl::set_option(handle, CURLOPT_UPLOAD, 1L);
+    curl::set_option(handle, CURLOPT_UPLOAD_BUFFERSIZE, Storage::get_upload_buffer_size());
+    curl::set_option(handle, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(fileSize));
+    curl::set_option(handle, CURLOPT_READFUNCTION, curl::read_data_from_file);
+    curl::set_option(handle, CURLOPT_READDATA, &transfer->upload);
+
+    // The parent is captured now since the caller is free to change directories before this finishes.
+    const std::string name{remoteName};
+    const std::string id = m_parent + "/" + escapedName;
+    transfer->complete = [this, name, id, parent = m_parent, fileSize, onFinished](curl::Transfer &, bool performed)
+    {
+        if (performed) { m_list.emplace_back(name, id, parent, fileSize, false); }
+        if (onFinished) { onFinished(performed); }
+    };
+
+    engine.add(std::move(transfer));
+    return true;
+}
+
 bool remote::WebDav::patch_file(remote::Item *item, const fslib::Path &source, sys::ProgressTask *task)
 {
     static constexpr const char *STRING_ERROR_PATCHING = "Error patching file: %s";
@@ -175,10 +223,10 @@ bool remote::WebDav::patch_file(remote::Item *item, const fslib::Path &source, s
 
     curl::UploadStruct uploadData{.source = &sourceFile, .task = task};
     curl::reset_handle(m_curl);
-    WebDav::append_credentials();
+    WebDav::append_credentials(m_curl);
     curl::set_option(m_curl, CURLOPT_URL, url.get());
     curl::set_option(m_curl, CURLOPT_UPLOAD, 1L);
-    curl::set_option(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, Storage::SIZE_UPLOAD_BUFFER);
+    curl::set_option(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, Storage::get_upload_buffer_size());
     curl::set_option(m_curl, CURLOPT_READFUNCTION, curl::read_data_from_file);
     curl::set_option(m_curl, CURLOPT_READDATA, &uploadData);
 
@@ -190,6 +238,58 @@ bool remote::WebDav::patch_file(remote::Item *item, const fslib::Path &source, s
     return true;
 }
 
+bool remote::WebDav::upload_stream(fs::ZipPipe &pipe, std::string_view remoteName)
+{
+    std::string escapedName{};
+    const bool nameEscaped = curl::escape_string(m_curl, remoteName, escapedName);
+    if (!nameEscaped)
+    {
+        logger::log("Error streaming to WebDav: %s", "Failed to escape filename!");
+        return false;
+    }
+
+    remote::URL url{m_origin};
+    url.append_path(m_parent).append_path(escapedName);
+
+    // No size is set, so curl sends this with chunked transfer encoding.
+    curl::UploadStruct uploadData{.pipe = &pipe};
+    curl::reset_handle(m_curl);
+    WebDav::append_credentials(m_curl);
+    curl::set_option(m_curl, CURLOPT_URL, url.get());
+    curl::set_option(m_curl, CURLOPT_UPLOAD, 1L);
+    curl::set_option(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, Storage::get_upload_buffer_size());
+    curl::set_option(m_curl, CURLOPT_READFUNCTION, curl::read_data_from_pipe);
+    curl::set_option(m_curl, CURLOPT_READDATA, &uploadData);
+
+    if (!curl::perform(m_curl)) { return false; }
+
+    const std::string id = m_parent + "/" + escapedName;
+    m_list.emplace_back(remoteName, id, m_parent, uploadData.pipeSize, false);
+
+    return true;
+}
+
+bool remote::WebDav::patch_stream(remote::Item *item, fs::ZipPipe &pipe)
+{
+    remote::URL url{m_origin};
+    url.append_path(item->get_id());
+
+    curl::UploadStruct uploadData{.pipe = &pipe};
+    curl::reset_handle(m_curl);
+    WebDav::append_credentials(m_curl);
+    curl::set_option(m_curl, CURLOPT_URL, url.get());
+    curl::set_option(m_curl, CURLOPT_UPLOAD, 1L);
+    curl::set_option(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, Storage::get_upload_buffer_size());
+    curl::set_option(m_curl, CURLOPT_READFUNCTION, curl::read_data_from_pipe);
+    curl::set_option(m_curl, CURLOPT_READDATA, &uploadData);
+
+    if (!curl::perform(m_curl)) { return false; }
+
+    item->set_size(uploadData.pipeSize);
+
+    return true;
+}
+
 bool remote::WebDav::download_file(const remote::Item *item, const fslib::Path &destination, sys::ProgressTask *task)
 {
     static constexpr const char *STRING_ERROR_DOWNLOADING = "Error downloading file: %s";
@@ -209,7 +309,7 @@ bool remote::WebDav::download_file(const remote::Item *item, const fslib::Path &
 
     auto download = curl::create_download_struct(destFile, task, itemSize);
     curl::reset_handle(m_curl);
-    WebDav::append_credentials();
+    WebDav::append_credentials(m_curl);
     curl::set_option(m_curl, CURLOPT_HTTPGET, 1L);
     curl::set_option(m_curl, CURLOPT_URL, url.get());
     curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::download_file_threaded);
@@ -218,12 +318,31 @@ bool remote::WebDav::download_file(const remote::Item *item, const fslib::Path &
     // Copied from gd.cpp implementation.
     // TODO: Not sure how a thread helps if this parent waits here.
     // TODO: Read and understand what's actually happening before making comments on other's choices.
-    sys::threadpool::push_job(curl::download_write_thread_function, download);
-    if (!curl::perform(m_curl)) { return false; }
+    const auto writeJob  = sys::threadpool::push_job(curl::download_write_thread_function, download);
+    const bool performed = curl::perform(m_curl);
 
-    download->writeComplete.acquire();
+    return curl::finish_threaded_download(download.get(), writeJob, performed);
+}
 
-    return true;
+bool remote::WebDav::download_stream(const remote::Item *item, fs::ZipPipe &pipe, sys::ProgressTask *task)
+{
+    remote::URL url{m_origin};
+    url.append_path(item->get_id());
+
+    if (task) { task->reset(static_cast<double>(item->get_size())); }
+
+    curl::StreamDownloadStruct download{.pipe = &pipe, .task = task};
+    curl::reset_handle(m_curl);
+    WebDav::append_credentials(m_curl);
+    curl::set_option(m_curl, CURLOPT_HTTPGET, 1L);
+    curl::set_option(m_curl, CURLOPT_URL, url.get());
+    curl::set_option(m_curl, CURLOPT_WRITEFUNCTION, curl::download_to_pipe);
+    curl::set_option(m_curl, CURLOPT_WRITEDATA, &download);
+
+    const bool performed = curl::perform(m_curl);
+    pipe.close(performed);
+
+    return performed;
 }
 
 bool remote::WebDav::delete_item(const remote::Item *item)
@@ -235,7 +354,7 @@ bool remote::WebDav::delete_item(const remote::Item *item)
     if (item->is_directory()) { url.append_slash(); }
 
     curl::reset_handle(m_curl);
-    WebDav::append_credentials();
+    WebDav::append_credentials(m_curl);
     curl::set_option(m_curl, CURLOPT_CUSTOMREQUEST, "DELETE");
     curl::set_option(m_curl, CURLOPT_URL, url.get());
 
@@ -277,7 +396,7 @@ bool remote::WebDav::rename_item(remote::Item *item, std::string_view newName)
     curl::append_header(header, destHeader);
 
     curl::reset_handle(m_curl);
-    WebDav::append_credentials();
+    WebDav::append_credentials(m_curl);
     curl::set_option(m_curl, CURLOPT_CUSTOMREQUEST, "MOVE");
     curl::set_option(m_curl, CURLOPT_HTTPHEADER, header.get());
     curl::set_option(m_curl, CURLOPT_URL, url.get());
@@ -305,12 +424,14 @@ bool remote::WebDav::rename_item(remote::Item *item, std::string_view newName)
     return false;
 }
 
+void remote::WebDav::preconnect() { curl::preconnect(m_origin); }
+
 //                      ---- Private functions ----
 
-void remote::WebDav::append_credentials()
+void remote::WebDav::append_credentials(curl::Handle &handle)
 {
-    if (!m_username.empty()) { curl::set_option(m_curl, CURLOPT_USERNAME, m_username.c_str()); }
-    if (!m_password.empty()) { curl::set_option(m_curl, CURLOPT_PASSWORD, m_password.c_str()); }
+    if (!m_username.empty()) { curl::set_option(handle, CURLOPT_USERNAME, m_username.c_str()); }
+    if (!m_password.empty()) { curl::set_option(handle, CURLOPT_PASSWORD, m_password.c_str()); }
 }
 
 bool remote::WebDav::prop_find(const remote::URL &url, std::string &xml)
@@ -320,7 +441,7 @@ bool remote::WebDav::prop_find(const remote::URL &url, std::string &xml)
     curl::append_header(header, "Depth: 1");
 
     curl::reset_handle(m_curl);
-    WebDav::append_credentials();
+    WebDav::append_credentials(m_curl);
     curl::set_option(m_curl, CURLOPT_CUSTOMREQUEST, "PROPFIND");
     curl::set_option(m_curl, CURLOPT_HTTPHEADER, header.get());
     curl::set_option(m_curl, CURLOPT_URL, url.get());
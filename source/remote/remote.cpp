@@ -67,6 +67,14 @@ void remote::initialize(sys::threadpool::JobData jobData)
     else if (webdavExists) { initialize_webdav(); }
 }
 
+void remote::preconnect(sys::threadpool::JobData jobData)
+{
+    remote::Storage *remote = remote::get_remote_storage();
+    if (!remote || !remote->is_initialized()) { return; }
+
+    remote->preconnect();
+}
+
 void initialize_google_drive()
 {
     const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
@@ -21,12 +21,69 @@ void sys::ProgressTask::reset(double goal) noexcept
 
 void sys::ProgressTask::update_current(double current) noexcept { m_current = current; }
 
-void sys::ProgressTask::increase_current(double amount) noexcept { m_current += amount; }
+void sys::ProgressTask::increase_current(double amount) noexcept { m_current.fetch_add(amount); }
 
 double sys::ProgressTask::get_goal() const noexcept { return m_goal; }
 
 double sys::ProgressTask::get_progress() const noexcept
 {
     // Reminder: Never divide by zero. It ends badly every time!
-    return m_goal > 0 ? m_current / m_goal : 0;
+    // Verifying reads a file back after it's written, so current can run past the goal.
+    const double goal    = m_goal;
+    const double current = m_current;
+    if (goal <= 0) { return 0; }
+    return current >= goal ? 1.0 : current / goal;
+}
+
+void sys::ProgressTask::report_mismatch() noexcept { ++m_mismatches; }
+
+int sys::ProgressTask::get_mismatch_count() const noexcept { return m_mismatches; }
+
+void sys::ProgressTask::begin_operation(int64_t totalBytes, int64_t totalFiles) noexcept
+{
+    m_bytesDone      = 0;
+    m_bytesTotal     = totalBytes;
+    m_filesDone      = 0;
+    m_filesTotal     = totalFiles;
+    m_operationStart = std::chrono::steady_clock::now().time_since_epoch().count();
+    m_hasOperation   = true;
+}
+
+void sys::ProgressTask::extend_operation(int64_t bytes, int64_t files) noexcept
+{
+    m_bytesTotal += bytes;
+    m_filesTotal += files;
+}
+
+void sys::ProgressTask::add_progress(int64_t bytes) noexcept
+{
+    m_current.fetch_add(static_cast<double>(bytes));
+    m_bytesDone += bytes;
+}
+
+void sys::ProgressTask::finish_file() noexcept { ++m_filesDone; }
+
+bool sys::ProgressTask::has_operation() const noexcept { return m_hasOperation; }
+
+double sys::ProgressTask::get_operation_progress() const noexcept
+{
+    // Estimates can come up short, so this is clamped instead of letting the bar run off the end.
+    const int64_t total = m_bytesTotal;
+    const int64_t done  = m_bytesDone;
+    if (total <= 0) { return 0; }
+    return done >= total ? 1.0 : static_cast<double>(done) / static_cast<double>(total);
+}
+
+int64_t sys::ProgressTask::get_bytes_done() const noexcept { return m_bytesDone; }
+
+int64_t sys::ProgressTask::get_bytes_total() const noexcept { return m_bytesTotal; }
+
+int64_t sys::ProgressTask::get_files_done() const noexcept { return m_filesDone; }
+
+int64_t sys::ProgressTask::get_files_total() const noexcept { return m_filesTotal; }
+
+std::chrono::steady_clock::time_point sys::ProgressTask::get_operation_start() const noexcept
+{
+    const std::chrono::steady_clock::duration sinceEpoch{m_operationStart.load()};
+    return std::chrono::steady_clock::time_point{sinceEpoch};
 }
@@ -5,20 +5,27 @@
 //                      ---- Construction ----
 
 sys::Task::Task()
-    : m_isRunning(true) {};
+    : m_isRunning(true)
+    , m_statsBegin(sys::stats::get_snapshot()) {};
 
-sys::Task::Task(sys::threadpool::JobFunction function, sys::Task::TaskData taskData)
+sys::Task::Task(sys::threadpool::JobFunction function, sys::Task::TaskData taskData, sys::threadpool::Priority priority)
     : Task()
 {
     taskData->task = this;
-    sys::threadpool::push_job(function, taskData);
+    sys::threadpool::push_job(function, taskData, priority);
 }
 
 //                      ---- Public functions ----
 
 bool sys::Task::is_running() const noexcept { return m_isRunning; }
 
-void sys::Task::complete() noexcept { m_isRunning = false; }
+void sys::Task::complete() noexcept
+{
+    // The summary has to be written first. The state owning the task is free to destroy it as soon as it isn't running.
+    if (!m_isRunning) { return; }
+    sys::stats::log_summary("Task", m_statsBegin);
+    m_isRunning = false;
+}
 
 void sys::Task::set_status(std::string_view status)
 {
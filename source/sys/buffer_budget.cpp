@@ -0,0 +1,70 @@
+#include "sys/buffer_budget.hpp"
+
+#include "logging/logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <switch.h>
+
+namespace
+{
+    /// @brief Range for the limit when running as an application.
+    constexpr size_t SIZE_BUDGET_MIN = 0x800000;
+    constexpr size_t SIZE_BUDGET_MAX = 0x4000000;
+
+    /// @brief Cap for the limit when running as an applet.
+    constexpr size_t SIZE_BUDGET_APPLET_MAX = 0x1000000;
+
+    /// @brief Only this fraction of the free heap is handed out. The rest is left for everything else.
+    constexpr size_t DIVISOR_FREE_HEAP = 4;
+
+    /// @brief Limit and bytes currently reserved.
+    std::atomic<size_t> s_limit{SIZE_BUDGET_MIN};
+    std::atomic<size_t> s_reserved{};
+}
+
+void sys::buffer_budget::initialize()
+{
+    uint64_t totalMemory{};
+    uint64_t usedMemory{};
+    const bool totalError = R_FAILED(svcGetInfo(&totalMemory, InfoType_TotalMemorySize, CUR_PROCESS_HANDLE, 0));
+    const bool usedError  = R_FAILED(svcGetInfo(&usedMemory, InfoType_UsedMemorySize, CUR_PROCESS_HANDLE, 0));
+
+    const bool appletMode = appletGetAppletType() != AppletType_Application;
+    const size_t maxLimit = appletMode ? SIZE_BUDGET_APPLET_MAX : SIZE_BUDGET_MAX;
+    const size_t freeHeap = totalError || usedError || usedMemory > totalMemory ? 0 : totalMemory - usedMemory;
+    const size_t limit    = std::clamp(freeHeap / DIVISOR_FREE_HEAP, std::min(SIZE_BUDGET_MIN, maxLimit), maxLimit);
+
+    s_limit = limit;
+    logger::log("I/O buffer budget: %zu KB.", limit / 1024);
+}
+
+size_t sys::buffer_budget::reserve(size_t chunkCount, size_t chunkSize) noexcept
+{
+    if (chunkCount == 0 || chunkSize == 0) { return 0; }
+
+    size_t reserved = s_reserved.load();
+    size_t granted{};
+    do {
+        const size_t limit     = s_limit.load();
+        const size_t available = reserved < limit ? limit - reserved : 0;
+        granted                = std::clamp<size_t>(available / chunkSize, 1, chunkCount);
+    } while (!s_reserved.compare_exchange_weak(reserved, reserved + (granted * chunkSize)));
+
+    return granted;
+}
+
+bool sys::buffer_budget::try_reserve(size_t size) noexcept
+{
+    size_t reserved = s_reserved.load();
+    do {
+        const size_t limit = s_limit.load();
+        if (reserved > limit || size > limit - reserved) { return false; }
+    } while (!s_reserved.compare_exchange_weak(reserved, reserved + size));
+
+    return true;
+}
+
+void sys::buffer_budget::release(size_t size) noexcept { s_reserved.fetch_sub(size); }
+
+size_t sys::buffer_budget::get_limit() noexcept { return s_limit; }
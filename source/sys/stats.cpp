@@ -0,0 +1,182 @@
+#include "sys/stats.hpp"
+
+#include "logging/logger.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+namespace
+{
+    /// @brief Names for the pipelines. These are only used for the log and debug overlay.
+    constexpr std::array<std::string_view, sys::stats::COUNT_PIPELINES> PIPELINE_NAMES = {"File copy",
+                                                                                          "Zip",
+                                                                                          "Unzip",
+                                                                                          "Archive",
+                                                                                          "Download"};
+
+    /// @brief Job counters.
+    std::atomic<uint64_t> s_jobsQueued{};
+    std::atomic<uint64_t> s_jobsStarted{};
+    std::atomic<uint64_t> s_jobsCompleted{};
+
+    /// @brief Histograms for time spent queued and running.
+    sys::stats::Histogram s_queuedHistogram{};
+    sys::stats::Histogram s_runningHistogram{};
+
+    // clang-format off
+    struct PipelineCounters
+    {
+        std::atomic<uint64_t> streams{};
+        std::atomic<uint64_t> producerStall{};
+        std::atomic<uint64_t> consumerStall{};
+    };
+    // clang-format on
+
+    /// @brief Stall counters for each pipeline.
+    std::array<PipelineCounters, sys::stats::COUNT_PIPELINES> s_pipelines{};
+}
+
+//                      ---- Histogram ----
+
+void sys::stats::Histogram::record(uint64_t microseconds) noexcept
+{
+    const size_t bucket = std::min<size_t>(std::bit_width(microseconds), COUNT_HISTOGRAM_BUCKETS - 1);
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(microseconds, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t sys::stats::Histogram::get_count() const noexcept { return m_count.load(std::memory_order_relaxed); }
+
+uint64_t sys::stats::Histogram::get_total() const noexcept { return m_total.load(std::memory_order_relaxed); }
+
+uint64_t sys::stats::Histogram::get_bucket(size_t bucket) const noexcept
+{
+    if (bucket >= COUNT_HISTOGRAM_BUCKETS) { return 0; }
+    return m_buckets[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t sys::stats::Histogram::get_percentile(size_t percentile) const noexcept
+{
+    const uint64_t count = Histogram::get_count();
+    if (count == 0) { return 0; }
+
+    // The count is read separately from the buckets, so the target is clamped in case a sample landed in between.
+    const uint64_t target = std::max<uint64_t>((count * std::min<size_t>(percentile, 100) + 99) / 100, 1);
+    uint64_t seen{};
+    for (size_t i = 0; i < COUNT_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += Histogram::get_bucket(i);
+        if (seen >= target) { return 1ULL << i; }
+    }
+
+    return 1ULL << (COUNT_HISTOGRAM_BUCKETS - 1);
+}
+
+//                      ---- Counters ----
+
+uint64_t sys::stats::get_time() noexcept
+{
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+void sys::stats::job_queued() noexcept { s_jobsQueued.fetch_add(1, std::memory_order_relaxed); }
+
+void sys::stats::job_started(uint64_t queued) noexcept
+{
+    s_jobsStarted.fetch_add(1, std::memory_order_relaxed);
+    s_queuedHistogram.record(queued);
+}
+
+void sys::stats::job_finished(uint64_t running) noexcept
+{
+    s_runningHistogram.record(running);
+    s_jobsCompleted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void sys::stats::record_pipeline(sys::stats::Pipeline pipeline, uint64_t producerStall, uint64_t consumerStall) noexcept
+{
+    const size_t index = static_cast<size_t>(pipeline);
+    if (index >= COUNT_PIPELINES) { return; }
+
+    PipelineCounters &counters = s_pipelines[index];
+    counters.streams.fetch_add(1, std::memory_order_relaxed);
+    counters.producerStall.fetch_add(producerStall, std::memory_order_relaxed);
+    counters.consumerStall.fetch_add(consumerStall, std::memory_order_relaxed);
+}
+
+sys::stats::Snapshot sys::stats::get_snapshot() noexcept
+{
+    // Completed is read first and queued last so waiting and running can't come out negative.
+    const uint64_t completed = s_jobsCompleted.load(std::memory_order_relaxed);
+    const uint64_t started   = s_jobsStarted.load(std::memory_order_relaxed);
+    const uint64_t queued    = s_jobsQueued.load(std::memory_order_relaxed);
+
+    sys::stats::Snapshot snapshot{};
+    snapshot.time          = sys::stats::get_time();
+    snapshot.jobsWaiting   = queued - std::min(started, queued);
+    snapshot.jobsRunning   = started - std::min(completed, started);
+    snapshot.jobsCompleted = completed;
+    snapshot.timeQueued    = s_queuedHistogram.get_total();
+    snapshot.timeRunning   = s_runningHistogram.get_total();
+
+    for (size_t i = 0; i < COUNT_PIPELINES; i++)
+    {
+        const PipelineCounters &counters = s_pipelines[i];
+        sys::stats::PipelineStats &stats = snapshot.pipelines[i];
+
+        stats.streams       = counters.streams.load(std::memory_order_relaxed);
+        stats.producerStall = counters.producerStall.load(std::memory_order_relaxed);
+        stats.consumerStall = counters.consumerStall.load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+}
+
+const sys::stats::Histogram &sys::stats::get_queued_histogram() noexcept { return s_queuedHistogram; }
+
+const sys::stats::Histogram &sys::stats::get_running_histogram() noexcept { return s_runningHistogram; }
+
+std::string_view sys::stats::get_pipeline_name(sys::stats::Pipeline pipeline) noexcept
+{
+    const size_t index = static_cast<size_t>(pipeline);
+    if (index >= COUNT_PIPELINES) { return {}; }
+
+    return PIPELINE_NAMES[index];
+}
+
+void sys::stats::log_summary(std::string_view label, const sys::stats::Snapshot &begin)
+{
+    // Everything in the pool is counted, so anything else running at the same time shows up here too.
+    const sys::stats::Snapshot end = sys::stats::get_snapshot();
+    const uint64_t elapsed         = (end.time - begin.time) / 1000;
+    const uint64_t completed       = end.jobsCompleted - begin.jobsCompleted;
+    const uint64_t queued          = completed > 0 ? (end.timeQueued - begin.timeQueued) / completed : 0;
+    const uint64_t running         = completed > 0 ? (end.timeRunning - begin.timeRunning) / completed : 0;
+
+    logger::log("%s finished in %llu ms. Jobs completed: %llu. Average queued: %llu us. Average running: %llu us.",
+                label.data(),
+                elapsed,
+                completed,
+                queued,
+                running);
+
+    for (size_t i = 0; i < COUNT_PIPELINES; i++)
+    {
+        const sys::stats::PipelineStats &beginStats = begin.pipelines[i];
+        const sys::stats::PipelineStats &endStats   = end.pipelines[i];
+
+        const uint64_t streams = endStats.streams - beginStats.streams;
+        if (streams == 0) { continue; }
+
+        const uint64_t producerStall = (endStats.producerStall - beginStats.producerStall) / 1000;
+        const uint64_t consumerStall = (endStats.consumerStall - beginStats.consumerStall) / 1000;
+        logger::log("    %s: %llu streams. Producer stalled %llu ms. Consumer stalled %llu ms.",
+                    PIPELINE_NAMES[i].data(),
+                    streams,
+                    producerStall,
+                    consumerStall);
+    }
+}
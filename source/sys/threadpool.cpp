@@ -1,87 +1,378 @@
 #include "sys/threadpool.hpp"
 
 #include "error.hpp"
+#include "logging/logger.hpp"
+#include "sys/stats.hpp"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <switch.h>
 
 namespace
 {
-    /// @brief Number of threads to pool.
-    constexpr size_t COUNT_THREADS = 2;
+    /// @brief The pool never has fewer threads than this. Tasks run in the pool and block on the jobs they push, so one
+    /// thread isn't enough even if there's only one core to run on.
+    constexpr size_t COUNT_THREADS_MIN = 2;
+
+    /// @brief The Switch only has four cores.
+    constexpr size_t COUNT_THREADS_MAX = 4;
 
     /// @brief Size of the stack for the threads.
     constexpr size_t SIZE_THREAD_STACK = 0x40000;
 
-    /// @brief Another time/hand saver.
-    using QueuePair = std::pair<sys::threadpool::JobFunction, sys::threadpool::JobData>;
+    /// @brief Priority of threads on cores the main thread isn't using.
+    constexpr int PRIORITY_WORKER = 0x2B;
+
+    /// @brief Priority of the thread reserved for interactive jobs. It's above the workers so it can cut in on the core it
+    /// shares with one.
+    constexpr int PRIORITY_INTERACTIVE = 0x2A;
+
+    /// @brief Another time/hand saver. Everything about the job lives in the state so a JobGroup can run it too.
+    using Job = std::shared_ptr<sys::threadpool::JobHandle::State>;
+
+    // clang-format off
+    struct Worker
+    {
+        Thread thread{};
+        std::deque<Job> jobs{};
+        std::mutex jobMutex{};
+    };
+    // clang-format on
+
+    /// @brief Array of workers. Only the first s_threadCount are used.
+    std::array<Worker, COUNT_THREADS_MAX> s_workers{};
+
+    /// @brief Number of workers actually started.
+    size_t s_threadCount{};
 
-    /// @brief Array of threads.
-    constinit std::array<Thread, COUNT_THREADS> s_threads{};
+    /// @brief Thread that only runs interactive jobs so they never wait on a worker tied up with bulk ones.
+    Thread s_interactiveThread{};
 
-    /// @brief The queue of jobs.
-    std::queue<QueuePair> s_jobQueue{};
+    /// @brief Interactive jobs. Every thread checks these before looking at the workers' queues.
+    std::deque<Job> s_interactiveJobs{};
+    std::mutex s_interactiveMutex{};
 
-    /// @brief Mutex to prevent job corruption.
-    std::mutex s_jobMutex{};
+    /// @brief Jobs pushed from outside the pool are spread across the workers starting here.
+    std::atomic<size_t> s_nextWorker{};
 
-    /// @brief Conditional.
-    std::condition_variable s_jobCondition{};
+    /// @brief Number of jobs queued that haven't been taken yet. Idle workers sleep while this is 0.
+    size_t s_pendingJobs{};
+
+    /// @brief Number of interactive jobs queued that haven't been taken yet. The interactive thread sleeps while this is 0.
+    size_t s_pendingInteractive{};
+
+    /// @brief Mutex and conditions idle threads sleep on.
+    std::mutex s_sleepMutex{};
+    std::condition_variable s_sleepCondition{};
+    std::condition_variable s_interactiveCondition{};
 
     /// @brief So exit can signal.
     std::atomic_bool s_exitFlag{};
+
+    /// @brief Index of the worker the current thread is. -1 for threads outside the pool.
+    thread_local int t_workerIndex = -1;
+}
+
+// Defined at bottom.
+static void thread_pool_function(void *arg);
+static void interactive_thread_function(void *arg);
+static bool take_interactive_job(Job &jobOut);
+static bool take_job(size_t workerIndex, Job &jobOut);
+static void run_job(Job &job);
+static bool claim_job(Job &job);
+static void finish_job(Job &job);
+
+//                      ---- JobHandle ----
+
+sys::threadpool::JobHandle::JobHandle(std::shared_ptr<JobHandle::State> state)
+    : m_state(std::move(state)) {};
+
+bool sys::threadpool::JobHandle::is_valid() const noexcept { return m_state != nullptr; }
+
+bool sys::threadpool::JobHandle::is_finished() const
+{
+    if (!m_state) { return true; }
+
+    std::lock_guard stateGuard{m_state->mutex};
+    return m_state->finished;
+}
+
+void sys::threadpool::JobHandle::wait() const
+{
+    if (!m_state) { return; }
+
+    std::unique_lock stateGuard{m_state->mutex};
+    m_state->condition.wait(stateGuard, [this]() { return m_state->finished; });
+}
+
+void sys::threadpool::JobHandle::run_if_pending() const
+{
+    // The job stays queued. Whoever takes it later finds it already started and drops it.
+    if (!m_state) { return; }
+
+    Job job = m_state;
+    run_job(job);
 }
 
-/// @brief Defined at bottom.
-static void thread_pool_function(void *);
+//                      ---- JobGroup ----
+
+void sys::threadpool::JobGroup::add(sys::threadpool::JobHandle handle) { m_handles.push_back(std::move(handle)); }
+
+bool sys::threadpool::JobGroup::is_finished() const
+{
+    return std::all_of(m_handles.begin(), m_handles.end(), [](const JobHandle &handle) { return handle.is_finished(); });
+}
+
+void sys::threadpool::JobGroup::wait()
+{
+    for (const JobHandle &handle : m_handles)
+    {
+        handle.run_if_pending();
+        handle.wait();
+    }
+    m_handles.clear();
+}
+
+//                      ---- Pool ----
 
 void sys::threadpool::initialize()
 {
-    for (size_t i = 0; i < COUNT_THREADS; i++)
+    // The pool gets a thread for every core the process can use. The one sharing the main thread's core runs below it so
+    // it only gets time while the UI is waiting on vsync.
+    uint64_t coreMask{};
+    int32_t mainPriority{};
+    const bool maskRead     = !error::libnx(svcGetInfo(&coreMask, InfoType_CoreMask, CUR_PROCESS_HANDLE, 0));
+    const bool priorityRead = !error::libnx(svcGetThreadPriority(&mainPriority, CUR_THREAD_HANDLE));
+    const int mainCore      = svcGetCurrentProcessorNumber();
+    coreMask &= (1ULL << COUNT_THREADS_MAX) - 1;
+    if (!maskRead || coreMask == 0) { coreMask = 0b111; }
+    if (!priorityRead) { mainPriority = 0x2C; }
+
+    // Cores the main thread isn't on come first so they're used before the shared one.
+    std::array<int, COUNT_THREADS_MAX> cores{};
+    size_t coreCount{};
+    for (int core = 0; core < static_cast<int>(COUNT_THREADS_MAX); core++)
     {
-        // NOTE: If pool size increases, i + 1 isn't going to work anymore.
-        error::libnx(threadCreate(&s_threads[i], thread_pool_function, nullptr, nullptr, SIZE_THREAD_STACK, 0x2B, i + 1));
-        error::libnx(threadStart(&s_threads[i]));
+        if ((coreMask & (1ULL << core)) && core != mainCore) { cores[coreCount++] = core; }
     }
+    if (coreMask & (1ULL << mainCore)) { cores[coreCount++] = mainCore; }
+
+    s_threadCount = std::clamp(static_cast<size_t>(std::popcount(coreMask)), COUNT_THREADS_MIN, COUNT_THREADS_MAX);
+    for (size_t i = 0; i < s_threadCount; i++)
+    {
+        const int core     = coreCount > 0 ? cores[i % coreCount] : -2;
+        const int priority = core == mainCore ? mainPriority + 1 : PRIORITY_WORKER;
+        void *workerIndex  = reinterpret_cast<void *>(i);
+
+        Thread &thread = s_workers[i].thread;
+        error::libnx(threadCreate(&thread, thread_pool_function, workerIndex, nullptr, SIZE_THREAD_STACK, priority, core));
+        error::libnx(threadStart(&thread));
+    }
+
+    // The interactive thread goes on the first core a worker has to itself.
+    const int interactiveCore = coreCount > 0 ? cores[0] : -2;
+    error::libnx(threadCreate(&s_interactiveThread,
+                              interactive_thread_function,
+                              nullptr,
+                              nullptr,
+                              SIZE_THREAD_STACK,
+                              PRIORITY_INTERACTIVE,
+                              interactiveCore));
+    error::libnx(threadStart(&s_interactiveThread));
+
+    logger::log("Thread pool started with %zu threads. Core mask: 0x%X", s_threadCount, static_cast<uint32_t>(coreMask));
 }
 
 void sys::threadpool::exit()
 {
     s_exitFlag.store(true);
-    s_jobCondition.notify_all();
-    for (size_t i = 0; i < COUNT_THREADS; i++)
     {
-        error::libnx(threadWaitForExit(&s_threads[i]));
-        error::libnx(threadClose(&s_threads[i]));
+        std::lock_guard sleepGuard{s_sleepMutex};
+    }
+    s_sleepCondition.notify_all();
+    s_interactiveCondition.notify_all();
+
+    for (size_t i = 0; i < s_threadCount; i++)
+    {
+        error::libnx(threadWaitForExit(&s_workers[i].thread));
+        error::libnx(threadClose(&s_workers[i].thread));
     }
+    error::libnx(threadWaitForExit(&s_interactiveThread));
+    error::libnx(threadClose(&s_interactiveThread));
 }
 
-void sys::threadpool::push_job(sys::threadpool::JobFunction function, sys::threadpool::JobData data)
+size_t sys::threadpool::get_thread_count() noexcept { return s_threadCount; }
+
+sys::threadpool::JobHandle sys::threadpool::push_job(sys::threadpool::JobFunction function,
+                                                     sys::threadpool::JobData data,
+                                                     sys::threadpool::Priority priority)
 {
-    std::lock_guard jobGuard{s_jobMutex};
-    s_jobQueue.push(std::make_pair(function, data));
-    s_jobCondition.notify_all();
+    auto state      = std::make_shared<JobHandle::State>();
+    state->function = std::move(function);
+    state->data     = std::move(data);
+    state->queuedAt = sys::stats::get_time();
+    sys::stats::job_queued();
+
+    // The counts go up before the job is published. Otherwise, a thread could take it and decrement them past zero first.
+    const bool interactive = priority == Priority::Interactive;
+    {
+        std::lock_guard sleepGuard{s_sleepMutex};
+        ++s_pendingJobs;
+        if (interactive) { ++s_pendingInteractive; }
+    }
+
+    // Interactive jobs skip the workers' queues entirely. Both the interactive thread and a worker are woken so whichever is
+    // free first takes it.
+    if (interactive)
+    {
+        {
+            std::lock_guard interactiveGuard{s_interactiveMutex};
+            s_interactiveJobs.push_back(state);
+        }
+        s_interactiveCondition.notify_one();
+        s_sleepCondition.notify_one();
+
+        return JobHandle{std::move(state)};
+    }
+
+    // Workers keep what they push. Anything from outside the pool is spread out so no one deque gets everything.
+    const bool fromWorker    = t_workerIndex >= 0;
+    const size_t targetIndex = fromWorker ? t_workerIndex : s_nextWorker.fetch_add(1) % s_threadCount;
+    {
+        Worker &target = s_workers[targetIndex];
+        std::lock_guard jobGuard{target.jobMutex};
+        target.jobs.push_back(state);
+    }
+    s_sleepCondition.notify_one();
+
+    return JobHandle{std::move(state)};
 }
 
-static void thread_pool_function(void *)
+//                      ---- Static functions ----
+
+static void thread_pool_function(void *arg)
 {
-    auto condition = []() { return s_exitFlag.load() || !s_jobQueue.empty(); };
+    const size_t workerIndex = reinterpret_cast<size_t>(arg);
+    t_workerIndex            = static_cast<int>(workerIndex);
 
+    auto condition = []() { return s_exitFlag.load() || s_pendingJobs > 0; };
     while (true)
     {
-        std::unique_lock jobGuard{s_jobMutex};
-        s_jobCondition.wait(jobGuard, condition);
+        Job job{};
+        if (take_job(workerIndex, job))
+        {
+            run_job(job);
+            continue;
+        }
 
+        std::unique_lock sleepGuard{s_sleepMutex};
+        s_sleepCondition.wait(sleepGuard, condition);
         if (s_exitFlag.load()) { break; }
+    }
+}
+
+static void interactive_thread_function(void *arg)
+{
+    auto condition = []() { return s_exitFlag.load() || s_pendingInteractive > 0; };
+    while (true)
+    {
+        Job job{};
+        if (take_interactive_job(job))
+        {
+            run_job(job);
+            continue;
+        }
+
+        std::unique_lock sleepGuard{s_sleepMutex};
+        s_interactiveCondition.wait(sleepGuard, condition);
+        if (s_exitFlag.load()) { break; }
+    }
+}
+
+static bool take_interactive_job(Job &jobOut)
+{
+    {
+        std::lock_guard interactiveGuard{s_interactiveMutex};
+        if (s_interactiveJobs.empty()) { return false; }
+
+        jobOut = std::move(s_interactiveJobs.front());
+        s_interactiveJobs.pop_front();
+    }
+
+    std::lock_guard sleepGuard{s_sleepMutex};
+    --s_pendingJobs;
+    --s_pendingInteractive;
+    return true;
+}
+
+static bool take_job(size_t workerIndex, Job &jobOut)
+{
+    // Interactive jobs always go first.
+    if (take_interactive_job(jobOut)) { return true; }
 
-        auto [function, data] = s_jobQueue.front();
-        s_jobQueue.pop();
-        jobGuard.unlock();
+    // The owner takes its oldest job so what it queued runs in order. Thieves take the newest, which is usually a job its
+    // owner is blocked waiting on.
+    bool taken{};
+    for (size_t i = 0; i < s_threadCount && !taken; i++)
+    {
+        const size_t victimIndex = (workerIndex + i) % s_threadCount;
+        const bool isOwner       = i == 0;
 
-        function(data);
+        Worker &victim = s_workers[victimIndex];
+        std::lock_guard jobGuard{victim.jobMutex};
+        if (victim.jobs.empty()) { continue; }
+
+        jobOut = std::move(isOwner ? victim.jobs.front() : victim.jobs.back());
+        if (isOwner) { victim.jobs.pop_front(); }
+        else { victim.jobs.pop_back(); }
+        taken = true;
     }
-}
\ No newline at end of file
+
+    if (taken)
+    {
+        std::lock_guard sleepGuard{s_sleepMutex};
+        --s_pendingJobs;
+    }
+
+    return taken;
+}
+
+static void run_job(Job &job)
+{
+    if (!claim_job(job)) { return; }
+
+    const uint64_t startedAt = sys::stats::get_time();
+    sys::stats::job_started(startedAt - job->queuedAt);
+
+    job->function(job->data);
+
+    sys::stats::job_finished(sys::stats::get_time() - startedAt);
+    finish_job(job);
+}
+
+static bool claim_job(Job &job)
+{
+    // A job can be run by a worker or by a JobGroup waiting on it. Only the first one to get here runs it.
+    std::lock_guard stateGuard{job->mutex};
+    if (job->started) { return false; }
+
+    job->started = true;
+    return true;
+}
+
+static void finish_job(Job &job)
+{
+    // The function and data are released first so anything waiting on the job sees them as done with.
+    job->function = nullptr;
+    job->data.reset();
+    {
+        std::lock_guard stateGuard{job->mutex};
+        job->finished = true;
+    }
+    job->condition.notify_all();
+}
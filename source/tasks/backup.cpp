@@ -9,12 +9,59 @@
 #include "stringutil.hpp"
 #include "ui/PopMessageManager.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <map>
 
 namespace
 {
     constexpr const char *STRING_ZIP_EXT = ".zip";
     constexpr const char *PATH_JKSV_TEMP = "sdmc:/jksvTemp.zip"; // This is named this so if something fails, people know.
+
+    /// @brief Queued uploads each need their own file since several can be waiting at once. Every upload deletes its file
+    /// when it finishes, so the lowest free number is used and the names never grow past the number in flight.
+    constexpr const char *PATH_JKSV_TEMP_QUEUED = "sdmc:/jksvTemp%u.zip";
+
+    /// @brief Saves with a file larger than this are ZIPed to the SD and uploaded after. The pipe has to hold each entry
+    /// until minizip is finished with it.
+    constexpr int64_t SIZE_STREAM_ENTRY_MAX = 0x1000000;
+
+    // clang-format off
+    struct UploadStreamStruct : sys::threadpool::DataStruct
+    {
+        UploadStreamStruct(size_t entrySize) : pipe(fs::ZipPipe::SIZE_DEFAULT_WINDOW, entrySize) {};
+
+        /// @brief Pipe the ZIP is written to. This has to be able to hold the largest file in the save.
+        fs::ZipPipe pipe;
+
+        /// @brief Remote to upload to.
+        remote::Storage *remote{};
+
+        /// @brief Name of the new file.
+        std::string remoteName{};
+
+        /// @brief Optional. File to patch instead of uploading a new one.
+        remote::Item *target{};
+
+        /// @brief Whether or not the upload succeeded.
+        bool uploaded{};
+    };
+
+    struct DownloadStreamStruct : sys::threadpool::DataStruct
+    {
+        /// @brief Pipe the ZIP is downloaded to.
+        fs::ZipPipe pipe{};
+
+        /// @brief Remote to download from.
+        remote::Storage *remote{};
+
+        /// @brief File being downloaded.
+        const remote::Item *target{};
+
+        /// @brief Task download progress is reported to.
+        sys::ProgressTask *task{};
+    };
+    // clang-format on
 }
 
 // Definitions at bottom.
@@ -23,7 +70,51 @@ static bool read_and_process_meta(const fslib::Path &targetDir, BackupMenuState:
 static bool read_and_process_meta(fs::MiniUnzip &unzip, BackupMenuState::TaskData taskData, sys::ProgressTask *task);
 static void write_meta_file(const fslib::Path &target, const FsSaveDataInfo *saveInfo);
 static void write_meta_zip(fs::MiniZip &zip, const FsSaveDataInfo *saveInfo);
+static fslib::Path get_queued_temp_path();
 static fs::ScopedSaveMount create_scoped_mount(const FsSaveDataInfo *saveInfo);
+static bool build_manifest(const fslib::Path &target,
+                           const FsSaveDataInfo *saveInfo,
+                           fs::BackupManifest &manifest,
+                           sys::ProgressTask *task);
+static bool find_latest_manifest(const fslib::Path &target, fs::BackupManifest &manifestOut, std::string &nameOut);
+static bool backup_is_referenced(const fslib::Path &backup);
+static void write_changed_files(const fs::BackupManifest &manifest, const fslib::Path &target, sys::ProgressTask *task);
+static void write_changed_files(const fs::BackupManifest &manifest, fs::MiniZip &zip, sys::ProgressTask *task);
+static bool manifest_chain_is_complete(const fs::BackupManifest &manifest, const fslib::Path &target);
+static bool restore_from_manifest(const fs::BackupManifest &manifest,
+                                  const fslib::Path &target,
+                                  fs::JournalBudget &journal,
+                                  sys::ProgressTask *task);
+static void create_snapshot(const fslib::Path &target, const FsSaveDataInfo *saveInfo, sys::ProgressTask *task);
+static void restore_snapshot(const fslib::Path &target,
+                             BackupMenuState::TaskData taskData,
+                             int64_t journalSize,
+                             sys::ProgressTask *task);
+static void prune_chunk_store(const fslib::Path &target);
+static void create_archive(const fslib::Path &target, const FsSaveDataInfo *saveInfo, sys::ProgressTask *task);
+static void restore_archive(const fslib::Path &target,
+                            BackupMenuState::TaskData taskData,
+                            int64_t journalSize,
+                            sys::ProgressTask *task);
+static void extend_operation(sys::ProgressTask *task, int64_t fileCount, int64_t totalSize);
+static void get_zip_information(fs::MiniUnzip &unzip, int64_t &fileCount, int64_t &totalSize);
+static void get_manifest_information(const fs::BackupManifest &manifest, int64_t &fileCount, int64_t &totalSize);
+static int64_t get_backup_file_size(const fslib::Path &path);
+static std::shared_ptr<UploadStreamStruct> create_upload_stream(const FsSaveDataInfo *saveInfo);
+static int64_t get_largest_file_size(const fslib::Path &directoryPath);
+static bool stream_backup_remote(std::shared_ptr<UploadStreamStruct> uploadData,
+                                 const FsSaveDataInfo *saveInfo,
+                                 const fslib::Path &localPath,
+                                 remote::Storage *remote,
+                                 std::string_view remoteName,
+                                 remote::Item *target,
+                                 sys::ProgressTask *task);
+static void upload_stream_thread_function(sys::threadpool::JobData jobData);
+static bool stream_restore_remote(BackupMenuState::TaskData taskData,
+                                  remote::Storage *remote,
+                                  remote::Item *target,
+                                  sys::ProgressTask *task);
+static void download_stream_thread_function(sys::threadpool::JobData jobData);
 
 void tasks::backup::create_new_backup_local(sys::threadpool::JobData taskData)
 {
@@ -40,16 +131,48 @@ void tasks::backup::create_new_backup_local(sys::threadpool::JobData taskData)
     if (error::is_null(task)) { return; }
     else if (error::is_null(user) || error::is_null(titleInfo) || error::is_null(saveInfo)) { TASK_FINISH_RETURN(task); }
 
+    // Batches size up every save before starting. Otherwise, this is the whole operation.
+    if (killTask)
+    {
+        task->begin_operation(0, 0);
+        tasks::backup::add_save_to_operation(task, saveInfo);
+    }
+
     const std::string targetString = target.string();
+    const bool isSnapshot          = std::strstr(targetString.c_str(), fs::EXTENSION_SNAPSHOT.data());
+    const bool isArchive           = std::strstr(targetString.c_str(), fs::EXTENSION_ARCHIVE.data());
     const bool hasZipExt           = std::strstr(targetString.c_str(), STRING_ZIP_EXT);
-    if (hasZipExt) // At this point, this should have the zip extension appended if needed.
+
+    // Incremental backups hash the save first so only what changed since the newest backup with a manifest is stored.
+    fs::BackupManifest manifest{};
+    const bool incremental       = config::get_by_key(config::keys::INCREMENTAL_BACKUPS) && !isSnapshot && !isArchive;
+    const bool hasManifest       = incremental && build_manifest(target, saveInfo, manifest, task);
+    const bool changedOnly       = hasManifest && manifest.is_incremental();
+    const bool verify            = config::get_by_key(config::keys::VERIFY_WRITES);
+    const int popTicks           = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popErrorManifest = strings::get_by_name(strings::names::BACKUPMENU_POPS, 8);
+
+    // Hashing already covered reading the save. What's left is writing whatever changed.
+    if (hasManifest) { task->extend_operation(manifest.get_stored_size(), 0); }
+
+    if (isSnapshot) { create_snapshot(target, saveInfo, task); }
+    else if (isArchive) { create_archive(target, saveInfo, task); }
+    else if (hasZipExt) // At this point, this should have the zip extension appended if needed.
     {
         fs::MiniZip zip{target};
         if (!zip.is_open()) { TASK_FINISH_RETURN(task); }
 
         write_meta_zip(zip, saveInfo);
-        auto scopedMount = create_scoped_mount(saveInfo);
-        fs::copy_directory_to_zip(fs::DEFAULT_SAVE_ROOT, zip, task);
+        if (hasManifest && !manifest.write(zip)) { ui::PopMessageManager::push_message(popTicks, popErrorManifest); }
+
+        {
+            auto scopedMount = create_scoped_mount(saveInfo);
+            if (changedOnly) { write_changed_files(manifest, zip, task); }
+            else { fs::copy_directory_to_zip(fs::DEFAULT_SAVE_ROOT, zip, task); }
+        }
+        zip.close();
+
+        if (verify) { fs::verify_zip(target, task); }
     }
     else
     {
@@ -58,8 +181,11 @@ void tasks::backup::create_new_backup_local(sys::threadpool::JobData taskData)
         if (needsDir && createError) { TASK_FINISH_RETURN(task); }
 
         write_meta_file(target, saveInfo);
+        if (hasManifest && !manifest.write(target)) { ui::PopMessageManager::push_message(popTicks, popErrorManifest); }
+
         auto scopedMount = create_scoped_mount(saveInfo);
-        fs::copy_directory(fs::DEFAULT_SAVE_ROOT, target, task);
+        if (changedOnly) { write_changed_files(manifest, target, task); }
+        else { fs::copy_directory(fs::DEFAULT_SAVE_ROOT, target, task); }
     }
 
     // This is like this so I can reuse this code.
@@ -89,8 +215,35 @@ void tasks::backup::create_new_backup_remote(sys::threadpool::JobData taskData)
         TASK_FINISH_RETURN(task);
     }
 
-    const fslib::Path zipPath{keepLocal ? path : PATH_JKSV_TEMP};
+    if (killTask)
+    {
+        task->begin_operation(0, 0);
+        tasks::backup::add_save_to_operation(task, saveInfo);
+    }
+
     const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
+    const bool verify  = config::get_by_key(config::keys::VERIFY_WRITES);
+
+    // The ZIP is uploaded while it's being written when the save and the buffer budget allow it. Otherwise, it's written to
+    // the SD first.
+    auto uploadData = create_upload_stream(saveInfo);
+    if (uploadData)
+    {
+        const fslib::Path localPath = keepLocal ? path : fslib::Path{};
+        const bool uploaded = stream_backup_remote(uploadData, saveInfo, localPath, remote, remoteName, nullptr, task);
+        if (uploaded && keepLocal && verify) { fs::verify_zip(localPath, task); }
+        if (!uploaded)
+        {
+            const char *popErrorUploading = strings::get_by_name(strings::names::BACKUPMENU_POPS, 10);
+            ui::PopMessageManager::push_message(popTicks, popErrorUploading);
+        }
+
+        if (spawningState) { spawningState->refresh(); }
+        if (killTask) { task->complete(); }
+        return;
+    }
+
+    const fslib::Path zipPath{keepLocal ? path : PATH_JKSV_TEMP};
 
     fs::MiniZip zip{zipPath};
     if (!zip.is_open())
@@ -107,6 +260,10 @@ void tasks::backup::create_new_backup_remote(sys::threadpool::JobData taskData)
     }
     zip.close();
 
+    if (verify) { fs::verify_zip(zipPath, task); }
+
+    // The size of the upload isn't known until the ZIP is finished.
+    task->extend_operation(get_backup_file_size(zipPath), 0);
     {
         const char *uploadFormat = strings::get_by_name(strings::names::IO_STATUSES, 5);
         std::string status       = stringutil::get_formatted_string(uploadFormat, remoteName.data());
@@ -125,6 +282,60 @@ void tasks::backup::create_new_backup_remote(sys::threadpool::JobData taskData)
     if (killTask) { task->complete(); }
 }
 
+void tasks::backup::queue_new_backup_remote(BackupMenuState::TaskData taskData, curl::TransferEngine &engine)
+{
+    sys::ProgressTask *task        = static_cast<sys::ProgressTask *>(taskData->task);
+    const FsSaveDataInfo *saveInfo = taskData->saveInfo;
+    const std::string &remoteName  = taskData->remoteName;
+    remote::Storage *remote        = remote::get_remote_storage();
+    if (error::is_null(task) || error::is_null(saveInfo) || error::is_null(remote)) { return; }
+
+    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
+    const bool verify  = config::get_by_key(config::keys::VERIFY_WRITES);
+
+    // Streaming doesn't work here. curl_multi can't wait on a pipe, so the ZIP is written out first.
+    const fslib::Path zipPath = get_queued_temp_path();
+    {
+        fs::MiniZip zip{zipPath};
+        if (!zip.is_open())
+        {
+            const char *popErrorCreating = strings::get_by_name(strings::names::BACKUPMENU_POPS, 5);
+            ui::PopMessageManager::push_message(popTicks, popErrorCreating);
+            return;
+        }
+
+        write_meta_zip(zip, saveInfo);
+        {
+            auto scopedMount = create_scoped_mount(saveInfo);
+            fs::copy_directory_to_zip(fs::DEFAULT_SAVE_ROOT, zip, task);
+        }
+        zip.close();
+    }
+
+    if (verify) { fs::verify_zip(zipPath, task); }
+    task->extend_operation(get_backup_file_size(zipPath), 0);
+
+    // This runs on the batch's thread whenever the engine gets around to it. Nothing is kept locally in a batch, so the file
+    // is deleted whether the upload made it or not.
+    auto onFinished = [zipPath, popTicks](bool uploaded)
+    {
+        const bool deleteError = error::fslib(fslib::delete_file(zipPath));
+        if (!uploaded || deleteError)
+        {
+            const char *popErrorUploading = strings::get_by_name(strings::names::BACKUPMENU_POPS, 10);
+            ui::PopMessageManager::push_message(popTicks, popErrorUploading);
+        }
+    };
+
+    const bool queued = remote->queue_upload(engine, zipPath, remoteName, task, std::move(onFinished));
+    if (!queued)
+    {
+        error::fslib(fslib::delete_file(zipPath));
+        const char *popErrorUploading = strings::get_by_name(strings::names::BACKUPMENU_POPS, 10);
+        ui::PopMessageManager::push_message(popTicks, popErrorUploading);
+    }
+}
+
 void tasks::backup::overwrite_backup_local(sys::threadpool::JobData taskData)
 {
     auto castData = std::static_pointer_cast<BackupMenuState::DataStruct>(taskData);
@@ -133,7 +344,14 @@ void tasks::backup::overwrite_backup_local(sys::threadpool::JobData taskData)
     const fslib::Path &target = castData->path;
     if (error::is_null(task)) { return; }
 
-    const int popTicks     = ui::PopMessageManager::DEFAULT_TICKS;
+    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
+    if (backup_is_referenced(target))
+    {
+        const char *popReferenced = strings::get_by_name(strings::names::BACKUPMENU_POPS, 17);
+        ui::PopMessageManager::push_message(popTicks, popReferenced);
+        TASK_FINISH_RETURN(task);
+    }
+
     const bool isDirectory = fslib::directory_exists(target);
     const bool dirFailed   = isDirectory && error::fslib(fslib::delete_directory_recursively(target));
     const bool fileFailed  = !isDirectory && error::fslib(fslib::delete_file(target));
@@ -163,6 +381,24 @@ void tasks::backup::overwrite_backup_remote(sys::threadpool::JobData taskData)
     const fslib::Path tempPath{PATH_JKSV_TEMP};
     const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
 
+    task->begin_operation(0, 0);
+    tasks::backup::add_save_to_operation(task, saveInfo);
+
+    // Nothing is kept locally here, so a save that can be streamed never touches the SD.
+    auto uploadData = create_upload_stream(saveInfo);
+    if (uploadData)
+    {
+        const bool uploaded = stream_backup_remote(uploadData, saveInfo, fslib::Path{}, remote, {}, target, task);
+        if (!uploaded)
+        {
+            const char *popErrorUploading = strings::get_by_name(strings::names::BACKUPMENU_POPS, 10);
+            ui::PopMessageManager::push_message(popTicks, popErrorUploading);
+        }
+
+        task->complete();
+        return;
+    }
+
     fs::MiniZip zip{tempPath};
     if (!zip.is_open()) { TASK_FINISH_RETURN(task); }
 
@@ -173,6 +409,10 @@ void tasks::backup::overwrite_backup_remote(sys::threadpool::JobData taskData)
     }
     zip.close();
 
+    const bool verify = config::get_by_key(config::keys::VERIFY_WRITES);
+    if (verify) { fs::verify_zip(tempPath, task); }
+
+    task->extend_operation(get_backup_file_size(tempPath), 0);
     {
         const char *targetName   = target->get_name().data();
         const char *statusFormat = strings::get_by_name(strings::names::IO_STATUSES, 5);
@@ -216,10 +456,29 @@ void tasks::backup::restore_backup_local(sys::threadpool::JobData taskData)
     const std::string targetString = target.string();
     const bool autoBackup          = config::get_by_key(config::keys::AUTO_BACKUP_ON_RESTORE);
     const bool isDir               = fslib::directory_exists(target);
+    const bool isSnapshot          = !isDir && std::strstr(targetString.c_str(), fs::EXTENSION_SNAPSHOT.data());
+    const bool isArchive           = !isDir && std::strstr(targetString.c_str(), fs::EXTENSION_ARCHIVE.data());
     const bool hasZipExt           = std::strstr(targetString.c_str(), STRING_ZIP_EXT);
+    const bool isZip               = !isSnapshot && !isArchive && !isDir && hasZipExt;
+    const int popTicks             = ui::PopMessageManager::DEFAULT_TICKS;
 
-    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
-    if (autoBackup) { auto_backup(task, castData); }
+    // Incremental backups need the ones they were built on. Everything is checked before the save is touched.
+    fs::BackupManifest manifest{};
+    const bool changedOnly = (isZip || isDir) && manifest.read(target) && manifest.is_incremental();
+    if (changedOnly && !manifest_chain_is_complete(manifest, target))
+    {
+        const char *popErrorOpening = strings::get_by_name(strings::names::BACKUPMENU_POPS, 3);
+        ui::PopMessageManager::push_message(popTicks, popErrorOpening);
+        TASK_FINISH_RETURN(task);
+    }
+
+    // The backup being restored is added once whichever path below knows how big it is.
+    task->begin_operation(0, 0);
+    if (autoBackup)
+    {
+        tasks::backup::add_save_to_operation(task, saveInfo);
+        auto_backup(task, castData);
+    }
 
     {
         auto scopedMount = create_scoped_mount(saveInfo);
@@ -227,7 +486,9 @@ void tasks::backup::restore_backup_local(sys::threadpool::JobData taskData)
         error::fslib(fslib::commit_data_to_file_system(fs::DEFAULT_SAVE_MOUNT));
     }
 
-    if (!isDir && hasZipExt)
+    if (isSnapshot) { restore_snapshot(target, castData, journalSize, task); }
+    else if (isArchive) { restore_archive(target, castData, journalSize, task); }
+    else if (isZip)
     {
         fs::MiniUnzip unzip{target};
         if (!unzip.is_open())
@@ -238,17 +499,42 @@ void tasks::backup::restore_backup_local(sys::threadpool::JobData taskData)
         }
 
         read_and_process_meta(unzip, castData, task);
+
+        int64_t fileCount{}, totalSize{};
+        if (changedOnly) { get_manifest_information(manifest, fileCount, totalSize); }
+        else { get_zip_information(unzip, fileCount, totalSize); }
+        extend_operation(task, fileCount, totalSize);
+
         auto scopedMount = create_scoped_mount(saveInfo);
-        fs::copy_zip_to_directory(unzip, fs::DEFAULT_SAVE_ROOT, journalSize, task);
+        if (changedOnly)
+        {
+            fs::JournalBudget journal{fs::DEFAULT_SAVE_MOUNT, journalSize};
+            const bool restored = restore_from_manifest(manifest, target, journal, task);
+            if (restored) { fs::commit_journal(journal); }
+        }
+        else { fs::copy_zip_to_directory(unzip, fs::DEFAULT_SAVE_ROOT, journalSize, task); }
     }
     else if (isDir)
     {
         read_and_process_meta(target, castData, task);
+
+        int64_t subDirCount{}, fileCount{}, totalSize{};
+        if (changedOnly) { get_manifest_information(manifest, fileCount, totalSize); }
+        else { fs::get_directory_information(target, subDirCount, fileCount, totalSize); }
+        extend_operation(task, fileCount, totalSize);
+
         auto scopedMount = create_scoped_mount(saveInfo);
-        fs::copy_directory_commit(target, fs::DEFAULT_SAVE_ROOT, journalSize, task);
+        if (changedOnly)
+        {
+            fs::JournalBudget journal{fs::DEFAULT_SAVE_MOUNT, journalSize};
+            const bool restored = restore_from_manifest(manifest, target, journal, task);
+            if (restored) { fs::commit_journal(journal); }
+        }
+        else { fs::copy_directory_commit(target, fs::DEFAULT_SAVE_ROOT, journalSize, task); }
     }
     else
     {
+        extend_operation(task, 1, get_backup_file_size(target));
         auto scopedMount = create_scoped_mount(saveInfo);
         fs::copy_file_commit(target, fs::DEFAULT_SAVE_ROOT, journalSize, task);
     }
@@ -280,16 +566,24 @@ void tasks::backup::restore_backup_remote(sys::threadpool::JobData taskData)
         TASK_FINISH_RETURN(task);
     }
 
-    if (autoBackup) { auto_backup(task, castData); }
+    // The contents of the backup are added once it's downloaded and can be read.
+    remote::Item *target = castData->remoteItem;
+    task->begin_operation(static_cast<int64_t>(target->get_size()), 0);
+    if (autoBackup)
+    {
+        tasks::backup::add_save_to_operation(task, saveInfo);
+        auto_backup(task, castData);
+    }
 
+    // The backup is extracted as it downloads. Going through the SD is only needed if the stream couldn't get started.
+    if (stream_restore_remote(castData, remote, target, task))
     {
-        auto scopedMount = create_scoped_mount(saveInfo);
-        error::fslib(fslib::delete_directory_recursively(fs::DEFAULT_SAVE_ROOT));
-        error::fslib(fslib::commit_data_to_file_system(fs::DEFAULT_SAVE_MOUNT));
+        spawningState->save_data_written();
+        task->complete();
+        return;
     }
 
-    const int popTicks   = ui::PopMessageManager::DEFAULT_TICKS;
-    remote::Item *target = castData->remoteItem;
+    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
     const fslib::Path tempPath{PATH_JKSV_TEMP};
     {
         const char *name              = target->get_name().data();
@@ -306,6 +600,15 @@ void tasks::backup::restore_backup_remote(sys::threadpool::JobData taskData)
         TASK_FINISH_RETURN(task);
     }
 
+    // This is committed in pieces, so the whole backup is checked before the save is touched.
+    if (!fs::verify_zip(tempPath, task))
+    {
+        const char *popDamaged = strings::get_by_name(strings::names::BACKUPMENU_POPS, 21);
+        ui::PopMessageManager::push_message(popTicks, popDamaged);
+        error::fslib(fslib::delete_file(tempPath));
+        TASK_FINISH_RETURN(task);
+    }
+
     fs::MiniUnzip backup{tempPath};
     if (!backup.is_open())
     {
@@ -326,6 +629,12 @@ void tasks::backup::restore_backup_remote(sys::threadpool::JobData taskData)
         }
     }
 
+    {
+        int64_t fileCount{}, totalSize{};
+        get_zip_information(backup, fileCount, totalSize);
+        extend_operation(task, fileCount, totalSize);
+    }
+
     read_and_process_meta(backup, castData, task);
     {
         FsSaveDataExtraData extraData{};
@@ -367,10 +676,20 @@ void tasks::backup::delete_backup_local(sys::threadpool::JobData taskData)
         task->set_status(status);
     }
 
-    const bool trashEnabled = config::get_by_key(config::keys::ENABLE_TRASH_BIN);
-    const bool isDir        = fslib::directory_exists(path);
+    if (backup_is_referenced(path))
+    {
+        const char *popReferenced = strings::get_by_name(strings::names::BACKUPMENU_POPS, 17);
+        ui::PopMessageManager::push_message(popTicks, popReferenced);
+        TASK_FINISH_RETURN(task);
+    }
+
+    // Snapshots are useless without the store next to them, so they skip the trash and their chunks are pruned right away.
+    const std::string pathString = path.string();
+    const bool trashEnabled      = config::get_by_key(config::keys::ENABLE_TRASH_BIN);
+    const bool isDir             = fslib::directory_exists(path);
+    const bool isSnapshot        = !isDir && std::strstr(pathString.c_str(), fs::EXTENSION_SNAPSHOT.data());
     bool dirError{}, fileError{};
-    if (trashEnabled)
+    if (trashEnabled && !isSnapshot)
     {
         const fslib::Path newPath{config::get_working_directory() / "_TRASH_" / path.get_filename()};
         dirError  = isDir && error::fslib(fslib::rename_directory(path, newPath));
@@ -387,6 +706,7 @@ void tasks::backup::delete_backup_local(sys::threadpool::JobData taskData)
         const char *popFailed = strings::get_by_name(strings::names::BACKUPMENU_POPS, 4);
         ui::PopMessageManager::push_message(popTicks, popFailed);
     }
+    else if (isSnapshot) { prune_chunk_store(path); }
 
     spawningState->refresh();
     task->complete();
@@ -443,7 +763,9 @@ void tasks::backup::upload_backup(sys::threadpool::JobData taskData)
     }
 
     // The backup menu should've made sure the remote is pointing to the correct location.
+    task->begin_operation(get_backup_file_size(path), 1);
     remote->upload_file(path, path.get_filename(), task);
+    task->finish_file();
     spawningState->refresh();
     task->complete();
 }
@@ -470,10 +792,20 @@ void tasks::backup::patch_backup(sys::threadpool::JobData taskData)
         task->set_status(status);
     }
 
+    task->begin_operation(get_backup_file_size(path), 1);
     remote->patch_file(remoteItem, path, task);
+    task->finish_file();
     task->complete();
 }
 
+void tasks::backup::add_save_to_operation(sys::ProgressTask *task, const FsSaveDataInfo *saveInfo)
+{
+    int64_t fileCount{}, totalSize{};
+    if (error::is_null(task) || error::is_null(saveInfo)) { return; }
+    else if (!fs::get_save_data_information(saveInfo, fileCount, totalSize)) { return; }
+    extend_operation(task, fileCount, totalSize);
+}
+
 static void auto_backup(sys::ProgressTask *task, BackupMenuState::TaskData taskData)
 {
     if (error::is_null(task)) { return; }
@@ -491,14 +823,18 @@ static void auto_backup(sys::ProgressTask *task, BackupMenuState::TaskData taskD
         if (!testMount.is_open() || !hasData) { return; }
     }
 
-    const bool autoUpload = config::get_by_key(config::keys::AUTO_UPLOAD);
-    const bool exportZip  = config::get_by_key(config::keys::EXPORT_TO_ZIP);
-    const bool zip        = autoUpload || exportZip;
+    const bool autoUpload  = config::get_by_key(config::keys::AUTO_UPLOAD);
+    const bool exportZip   = config::get_by_key(config::keys::EXPORT_TO_ZIP);
+    const bool deduplicate = !autoUpload && config::get_by_key(config::keys::DEDUPLICATE_BACKUPS);
+    const bool archive     = !autoUpload && !deduplicate && config::get_by_key(config::keys::INDEXED_ARCHIVES);
+    const bool zip         = !deduplicate && !archive && (autoUpload || exportZip);
 
     const char *safeNickname     = user->get_path_safe_nickname();
     const std::string dateString = stringutil::get_date_string();
     std::string backupName       = stringutil::get_formatted_string("AUTO - %s - %s", safeNickname, dateString.c_str());
-    if (zip) { backupName += STRING_ZIP_EXT; }
+    if (deduplicate) { backupName += fs::EXTENSION_SNAPSHOT; }
+    else if (archive) { backupName += fs::EXTENSION_ARCHIVE; }
+    else if (zip) { backupName += STRING_ZIP_EXT; }
 
     taskData->killTask = false;
 
@@ -635,6 +971,15 @@ static void write_meta_zip(fs::MiniZip &zip, const FsSaveDataInfo *saveInfo)
     }
 }
 
+static fslib::Path get_queued_temp_path()
+{
+    for (uint32_t index = 0;; index++)
+    {
+        fslib::Path path{stringutil::get_formatted_string(PATH_JKSV_TEMP_QUEUED, index)};
+        if (!fslib::file_exists(path)) { return path; }
+    }
+}
+
 static fs::ScopedSaveMount create_scoped_mount(const FsSaveDataInfo *saveInfo)
 {
     const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
@@ -648,3 +993,673 @@ static fs::ScopedSaveMount create_scoped_mount(const FsSaveDataInfo *saveInfo)
     }
     return saveMount;
 }
+
+static bool build_manifest(const fslib::Path &target,
+                           const FsSaveDataInfo *saveInfo,
+                           fs::BackupManifest &manifest,
+                           sys::ProgressTask *task)
+{
+    {
+        const char *statusChecking = strings::get_by_name(strings::names::BACKUPMENU_STATUS, 1);
+        task->set_status(statusChecking);
+    }
+
+    {
+        auto scopedMount = create_scoped_mount(saveInfo);
+        if (!manifest.build(fs::DEFAULT_SAVE_ROOT, task)) { return false; }
+    }
+
+    // No previous manifest just means this one is the start of a new chain.
+    fs::BackupManifest parent{};
+    std::string parentName{};
+    if (!find_latest_manifest(target, parent, parentName)) { return true; }
+
+    const size_t inherited = manifest.inherit_from(parent, parentName);
+    logger::log("%zu file(s) unchanged since %s.", inherited, parentName.c_str());
+    return true;
+}
+
+static bool find_latest_manifest(const fslib::Path &target, fs::BackupManifest &manifestOut, std::string &nameOut)
+{
+    const size_t lastSlash = target.find_last_of('/');
+    if (lastSlash == target.NOT_FOUND) { return false; }
+
+    const fslib::Path titleDir{target.sub_path(lastSlash)};
+    const std::string_view targetName = target.get_filename();
+    fslib::Directory titleListing{titleDir};
+    if (!titleListing.is_open()) { return false; }
+
+    bool found{};
+    for (const fslib::DirectoryEntry &entry : titleListing)
+    {
+        const char *filename = entry.get_filename();
+        if (filename == targetName) { continue; }
+
+        fs::BackupManifest manifest{};
+        const bool read  = manifest.read(titleDir / filename);
+        const bool newer = read && (!found || manifest.get_timestamp() > manifestOut.get_timestamp());
+        if (!newer) { continue; }
+
+        manifestOut = std::move(manifest);
+        nameOut     = filename;
+        found       = true;
+    }
+
+    return found;
+}
+
+static bool backup_is_referenced(const fslib::Path &backup)
+{
+    const size_t lastSlash = backup.find_last_of('/');
+    if (lastSlash == backup.NOT_FOUND) { return false; }
+
+    const fslib::Path titleDir{backup.sub_path(lastSlash)};
+    const std::string_view backupName = backup.get_filename();
+    fslib::Directory titleListing{titleDir};
+    if (!titleListing.is_open()) { return false; }
+
+    for (const fslib::DirectoryEntry &entry : titleListing)
+    {
+        const char *filename = entry.get_filename();
+        if (filename == backupName) { continue; }
+
+        fs::BackupManifest manifest{};
+        const bool read = manifest.read(titleDir / filename);
+        if (read && manifest.references(backupName)) { return true; }
+    }
+
+    return false;
+}
+
+static void write_changed_files(const fs::BackupManifest &manifest, const fslib::Path &target, sys::ProgressTask *task)
+{
+    const fslib::Path saveRoot{fs::DEFAULT_SAVE_ROOT};
+    for (const fs::BackupManifest::Entry &entry : manifest.get_entries())
+    {
+        if (entry.origin != fs::BackupManifest::ORIGIN_SELF) { continue; }
+
+        // Directories are always listed before anything inside of them.
+        const fslib::Path destination{target / entry.path};
+        if (entry.size == fs::BackupManifest::SIZE_DIRECTORY)
+        {
+            const bool exists = fslib::directory_exists(destination);
+            if (!exists) { error::fslib(fslib::create_directory(destination)); }
+            continue;
+        }
+
+        fs::copy_file(saveRoot / entry.path, destination, task);
+    }
+}
+
+static void write_changed_files(const fs::BackupManifest &manifest, fs::MiniZip &zip, sys::ProgressTask *task)
+{
+    const fslib::Path saveRoot{fs::DEFAULT_SAVE_ROOT};
+    for (const fs::BackupManifest::Entry &entry : manifest.get_entries())
+    {
+        if (entry.origin != fs::BackupManifest::ORIGIN_SELF) { continue; }
+
+        const fslib::Path source{saveRoot / entry.path};
+        if (entry.size == fs::BackupManifest::SIZE_DIRECTORY) { zip.add_directory(source.string()); }
+        else { fs::copy_file_to_zip(source, zip, task); }
+    }
+}
+
+static bool manifest_chain_is_complete(const fs::BackupManifest &manifest, const fslib::Path &target)
+{
+    const size_t lastSlash = target.find_last_of('/');
+    if (lastSlash == target.NOT_FOUND) { return false; }
+
+    const fslib::Path titleDir{target.sub_path(lastSlash)};
+
+    std::map<uint16_t, std::vector<const fs::BackupManifest::Entry *>> originFiles{};
+    for (const fs::BackupManifest::Entry &entry : manifest.get_entries())
+    {
+        if (entry.size != fs::BackupManifest::SIZE_DIRECTORY) { originFiles[entry.origin].push_back(&entry); }
+    }
+
+    for (const auto &[origin, files] : originFiles)
+    {
+        const std::string_view originName = manifest.get_origin(*files.front());
+        const fslib::Path originPath{origin == fs::BackupManifest::ORIGIN_SELF ? target : titleDir / originName};
+        const std::string originString     = originPath.string();
+        if (fslib::directory_exists(originPath))
+        {
+            for (const fs::BackupManifest::Entry *file : files)
+            {
+                if (fslib::file_exists(originPath / file->path)) { continue; }
+
+                logger::log("Incremental backup is incomplete: %s is missing %s.", originString.c_str(), file->path.c_str());
+                return false;
+            }
+            continue;
+        }
+
+        fs::MiniUnzip unzip{originPath};
+        if (!unzip.is_open())
+        {
+            logger::log("Incremental backup is incomplete: %s is missing.", originString.c_str());
+            return false;
+        }
+
+        for (const fs::BackupManifest::Entry *file : files)
+        {
+            if (unzip.locate_file(file->path)) { continue; }
+
+            logger::log("Incremental backup is incomplete: %s is missing %s.", originString.c_str(), file->path.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool restore_from_manifest(const fs::BackupManifest &manifest,
+                                  const fslib::Path &target,
+                                  fs::JournalBudget &journal,
+                                  sys::ProgressTask *task)
+{
+    const size_t lastSlash = target.find_last_of('/');
+    if (lastSlash == target.NOT_FOUND) { return false; }
+
+    const fslib::Path titleDir{target.sub_path(lastSlash)};
+    const fslib::Path saveRoot{fs::DEFAULT_SAVE_ROOT};
+
+    // Directories first. Files are grouped by the backup they're stored in so each one is only opened once.
+    std::map<uint16_t, std::vector<const fs::BackupManifest::Entry *>> originFiles{};
+    for (const fs::BackupManifest::Entry &entry : manifest.get_entries())
+    {
+        if (entry.size != fs::BackupManifest::SIZE_DIRECTORY)
+        {
+            originFiles[entry.origin].push_back(&entry);
+            continue;
+        }
+
+        const fslib::Path directory{saveRoot / entry.path};
+        const bool exists = fslib::directory_exists(directory);
+        if (!exists && !error::fslib(fslib::create_directories_recursively(directory))) { journal.consume_entry(); }
+    }
+
+    // The chain was checked before the save was cleared. Anything missing now means it changed since, so this stops instead
+    // of committing a partial save.
+    for (const auto &[origin, files] : originFiles)
+    {
+        const std::string_view originName = manifest.get_origin(*files.front());
+        const fslib::Path originPath{origin == fs::BackupManifest::ORIGIN_SELF ? target : titleDir / originName};
+        if (fslib::directory_exists(originPath))
+        {
+            for (const fs::BackupManifest::Entry *file : files)
+            {
+                fs::copy_file_commit(originPath / file->path, saveRoot / file->path, journal, task);
+            }
+            continue;
+        }
+
+        fs::MiniUnzip unzip{originPath};
+        if (!unzip.is_open())
+        {
+            logger::log("Error restoring incremental backup: %s is missing.", originPath.string().c_str());
+            return false;
+        }
+
+        for (const fs::BackupManifest::Entry *file : files)
+        {
+            const bool located = unzip.locate_file(file->path);
+            if (!located)
+            {
+                logger::log("Error restoring incremental backup: %s not found.", file->path.c_str());
+                return false;
+            }
+
+            fs::copy_zip_file_commit(unzip, saveRoot / file->path, journal, task);
+        }
+    }
+
+    return true;
+}
+
+static void create_snapshot(const fslib::Path &target, const FsSaveDataInfo *saveInfo, sys::ProgressTask *task)
+{
+    const size_t lastSlash = target.find_last_of('/');
+    if (lastSlash == target.NOT_FOUND) { return; }
+
+    const int popTicks           = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popErrorCreating = strings::get_by_name(strings::names::BACKUPMENU_POPS, 5);
+
+    fs::SaveMetaData saveMeta{};
+    if (!fs::fill_save_meta_data(saveInfo, saveMeta))
+    {
+        const char *popErrorWritingMeta = strings::get_by_name(strings::names::BACKUPMENU_POPS, 8);
+        ui::PopMessageManager::push_message(popTicks, popErrorWritingMeta);
+    }
+
+    fs::ChunkStore store{target.sub_path(lastSlash) / fs::NAME_CHUNK_STORE};
+    if (!store.is_open())
+    {
+        ui::PopMessageManager::push_message(popTicks, popErrorCreating);
+        return;
+    }
+
+    fs::Snapshot snapshot{saveMeta};
+    bool built{};
+    {
+        auto scopedMount = create_scoped_mount(saveInfo);
+        built            = snapshot.build(fs::DEFAULT_SAVE_ROOT, store, task);
+    }
+
+    // The snapshot is only written once every chunk it points to is safely in the store.
+    const bool flushed = built && store.flush();
+    const bool written = flushed && snapshot.write(target);
+    if (!written) { ui::PopMessageManager::push_message(popTicks, popErrorCreating); }
+}
+
+static void restore_snapshot(const fslib::Path &target,
+                             BackupMenuState::TaskData taskData,
+                             int64_t journalSize,
+                             sys::ProgressTask *task)
+{
+    const size_t lastSlash = target.find_last_of('/');
+    if (lastSlash == target.NOT_FOUND) { return; }
+
+    const FsSaveDataInfo *saveInfo = taskData->saveInfo;
+    const int popTicks             = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popErrorReading    = strings::get_by_name(strings::names::BACKUPMENU_POPS, 19);
+    {
+        const char *statusProcessing = strings::get_by_name(strings::names::BACKUPMENU_STATUS, 0);
+        task->set_status(statusProcessing);
+    }
+
+    fs::Snapshot snapshot{};
+    fs::ChunkStore store{target.sub_path(lastSlash) / fs::NAME_CHUNK_STORE};
+    if (!snapshot.read(target) || !store.is_open())
+    {
+        ui::PopMessageManager::push_message(popTicks, popErrorReading);
+        return;
+    }
+
+    {
+        int64_t fileCount{}, totalSize{};
+        snapshot.get_information(fileCount, totalSize);
+        extend_operation(task, fileCount, totalSize);
+    }
+
+    const bool processed = fs::process_save_meta_data(saveInfo, snapshot.get_meta());
+    if (!processed)
+    {
+        const char *popErrorProcessing = strings::get_by_name(strings::names::BACKUPMENU_POPS, 11);
+        ui::PopMessageManager::push_message(popTicks, popErrorProcessing);
+    }
+
+    auto scopedMount = create_scoped_mount(saveInfo);
+    fs::JournalBudget journal{fs::DEFAULT_SAVE_MOUNT, journalSize};
+    const bool restored = snapshot.restore(fs::DEFAULT_SAVE_ROOT, store, journal, task);
+    fs::commit_journal(journal);
+    if (!restored) { ui::PopMessageManager::push_message(popTicks, popErrorReading); }
+}
+
+static void prune_chunk_store(const fslib::Path &target)
+{
+    const size_t lastSlash = target.find_last_of('/');
+    if (lastSlash == target.NOT_FOUND) { return; }
+
+    const fslib::Path titleDir{target.sub_path(lastSlash)};
+    const fslib::Path storePath{titleDir / fs::NAME_CHUNK_STORE};
+    fslib::Directory titleListing{titleDir};
+    if (!titleListing.is_open() || !fslib::directory_exists(storePath)) { return; }
+
+    // Every chunk a remaining snapshot needs is kept. If one can't be read, nothing is pruned to be safe.
+    fs::ChunkStore::HashSet liveChunks{};
+    for (const fslib::DirectoryEntry &entry : titleListing)
+    {
+        const char *filename = entry.get_filename();
+        if (entry.is_directory() || !std::strstr(filename, fs::EXTENSION_SNAPSHOT.data())) { continue; }
+
+        fs::Snapshot snapshot{};
+        if (!snapshot.read(titleDir / filename)) { return; }
+        snapshot.collect_chunks(liveChunks);
+    }
+
+    fs::ChunkStore store{storePath};
+    if (store.is_open()) { store.prune(liveChunks); }
+}
+
+static void create_archive(const fslib::Path &target, const FsSaveDataInfo *saveInfo, sys::ProgressTask *task)
+{
+    const int popTicks           = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popErrorCreating = strings::get_by_name(strings::names::BACKUPMENU_POPS, 5);
+
+    fs::SaveMetaData saveMeta{};
+    if (!fs::fill_save_meta_data(saveInfo, saveMeta))
+    {
+        const char *popErrorWritingMeta = strings::get_by_name(strings::names::BACKUPMENU_POPS, 8);
+        ui::PopMessageManager::push_message(popTicks, popErrorWritingMeta);
+    }
+
+    // The title's dictionary is trained from its other backups the first time it's needed. Without enough of them, the
+    // archive is just compressed without one.
+    fs::CompressionDictionary dictionary{};
+    const bool useDictionary = config::get_by_key(config::keys::TITLE_DICTIONARIES);
+    const size_t lastSlash   = target.find_last_of('/');
+    if (useDictionary && lastSlash != target.NOT_FOUND)
+    {
+        const fslib::Path titleDir{target.sub_path(lastSlash)};
+        if (!dictionary.load_any(titleDir)) { dictionary.train(titleDir, task); }
+    }
+
+    fs::BackupArchive archive{};
+    bool created{};
+    {
+        fs::CompressionDictionary *archiveDictionary = dictionary.is_loaded() ? &dictionary : nullptr;
+        auto scopedMount                             = create_scoped_mount(saveInfo);
+        created = archive.create(target, fs::DEFAULT_SAVE_ROOT, saveMeta, task, archiveDictionary);
+    }
+
+    if (!created)
+    {
+        ui::PopMessageManager::push_message(popTicks, popErrorCreating);
+        return;
+    }
+
+    const bool verify = config::get_by_key(config::keys::VERIFY_WRITES);
+    if (verify) { archive.verify(task); }
+}
+
+static void restore_archive(const fslib::Path &target,
+                            BackupMenuState::TaskData taskData,
+                            int64_t journalSize,
+                            sys::ProgressTask *task)
+{
+    const FsSaveDataInfo *saveInfo = taskData->saveInfo;
+    const int popTicks             = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popErrorReading    = strings::get_by_name(strings::names::BACKUPMENU_POPS, 20);
+    {
+        const char *statusProcessing = strings::get_by_name(strings::names::BACKUPMENU_STATUS, 0);
+        task->set_status(statusProcessing);
+    }
+
+    // The meta and the size of everything come straight from the header and index.
+    fs::BackupArchive archive{target};
+    if (!archive.is_open())
+    {
+        ui::PopMessageManager::push_message(popTicks, popErrorReading);
+        return;
+    }
+
+    {
+        int64_t fileCount{}, totalSize{};
+        archive.get_information(fileCount, totalSize);
+        extend_operation(task, fileCount, totalSize);
+    }
+
+    const bool processed = fs::process_save_meta_data(saveInfo, archive.get_meta());
+    if (!processed)
+    {
+        const char *popErrorProcessing = strings::get_by_name(strings::names::BACKUPMENU_POPS, 11);
+        ui::PopMessageManager::push_message(popTicks, popErrorProcessing);
+    }
+
+    auto scopedMount = create_scoped_mount(saveInfo);
+    fs::JournalBudget journal{fs::DEFAULT_SAVE_MOUNT, journalSize};
+    const bool restored = archive.restore(fs::DEFAULT_SAVE_ROOT, journal, task);
+    fs::commit_journal(journal);
+    if (!restored) { ui::PopMessageManager::push_message(popTicks, popErrorReading); }
+}
+
+static void extend_operation(sys::ProgressTask *task, int64_t fileCount, int64_t totalSize)
+{
+    // Verifying reads everything back after it's written, so it's all processed twice.
+    const bool verify = config::get_by_key(config::keys::VERIFY_WRITES);
+    task->extend_operation(verify ? totalSize * 2 : totalSize, fileCount);
+}
+
+static void get_zip_information(fs::MiniUnzip &unzip, int64_t &fileCount, int64_t &totalSize)
+{
+    if (!unzip.reset()) { return; }
+
+    do {
+        if (unzip.is_directory()) { continue; }
+        totalSize += static_cast<int64_t>(unzip.get_uncompressed_size());
+        ++fileCount;
+    } while (unzip.next_file());
+    unzip.reset();
+}
+
+static void get_manifest_information(const fs::BackupManifest &manifest, int64_t &fileCount, int64_t &totalSize)
+{
+    // Restoring a chain writes every file, not just the ones stored in this backup.
+    for (const fs::BackupManifest::Entry &entry : manifest.get_entries())
+    {
+        if (entry.size == fs::BackupManifest::SIZE_DIRECTORY) { continue; }
+        totalSize += entry.size;
+        ++fileCount;
+    }
+}
+
+static int64_t get_backup_file_size(const fslib::Path &path)
+{
+    fslib::File file{path, FsOpenMode_Read};
+    return file.is_open() ? file.get_size() : 0;
+}
+
+static std::shared_ptr<UploadStreamStruct> create_upload_stream(const FsSaveDataInfo *saveInfo)
+{
+    int64_t largestFile{};
+    {
+        // This is quiet on purpose. If the save can't be mounted, the normal path reports it.
+        fs::ScopedSaveMount saveMount{fs::DEFAULT_SAVE_MOUNT, saveInfo};
+        if (!saveMount.is_open()) { return nullptr; }
+
+        largestFile = get_largest_file_size(fs::DEFAULT_SAVE_ROOT);
+        if (largestFile > SIZE_STREAM_ENTRY_MAX) { return nullptr; }
+    }
+
+    // The pipe is sized for this save's largest file. If the budget can't cover that, the SD is used instead.
+    auto uploadData = std::make_shared<UploadStreamStruct>(static_cast<size_t>(largestFile));
+    if (!uploadData->pipe.has_reservation()) { return nullptr; }
+
+    return uploadData;
+}
+
+static int64_t get_largest_file_size(const fslib::Path &directoryPath)
+{
+    fslib::Directory directory{directoryPath};
+    if (!directory.is_open()) { return 0; }
+
+    int64_t largest{};
+    for (const fslib::DirectoryEntry &entry : directory)
+    {
+        const int64_t size = entry.is_directory() ? get_largest_file_size(directoryPath / entry.get_filename())
+                                                  : entry.get_size();
+        largest            = std::max(largest, size);
+    }
+
+    return largest;
+}
+
+static bool stream_backup_remote(std::shared_ptr<UploadStreamStruct> uploadData,
+                                 const FsSaveDataInfo *saveInfo,
+                                 const fslib::Path &localPath,
+                                 remote::Storage *remote,
+                                 std::string_view remoteName,
+                                 remote::Item *target,
+                                 sys::ProgressTask *task)
+{
+    uploadData->remote     = remote;
+    uploadData->remoteName = remoteName;
+    uploadData->target     = target;
+
+    // The upload runs in the pool while this thread writes the ZIP. curl blocks until there's something to send.
+    const auto uploadJob = sys::threadpool::push_job(upload_stream_thread_function, uploadData);
+
+    // A ZIP that fails to open closes the pipe, so the upload still ends.
+    fs::MiniZip zip{uploadData->pipe, localPath};
+    const bool zipOpened = zip.is_open();
+    if (zipOpened)
+    {
+        write_meta_zip(zip, saveInfo);
+        {
+            auto scopedMount = create_scoped_mount(saveInfo);
+            fs::copy_directory_to_zip(fs::DEFAULT_SAVE_ROOT, zip, task);
+        }
+        zip.close();
+    }
+
+    {
+        const std::string_view name = target ? target->get_name() : remoteName;
+        const char *uploadFormat    = strings::get_by_name(strings::names::IO_STATUSES, 5);
+        std::string status          = stringutil::get_formatted_string(uploadFormat, name.data());
+        task->set_status(status);
+    }
+    uploadJob.wait();
+
+    return zipOpened && uploadData->uploaded;
+}
+
+static void upload_stream_thread_function(sys::threadpool::JobData jobData)
+{
+    auto castData = std::static_pointer_cast<UploadStreamStruct>(jobData);
+
+    fs::ZipPipe &pipe       = castData->pipe;
+    remote::Storage *remote = castData->remote;
+    remote::Item *target    = castData->target;
+
+    const bool uploaded = target ? remote->patch_stream(target, pipe) : remote->upload_stream(pipe, castData->remoteName);
+
+    // The ZIP side would wait on a full pipe forever otherwise.
+    if (!uploaded) { pipe.abort(); }
+
+    castData->uploaded = uploaded;
+}
+
+static bool stream_restore_remote(BackupMenuState::TaskData taskData,
+                                  remote::Storage *remote,
+                                  remote::Item *target,
+                                  sys::ProgressTask *task)
+{
+    data::User *user               = taskData->user;
+    data::TitleInfo *titleInfo     = taskData->titleInfo;
+    const FsSaveDataInfo *saveInfo = taskData->saveInfo;
+    const int popTicks             = ui::PopMessageManager::DEFAULT_TICKS;
+    const char *popDamaged         = strings::get_by_name(strings::names::BACKUPMENU_POPS, 21);
+
+    // Nothing is committed until the whole stream has been checked, so it has to fit in a journal of known size.
+    FsSaveDataExtraData extraData{};
+    const bool readExtra      = fs::read_save_extra_data(saveInfo, extraData);
+    const uint8_t saveType    = user->get_account_save_type();
+    const int64_t journalSize = readExtra ? extraData.journal_size : titleInfo->get_journal_size(saveType);
+    if (journalSize <= 0) { return false; }
+
+    // The SD is used instead if the buffer budget can't cover the pipe.
+    auto downloadData = std::make_shared<DownloadStreamStruct>();
+    if (!downloadData->pipe.has_reservation()) { return false; }
+
+    downloadData->remote = remote;
+    downloadData->target = target;
+    downloadData->task   = task;
+    {
+        const char *name              = target->get_name().data();
+        const char *downloadingFormat = strings::get_by_name(strings::names::IO_STATUSES, 4);
+        std::string status            = stringutil::get_formatted_string(downloadingFormat, name);
+        task->set_status(status);
+    }
+
+    // The download runs in the pool and blocks once the pipe is full, so only a few MB are ever held.
+    const auto downloadJob = sys::threadpool::push_job(download_stream_thread_function, downloadData);
+
+    fs::ZipPipe &pipe = downloadData->pipe;
+    fs::ZipStreamReader reader{pipe};
+    if (!reader.next_entry())
+    {
+        // Nothing was touched, so the old path gets to try.
+        pipe.abort();
+        downloadJob.wait();
+        return false;
+    }
+
+    // JKSV always writes the meta first. Like a local restore, a missing or bad meta isn't fatal.
+    const bool hasMeta = reader.get_filename() == fs::NAME_SAVE_META;
+    if (hasMeta)
+    {
+        fs::SaveMetaData saveMeta{};
+        sys::Byte *metaBuffer = reinterpret_cast<sys::Byte *>(&saveMeta);
+        ssize_t metaRead{}, read{};
+        while (metaRead < fs::SIZE_SAVE_META && (read = reader.read(&metaBuffer[metaRead], fs::SIZE_SAVE_META - metaRead)) > 0)
+        {
+            metaRead += read;
+        }
+
+        // A short meta means the backup is damaged. Nothing has been touched yet, so the restore just stops here.
+        if (metaRead != fs::SIZE_SAVE_META)
+        {
+            ui::PopMessageManager::push_message(popTicks, popDamaged);
+            pipe.abort();
+            downloadJob.wait();
+            return true;
+        }
+
+        const bool metaProcessed = fs::process_save_meta_data(saveInfo, saveMeta);
+        if (!metaProcessed)
+        {
+            const char *popErrorProcessing = strings::get_by_name(strings::names::BACKUPMENU_POPS, 11);
+            ui::PopMessageManager::push_message(popTicks, popErrorProcessing);
+        }
+    }
+    else
+    {
+        const char *popNotFound = strings::get_by_name(strings::names::BACKUPMENU_POPS, 16);
+        ui::PopMessageManager::push_message(popTicks, popNotFound);
+    }
+
+    const bool entriesLeft = !hasMeta || reader.next_entry();
+    if (reader.has_failed())
+    {
+        ui::PopMessageManager::push_message(popTicks, popDamaged);
+        downloadJob.wait();
+        return true;
+    }
+
+    bool deleteError{}, restored{}, fits{true};
+    {
+        auto scopedMount = create_scoped_mount(saveInfo);
+
+        // The reset and everything after it are only committed once the whole backup has been extracted and checked. If
+        // anything goes wrong, unmounting throws all of it away and the save is left the way it was.
+        deleteError = error::fslib(fslib::delete_directory_recursively(fs::DEFAULT_SAVE_ROOT));
+        fs::JournalBudget journal{fs::DEFAULT_SAVE_MOUNT, journalSize};
+        if (deleteError) { restored = false; }
+        else if (entriesLeft)
+        {
+            restored = fs::copy_zip_stream_to_directory(reader, fs::DEFAULT_SAVE_ROOT, journal, fits, task);
+        }
+        else { restored = reader.is_finished(); }
+
+        if (restored) { fs::commit_journal(journal); }
+    }
+
+    // Backups too big for one commit are downloaded to the SD first so they can be checked before being committed in pieces.
+    if (!fits)
+    {
+        pipe.abort();
+        downloadJob.wait();
+        return false;
+    }
+
+    if (deleteError)
+    {
+        const char *popErrorResetting = strings::get_by_name(strings::names::BACKUPMENU_POPS, 2);
+        ui::PopMessageManager::push_message(popTicks, popErrorResetting);
+    }
+    else if (!restored) { ui::PopMessageManager::push_message(popTicks, popDamaged); }
+
+    if (!restored) { pipe.abort(); }
+    downloadJob.wait();
+
+    return true;
+}
+
+static void download_stream_thread_function(sys::threadpool::JobData jobData)
+{
+    auto castData = std::static_pointer_cast<DownloadStreamStruct>(jobData);
+
+    // This always closes the pipe, so the reader can't be left waiting.
+    castData->remote->download_stream(castData->target, castData->pipe, castData->task);
+}
@@ -0,0 +1,267 @@
+#include "tasks/extras.hpp"
+
+#include "config/config.hpp"
+#include "error.hpp"
+#include "fs/fs.hpp"
+#include "logging/logger.hpp"
+#include "strings/strings.hpp"
+#include "stringutil.hpp"
+#include "ui/PopMessageManager.hpp"
+
+#include <array>
+#include <chrono>
+#include <memory>
+
+namespace
+{
+    /// @brief Size of the file written to the SD to time it. This is also the most read from system storage per run.
+    constexpr int64_t SIZE_TEST_FILE = 0x1000000;
+
+    /// @brief Chunk sizes timed as shifts. 64KB to 2MB. These need to stay within the range fs::get_device_chunk_size accepts.
+    constexpr std::array<uint8_t, 6> SHIFT_CHUNK_SIZES = {16, 17, 18, 19, 20, 21};
+
+    /// @brief Queue depths timed.
+    constexpr std::array<uint8_t, 4> COUNT_QUEUE_DEPTHS = {2, 3, 4, 6};
+
+    /// @brief Names of the files used to time the SD.
+    constexpr std::string_view NAME_TEST_FILE = "_calibration.bin";
+    constexpr std::string_view NAME_TEST_COPY = "_calibration_copy.bin";
+
+    /// @brief The system partition is mounted here to time system storage. It's only ever read from.
+    constexpr std::string_view DEVICE_SYSTEM = "calibration";
+    constexpr std::string_view PATH_SYSTEM   = "calibration:/Contents";
+} // namespace
+
+// Definitions at bottom.
+static uint8_t calibrate_sd(const fslib::Path &testPath, sys::Byte *buffer, sys::ProgressTask *task);
+static uint8_t calibrate_system(sys::Byte *buffer, sys::ProgressTask *task);
+static uint8_t calibrate_queue_depth(const fslib::Path &testPath, const fslib::Path &copyPath, sys::ProgressTask *task);
+static double time_write(const fslib::Path &path, sys::Byte *buffer, size_t chunkSize);
+static double time_read(const fslib::Path &path, sys::Byte *buffer, size_t chunkSize, int64_t limit);
+static bool find_largest_file(const fslib::Path &directory, fslib::Path &pathOut, int64_t &sizeOut);
+static void set_timing_status(sys::ProgressTask *task, std::string_view device, uint8_t shift);
+
+void tasks::extras::calibrate_io(sys::threadpool::JobData taskData)
+{
+    auto castData = std::static_pointer_cast<sys::Task::DataStruct>(taskData);
+
+    sys::ProgressTask *task = static_cast<sys::ProgressTask *>(castData->task);
+    if (error::is_null(task)) { return; }
+
+    const fslib::Path workDir{config::get_working_directory()};
+    const fslib::Path testPath{workDir / NAME_TEST_FILE};
+    const fslib::Path copyPath{workDir / NAME_TEST_COPY};
+    const int popTicks = ui::PopMessageManager::DEFAULT_TICKS;
+
+    // Every chunk size for both devices plus every queue depth is one step.
+    const size_t stepCount = (SHIFT_CHUNK_SIZES.size() * 2) + COUNT_QUEUE_DEPTHS.size();
+    task->reset(static_cast<double>(stepCount));
+
+    const size_t bufferSize = static_cast<size_t>(1) << SHIFT_CHUNK_SIZES.back();
+    auto buffer             = std::make_unique<sys::Byte[]>(bufferSize);
+
+    const uint8_t sdShift     = calibrate_sd(testPath, buffer.get(), task);
+    const uint8_t systemShift = calibrate_system(buffer.get(), task);
+    if (sdShift == 0)
+    {
+        const char *popFailed = strings::get_by_name(strings::names::EXTRASMENU_POPS, 3);
+        ui::PopMessageManager::push_message(popTicks, popFailed);
+        fslib::delete_file(testPath);
+        TASK_FINISH_RETURN(task);
+    }
+
+    // The copy pipeline reads the config for every file, so the depth is timed using the chunk size that was just picked.
+    config::set_by_key(config::keys::SD_CHUNK_SHIFT, sdShift);
+    const uint8_t queueDepth = calibrate_queue_depth(testPath, copyPath, task);
+    fslib::delete_file(testPath);
+    fslib::delete_file(copyPath);
+
+    if (systemShift != 0) { config::set_by_key(config::keys::SYSTEM_CHUNK_SHIFT, systemShift); }
+    config::set_by_key(config::keys::IO_QUEUE_DEPTH, queueDepth);
+    config::save();
+
+    {
+        const char *popFormat    = strings::get_by_name(strings::names::EXTRASMENU_POPS, 2);
+        const unsigned sdSize    = fs::get_device_chunk_size("sdmc") / 1024;
+        const unsigned sysSize   = fs::get_device_chunk_size(DEVICE_SYSTEM) / 1024;
+        const std::string popMsg = stringutil::get_formatted_string(popFormat, sdSize, sysSize, queueDepth);
+        ui::PopMessageManager::push_message(popTicks, popMsg);
+    }
+
+    TASK_FINISH_RETURN(task);
+}
+
+//                      ---- Static functions ----
+
+static uint8_t calibrate_sd(const fslib::Path &testPath, sys::Byte *buffer, sys::ProgressTask *task)
+{
+    uint8_t bestShift{};
+    double bestTime{};
+    for (const uint8_t shift : SHIFT_CHUNK_SIZES)
+    {
+        set_timing_status(task, "sdmc", shift);
+
+        // Copies on the SD read and write the same device, so both are weighed the same.
+        const size_t chunkSize = static_cast<size_t>(1) << shift;
+        const unsigned chunkKB = chunkSize / 1024;
+        const double writeTime = time_write(testPath, buffer, chunkSize);
+        const double readTime  = writeTime > 0 ? time_read(testPath, buffer, chunkSize, SIZE_TEST_FILE) : -1;
+        task->increase_current(1);
+        if (writeTime <= 0 || readTime <= 0) { continue; }
+
+        const double totalTime = writeTime + readTime;
+        logger::log("Calibration: sdmc %u KB: write %.3fs, read %.3fs.", chunkKB, writeTime, readTime);
+        if (bestShift == 0 || totalTime < bestTime)
+        {
+            bestShift = shift;
+            bestTime  = totalTime;
+        }
+    }
+
+    return bestShift;
+}
+
+static uint8_t calibrate_system(sys::Byte *buffer, sys::ProgressTask *task)
+{
+    // Writing to saves or the BIS partitions just to time them isn't worth the risk. Reads from the system partition are
+    // what's timed here since save data and the other partitions all live on the same NAND.
+    const bool mountError = error::fslib(fslib::open_bis_filesystem(DEVICE_SYSTEM, FsBisPartitionId_System));
+    if (mountError)
+    {
+        task->increase_current(static_cast<double>(SHIFT_CHUNK_SIZES.size()));
+        return 0;
+    }
+
+    fslib::Path largestPath{};
+    int64_t largestSize{};
+    const bool found     = find_largest_file(PATH_SYSTEM, largestPath, largestSize);
+    const int64_t toRead = std::min(largestSize, SIZE_TEST_FILE);
+
+    uint8_t bestShift{};
+    double bestTime{};
+    for (const uint8_t shift : SHIFT_CHUNK_SIZES)
+    {
+        set_timing_status(task, "system", shift);
+
+        const size_t chunkSize = static_cast<size_t>(1) << shift;
+        const unsigned chunkKB = chunkSize / 1024;
+        const double readTime  = found ? time_read(largestPath, buffer, chunkSize, toRead) : -1;
+        task->increase_current(1);
+        if (readTime <= 0) { continue; }
+
+        logger::log("Calibration: system %u KB: read %.3fs.", chunkKB, readTime);
+        if (bestShift == 0 || readTime < bestTime)
+        {
+            bestShift = shift;
+            bestTime  = readTime;
+        }
+    }
+    fslib::close_file_system(DEVICE_SYSTEM);
+
+    return bestShift;
+}
+
+static uint8_t calibrate_queue_depth(const fslib::Path &testPath, const fslib::Path &copyPath, sys::ProgressTask *task)
+{
+    const char *statusFormat = strings::get_by_name(strings::names::IO_STATUSES, 9);
+    const uint8_t previous   = static_cast<uint8_t>(fs::get_queue_depth());
+
+    uint8_t bestDepth{};
+    double bestTime{};
+    for (const uint8_t depth : COUNT_QUEUE_DEPTHS)
+    {
+        {
+            std::string status = stringutil::get_formatted_string(statusFormat, depth);
+            task->set_status(status);
+        }
+
+        // The real copy pipeline is timed so the reader and writer threads overlap the way they do normally.
+        config::set_by_key(config::keys::IO_QUEUE_DEPTH, depth);
+        const auto start = std::chrono::steady_clock::now();
+        fs::copy_file(testPath, copyPath);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        task->increase_current(1);
+
+        fslib::File copyFile{copyPath, FsOpenMode_Read};
+        const bool copied = copyFile.is_open() && copyFile.get_size() == SIZE_TEST_FILE;
+        copyFile.close();
+        fslib::delete_file(copyPath);
+        if (!copied) { continue; }
+
+        const double copyTime = elapsed.count();
+        logger::log("Calibration: queue depth %u: copy %.3fs.", depth, copyTime);
+        if (bestDepth == 0 || copyTime < bestTime)
+        {
+            bestDepth = depth;
+            bestTime  = copyTime;
+        }
+    }
+
+    return bestDepth == 0 ? previous : bestDepth;
+}
+
+static double time_write(const fslib::Path &path, sys::Byte *buffer, size_t chunkSize)
+{
+    if (fslib::file_exists(path) && error::fslib(fslib::delete_file(path))) { return -1; }
+
+    const auto start = std::chrono::steady_clock::now();
+    fslib::File testFile{path, FsOpenMode_Create | FsOpenMode_Write, SIZE_TEST_FILE};
+    if (error::fslib(testFile.is_open())) { return -1; }
+
+    for (int64_t i = 0; i < SIZE_TEST_FILE;)
+    {
+        const ssize_t written = testFile.write(buffer, chunkSize);
+        if (written != static_cast<ssize_t>(chunkSize)) { return -1; }
+        i += written;
+    }
+    testFile.close();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static double time_read(const fslib::Path &path, sys::Byte *buffer, size_t chunkSize, int64_t limit)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fslib::File testFile{path, FsOpenMode_Read};
+    if (error::fslib(testFile.is_open())) { return -1; }
+
+    for (int64_t i = 0; i < limit;)
+    {
+        const ssize_t readSize = testFile.read(buffer, chunkSize);
+        if (readSize <= 0) { return -1; }
+        i += readSize;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static bool find_largest_file(const fslib::Path &directory, fslib::Path &pathOut, int64_t &sizeOut)
+{
+    fslib::Directory dir{directory};
+    if (!dir.is_open()) { return false; }
+
+    bool found{};
+    for (const fslib::DirectoryEntry &entry : dir)
+    {
+        const fslib::Path fullPath{directory / entry};
+        if (entry.is_directory()) { found = find_largest_file(fullPath, pathOut, sizeOut) || found; }
+        else if (entry.get_size() > sizeOut)
+        {
+            pathOut = fullPath;
+            sizeOut = entry.get_size();
+            found   = true;
+        }
+    }
+
+    return found;
+}
+
+static void set_timing_status(sys::ProgressTask *task, std::string_view device, uint8_t shift)
+{
+    const char *statusFormat = strings::get_by_name(strings::names::IO_STATUSES, 8);
+    const unsigned chunkKB   = (static_cast<size_t>(1) << shift) / 1024;
+    std::string status       = stringutil::get_formatted_string(statusFormat, device.data(), chunkKB);
+    task->set_status(status);
+}
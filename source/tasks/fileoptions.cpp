@@ -8,6 +8,19 @@
 #include "strings/strings.hpp"
 #include "stringutil.hpp"
 
+// Defined at bottom.
+static void copy_zip_directory(const fs::ZipIndex &zipIndex,
+                               fs::MiniUnzip &unzip,
+                               const std::string &zipDir,
+                               const fslib::Path &dest,
+                               fs::JournalBudget &journal,
+                               sys::ProgressTask *task);
+static void copy_zip_entry(fs::MiniUnzip &unzip,
+                           const fs::ZipIndex::Entry &entry,
+                           const fslib::Path &dest,
+                           fs::JournalBudget &journal,
+                           sys::ProgressTask *task);
+
 void tasks::fileoptions::copy_source_to_destination(sys::threadpool::JobData taskData)
 {
 
@@ -55,6 +68,73 @@ void tasks::fileoptions::copy_source_to_destination(sys::threadpool::JobData tas
     task->complete();
 }
 
+void tasks::fileoptions::copy_zip_to_destination(sys::threadpool::JobData taskData)
+{
+    auto castData = std::static_pointer_cast<FileOptionState::DataStruct>(taskData);
+
+    const int popTicks             = ui::PopMessageManager::DEFAULT_TICKS;
+    sys::ProgressTask *task        = static_cast<sys::ProgressTask *>(castData->task);
+    const fs::ZipIndex *zipIndex   = castData->zipIndex.get();
+    const std::string &zipEntry    = castData->zipEntry;
+    const fslib::Path &dest        = castData->destPath;
+    const int64_t journalSpace     = castData->journalSize;
+    FileOptionState *spawningState = castData->spawningState;
+
+    if (error::is_null(task)) { return; }
+    else if (error::is_null(spawningState) || error::is_null(zipIndex)) { TASK_FINISH_RETURN(task); }
+
+    const char *errorFormat = strings::get_by_name(strings::names::FILEOPTION_POPS, 0);
+    const std::string pop   = stringutil::get_formatted_string(errorFormat, zipIndex->get_path().get_filename());
+
+    // Each copy gets its own handle so the index can keep being browsed while this runs.
+    fs::MiniUnzip unzip{zipIndex->get_path()};
+    if (!unzip.is_open())
+    {
+        ui::PopMessageManager::push_message(popTicks, pop);
+        TASK_FINISH_RETURN(task);
+    }
+
+    // The root of the ZIP doesn't have an entry of its own.
+    const fs::ZipIndex::Entry *entry = zipIndex->find_entry(zipEntry);
+    const bool sourceIsDir           = !entry || entry->isDirectory;
+    bool destError                   = false;
+    if (sourceIsDir) { destError = error::fslib(fslib::create_directories_recursively(dest)); }
+    else
+    {
+        const size_t subDest = dest.find_last_of('/');
+        if (subDest != dest.NOT_FOUND && subDest > 1)
+        {
+            fslib::Path subDestPath{dest.sub_path(subDest)};
+            destError = error::fslib(fslib::create_directories_recursively(subDestPath));
+        }
+    }
+
+    if (destError)
+    {
+        ui::PopMessageManager::push_message(popTicks, pop);
+        TASK_FINISH_RETURN(task);
+    }
+
+    int64_t subDirCount{};
+    int64_t fileCount{1};
+    int64_t totalSize{entry ? entry->size : 0};
+    if (sourceIsDir)
+    {
+        fileCount = 0;
+        zipIndex->get_information(zipEntry, subDirCount, fileCount, totalSize);
+    }
+    task->begin_operation(totalSize, fileCount);
+
+    // A journal size of 0 disables committing for the SD card side.
+    fs::JournalBudget journal{dest.get_device_name(), journalSpace};
+    if (sourceIsDir) { copy_zip_directory(*zipIndex, unzip, zipEntry, dest, journal, task); }
+    else { copy_zip_entry(unzip, *entry, dest, journal, task); }
+    fs::commit_journal(journal);
+
+    spawningState->update_destination();
+    task->complete();
+}
+
 void tasks::fileoptions::delete_target(sys::threadpool::JobData taskData)
 {
     auto castData = std::static_pointer_cast<FileOptionState::DataStruct>(taskData);
@@ -103,3 +183,49 @@ void tasks::fileoptions::delete_target(sys::threadpool::JobData taskData)
     spawningState->update_source();
     task->complete();
 }
+
+//                      ---- Static functions ----
+
+static void copy_zip_directory(const fs::ZipIndex &zipIndex,
+                               fs::MiniUnzip &unzip,
+                               const std::string &zipDir,
+                               const fslib::Path &dest,
+                               fs::JournalBudget &journal,
+                               sys::ProgressTask *task)
+{
+    const std::vector<size_t> *children = zipIndex.get_directory(zipDir);
+    if (!children) { return; }
+
+    for (const size_t index : *children)
+    {
+        const fs::ZipIndex::Entry &entry = zipIndex.get_entry(index);
+        const fslib::Path fullDest{dest / entry.name};
+        if (!entry.isDirectory)
+        {
+            copy_zip_entry(unzip, entry, fullDest, journal, task);
+            continue;
+        }
+
+        const bool exists      = fslib::directory_exists(fullDest);
+        const bool createError = !exists && error::fslib(fslib::create_directory(fullDest));
+        if (createError) { continue; }
+        else if (!exists) { journal.consume_entry(); }
+
+        copy_zip_directory(zipIndex, unzip, entry.path, fullDest, journal, task);
+    }
+}
+
+static void copy_zip_entry(fs::MiniUnzip &unzip,
+                           const fs::ZipIndex::Entry &entry,
+                           const fslib::Path &dest,
+                           fs::JournalBudget &journal,
+                           sys::ProgressTask *task)
+{
+    if (!unzip.go_to_position(entry.position))
+    {
+        logger::log("Error locating %s in ZIP.", entry.path.c_str());
+        return;
+    }
+
+    fs::copy_zip_file_commit(unzip, dest, journal, task);
+}
@@ -23,6 +23,16 @@ void tasks::mainmenu::backup_all_for_all_local(sys::threadpool::JobData taskData
 
     if (error::is_null(task)) { return; }
 
+    // Everything is sized up front so the time remaining covers the whole batch.
+    task->begin_operation(0, 0);
+    for (data::User *user : userList)
+    {
+        if (user->get_account_save_type() == FsSaveDataType_System) { continue; }
+
+        const int64_t titleCount = user->get_total_data_entries();
+        for (int64_t i = 0; i < titleCount; i++) { tasks::backup::add_save_to_operation(task, user->get_save_info_at(i)); }
+    }
+
     for (data::User *user : userList)
     {
         backupStruct->user = user;
@@ -86,6 +96,17 @@ void tasks::mainmenu::backup_all_for_all_remote(sys::threadpool::JobData taskDat
     backupStruct->killTask = false;
 
     const data::UserList &userList = castData->userList;
+    task->begin_operation(0, 0);
+    for (data::User *user : userList)
+    {
+        if (user->get_account_save_type() == FsSaveDataType_System) { continue; }
+
+        const int64_t titleCount = user->get_total_data_entries();
+        for (int64_t i = 0; i < titleCount; i++) { tasks::backup::add_save_to_operation(task, user->get_save_info_at(i)); }
+    }
+
+    // Saves are uploaded in the background while the next ones are compressed.
+    curl::TransferEngine engine{config::get_by_key(config::keys::REMOTE_TRANSFER_LIMIT)};
     for (data::User *user : userList)
     {
         if (user->get_account_save_type() == FsSaveDataType_System) { continue; }
@@ -122,10 +143,11 @@ void tasks::mainmenu::backup_all_for_all_remote(sys::threadpool::JobData taskDat
             std::string remoteName       = stringutil::get_formatted_string("%s - %s.zip", pathSafe, dateString.c_str());
             backupStruct->remoteName     = std::move(remoteName);
 
-            tasks::backup::create_new_backup_remote(backupStruct);
+            tasks::backup::queue_new_backup_remote(backupStruct, engine);
             remote->return_to_root();
         }
     }
 
+    engine.wait();
     task->complete();
 }
@@ -10,6 +10,8 @@
 #include "stringutil.hpp"
 #include "ui/PopMessageManager.hpp"
 
+#include <cstring>
+
 // Defined at bottom.
 static bool read_save_meta(const fslib::Path &path, fs::SaveMetaData &metaOut);
 static bool test_for_save(data::User *user, const fs::SaveMetaData &saveMeta);
@@ -36,18 +38,34 @@ void tasks::saveimport::import_save_backup(sys::threadpool::JobData taskData)
     const FsSaveDataInfo *saveInfo = user->get_save_info_by_id(metaData.applicationID);
     if (error::is_null(saveInfo)) { TASK_FINISH_RETURN(task); }
 
+    // The save might have been created or extended with a different journal than the backup recorded.
+    FsSaveDataExtraData extraData{};
+    const bool readExtra      = fs::read_save_extra_data(saveInfo, extraData);
+    const int64_t journalSize = readExtra ? extraData.journal_size : metaData.journalSize;
+
     {
         fs::ScopedSaveMount saveMount{fs::DEFAULT_SAVE_MOUNT, saveInfo};
         if (!saveMount.is_open()) { TASK_FINISH_RETURN(task); }
 
-        const bool isDir = fslib::directory_exists(target);
-        if (isDir) { fs::copy_directory_commit(target, fs::DEFAULT_SAVE_ROOT, metaData.journalSize, task); }
+        const std::string targetString = target.string();
+        const bool isDir               = fslib::directory_exists(target);
+        const bool isArchive           = !isDir && std::strstr(targetString.c_str(), fs::EXTENSION_ARCHIVE.data());
+        if (isDir) { fs::copy_directory_commit(target, fs::DEFAULT_SAVE_ROOT, journalSize, task); }
+        else if (isArchive)
+        {
+            fs::BackupArchive archive{target};
+            if (!archive.is_open()) { TASK_FINISH_RETURN(task); }
+
+            fs::JournalBudget journal{fs::DEFAULT_SAVE_MOUNT, journalSize};
+            archive.restore(fs::DEFAULT_SAVE_ROOT, journal, task);
+            fs::commit_journal(journal);
+        }
         else
         {
             fs::MiniUnzip unzip{target};
             if (!unzip.is_open()) { TASK_FINISH_RETURN(task); }
 
-            fs::copy_zip_to_directory(unzip, fs::DEFAULT_SAVE_ROOT, metaData.journalSize, task);
+            fs::copy_zip_to_directory(unzip, fs::DEFAULT_SAVE_ROOT, journalSize, task);
         }
     }
 
@@ -56,7 +74,9 @@ void tasks::saveimport::import_save_backup(sys::threadpool::JobData taskData)
 
 static bool read_save_meta(const fslib::Path &path, fs::SaveMetaData &metaOut)
 {
-    const bool isDir = fslib::directory_exists(path);
+    const std::string pathString = path.string();
+    const bool isDir             = fslib::directory_exists(path);
+    const bool isArchive         = !isDir && std::strstr(pathString.c_str(), fs::EXTENSION_ARCHIVE.data());
     if (isDir)
     {
         const fslib::Path metaPath{path / fs::NAME_SAVE_META};
@@ -69,6 +89,13 @@ static bool read_save_meta(const fslib::Path &path, fs::SaveMetaData &metaOut)
         const bool magicMatch = metaRead && metaOut.magic == fs::SAVE_META_MAGIC;
         if (!metaRead || !magicMatch) { return false; }
     }
+    else if (isArchive)
+    {
+        // The meta is part of the archive's header.
+        fs::BackupArchive archive{path};
+        if (!archive.is_open() || archive.get_meta().magic != fs::SAVE_META_MAGIC) { return false; }
+        metaOut = archive.get_meta();
+    }
     else
     {
         fs::MiniUnzip zip{path};
@@ -87,9 +87,9 @@ void tasks::update::download_update(sys::threadpool::JobData jobData)
     curl::set_option(downloadCurl, CURLOPT_WRITEDATA, download.get());
     curl::set_option(downloadCurl, CURLOPT_FOLLOWLOCATION, 1L);
 
-    sys::threadpool::push_job(curl::download_write_thread_function, download);
-    if (!curl::perform(downloadCurl)) { TASK_FINISH_RETURN(task); }
-    download->writeComplete.acquire();
+    const auto writeJob  = sys::threadpool::push_job(curl::download_write_thread_function, download);
+    const bool performed = curl::perform(downloadCurl);
+    if (!curl::finish_threaded_download(download.get(), writeJob, performed)) { TASK_FINISH_RETURN(task); }
 
     task->complete();
 
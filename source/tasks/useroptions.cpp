@@ -27,6 +27,11 @@ void tasks::useroptions::backup_all_for_user_local(sys::threadpool::JobData task
     const fslib::Path workDir{config::get_working_directory()};
     const bool exportToZip = config::get_by_key(config::keys::EXPORT_TO_ZIP);
     const int titleCount   = user->get_total_data_entries();
+
+    // Everything is sized up front so the time remaining covers the whole batch.
+    task->begin_operation(0, 0);
+    for (int i = 0; i < titleCount; i++) { tasks::backup::add_save_to_operation(task, user->get_save_info_at(i)); }
+
     for (int i = 0; i < titleCount; i++)
     {
         const FsSaveDataInfo *saveInfo = user->get_save_info_at(i);
@@ -80,6 +85,13 @@ void tasks::useroptions::backup_all_for_user_remote(sys::threadpool::JobData tas
     backupStruct->killTask = false;
 
     const int titleCount = user->get_total_data_entries();
+
+    task->begin_operation(0, 0);
+    for (int i = 0; i < titleCount; i++) { tasks::backup::add_save_to_operation(task, user->get_save_info_at(i)); }
+
+    // Saves are uploaded in the background while the next ones are compressed.
+    curl::TransferEngine engine{config::get_by_key(config::keys::REMOTE_TRANSFER_LIMIT)};
+
     for (int i = 0; i < titleCount; i++)
     {
         const FsSaveDataInfo *saveInfo = user->get_save_info_at(i);
@@ -107,10 +119,11 @@ void tasks::useroptions::backup_all_for_user_remote(sys::threadpool::JobData tas
         const std::string dateString = stringutil::get_date_string();
 
         backupStruct->remoteName = stringutil::get_formatted_string("%s - %s.zip", user->get_nickname(), dateString.c_str());
-        tasks::backup::create_new_backup_remote(backupStruct);
+        tasks::backup::queue_new_backup_remote(backupStruct, engine);
 
         remote->return_to_root();
     }
+    engine.wait();
     task->complete();
 }
 